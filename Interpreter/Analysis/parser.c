@@ -32,11 +32,11 @@
         VI_EXIT(EXIT_ILLEGAL_HEX, \
 "Verifique se \"%s\" excedeu o limite aceito (se nao esta\n\tusando um hexadecimal maior que FFH para um parametro que\n\taceita apenas ate FFH, por exemplo).",\
         v ? v->value : "null",                                                              \
-            v ? getTokenTypeString(v->type) : getTokenTypeString(TokenType_Unknown));           \
+            v ? getTokenTypeString(v->type, &state->env->diagnostics) : getTokenTypeString(TokenType_Unknown, &state->env->diagnostics));           \
         else \
             VI_EXIT(EXIT_INVALID_ARGUMENT, "Argumento hexadecimal invalido \"%s\" (%s)\n",      \
             v ? v->value : "null",                                                              \
-            v ? getTokenTypeString(v->type) : getTokenTypeString(TokenType_Unknown));           \
+            v ? getTokenTypeString(v->type, &state->env->diagnostics) : getTokenTypeString(TokenType_Unknown, &state->env->diagnostics));           \
        }\
     if (name > HEX##s##_MAX)                                                               \
         VI_EXIT(EXIT_INVALID_ARGUMENT, "Valor hexadecimal muito grande: %x\n", name);
@@ -104,14 +104,14 @@ Token_t* expect_and_consume(ParserState* state, TokenType_t expected_type) {
         do {
             last_token = state->tokens[state->index];
             if (state->index == 0) {
-                char* tts = token ? getTokenTypeString(token->type) : getTokenTypeString(TokenType_Unknown);
-                if (tts == getTokenTypeString(TokenType_Identifier)) {
+                char* tts = token ? getTokenTypeString(token->type, &state->env->diagnostics) : getTokenTypeString(TokenType_Unknown, &state->env->diagnostics);
+                if (tts == getTokenTypeString(TokenType_Identifier, &state->env->diagnostics)) {
                     tts = "Identificador/Desconhecido";
                 }
                 // Avisa o erro e sai do programa
                 VI_EXIT(EXIT_INVALID_ARGUMENT, "Erro de sintaxe em (%s): esperado %s, encontrado \"%s\" (%s)\n",
 
-                getTokenTypeString(expected_type),
+                getTokenTypeString(expected_type, &state->env->diagnostics),
                 token ? token->value : "null",
                 tts);
             }
@@ -121,9 +121,9 @@ Token_t* expect_and_consume(ParserState* state, TokenType_t expected_type) {
         // Avisa o erro e sai do programa
         VI_EXIT(EXIT_INVALID_ARGUMENT, "Erro de sintaxe depois de \"%s\": esperado %s, encontrado \"%s\" (%s)\n",
         last_token.value,
-        getTokenTypeString(expected_type),
+        getTokenTypeString(expected_type, &state->env->diagnostics),
         token ? token->value : "null",
-        token ? getTokenTypeString(token->type) : getTokenTypeString(TokenType_Unknown));
+        token ? getTokenTypeString(token->type, &state->env->diagnostics) : getTokenTypeString(TokenType_Unknown, &state->env->diagnostics));
 
     }
     consume(state);
@@ -193,7 +193,7 @@ hex2_t consume_hex(ParserState * state, unsigned int size) {
     // Se chegou até aqui, é algo inválido
     VI_EXIT(EXIT_INVALID_ARGUMENT, "Erro de sintaxe: esperado Hexadecimal ou Identificador, encontrado \"%s\" (%s)\n",
     temp ? temp->value : "null",
-    getTokenTypeString(temp->type));
+    getTokenTypeString(temp->type, &state->env->diagnostics));
 
 }
 
@@ -509,7 +509,8 @@ void parse_instruction(ParserState * state) {
 // analisa um identificador
 void parse_identifier(ParserState * state) {
     Token_t * identifier_token = expect_and_consume(state, TokenType_Identifier);
-    char* lname = strdup(identifier_token->value);
+    // O ambiente guarda a própria cópia do nome (ver addLabel)
+    char* lname = identifier_token->value;
     if (lname == NULL) VI_EXIT(EXIT_INVALID_ARGUMENT, "%s", "O rotulo eh invalido");
 
     (void) expect_and_consume(state, TokenType_Colon);
@@ -550,7 +551,7 @@ bool parse_statement(ParserState * state) {
     }
 }
 
-void parse(Token_t * tokens, size_t size, Environment * env) {
+void parse_pass(Token_t * tokens, size_t size, Environment * env, bool firstPass) {
     ParserState state = {
         .env = env,
         .tokens = tokens,
@@ -558,21 +559,21 @@ void parse(Token_t * tokens, size_t size, Environment * env) {
         .index = 0
     };
 
-    env->isFirstPass = true;
-    while (state.index < state.size) {
-        if (parse_statement(&state)) {
-            break;
-        };
+    env->isFirstPass = firstPass;
+    if (!firstPass) {
+        env->programCounter = env_params->start_address;
+        env->currentInstruction = 0;
     }
-
-    env->isFirstPass = false;
-    state.index = 0;
-    env->programCounter = env_params->start_address;
-    env->currentInstruction = 0;
     while (state.index < state.size) {
         if (parse_statement(&state)) {
-            return;
+            break;
         };
     }
+}
 
-}
\ No newline at end of file
+void parse(Token_t * tokens, size_t size, Environment * env) {
+    // A primeira passagem só guarda os rótulos (e conta os endereços);
+    // a segunda escreve as instruções na memória
+    parse_pass(tokens, size, env, true);
+    parse_pass(tokens, size, env, false);
+}
@@ -18,4 +18,14 @@
  */
 void parse(Token_t * tokens, size_t size, Environment * env);
 
+/**
+ * Faz só uma das passagens do parser (parse() faz as duas). Serve para
+ * medir cada passagem separadamente.
+ * @param tokens array dos tokens das instruções
+ * @param size tamanho do array de tokens
+ * @param env ambiente do sap2
+ * @param firstPass se é a primeira passagem (que só guarda os rótulos)
+ */
+void parse_pass(Token_t * tokens, size_t size, Environment * env, bool firstPass);
+
 #endif //SAP2_COMPILER_PARSER_H
\ No newline at end of file
@@ -36,9 +36,10 @@ bool validCharForAlpha(char c) {
 /**
  * Retorna o tipo de token que o texto é.
  * @param text o texto que se quer saber o tipo de token
+ * @param diagnostics onde os avisos e erros são impressos
  * @return o tipo de token
  */
-TokenType_t getTypeOfToken(char* text) {
+TokenType_t getTypeOfToken(char* text, diagnostics_t * diagnostics) {
     size_t len = strlen(text);
 
     // Se não tiver tamanho, retorna desconhecido
@@ -93,7 +94,7 @@ TokenType_t getTypeOfToken(char* text) {
     // houver um ponto entre os números), avisa o
     // usuário que o programa só aceita hexadecimal.
     if ( (qntdDigit == len) || (qntdDigit == len-1 && qntdDot == 1) ) {
-        V_EXIT(EXIT_INVALID_ARGUMENT,
+        diagnostics_fatal(diagnostics, EXIT_INVALID_ARGUMENT,
     "O numero \"%s\" foi encontrado.\nNo entanto, apenas hexadecimais sao permitidos.\nNesse programa, hexadecimais sao numeros inteiros\nque terminam com H, como 1234H.",
     text);
     }
@@ -110,7 +111,7 @@ TokenType_t getTypeOfToken(char* text) {
     return TokenType_Unknown;
 }
 
-char* getTokenTypeString(TokenType_t type) {
+char* getTokenTypeString(TokenType_t type, diagnostics_t * diagnostics) {
     switch (type) {
         case TokenType_Register: return "Registador";
         case TokenType_Hexadecimal: return "Hexadecimal";
@@ -123,7 +124,7 @@ char* getTokenTypeString(TokenType_t type) {
         case TokenType_Colon: return "Dois pontos";
         case TokenType_Unknown: return "Desconhecido";
         default: {
-            WARN("Tipo de token indefinido. Valor enum: %d", type);
+            diagnostics_warn(diagnostics, "Tipo de token indefinido. Valor enum: %d", type);
             return "Desconhecido";
         }
     }
@@ -150,15 +151,16 @@ size_t addTokenToArray(Token_t token, Token_t** array, size_t size) {
  * Constrói um token a partir dos valores dados
  * @param type tipo do token
  * @param value texto do token
+ * @param diagnostics onde os avisos e erros são impressos
  * @return o token construído com os valores dados
  */
-Token_t buildToken(TokenType_t type, const char* value) {
+Token_t buildToken(TokenType_t type, const char* value, diagnostics_t * diagnostics) {
     // Clona o texto
     char* copy = NULL;
     if (value != NULL) {
         copy = strdup(value);
         if (copy == NULL) {
-            EXIT_ERR(EXIT_NO_MEMORY);
+            diagnostics_fatal(diagnostics, EXIT_NO_MEMORY, "Erro Interno: %s", EXIT_NO_MEMORY_MESSAGE);
             /*return (Token_t) {
                 .type = TokenType_Unknown,
                 .value = NULL
@@ -175,7 +177,7 @@ Token_t buildToken(TokenType_t type, const char* value) {
 }
 
 
-Token_t getNextToken(FILE* file) {
+Token_t getNextToken(FILE* file, diagnostics_t * diagnostics) {
 
     // Inicializa a string do texto
     char* text = NULL;
@@ -193,7 +195,7 @@ Token_t getNextToken(FILE* file) {
         if (c == EOF) {
             // Se não leu nada de texto, retorna um EOF
             if (text == NULL)
-                return buildToken(TokenType_EOF, "EOF");
+                return buildToken(TokenType_EOF, "EOF", diagnostics);
 
             // Se leu alguma coisa, acaba o loop.
             // Um "HLT" no fim do arquivo chegaria aqui, por exemplo.
@@ -240,15 +242,15 @@ Token_t getNextToken(FILE* file) {
                     // caractere dado for EOF(o que não é no nosso caso)
                     // ou se não houver espaço no buffer de push-back.
                     // Nesse caso, só sai do programa.
-                    EXIT_ERR(EXIT_NO_MEMORY);
+                    diagnostics_fatal(diagnostics, EXIT_NO_MEMORY, "Erro Interno: %s", EXIT_NO_MEMORY_MESSAGE);
                 }
                 // Para o loop para salvar o texto lido
                 break;
             }
             // Se chegou até aqui (não tem texto para salvar),
             // cria um token de vírgula/dois pontos
-            if (c == ',') return buildToken(TokenType_Comma, ",");
-            else return buildToken(TokenType_Colon, ":");
+            if (c == ',') return buildToken(TokenType_Comma, ",", diagnostics);
+            else return buildToken(TokenType_Colon, ":", diagnostics);
         }
 
         int alpha = isalpha(c); // se é um caractere do alfabeto
@@ -258,32 +260,32 @@ Token_t getNextToken(FILE* file) {
         if ( alpha || digit ) {
             textSize = addCharToString(c, &text, textSize);
             if (textSize == -1) {
-                EXIT_ERR(EXIT_NO_MEMORY);
+                diagnostics_fatal(diagnostics, EXIT_NO_MEMORY, "Erro Interno: %s", EXIT_NO_MEMORY_MESSAGE);
                 //return buildToken(TokenType_Unknown, NULL);
             }
         } else {
             // Se o caractere for desconhecido, imprime uma mensagem
             // e pula ele
-            WARN("Caractere invalido: %c", c);
+            diagnostics_warn(diagnostics, "Caractere invalido: %c", c);
             continue;
         }
     } while (c);
 
     // Constrói e retorna o token, além de liberar memória
-    Token_t token = buildToken(getTypeOfToken(text), text);
+    Token_t token = buildToken(getTypeOfToken(text, diagnostics), text, diagnostics);
     free(text);
     return token;
 }
 
-ErrorCode_t tokenize(FILE* file, Token_t** finalTokenArray, size_t* finalSize) {
+ErrorCode_t tokenize(FILE* file, Token_t** finalTokenArray, size_t* finalSize, diagnostics_t * diagnostics) {
     // Se algum dos parâmetros for nulo (não deve acontecer, já
     // que há verificação antes)
     if (file == NULL)
-        RETURN_ERR(EXIT_FILE_NOT_FOUND);
+        diagnostics_fatal(diagnostics, EXIT_FILE_NOT_FOUND, "%s", EXIT_FILE_NOT_FOUND_MESSAGE);
     if (finalTokenArray == NULL)
-        RETURN_CUSTOM_ERR(EXIT_INVALID_ARGUMENT, "Erro interno: o array de tokens eh null");
+        diagnostics_fatal(diagnostics, EXIT_INVALID_ARGUMENT, "Erro Interno: o array de tokens eh null");
     if (finalSize == NULL)
-        RETURN_CUSTOM_ERR(EXIT_INVALID_ARGUMENT, "Erro interno: o endereco do tamanho do array de tokens eh null");
+        diagnostics_fatal(diagnostics, EXIT_INVALID_ARGUMENT, "Erro Interno: o endereco do tamanho do array de tokens eh null");
 
     // Inicializa o vetor de tokens
     Token_t* tokens = NULL;
@@ -294,12 +296,12 @@ ErrorCode_t tokenize(FILE* file, Token_t** finalTokenArray, size_t* finalSize) {
 
     // Obtém os tokens do arquivo
     do {
-        currToken = getNextToken(file);
+        currToken = getNextToken(file, diagnostics);
         // Adiciona o token ao array. Se não conseguir, para
         // de interpretar
         size = addTokenToArray(currToken, &tokens, size);
         if (size == -1)
-            RETURN_ERR(EXIT_NO_MEMORY);
+            diagnostics_fatal(diagnostics, EXIT_NO_MEMORY, "Erro Interno: %s", EXIT_NO_MEMORY_MESSAGE);
     } while (currToken.type != TokenType_EOF);
 
     *finalTokenArray = tokens;
@@ -11,6 +11,7 @@
 #define SAP2_COMPILER_TOKENIZER_H
 
 #include "../ErrorCodes.h"
+#include "../diagnostics.h"
 #include <stdio.h>
 #include <stddef.h>
 
@@ -51,14 +52,16 @@ typedef struct {
  * @param file o texto a ser transformado
  * @param finalTokenArray o endereço do vetor a ser colocado os tokens
  * @param finalSize o endereço da variável que guardará o tamanho do vetor de tokens
+ * @param diagnostics onde os avisos e erros são impressos
  * @return código de erro
  */
-ErrorCode_t tokenize(FILE* file, Token_t** finalTokenArray, size_t* finalSize);
+ErrorCode_t tokenize(FILE* file, Token_t** finalTokenArray, size_t* finalSize, diagnostics_t * diagnostics);
 
 /**
  * Retorna uma string representando o tipo do token
  * @param type tipo do token
+ * @param diagnostics onde os avisos são impressos
  * @return string com o nome do token
  */
-char* getTokenTypeString(TokenType_t type);
+char* getTokenTypeString(TokenType_t type, diagnostics_t * diagnostics);
 #endif //SAP2_COMPILER_TOKENIZER_H
\ No newline at end of file
@@ -0,0 +1,375 @@
+// Executa vários programas (um lote) ao mesmo tempo, cada um
+// no seu próprio ambiente, usando um grupo fixo de threads.
+//
+// Author: André
+// Date: 21/10/2025
+//
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dirent.h>
+    #include <sys/stat.h>
+#endif
+
+#include "batch.h"
+#include "../interpreter.h"
+#include "../Analysis/tokenizer.h"
+#include "../Utils/Utils.h"
+
+// Tamanho máximo de uma linha da lista de programas
+#define BATCH_MAX_LINE 4096
+
+// Fila compartilhada entre as threads de um batch_parallel_for
+typedef struct {
+    size_t count;
+    void (*fn)(void * ctx, size_t i);
+    void * ctx;
+    // Próxima chamada que ainda não foi pega por nenhuma thread
+    atomic_size_t next;
+} batchQueue_t;
+
+/**
+ * Adiciona um programa ao fim do lote
+ * @param batch o lote
+ * @param path caminho do arquivo
+ * @param args parâmetros extras (pode ser NULL)
+ * @param params parâmetros iniciais do programa
+ * @return o código de erro
+ */
+static ErrorCode_t batch_add(batch_t * batch, const char * path, const char * args, const Parametros * params) {
+    batchJob_t * temp = realloc(batch->jobs, sizeof(batchJob_t) * (batch->count + 1));
+    if (temp == NULL)
+        return EXIT_NO_MEMORY;
+    batch->jobs = temp;
+
+    batchJob_t * job = &batch->jobs[batch->count];
+    *job = (batchJob_t) {
+        .path = strdup(path),
+        .args = args != NULL ? strdup(args) : NULL,
+        .params = *params,
+        .exit_code = EXIT_SUCCESS
+    };
+    if (job->path == NULL)
+        return EXIT_NO_MEMORY;
+
+    batch->count++;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Compara dois textos (para o qsort)
+ */
+static int comp_str(const void * a, const void * b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * Retorna se o nome termina com a extensão dos programas do lote
+ * @param name nome do arquivo
+ */
+static bool has_batch_extension(const char * name) {
+    size_t len = strlen(name);
+    size_t ext = strlen(BATCH_FILE_EXTENSION);
+    return len > ext && strcmpi(name + len - ext, BATCH_FILE_EXTENSION) == 0;
+}
+
+/**
+ * Adiciona ao lote todos os programas do diretório dado, em ordem
+ * alfabética.
+ * @return o código de erro (EXIT_FILE_NOT_FOUND se não for um diretório)
+ */
+static ErrorCode_t batch_discover_directory(const char * path, const Parametros * params, batch_t * batch) {
+    char ** names = NULL;
+    size_t count = 0;
+
+    #ifdef _WIN32
+        char pattern[MAX_PATH];
+        snprintf(pattern, sizeof(pattern), "%s\\*", path);
+        WIN32_FIND_DATAA data;
+        HANDLE find = FindFirstFileA(pattern, &data);
+        if (find == INVALID_HANDLE_VALUE)
+            return EXIT_FILE_NOT_FOUND;
+        do {
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY || !has_batch_extension(data.cFileName))
+                continue;
+            char ** temp = realloc(names, sizeof(char *) * (count + 1));
+            if (temp == NULL) break;
+            names = temp;
+            names[count++] = strdup(data.cFileName);
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    #else
+        DIR * dir = opendir(path);
+        if (dir == NULL)
+            return EXIT_FILE_NOT_FOUND;
+        struct dirent * entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (!has_batch_extension(entry->d_name))
+                continue;
+            char ** temp = realloc(names, sizeof(char *) * (count + 1));
+            if (temp == NULL) break;
+            names = temp;
+            names[count++] = strdup(entry->d_name);
+        }
+        closedir(dir);
+    #endif
+
+    qsort(names, count, sizeof(char *), comp_str);
+
+    ErrorCode_t err = EXIT_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        if (err == EXIT_SUCCESS && names[i] != NULL) {
+            char * full = formatString("%s/%s", path, names[i]);
+            err = full != NULL ? batch_add(batch, full, NULL, params) : EXIT_NO_MEMORY;
+            free(full);
+        }
+        free(names[i]);
+    }
+    free(names);
+    return err;
+}
+
+/**
+ * Adiciona ao lote os programas da lista dada (um por linha)
+ * @return o código de erro
+ */
+static ErrorCode_t batch_discover_list(FILE * list, const Parametros * params, batch_t * batch) {
+    char line[BATCH_MAX_LINE];
+    while (fgets(line, sizeof(line), list) != NULL) {
+        // Remove os espaços do começo e do fim
+        char * start = line;
+        while (isspace((unsigned char)*start)) start++;
+        size_t len = strlen(start);
+        while (len > 0 && isspace((unsigned char)start[len - 1])) start[--len] = '\0';
+
+        // Pula linhas vazias e comentários
+        if (len == 0 || start[0] == COMMENT_CHAR)
+            continue;
+
+        // Separa o caminho dos parâmetros
+        char * args = start;
+        while (*args != '\0' && !isspace((unsigned char)*args)) args++;
+        if (*args != '\0') {
+            *args++ = '\0';
+            while (isspace((unsigned char)*args)) args++;
+        }
+
+        ErrorCode_t err = batch_add(batch, start, *args != '\0' ? args : NULL, params);
+        if (err != EXIT_SUCCESS)
+            return err;
+    }
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t batch_discover(const char * path, const Parametros * params, batch_t * batch) {
+    batch->jobs = NULL;
+    batch->count = 0;
+    batch->threads = 0;
+    batch->elapsed_time = 0;
+    batch->input = NULL;
+    batch->inputSize = 0;
+    batch->inputEnd = INPUT_END_ERROR;
+    batch->warningLevel = WARNINGS_FIRST;
+
+    // Tenta como diretório primeiro
+    ErrorCode_t err = batch_discover_directory(path, params, batch);
+    if (err != EXIT_FILE_NOT_FOUND)
+        return err;
+
+    // Se não for um diretório, é uma lista
+    FILE * list = fopen(path, "r");
+    if (list == NULL)
+        return EXIT_FILE_NOT_FOUND;
+    err = batch_discover_list(list, params, batch);
+    fclose(list);
+    return err;
+}
+
+/**
+ * Lê todo o conteúdo de um arquivo temporário
+ * @param f o arquivo
+ * @param size onde o tamanho do conteúdo é guardado
+ * @return o conteúdo (terminado em '\0')
+ */
+static char * read_all(FILE * f, size_t * size) {
+    fflush(f);
+    long len = ftell(f);
+    if (len < 0) len = 0;
+    rewind(f);
+
+    char * content = malloc((size_t)len + 1);
+    if (content == NULL) {
+        *size = 0;
+        return NULL;
+    }
+    *size = fread(content, 1, (size_t)len, f);
+    content[*size] = '\0';
+    return content;
+}
+
+/**
+ * Executa um programa do lote no seu próprio ambiente, guardando
+ * os resultados no próprio programa.
+ * @param batch o lote
+ * @param job o programa
+ */
+static void batch_run_job(const batch_t * batch, batchJob_t * job) {
+    stopWatch_s stopWatch;
+    stopWatch_start(&stopWatch);
+
+    FILE * file = fopen(job->path, "r");
+    if (file == NULL) {
+        job->exit_code = EXIT_FILE_NOT_FOUND;
+        job->output = strdup(EXIT_FILE_NOT_FOUND_MESSAGE);
+        job->outputSize = job->output != NULL ? strlen(job->output) : 0;
+        return;
+    }
+
+    // A saída (e os diagnósticos) ficam guardados em um arquivo
+    // temporário próprio. A entrada é vazia, já que não há terminal
+    // (a não ser que as entradas do lote tenham sido fornecidas).
+    FILE * out = tmpfile();
+    FILE * in = tmpfile();
+    Environment * env = env_create(&job->params, NULL);
+    if (out == NULL || in == NULL || env == NULL) {
+        job->exit_code = EXIT_NO_MEMORY;
+        job->output = strdup(EXIT_NO_MEMORY_MESSAGE);
+        job->outputSize = job->output != NULL ? strlen(job->output) : 0;
+    } else {
+        env->out = out;
+        env->in = in;
+        env->diagnostics.warnings = out;
+        env->diagnostics.errors = out;
+        if (batch->input != NULL)
+            env_set_input(env, batch->input, batch->inputSize);
+        env->inputEnd = batch->inputEnd;
+        env->diagnostics.level = batch->warningLevel;
+
+        job->exit_code = interpret_env(env, file);
+        job->totalInstructions = env->totalInstructions;
+        job->totalTStates = env->totalTStates;
+        job->output = read_all(out, &job->outputSize);
+    }
+
+    env_destroy(env);
+    if (out != NULL) fclose(out);
+    if (in != NULL) fclose(in);
+    fclose(file);
+
+    stopWatch_end(&stopWatch);
+    job->host_time = stopWatch.elapsed_time;
+}
+
+// Thread do grupo: pega a próxima chamada da fila até acabar
+static void * batch_worker(void * arg) {
+    batchQueue_t * queue = arg;
+    size_t i;
+    while ((i = atomic_fetch_add(&queue->next, 1)) < queue->count) {
+        queue->fn(queue->ctx, i);
+    }
+    return NULL;
+}
+
+int batch_parallel_for(size_t count, int threads, void (*fn)(void * ctx, size_t i), void * ctx) {
+    if (threads <= 0)
+        threads = get_core_count();
+    if ((size_t)threads > count)
+        threads = count > 0 ? (int)count : 1;
+
+    batchQueue_t queue = {
+        .count = count,
+        .fn = fn,
+        .ctx = ctx
+    };
+    atomic_init(&queue.next, 0);
+
+    pthread_t * workers = malloc(sizeof(pthread_t) * threads);
+    int started = 0;
+    if (workers != NULL) {
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started], NULL, batch_worker, &queue) != 0)
+                break;
+        }
+    }
+
+    // Se não conseguiu criar nenhuma thread, executa nessa mesma
+    if (started == 0)
+        batch_worker(&queue);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    return started > 0 ? started : 1;
+}
+
+// Executa o i-ésimo programa do lote (se ele ainda não tiver um erro)
+static void batch_run_index(void * ctx, size_t i) {
+    batch_t * batch = ctx;
+    if (batch->jobs[i].exit_code == EXIT_SUCCESS)
+        batch_run_job(batch, &batch->jobs[i]);
+}
+
+void batch_run(batch_t * batch, int threads) {
+    stopWatch_s stopWatch;
+    stopWatch_start(&stopWatch);
+
+    batch->threads = batch_parallel_for(batch->count, threads, batch_run_index, batch);
+
+    stopWatch_end(&stopWatch);
+    batch->elapsed_time = stopWatch.elapsed_time;
+}
+
+void batch_report(batch_t * batch, FILE * f, bool print_outputs) {
+    size_t failures = 0;
+    long totalInstructions = 0;
+
+    fprintf(f, "\nRelatorio do lote ===========================================================\n");
+    fprintf(f, "%-32s | %5s | %12s | %14s | %12s\n",
+        "Programa", "Saida", "Instrucoes", "T. simulado ms", "T. real ms");
+    for (size_t i = 0; i < batch->count; i++) {
+        batchJob_t * job = &batch->jobs[i];
+        // 1 T-State = 1 microssegundo (ver sleep_us)
+        fprintf(f, "%-32s | %5d | %12ld | %14.3f | %12.3f\n",
+            job->path,
+            job->exit_code,
+            job->totalInstructions,
+            (double)job->totalTStates / 1000.0,
+            seg_to_ms(job->host_time));
+
+        if (job->exit_code != EXIT_SUCCESS) failures++;
+        totalInstructions += job->totalInstructions;
+    }
+    fprintf(f, "\nProgramas: %zu (%zu com erro) | Threads: %d | Instrucoes: %ld | Tempo total: %.3f segundos\n",
+        batch->count, failures, batch->threads, totalInstructions, batch->elapsed_time);
+
+    if (!print_outputs)
+        return;
+
+    for (size_t i = 0; i < batch->count; i++) {
+        batchJob_t * job = &batch->jobs[i];
+        fprintf(f, "\n=== %s (Saida de Erro: %d) ===\n", job->path, job->exit_code);
+        if (job->output != NULL)
+            fwrite(job->output, 1, job->outputSize, f);
+        fprintf(f, "\n");
+    }
+}
+
+void batch_free(batch_t * batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        free(batch->jobs[i].path);
+        free(batch->jobs[i].args);
+        free(batch->jobs[i].output);
+    }
+    free(batch->jobs);
+    batch->jobs = NULL;
+    batch->count = 0;
+}
@@ -0,0 +1,109 @@
+// Executa vários programas (um lote) ao mesmo tempo, cada um
+// no seu próprio ambiente, usando um grupo fixo de threads.
+//
+// Author: André
+// Date: 21/10/2025
+//
+
+#ifndef SAP2_COMPILER_BATCH_H
+#define SAP2_COMPILER_BATCH_H
+
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Extensão dos arquivos procurados em um diretório
+#define BATCH_FILE_EXTENSION ".asm"
+
+// Um programa do lote
+typedef struct {
+    // Caminho do arquivo
+    char * path;
+    // Parâmetros extras do programa (texto depois do caminho em uma
+    // lista, como "-lt 500 -li 1000"). NULL se não houver.
+    char * args;
+    // Parâmetros próprios do programa
+    Parametros params;
+
+    // Resultados //
+    // Código de saída (se já houver um erro antes da execução, como um
+    // parâmetro inválido na lista, o programa não é executado)
+    ErrorCode_t exit_code;
+    // Quantidade de instruções executadas
+    long totalInstructions;
+    // Quantidade de T-States simulados
+    uint64_t totalTStates;
+    // Tempo real que demorou (em segundos)
+    double host_time;
+    // Tudo que o programa imprimiu (OUT, memória, avisos e erros)
+    char * output;
+    size_t outputSize;
+} batchJob_t;
+
+// Um lote de programas
+typedef struct {
+    batchJob_t * jobs;
+    size_t count;
+    // Quantidade de threads usadas na execução
+    int threads;
+    // Tempo real que o lote inteiro demorou (em segundos)
+    double elapsed_time;
+    // Entradas do IN que todos os programas usam (NULL se o IN ler a
+    // entrada vazia). Cada programa começa da primeira.
+    const hex1_t * input;
+    size_t inputSize;
+    // O que o IN faz quando as entradas acabam
+    inputEnd_t inputEnd;
+    // Quais avisos são impressos na saída de cada programa
+    warningLevel_t warningLevel;
+} batch_t;
+
+/**
+ * Chama fn(ctx, i) para todo i de 0 até count-1, dividindo as
+ * chamadas entre um grupo fixo de threads. Retorna só depois que
+ * todas as chamadas terminarem.
+ * @param count quantidade de chamadas
+ * @param threads quantidade de threads (0 para a quantidade de núcleos)
+ * @param fn a função chamada
+ * @param ctx dados passados para a função
+ * @return a quantidade de threads usadas
+ */
+int batch_parallel_for(size_t count, int threads, void (*fn)(void * ctx, size_t i), void * ctx);
+
+/**
+ * Encontra os programas do lote. Se o caminho for um diretório, usa
+ * todos os arquivos ".asm" dele (em ordem alfabética). Se for um
+ * arquivo, cada linha não vazia é um programa, no formato
+ * "<arquivo> [parametros]" (linhas que começam com ';' são ignoradas).
+ * @param path o diretório ou a lista
+ * @param params os parâmetros que cada programa recebe inicialmente
+ * @param batch onde os programas encontrados são guardados
+ * @return o código de erro
+ */
+ErrorCode_t batch_discover(const char * path, const Parametros * params, batch_t * batch);
+
+/**
+ * Executa todos os programas do lote, cada um no seu próprio ambiente,
+ * usando um grupo fixo de threads.
+ * @param batch o lote
+ * @param threads quantidade de threads (0 para a quantidade de núcleos)
+ */
+void batch_run(batch_t * batch, int threads);
+
+/**
+ * Imprime o relatório do lote: código de saída, instruções executadas,
+ * tempo simulado e tempo real de cada programa, além da saída de cada um.
+ * @param batch o lote
+ * @param f onde o relatório é impresso
+ * @param print_outputs se a saída de cada programa também deve ser impressa
+ */
+void batch_report(batch_t * batch, FILE * f, bool print_outputs);
+
+/**
+ * Libera os programas do lote
+ * @param batch o lote
+ */
+void batch_free(batch_t * batch);
+
+#endif //SAP2_COMPILER_BATCH_H
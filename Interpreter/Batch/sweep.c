@@ -0,0 +1,206 @@
+// Varredura de entradas: executa o mesmo programa (montado uma
+// vez só) para várias entradas do IN, em paralelo.
+//
+// Author: André
+// Date: 22/10/2025
+//
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sweep.h"
+#include "batch.h"
+#include "../interpreter.h"
+#include "../Analysis/tokenizer.h"
+#include "../Utils/Utils.h"
+
+// Tamanho máximo de uma linha do arquivo de vetores
+#define SWEEP_MAX_LINE 4096
+
+// Dados passados para cada execução
+typedef struct {
+    sweep_t * sweep;
+    const Environment * image;
+} sweepContext_t;
+
+/**
+ * Adiciona um vetor de entrada ao fim da varredura (o vetor
+ * passa a pertencer à varredura)
+ * @return o código de erro
+ */
+static ErrorCode_t sweep_add(sweep_t * sweep, hex1_t * values, size_t size) {
+    sweepRun_t * temp = realloc(sweep->runs, sizeof(sweepRun_t) * (sweep->count + 1));
+    if (temp == NULL)
+        return EXIT_NO_MEMORY;
+    sweep->runs = temp;
+
+    sweep->runs[sweep->count++] = (sweepRun_t) {
+        .values = values,
+        .size = size,
+        .exit_code = EXIT_SUCCESS
+    };
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t sweep_read_vectors(FILE * f, sweep_t * sweep) {
+    char line[SWEEP_MAX_LINE];
+    int nLine = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        nLine++;
+
+        // Pula linhas vazias e comentários
+        char * c = line;
+        while (isspace((unsigned char)*c)) c++;
+        if (*c == '\0' || *c == COMMENT_CHAR)
+            continue;
+
+        hex1_t * values = NULL;
+        size_t size = 0;
+        while (*c != '\0') {
+            // Pula os separadores
+            while (isspace((unsigned char)*c) || *c == ',') c++;
+            if (*c == '\0' || *c == COMMENT_CHAR) break;
+
+            // Lê o hexadecimal
+            char * start = c;
+            while (*c != '\0' && !isspace((unsigned char)*c) && *c != ',') c++;
+            char end = *c;
+            *c = '\0';
+
+            hex1_t value;
+            if (str_to_hex1(start, &value) != EXIT_SUCCESS) {
+                WARN("Linha %d dos vetores de entrada: \"%s\" nao eh um hexadecimal valido (como 12H).", nLine, start);
+                free(values);
+                return EXIT_INVALID_ARGUMENT;
+            }
+            *c = end;
+
+            hex1_t * temp = realloc(values, sizeof(hex1_t) * (size + 1));
+            if (temp == NULL) {
+                free(values);
+                return EXIT_NO_MEMORY;
+            }
+            values = temp;
+            values[size++] = value;
+        }
+
+        if (sweep_add(sweep, values, size) != EXIT_SUCCESS) {
+            free(values);
+            return EXIT_NO_MEMORY;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t sweep_exhaustive(sweep_t * sweep) {
+    for (int i = 0; i < SWEEP_EXHAUSTIVE_SIZE; i++) {
+        hex1_t * value = malloc(sizeof(hex1_t));
+        if (value == NULL)
+            return EXIT_NO_MEMORY;
+        *value = (hex1_t)i;
+        if (sweep_add(sweep, value, 1) != EXIT_SUCCESS) {
+            free(value);
+            return EXIT_NO_MEMORY;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+// Executa a i-ésima execução da varredura
+static void sweep_run_index(void * ctx, size_t i) {
+    sweepContext_t * context = ctx;
+    sweepRun_t * r = &context->sweep->runs[i];
+
+    // A saída e os avisos são descartados: o que importa são
+    // os valores do OUT, que ficam guardados
+    FILE * null = open_null_stream();
+    Environment * env = env_clone(context->image);
+    if (null == NULL || env == NULL) {
+        r->exit_code = EXIT_NO_MEMORY;
+    } else {
+        env->in = null;
+        env->out = null;
+        env->diagnostics.warnings = null;
+        env->diagnostics.errors = null;
+        env->params.hlt_prints_memory = false;
+        env->params.debug_mode = false;
+        env->capturedOutput = &r->output;
+        env_set_input(env, r->values, r->size);
+        env->inputEnd = context->sweep->inputEnd;
+        env->diagnostics.level = context->sweep->warningLevel;
+
+        r->exit_code = run_env(env);
+        memcpy(r->registers, env->registers, sizeof(r->registers));
+        memcpy(r->flags, env->flags, sizeof(r->flags));
+        r->totalInstructions = env->totalInstructions;
+    }
+
+    env_destroy(env);
+    if (null != NULL) fclose(null);
+}
+
+void sweep_run(sweep_t * sweep, const Environment * image, int threads) {
+    stopWatch_s stopWatch;
+    stopWatch_start(&stopWatch);
+
+    sweepContext_t context = {
+        .sweep = sweep,
+        .image = image
+    };
+    sweep->threads = batch_parallel_for(sweep->count, threads, sweep_run_index, &context);
+
+    stopWatch_end(&stopWatch);
+    sweep->elapsed_time = stopWatch.elapsed_time;
+}
+
+/**
+ * Imprime os valores separados por espaço, ocupando pelo menos
+ * "width" caracteres
+ */
+static void print_values(FILE * f, const hex1_t * values, size_t size, int width) {
+    int printed = 0;
+    for (size_t i = 0; i < size; i++) {
+        printed += fprintf(f, i == 0 ? "%02xH" : " %02xH", (uhex1_t)values[i]);
+    }
+    if (size == 0)
+        printed += fprintf(f, "-");
+    if (printed < width)
+        fprintf(f, "%*s", width - printed, "");
+}
+
+void sweep_report(sweep_t * sweep, FILE * f) {
+    fprintf(f, "\nVarredura de entradas =======================================================\n");
+    fprintf(f, "%-20s | %-24s | %-3s | %-3s | %-3s | S | Z | %10s | Saida\n",
+        "Entrada", "Saida (OUT)", "A", "B", "C", "Instrucoes");
+
+    size_t failures = 0;
+    for (size_t i = 0; i < sweep->count; i++) {
+        sweepRun_t * r = &sweep->runs[i];
+        print_values(f, r->values, r->size, 20);
+        fprintf(f, " | ");
+        print_values(f, r->output.values, r->output.count, 24);
+        fprintf(f, " | %02xH | %02xH | %02xH | %d | %d | %10ld | %d\n",
+            (uhex1_t)r->registers[ACCUMULATOR],
+            (uhex1_t)r->registers[REGISTER_B],
+            (uhex1_t)r->registers[REGISTER_C],
+            r->flags[FLAG_S],
+            r->flags[FLAG_Z],
+            r->totalInstructions,
+            r->exit_code);
+        if (r->exit_code != EXIT_SUCCESS) failures++;
+    }
+
+    fprintf(f, "\nExecucoes: %zu (%zu com erro) | Threads: %d | Tempo total: %.3f segundos\n",
+        sweep->count, failures, sweep->threads, sweep->elapsed_time);
+}
+
+void sweep_free(sweep_t * sweep) {
+    for (size_t i = 0; i < sweep->count; i++) {
+        free(sweep->runs[i].values);
+        free(sweep->runs[i].output.values);
+    }
+    free(sweep->runs);
+    sweep->runs = NULL;
+    sweep->count = 0;
+}
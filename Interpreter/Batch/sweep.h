@@ -0,0 +1,91 @@
+// Varredura de entradas: executa o mesmo programa (montado uma
+// vez só) para várias entradas do IN, em paralelo.
+//
+// Author: André
+// Date: 22/10/2025
+//
+
+#ifndef SAP2_COMPILER_SWEEP_H
+#define SAP2_COMPILER_SWEEP_H
+
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade de valores de um byte (varredura completa)
+#define SWEEP_EXHAUSTIVE_SIZE 256
+
+// Uma execução da varredura
+typedef struct {
+    // Entradas usadas pelo IN (em ordem)
+    hex1_t * values;
+    size_t size;
+
+    // Resultados //
+    ErrorCode_t exit_code;
+    // Valores impressos pelo OUT
+    hexBuffer_t output;
+    // Registradores e flags no fim da execução
+    hex1_t registers[NUMBER_OF_REGISTERS];
+    int flags[NUMBER_OF_FLAGS];
+    // Quantidade de instruções executadas
+    long totalInstructions;
+} sweepRun_t;
+
+// Uma varredura
+typedef struct {
+    sweepRun_t * runs;
+    size_t count;
+    // Quantidade de threads usadas na execução
+    int threads;
+    // Tempo real que a varredura inteira demorou (em segundos)
+    double elapsed_time;
+    // O que o IN faz quando as entradas de um vetor acabam
+    inputEnd_t inputEnd;
+    // Quais avisos são guardados em cada execução
+    warningLevel_t warningLevel;
+} sweep_t;
+
+/**
+ * Lê os vetores de entrada do arquivo dado. Cada linha não vazia é
+ * um vetor, com os hexadecimais separados por espaços ou vírgulas
+ * (como "12H 3H"). Linhas que começam com ';' são ignoradas.
+ * @param f o arquivo
+ * @param sweep onde os vetores são guardados
+ * @return o código de erro
+ */
+ErrorCode_t sweep_read_vectors(FILE * f, sweep_t * sweep);
+
+/**
+ * Cria os 256 vetores de um byte só (00H até FFH)
+ * @param sweep onde os vetores são guardados
+ * @return o código de erro
+ */
+ErrorCode_t sweep_exhaustive(sweep_t * sweep);
+
+/**
+ * Executa o programa já montado para cada vetor de entrada. Cada
+ * execução usa uma cópia (env_clone) do ambiente dado, que não é
+ * alterado.
+ * @param sweep a varredura
+ * @param image o ambiente com o programa já montado
+ * @param threads quantidade de threads (0 para a quantidade de núcleos)
+ */
+void sweep_run(sweep_t * sweep, const Environment * image, int threads);
+
+/**
+ * Imprime a tabela da varredura: entrada -> saídas, registradores
+ * e flags finais de cada execução.
+ * @param sweep a varredura
+ * @param f onde a tabela é impressa
+ */
+void sweep_report(sweep_t * sweep, FILE * f);
+
+/**
+ * Libera os vetores e os resultados da varredura
+ * @param sweep a varredura
+ */
+void sweep_free(sweep_t * sweep);
+
+#endif //SAP2_COMPILER_SWEEP_H
@@ -0,0 +1,250 @@
+// Medição do desempenho do montador
+//
+// Author: André
+// Date: 02/11/2025
+//
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asmbench.h"
+#include "../interpreter.h"
+#include "../Analysis/tokenizer.h"
+#include "../Analysis/parser.h"
+#include "../Utils/Utils.h"
+
+// Um pulo a cada JUMP_EVERY linhas de código (em média)
+#define JUMP_EVERY 8
+// Distância máxima (em rótulos) de um pulo para frente
+#define MAX_FORWARD_DISTANCE 32
+
+// Instruções sem rótulo usadas no código gerado
+static const struct {
+    const char * text;
+    int size;
+} INSTRUCTIONS[] = {
+    { "MOV A, B", 1 }, { "MOV B, C", 1 }, { "MOV C, A", 1 }, { "ADD B", 1 },
+    { "SUB C", 1 }, { "INR A", 1 }, { "DCR B", 1 }, { "ANA C", 1 },
+    { "ORA B", 1 }, { "XRA C", 1 }, { "CMA", 1 }, { "RAL", 1 },
+    { "RAR", 1 }, { "NOP", 1 }, { "MVI A, 12H", 2 }, { "MVI B, 0FFH", 2 },
+    { "ANI 0FH", 2 }, { "ORI 0F0H", 2 }, { "XRI 55H", 2 }, { "LDA 9000H", 3 },
+    { "STA 9100H", 3 }
+};
+#define INSTRUCTION_COUNT ((int)(sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0])))
+
+// Pulos (todos com 3 bytes)
+static const char * JUMPS[] = { "JMP", "JNZ", "JZ", "JM", "CALL" };
+#define JUMP_COUNT ((int)(sizeof(JUMPS) / sizeof(JUMPS[0])))
+
+/**
+ * Próximo número pseudoaleatório (xorshift32). Não usa rand() para
+ * que o código gerado seja o mesmo em qualquer sistema.
+ */
+static uint32_t next_random(uint32_t * state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Se o sorteio (de 0 a 99) ficou abaixo da porcentagem
+#define chance(state, percent) ((int)(next_random(state) % 100) < (percent))
+
+ErrorCode_t asmbench_write(const asmSource_t * source, FILE * out) {
+    uint32_t state = source->seed != 0 ? source->seed : 1;
+    // Bytes que ainda cabem na memória (com espaço para o HLT)
+    long budget = (long)MEMORY_SIZE - ASMBENCH_START_ADDRESS - 1;
+    // Rótulos definidos e o maior rótulo usado por um pulo para frente
+    long defined = 0;
+    long highestForward = -1;
+    long constants = 0;
+
+    fprintf(out, "; Codigo gerado para medir o montador (%ld linhas)\n", source->lines);
+    for (long line = 1; line < source->lines; line++) {
+        bool comment = chance(&state, source->commentPercent);
+        bool label = chance(&state, source->labelPercent);
+
+        // Sem espaço na memória: só constantes e comentários
+        if (budget < 3) {
+            if (label)
+                fprintf(out, "K%ld: %02XH\n", constants++, next_random(&state) & 0xFF);
+            else
+                fprintf(out, "; linha %ld: sem espaco na memoria, so comentarios\n", line);
+            continue;
+        }
+
+        // Metade dos comentários ocupa a linha inteira
+        if (comment && (next_random(&state) & 1)) {
+            fprintf(out, "; linha %ld: comentario que o tokenizer precisa pular\n", line);
+            continue;
+        }
+
+        if (label)
+            fprintf(out, "L%ld: ", defined++);
+
+        if (next_random(&state) % JUMP_EVERY == 0) {
+            const char * jump = JUMPS[next_random(&state) % JUMP_COUNT];
+            long target;
+            if (defined == 0 || chance(&state, source->forwardPercent)) {
+                target = defined + (long)(next_random(&state) % MAX_FORWARD_DISTANCE);
+                if (target > highestForward)
+                    highestForward = target;
+            } else {
+                target = (long)(next_random(&state) % defined);
+            }
+            fprintf(out, "%s L%ld", jump, target);
+            budget -= 3;
+        } else {
+            int i = (int)(next_random(&state) % INSTRUCTION_COUNT);
+            fprintf(out, "%s", INSTRUCTIONS[i].text);
+            budget -= INSTRUCTIONS[i].size;
+        }
+        fprintf(out, comment ? " ; comentario depois da instrucao\n" : "\n");
+    }
+
+    // Os rótulos usados mas ainda não definidos ficam no fim
+    for (; defined <= highestForward; defined++)
+        fprintf(out, "L%ld:\n", defined);
+    fprintf(out, "HLT\n");
+
+    if (ferror(out))
+        return EXIT_FILE_NOT_FOUND;
+    return EXIT_SUCCESS;
+}
+
+#ifdef __linux__
+
+/**
+ * Zera o pico de memória do processo (o pico passa a ser a memória atual)
+ */
+static void reset_peak_memory(void) {
+    FILE * file = fopen("/proc/self/clear_refs", "w");
+    if (file == NULL)
+        return;
+    fputs("5", file);
+    fclose(file);
+}
+
+/**
+ * Retorna o pico de memória do processo (em KB, 0 se não conseguir ler)
+ */
+static long read_peak_memory(void) {
+    FILE * file = fopen("/proc/self/status", "r");
+    if (file == NULL)
+        return 0;
+    char line[256];
+    long peak = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            peak = strtol(line + 6, NULL, 10);
+            break;
+        }
+    }
+    fclose(file);
+    return peak;
+}
+
+#else
+
+static void reset_peak_memory(void) {
+}
+
+static long read_peak_memory(void) {
+    return 0;
+}
+
+#endif // __linux__
+
+/**
+ * Conta as linhas do arquivo e volta para o começo dele
+ */
+static long count_lines(FILE * file) {
+    rewind(file);
+    long lines = 0;
+    int c;
+    while ((c = fgetc(file)) != EOF)
+        if (c == '\n')
+            lines++;
+    rewind(file);
+    return lines;
+}
+
+/**
+ * Monta o código, medindo cada etapa. Os tokens ficam em "tokens" para
+ * serem liberados mesmo se houver um erro fatal.
+ */
+static void assemble_measured(Environment * env, FILE * file, Token_t ** tokens, size_t * size,
+                              asmBenchResult_t * result) {
+    stopWatch_s stopWatch;
+
+    stopWatch_start(&stopWatch);
+    result->exitCode = tokenize(file, tokens, size, &env->diagnostics);
+    stopWatch_end(&stopWatch);
+    result->tokenizeSeconds = stopWatch.elapsed_time;
+    if (result->exitCode != EXIT_SUCCESS)
+        return;
+    result->tokens = *size;
+
+    stopWatch_start(&stopWatch);
+    parse_pass(*tokens, *size, env, true);
+    stopWatch_end(&stopWatch);
+    result->pass1Seconds = stopWatch.elapsed_time;
+
+    stopWatch_start(&stopWatch);
+    parse_pass(*tokens, *size, env, false);
+    stopWatch_end(&stopWatch);
+    result->pass2Seconds = stopWatch.elapsed_time;
+}
+
+ErrorCode_t asmbench_measure(const asmSource_t * source, asmBenchResult_t * result) {
+    memset(result, 0, sizeof(asmBenchResult_t));
+
+    FILE * file = tmpfile();
+    if (file == NULL)
+        return EXIT_FILE_NOT_FOUND;
+    ErrorCode_t err = asmbench_write(source, file);
+    if (err != EXIT_SUCCESS) {
+        fclose(file);
+        return err;
+    }
+    result->bytes = ftell(file);
+    result->lines = count_lines(file);
+
+    Parametros * params = get_standard_parameters();
+    params->start_address = ASMBENCH_START_ADDRESS;
+    Environment * env = env_create(params, NULL);
+    free(params);
+    if (env == NULL) {
+        fclose(file);
+        return EXIT_NO_MEMORY;
+    }
+
+    Token_t * tokens = NULL;
+    size_t size = 0;
+    reset_peak_memory();
+
+    // Um erro fatal na montagem só encerra a medição
+    jmp_buf on_fatal;
+    int code = setjmp(on_fatal);
+    if (code == 0) {
+        env->diagnostics.on_fatal = &on_fatal;
+        assemble_measured(env, file, &tokens, &size, result);
+    } else {
+        result->exitCode = (ErrorCode_t)code;
+    }
+    env->diagnostics.on_fatal = NULL;
+
+    result->peakKb = read_peak_memory();
+    result->labels = env->symbolCount;
+    result->programBytes = (long)env->programCounter - ASMBENCH_START_ADDRESS;
+
+    for (size_t i = 0; i < size; i++)
+        free(tokens[i].value);
+    free(tokens);
+    env_destroy(env);
+    fclose(file);
+    return result->exitCode;
+}
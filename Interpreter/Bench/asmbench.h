@@ -0,0 +1,75 @@
+// Medição do desempenho do montador: gera códigos grandes (de mil a um
+// milhão de linhas) e mede separadamente o tokenizer e as duas passagens
+// do parser, em linhas e bytes por segundo, e o pico de memória.
+//
+// Como o programa do SAP2 precisa caber na memória (64 KB), as linhas que
+// passariam do limite viram constantes ("NOME: 12H") e comentários, que
+// também passam pelo tokenizer e pela tabela de símbolos.
+//
+// Author: André
+// Date: 02/11/2025
+//
+
+#ifndef SAP2_COMPILER_ASMBENCH_H
+#define SAP2_COMPILER_ASMBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Endereço do começo do código gerado
+#define ASMBENCH_START_ADDRESS 0x0800
+
+// Como o código é gerado
+typedef struct {
+    // Quantidade de linhas
+    long lines;
+    // Porcentagem das linhas com rótulo
+    int labelPercent;
+    // Porcentagem das linhas que são (ou têm) comentários
+    int commentPercent;
+    // Porcentagem dos pulos para rótulos ainda não definidos
+    int forwardPercent;
+    // Semente dos números pseudoaleatórios (o mesmo código sai da mesma semente)
+    uint32_t seed;
+} asmSource_t;
+
+// Resultado da montagem de um código gerado
+typedef struct {
+    ErrorCode_t exitCode;
+    // Linhas e bytes do código
+    long lines;
+    long bytes;
+    // Tokens, rótulos e bytes do programa montado
+    size_t tokens;
+    size_t labels;
+    long programBytes;
+    // Tempos (em segundos)
+    double tokenizeSeconds;
+    double pass1Seconds;
+    double pass2Seconds;
+    // Pico de memória do processo durante a montagem (em KB, 0 se não
+    // for possível medir)
+    long peakKb;
+} asmBenchResult_t;
+
+/**
+ * Escreve um código gerado
+ * @param source como o código é gerado
+ * @param out onde o código é escrito
+ * @return o código de erro
+ */
+ErrorCode_t asmbench_write(const asmSource_t * source, FILE * out);
+
+/**
+ * Gera o código e mede a montagem dele (tokenizer, primeira e segunda
+ * passagem do parser)
+ * @param source como o código é gerado
+ * @param result onde o resultado é guardado
+ * @return o código de erro
+ */
+ErrorCode_t asmbench_measure(const asmSource_t * source, asmBenchResult_t * result);
+
+#endif //SAP2_COMPILER_ASMBENCH_H
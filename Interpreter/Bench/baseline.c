@@ -0,0 +1,455 @@
+// Bases de desempenho (arquivos JSON do sap2_bench)
+//
+// Author: André
+// Date: 03/11/2025
+//
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "baseline.h"
+
+ErrorCode_t baseline_add(baseline_t * baseline, const char * name, const char * metric,
+                         double median, double p10, double p90, bool higherIsBetter,
+                         const double * samples, size_t sampleCount) {
+    double * copy = NULL;
+    if (samples != NULL && sampleCount > 0) {
+        copy = malloc(sizeof(double) * sampleCount);
+        if (copy == NULL)
+            return EXIT_NO_MEMORY;
+        memcpy(copy, samples, sizeof(double) * sampleCount);
+    }
+    baselineEntry_t * temp = realloc(baseline->entries, sizeof(baselineEntry_t) * (baseline->count + 1));
+    if (temp == NULL) {
+        free(copy);
+        return EXIT_NO_MEMORY;
+    }
+    baseline->entries = temp;
+
+    baselineEntry_t * entry = &baseline->entries[baseline->count++];
+    memset(entry, 0, sizeof(baselineEntry_t));
+    entry->samples = copy;
+    entry->sampleCount = copy != NULL ? sampleCount : 0;
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    snprintf(entry->metric, sizeof(entry->metric), "%s", metric);
+    entry->median = median;
+    entry->p10 = p10 < p90 ? p10 : p90;
+    entry->p90 = p10 < p90 ? p90 : p10;
+    entry->higherIsBetter = higherIsBetter;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Escreve um texto entre aspas, com os caracteres especiais do JSON
+ */
+static void write_string(FILE * out, const char * text) {
+    fputc('"', out);
+    for (const char * c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\')
+            fprintf(out, "\\%c", *c);
+        else if ((unsigned char)*c < 0x20)
+            fprintf(out, "\\u%04x", (unsigned char)*c);
+        else
+            fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+ErrorCode_t baseline_save(const baseline_t * baseline, const char * path) {
+    FILE * out = fopen(path, "w");
+    if (out == NULL)
+        return EXIT_FILE_NOT_FOUND;
+
+    fprintf(out, "{\n  \"versao\": %d,\n  \"repeticoes\": %d,\n  \"resultados\": [\n",
+        BASELINE_VERSION, baseline->runs);
+    for (size_t i = 0; i < baseline->count; i++) {
+        const baselineEntry_t * entry = &baseline->entries[i];
+        fprintf(out, "    { \"nome\": ");
+        write_string(out, entry->name);
+        fprintf(out, ", \"medida\": ");
+        write_string(out, entry->metric);
+        fprintf(out, ", \"mediana\": %.9g, \"p10\": %.9g, \"p90\": %.9g, \"maior_melhor\": %s",
+            entry->median, entry->p10, entry->p90, entry->higherIsBetter ? "true" : "false");
+        if (entry->sampleCount > 0) {
+            fprintf(out, ",\n      \"amostras\": [");
+            for (size_t s = 0; s < entry->sampleCount; s++)
+                fprintf(out, s == 0 ? "%.9g" : ", %.9g", entry->samples[s]);
+            fprintf(out, "]");
+        }
+        fprintf(out, " }%s\n", i + 1 < baseline->count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    ErrorCode_t err = ferror(out) ? EXIT_FILE_NOT_FOUND : EXIT_SUCCESS;
+    if (fclose(out) != 0)
+        err = EXIT_FILE_NOT_FOUND;
+    return err;
+}
+
+// Leitura do JSON //
+// Só o necessário para ler os arquivos gravados por baseline_save():
+// objetos, listas, textos, números e true/false.
+
+typedef struct {
+    const char * text;
+    size_t position;
+} reader_t;
+
+static void skip_spaces(reader_t * reader) {
+    while (isspace((unsigned char)reader->text[reader->position]))
+        reader->position++;
+}
+
+/**
+ * Consome o caractere esperado (depois dos espaços)
+ * @return se o caractere era o esperado
+ */
+static bool expect_char(reader_t * reader, char c) {
+    skip_spaces(reader);
+    if (reader->text[reader->position] != c)
+        return false;
+    reader->position++;
+    return true;
+}
+
+/**
+ * Lê um texto entre aspas
+ * @return se conseguiu ler
+ */
+static bool read_string(reader_t * reader, char * buffer, size_t size) {
+    if (!expect_char(reader, '"'))
+        return false;
+    size_t length = 0;
+    for (;;) {
+        char c = reader->text[reader->position++];
+        if (c == '\0')
+            return false;
+        if (c == '"')
+            break;
+        if (c == '\\') {
+            c = reader->text[reader->position++];
+            if (c == 'u') {
+                char hex[5] = { 0 };
+                strncpy(hex, reader->text + reader->position, 4);
+                reader->position += strlen(hex);
+                c = (char)strtol(hex, NULL, 16);
+            } else if (c == 'n') {
+                c = '\n';
+            } else if (c == 't') {
+                c = '\t';
+            } else if (c == '\0') {
+                return false;
+            }
+        }
+        if (length + 1 < size)
+            buffer[length++] = c;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
+/**
+ * Lê um número
+ * @return se conseguiu ler
+ */
+static bool read_number(reader_t * reader, double * value) {
+    skip_spaces(reader);
+    char * end = NULL;
+    *value = strtod(reader->text + reader->position, &end);
+    if (end == reader->text + reader->position)
+        return false;
+    reader->position = end - reader->text;
+    return true;
+}
+
+/**
+ * Lê true ou false
+ * @return se conseguiu ler
+ */
+static bool read_bool(reader_t * reader, bool * value) {
+    skip_spaces(reader);
+    if (strncmp(reader->text + reader->position, "true", 4) == 0) {
+        *value = true;
+        reader->position += 4;
+        return true;
+    }
+    if (strncmp(reader->text + reader->position, "false", 5) == 0) {
+        *value = false;
+        reader->position += 5;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Lê uma lista de números ([1.5, 2, ...]), guardada em uma memória nova
+ * @return se conseguiu ler
+ */
+static bool read_numbers(reader_t * reader, double ** values, size_t * count) {
+    if (!expect_char(reader, '['))
+        return false;
+    if (expect_char(reader, ']'))
+        return true;
+    do {
+        double value;
+        if (!read_number(reader, &value))
+            return false;
+        double * temp = realloc(*values, sizeof(double) * (*count + 1));
+        if (temp == NULL)
+            return false;
+        *values = temp;
+        (*values)[(*count)++] = value;
+    } while (expect_char(reader, ','));
+    return expect_char(reader, ']');
+}
+
+/**
+ * Lê um resultado ({ "nome": ..., "medida": ..., ... }). As amostras
+ * ficam em uma memória nova, mesmo se não conseguir ler.
+ * @return se conseguiu ler
+ */
+static bool read_entry(reader_t * reader, baselineEntry_t * entry) {
+    memset(entry, 0, sizeof(baselineEntry_t));
+    entry->higherIsBetter = true;
+    if (!expect_char(reader, '{'))
+        return false;
+    if (expect_char(reader, '}'))
+        return true;
+    do {
+        char key[BASELINE_METRIC_SIZE];
+        if (!read_string(reader, key, sizeof(key)) || !expect_char(reader, ':'))
+            return false;
+        bool ok;
+        if (strcmp(key, "nome") == 0)
+            ok = read_string(reader, entry->name, sizeof(entry->name));
+        else if (strcmp(key, "medida") == 0)
+            ok = read_string(reader, entry->metric, sizeof(entry->metric));
+        else if (strcmp(key, "mediana") == 0)
+            ok = read_number(reader, &entry->median);
+        else if (strcmp(key, "p10") == 0)
+            ok = read_number(reader, &entry->p10);
+        else if (strcmp(key, "p90") == 0)
+            ok = read_number(reader, &entry->p90);
+        else if (strcmp(key, "maior_melhor") == 0)
+            ok = read_bool(reader, &entry->higherIsBetter);
+        else if (strcmp(key, "amostras") == 0)
+            ok = read_numbers(reader, &entry->samples, &entry->sampleCount);
+        else
+            ok = false;
+        if (!ok)
+            return false;
+    } while (expect_char(reader, ','));
+    return expect_char(reader, '}');
+}
+
+/**
+ * Lê o arquivo inteiro
+ * @return o conteúdo (terminado em '\0', NULL se não conseguir)
+ */
+static char * read_file(const char * path) {
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+    char * text = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        rewind(file);
+        text = size >= 0 ? malloc(size + 1) : NULL;
+        if (text != NULL) {
+            size_t read = fread(text, 1, size, file);
+            text[read] = '\0';
+        }
+    }
+    fclose(file);
+    return text;
+}
+
+ErrorCode_t baseline_load(baseline_t * baseline, const char * path) {
+    memset(baseline, 0, sizeof(baseline_t));
+    char * text = read_file(path);
+    if (text == NULL)
+        return EXIT_FILE_NOT_FOUND;
+
+    reader_t reader = { text, 0 };
+    ErrorCode_t err = EXIT_SUCCESS;
+    if (!expect_char(&reader, '{'))
+        err = EXIT_INVALID_ARGUMENT;
+    while (err == EXIT_SUCCESS) {
+        char key[BASELINE_METRIC_SIZE];
+        double number;
+        if (!read_string(&reader, key, sizeof(key)) || !expect_char(&reader, ':')) {
+            err = EXIT_INVALID_ARGUMENT;
+            break;
+        }
+        if (strcmp(key, "resultados") == 0) {
+            if (!expect_char(&reader, '[')) {
+                err = EXIT_INVALID_ARGUMENT;
+                break;
+            }
+            if (!expect_char(&reader, ']')) {
+                do {
+                    baselineEntry_t entry;
+                    bool ok = read_entry(&reader, &entry);
+                    if (ok)
+                        err = baseline_add(baseline, entry.name, entry.metric, entry.median, entry.p10,
+                            entry.p90, entry.higherIsBetter, entry.samples, entry.sampleCount);
+                    free(entry.samples);
+                    if (!ok) {
+                        err = EXIT_INVALID_ARGUMENT;
+                        break;
+                    }
+                } while (err == EXIT_SUCCESS && expect_char(&reader, ','));
+                if (err == EXIT_SUCCESS && !expect_char(&reader, ']'))
+                    err = EXIT_INVALID_ARGUMENT;
+            }
+        } else if (read_number(&reader, &number)) {
+            if (strcmp(key, "versao") == 0 && ((int)number < 1 || (int)number > BASELINE_VERSION))
+                err = EXIT_INVALID_ARGUMENT;
+            else if (strcmp(key, "repeticoes") == 0)
+                baseline->runs = (int)number;
+        } else {
+            err = EXIT_INVALID_ARGUMENT;
+        }
+        if (err != EXIT_SUCCESS || !expect_char(&reader, ','))
+            break;
+    }
+    if (err == EXIT_SUCCESS && !expect_char(&reader, '}'))
+        err = EXIT_INVALID_ARGUMENT;
+
+    free(text);
+    if (err != EXIT_SUCCESS)
+        baseline_free(baseline);
+    return err;
+}
+
+/**
+ * Procura o resultado com o mesmo nome e medida
+ * @return o resultado (NULL se não houver)
+ */
+static const baselineEntry_t * find_entry(const baseline_t * baseline, const baselineEntry_t * key) {
+    for (size_t i = 0; i < baseline->count; i++)
+        if (strcmp(baseline->entries[i].name, key->name) == 0
+            && strcmp(baseline->entries[i].metric, key->metric) == 0)
+            return &baseline->entries[i];
+    return NULL;
+}
+
+static int compare_doubles(const void * a, const void * b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Teste de Mann-Whitney (aproximação normal, com a correção dos empates):
+ * a chance de as amostras "now" serem pelo menos tão piores que as da base
+ * quanto foram, se as duas medições tivessem a mesma distribuição.
+ * @return o valor p (1 se não for possível calcular)
+ */
+static double mann_whitney_worse(const baselineEntry_t * before, const baselineEntry_t * now) {
+    size_t n = now->sampleCount, m = before->sampleCount;
+    if (n == 0 || m == 0)
+        return 1.0;
+
+    // U: pares (atual, base) em que a atual é pior (empates contam meio)
+    double u = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < m; j++) {
+            double x = now->samples[i], y = before->samples[j];
+            if (x == y)
+                u += 0.5;
+            else if (now->higherIsBetter ? x < y : x > y)
+                u += 1;
+        }
+
+    // Correção da variância pelos grupos de valores iguais
+    size_t total = n + m;
+    double * all = malloc(sizeof(double) * total);
+    if (all == NULL)
+        return 1.0;
+    memcpy(all, now->samples, sizeof(double) * n);
+    memcpy(all + n, before->samples, sizeof(double) * m);
+    qsort(all, total, sizeof(double), compare_doubles);
+    double ties = 0;
+    for (size_t i = 0; i < total;) {
+        size_t j = i;
+        while (j < total && all[j] == all[i])
+            j++;
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+    free(all);
+
+    double mean = (double)n * (double)m / 2.0;
+    double variance = (double)n * (double)m / 12.0
+        * ((double)(total + 1) - ties / ((double)total * (double)(total - 1)));
+    if (variance <= 0)
+        return 1.0;
+    // Correção de continuidade
+    double z = (u - mean - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+int baseline_compare(const baseline_t * base, const baseline_t * current, double noisePercent, FILE * out) {
+    int regressions = 0;
+    fprintf(out, "Comparacao com a base (ruido aceito: %.1f%%)\n\n", noisePercent);
+    fprintf(out, "%-32s| %-13s| %-12s| %-12s| %-9s| %-8s| %s\n",
+        "Programa", "Medida", "Base", "Atual", "Variacao", "p", "Resultado");
+
+    for (size_t i = 0; i < current->count; i++) {
+        const baselineEntry_t * now = &current->entries[i];
+        const baselineEntry_t * before = find_entry(base, now);
+        if (before == NULL) {
+            fprintf(out, "%-32s| %-13s| %-12s| %-12.6g| %-9s| %-8s| nova\n",
+                now->name, now->metric, "-", now->median, "-", "-");
+            continue;
+        }
+
+        double change = before->median != 0 ? (now->median - before->median) / before->median * 100.0 : 0.0;
+        // Variação no sentido de "melhor" (positiva se melhorou)
+        double gain = now->higherIsBetter ? change : -change;
+        // Se a diferença não é só ruído: pelo teste das amostras ou, se a
+        // base não tiver as amostras, se as repetições não se sobrepõem
+        bool tested = before->sampleCount > 0 && now->sampleCount > 0;
+        double p = 1.0;
+        bool worse, better;
+        if (tested) {
+            p = gain < 0 ? mann_whitney_worse(before, now) : mann_whitney_worse(now, before);
+            worse = better = p < BASELINE_ALPHA;
+        } else {
+            worse = better = now->p90 < before->p10 || now->p10 > before->p90;
+        }
+
+        const char * verdict = "igual (dentro do ruido)";
+        if (gain < -noisePercent && worse) {
+            verdict = "REGRESSAO";
+            regressions++;
+        } else if (gain > noisePercent && better) {
+            verdict = "melhorou";
+        }
+        char pText[16] = "-";
+        if (tested)
+            snprintf(pText, sizeof(pText), "%.4f", p);
+        fprintf(out, "%-32s| %-13s| %-12.6g| %-12.6g| %+-9.1f| %-8s| %s\n",
+            now->name, now->metric, before->median, now->median, change, pText, verdict);
+    }
+
+    for (size_t i = 0; i < base->count; i++)
+        if (find_entry(current, &base->entries[i]) == NULL)
+            fprintf(out, "%-32s| %-13s| %-12.6g| %-12s| %-9s| %-8s| nao medida\n",
+                base->entries[i].name, base->entries[i].metric, base->entries[i].median, "-", "-", "-");
+
+    fprintf(out, "\nRegressoes: %d\n", regressions);
+    return regressions;
+}
+
+void baseline_free(baseline_t * baseline) {
+    for (size_t i = 0; i < baseline->count; i++)
+        free(baseline->entries[i].samples);
+    free(baseline->entries);
+    baseline->entries = NULL;
+    baseline->count = 0;
+}
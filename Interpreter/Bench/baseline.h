@@ -0,0 +1,118 @@
+// Bases de desempenho: guarda os resultados do sap2_bench (MIPS dos
+// programas, velocidade da montagem, pico de memória) em um arquivo JSON
+// e compara uma medição nova com a base, apontando as regressões que
+// passam do ruído da medição.
+//
+// Formato do arquivo:
+//     {
+//       "versao": 2,
+//       "repeticoes": 7,
+//       "resultados": [
+//         { "nome": "programa/laco_dcr_jnz", "medida": "mips", "mediana": 7.48,
+//           "p10": 7.45, "p90": 7.51, "maior_melhor": true,
+//           "amostras": [7.45, 7.47, 7.48, 7.48, 7.49, 7.50, 7.51] },
+//         ...
+//       ]
+//     }
+// As bases da versão 1 (sem as amostras) ainda são lidas.
+//
+// Author: André
+// Date: 03/11/2025
+//
+
+#ifndef SAP2_COMPILER_BASELINE_H
+#define SAP2_COMPILER_BASELINE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../ErrorCodes.h"
+
+// Versão do formato do arquivo
+#define BASELINE_VERSION 2
+// Nível de significância do teste de Mann-Whitney: uma diferença só conta
+// se a chance de ela ser só ruído for menor que isso
+#define BASELINE_ALPHA 0.01
+// Tamanho máximo dos nomes (com o '\0')
+#define BASELINE_NAME_SIZE 128
+#define BASELINE_METRIC_SIZE 32
+
+// Um resultado (uma medida de um programa)
+typedef struct {
+    // Programa medido (ex.: "programa/laco_dcr_jnz", "exemplo/Delay.asm")
+    char name[BASELINE_NAME_SIZE];
+    // O que foi medido (ex.: "mips", "linhas_por_s", "pico_kb")
+    char metric[BASELINE_METRIC_SIZE];
+    // Mediana e percentis 10 e 90 das repetições (p10 <= mediana <= p90)
+    double median;
+    double p10;
+    double p90;
+    // Se um valor maior é melhor (MIPS) ou pior (memória)
+    bool higherIsBetter;
+    // Valor de cada repetição (NULL se a base não tiver as amostras)
+    double * samples;
+    size_t sampleCount;
+} baselineEntry_t;
+
+// Resultados de uma medição
+typedef struct {
+    baselineEntry_t * entries;
+    size_t count;
+    // Repetições de cada medida
+    int runs;
+} baseline_t;
+
+/**
+ * Adiciona um resultado
+ * @param baseline os resultados
+ * @param name o programa medido
+ * @param metric o que foi medido
+ * @param median a mediana
+ * @param p10 o percentil 10
+ * @param p90 o percentil 90
+ * @param higherIsBetter se um valor maior é melhor
+ * @param samples o valor de cada repetição (são copiados, NULL se não houver)
+ * @param sampleCount a quantidade de repetições
+ * @return o código de erro
+ */
+ErrorCode_t baseline_add(baseline_t * baseline, const char * name, const char * metric,
+                         double median, double p10, double p90, bool higherIsBetter,
+                         const double * samples, size_t sampleCount);
+
+/**
+ * Grava os resultados em um arquivo JSON
+ * @param baseline os resultados
+ * @param path o caminho do arquivo
+ * @return o código de erro
+ */
+ErrorCode_t baseline_save(const baseline_t * baseline, const char * path);
+
+/**
+ * Lê os resultados de um arquivo gravado por baseline_save()
+ * @param baseline onde os resultados são guardados (vazio antes)
+ * @param path o caminho do arquivo
+ * @return o código de erro
+ */
+ErrorCode_t baseline_load(baseline_t * baseline, const char * path);
+
+/**
+ * Compara a medição atual com a base e imprime cada medida. Uma medida é
+ * uma regressão se a mediana piorou mais que o ruído aceito e se o teste
+ * de Mann-Whitney das repetições diz que a piora não é só ruído (p menor
+ * que BASELINE_ALPHA). Se a base não tiver as amostras, as repetições
+ * das duas medições não podem se sobrepor (pelos percentis).
+ * @param base a base
+ * @param current a medição atual
+ * @param noisePercent a variação aceita como ruído (em %)
+ * @param out onde a comparação é impressa
+ * @return a quantidade de regressões
+ */
+int baseline_compare(const baseline_t * base, const baseline_t * current, double noisePercent, FILE * out);
+
+/**
+ * Libera os resultados
+ * @param baseline os resultados
+ */
+void baseline_free(baseline_t * baseline);
+
+#endif //SAP2_COMPILER_BASELINE_H
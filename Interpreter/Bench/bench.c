@@ -0,0 +1,161 @@
+// Medição de desempenho do interpretador
+//
+// Author: André
+// Date: 31/10/2025
+//
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../Runtime/evaluate.h"
+#include "../Utils/Utils.h"
+
+ErrorCode_t bench_evaluate(Environment * env, benchResult_t * result) {
+    memset(result, 0, sizeof(benchResult_t));
+    env_params->paced = false;
+    counters_open(&result->counters);
+    uint64_t instructions = (uint64_t)env->totalInstructions;
+    uint64_t tstates = env->totalTStates;
+
+    stopWatch_s stopWatch;
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    ErrorCode_t err;
+    stopWatch_start(&stopWatch);
+    counters_start(&result->counters);
+    int code = setjmp(on_fatal);
+    if (code == 0) {
+        env->diagnostics.on_fatal = &on_fatal;
+        err = evaluate(env);
+    } else {
+        err = (ErrorCode_t)code;
+    }
+    counters_stop(&result->counters);
+    stopWatch_end(&stopWatch);
+    env->diagnostics.on_fatal = previous;
+    counters_close(&result->counters);
+
+    result->exitCode = err;
+    result->instructions = (uint64_t)env->totalInstructions - instructions;
+    result->tstates = env->totalTStates - tstates;
+    result->seconds = stopWatch.elapsed_time;
+    return err;
+}
+
+// Uma medição: uma ou mais execuções do programa
+typedef struct {
+    benchResult_t total;
+    int executions;
+} benchSample_t;
+
+static int compare_samples(const void * a, const void * b) {
+    const benchSample_t * x = a;
+    const benchSample_t * y = b;
+    // Pelo tempo de uma execução (a ordem do MIPS é a inversa)
+    double tx = x->total.seconds / x->executions;
+    double ty = y->total.seconds / y->executions;
+    return tx < ty ? -1 : tx > ty;
+}
+
+static double sample_mips(const benchSample_t * sample) {
+    const benchResult_t * total = &sample->total;
+    return total->seconds > 0 ? (double)total->instructions / total->seconds / 1e6 : 0.0;
+}
+
+/**
+ * Executa o programa até somar "minSeconds" de execução
+ * @return o código de saída (o primeiro que não for sucesso)
+ */
+static ErrorCode_t measure_sample(const Environment * image, FILE * null_stream, double minSeconds,
+                                  benchSample_t * sample, ErrorCode_t * exitCode) {
+    memset(sample, 0, sizeof(benchSample_t));
+    do {
+        Environment * env = env_clone(image);
+        if (env == NULL)
+            return EXIT_NO_MEMORY;
+        env->out = null_stream;
+        env->diagnostics.warnings = null_stream;
+        env->diagnostics.errors = null_stream;
+        benchResult_t result;
+        ErrorCode_t exit_code = bench_evaluate(env, &result);
+        env_destroy(env);
+
+        // Programas que não terminam param no limite de instruções
+        if (exit_code == EXIT_INSTRUCTION_LIMIT_REACHED)
+            exit_code = EXIT_SUCCESS;
+        *exitCode = exit_code;
+        if (exit_code != EXIT_SUCCESS)
+            return exit_code;
+
+        benchResult_t * total = &sample->total;
+        total->instructions += result.instructions;
+        total->tstates += result.tstates;
+        total->seconds += result.seconds;
+        total->counters.error = result.counters.error;
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            total->counters.available[c] = result.counters.available[c];
+            total->counters.values[c] += result.counters.values[c];
+        }
+        sample->executions++;
+    } while (sample->total.seconds < minSeconds);
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t bench_measure(const Environment * image, int warmup, int runs, double minSeconds,
+                          double * samples, benchSummary_t * summary) {
+    memset(summary, 0, sizeof(benchSummary_t));
+    if (runs < 1)
+        runs = 1;
+    benchSample_t * results = calloc(runs, sizeof(benchSample_t));
+    FILE * null_stream = open_null_stream();
+    if (results == NULL || null_stream == NULL) {
+        free(results);
+        if (null_stream != NULL)
+            fclose(null_stream);
+        return EXIT_NO_MEMORY;
+    }
+
+    ErrorCode_t err = EXIT_SUCCESS;
+    for (int i = 0; i < warmup + runs && err == EXIT_SUCCESS; i++) {
+        benchSample_t sample;
+        err = measure_sample(image, null_stream, minSeconds, &sample, &summary->exitCode);
+        if (err == EXIT_SUCCESS && i >= warmup)
+            results[i - warmup] = sample;
+    }
+
+    if (err == EXIT_SUCCESS) {
+        if (samples != NULL)
+            for (int i = 0; i < runs; i++)
+                samples[i] = sample_mips(&results[i]);
+
+        qsort(results, runs, sizeof(benchSample_t), compare_samples);
+        const benchSample_t * median = &results[runs / 2];
+        summary->runs = runs;
+        summary->executions = median->executions;
+        summary->instructions = median->total.instructions / median->executions;
+        summary->medianSeconds = median->total.seconds / median->executions;
+        summary->medianMips = sample_mips(median);
+        summary->p10Mips = sample_mips(&results[(runs - 1) * 9 / 10]);
+        summary->p90Mips = sample_mips(&results[(runs - 1) / 10]);
+        summary->minMips = sample_mips(&results[runs - 1]);
+        summary->maxMips = sample_mips(&results[0]);
+        summary->counters = median->total.counters;
+    }
+
+    fclose(null_stream);
+    free(results);
+    return err;
+}
+
+void bench_print(const benchResult_t * result, FILE * out) {
+    fprintf(out, "\n\nDesempenho ================================\n");
+    fprintf(out, "%-26s: %llu\n", "Instrucoes do SAP2", (unsigned long long)result->instructions);
+    fprintf(out, "%-26s: %llu\n", "T-States", (unsigned long long)result->tstates);
+    fprintf(out, "%-26s: %.6f segundos\n", "Tempo da execucao", result->seconds);
+    if (result->seconds > 0)
+        fprintf(out, "%-26s: %.2f\n", "MIPS do SAP2", (double)result->instructions / result->seconds / 1e6);
+    counters_print(&result->counters, result->instructions, out);
+    fflush(out);
+}
@@ -0,0 +1,97 @@
+// Medição de desempenho do interpretador: executa um programa já montado
+// o mais rápido possível (sem esperar o tempo dos T-States) e mede o
+// tempo e os contadores de hardware (ver Profiler/counters.h) só em
+// volta da execução, sem a montagem nem a impressão da memória.
+//
+// Author: André
+// Date: 31/10/2025
+//
+
+#ifndef SAP2_COMPILER_BENCH_H
+#define SAP2_COMPILER_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+#include "../Profiler/counters.h"
+
+// Tempo mínimo de cada medição (em segundos). Os programas curtos são
+// executados várias vezes na mesma medição, para que o tempo medido não
+// seja só o ruído do relógio.
+#define BENCH_MIN_SAMPLE_SECONDS 0.05
+
+// Resultado de uma medição
+typedef struct {
+    // Código de saída da execução
+    ErrorCode_t exitCode;
+    // Instruções do SAP2 executadas
+    uint64_t instructions;
+    // T-States simulados
+    uint64_t tstates;
+    // Tempo real da execução (em segundos)
+    double seconds;
+    // Contadores de hardware
+    counters_t counters;
+} benchResult_t;
+
+// Resumo de várias medições do mesmo programa
+typedef struct {
+    // Código de saída da última execução
+    ErrorCode_t exitCode;
+    // Quantidade de medições (sem contar o aquecimento)
+    int runs;
+    // Execuções na medição mediana
+    int executions;
+    // Instruções do SAP2 executadas em cada execução
+    uint64_t instructions;
+    // Tempo de uma execução da medição mediana (em segundos)
+    double medianSeconds;
+    // MIPS do SAP2: mediana, percentis 10 e 90, menor e maior
+    double medianMips;
+    double p10Mips;
+    double p90Mips;
+    double minMips;
+    double maxMips;
+    // Contadores de hardware da medição mediana (somados)
+    counters_t counters;
+} benchSummary_t;
+
+/**
+ * Executa o programa do ambiente (já montado) sem esperar o tempo dos
+ * T-States, medindo o tempo e os contadores de hardware. Um erro fatal
+ * só encerra a execução.
+ * @param env o ambiente do SAP2
+ * @param result onde o resultado é guardado
+ * @return o código de saída da execução
+ */
+ErrorCode_t bench_evaluate(Environment * env, benchResult_t * result);
+
+/**
+ * Mede o programa montado várias vezes: cada execução usa uma cópia do
+ * ambiente (ver env_clone), com as saídas e os diagnósticos descartados.
+ * Cada medição executa o programa até somar pelo menos "minSeconds" de
+ * execução. As primeiras medições ("warmup") não entram no resumo.
+ * Chegar no limite de instruções (max_evaluated) conta como fim normal,
+ * para medir programas que não terminam.
+ * @param image o ambiente com o programa montado
+ * @param warmup quantidade de medições de aquecimento
+ * @param runs quantidade de medições (pelo menos 1)
+ * @param minSeconds tempo mínimo de cada medição (em segundos)
+ * @param samples onde o MIPS de cada medição é guardado ("runs" valores,
+ * NULL se não for necessário)
+ * @param summary onde o resumo é guardado
+ * @return o código de erro (o da execução, se alguma não terminar bem)
+ */
+ErrorCode_t bench_measure(const Environment * image, int warmup, int runs, double minSeconds,
+                          double * samples, benchSummary_t * summary);
+
+/**
+ * Imprime o resultado de uma medição
+ * @param result o resultado
+ * @param out onde o resultado é impresso
+ */
+void bench_print(const benchResult_t * result, FILE * out);
+
+#endif //SAP2_COMPILER_BENCH_H
@@ -0,0 +1,115 @@
+// Programas sintéticos usados para medir o desempenho do interpretador
+//
+// Author: André
+// Date: 01/11/2025
+//
+
+#include "workloads.h"
+
+// Laços aninhados de DCR/JNZ (como o Delay.asm): ~131 mil instruções
+static void body_loops(FILE * out) {
+    fprintf(out,
+        "MVI B, 0FFH\n"
+        "LACOB: MVI C, 0FFH\n"
+        "LACOC: DCR C\n"
+        "JNZ LACOC\n"
+        "DCR B\n"
+        "JNZ LACOB\n");
+}
+
+// Leituras e escritas na memória (LDA/STA): ~520 mil instruções
+static void body_memory(FILE * out) {
+    fprintf(out,
+        "MVI B, 0FFH\n"
+        "MEMB: MVI C, 0FFH\n"
+        "MEMC: LDA 9000H\n"
+        "INR A\n"
+        "STA 9000H\n"
+        "LDA 9100H\n"
+        "ADD C\n"
+        "STA 9100H\n"
+        "DCR C\n"
+        "JNZ MEMC\n"
+        "DCR B\n"
+        "JNZ MEMB\n");
+}
+
+// Chamadas de uma sub-rotina curta (CALL/RET): ~325 mil instruções
+static void body_calls(FILE * out) {
+    fprintf(out,
+        "MVI B, 0FFH\n"
+        "CHAMAB: MVI C, 0FFH\n"
+        "CHAMAC: CALL SUBROTINA\n"
+        "DCR C\n"
+        "JNZ CHAMAC\n"
+        "DCR B\n"
+        "JNZ CHAMAB\n");
+}
+
+static void after_calls(FILE * out) {
+    fprintf(out,
+        "SUBROTINA: INR A\n"
+        "RET\n");
+}
+
+// Mistura de operações lógicas e aritméticas: ~910 mil instruções
+static void body_alu(FILE * out) {
+    fprintf(out,
+        "MVI B, 0FFH\n"
+        "ULAB: MVI C, 0FFH\n"
+        "ULAC: MOV A, C\n"
+        "ANA B\n"
+        "ORA C\n"
+        "XRA B\n"
+        "RAL\n"
+        "RAR\n"
+        "ADD B\n"
+        "SUB C\n"
+        "ANI 0F0H\n"
+        "ORI 0FH\n"
+        "XRI 55H\n"
+        "CMA\n"
+        "DCR C\n"
+        "JNZ ULAC\n"
+        "DCR B\n"
+        "JNZ ULAB\n");
+}
+
+// Código sem laços que ocupa quase toda a memória (de 0800H até perto
+// da contagem): ~63 mil instruções de 1 byte
+#define LARGE_START 0x0800
+#define LARGE_RESERVED 32 // começo e fim do programa
+static void body_large(FILE * out) {
+    int groups = (WORKLOAD_COUNTER_ADDRESS - LARGE_START - LARGE_RESERVED) / 4;
+    for (int i = 0; i < groups; i++)
+        fprintf(out, "INR B\nADD B\nXRA C\nMOV C, A\n");
+}
+
+const workload_t WORKLOADS[] = {
+    { "laco_dcr_jnz", "lacos aninhados de DCR/JNZ", STANDARD_STARTER_MEMORY_ADDRESS, 40, body_loops, NULL },
+    { "memoria_lda_sta", "leituras e escritas na memoria", STANDARD_STARTER_MEMORY_ADDRESS, 10, body_memory, NULL },
+    { "chamadas_call_ret", "chamadas de sub-rotina", STANDARD_STARTER_MEMORY_ADDRESS, 16, body_calls, after_calls },
+    { "ula_mistura", "ANA/ORA/XRA/RAL/RAR/ADD/SUB e imediatos", STANDARD_STARTER_MEMORY_ADDRESS, 6, body_alu, NULL },
+    { "programa_64k", "programa de quase 64 KiB sem lacos", LARGE_START, 80, body_large, NULL }
+};
+const int WORKLOAD_COUNT = sizeof(WORKLOADS) / sizeof(WORKLOADS[0]);
+
+ErrorCode_t workload_write(const workload_t * workload, int scale, FILE * out) {
+    if (workload == NULL || out == NULL)
+        return EXIT_NULL_ARGUMENT;
+
+    long iterations = (long)workload->iterations * (scale > 0 ? scale : 1);
+    if (iterations > WORKLOAD_MAX_ITERATIONS)
+        iterations = WORKLOAD_MAX_ITERATIONS;
+
+    fprintf(out, "; %s: %s\n", workload->name, workload->description);
+    fprintf(out, "MVI A, 0%02lXH\nSTA 0%04XH\n", iterations, WORKLOAD_COUNTER_ADDRESS);
+    fprintf(out, "EXTERNO: NOP\n");
+    workload->body(out);
+    fprintf(out, "LDA 0%04XH\nDCR A\nSTA 0%04XH\nJNZ EXTERNO\nHLT\n",
+        WORKLOAD_COUNTER_ADDRESS, WORKLOAD_COUNTER_ADDRESS);
+    if (workload->after != NULL)
+        workload->after(out);
+
+    return ferror(out) ? EXIT_INVALID_ARGUMENT : EXIT_SUCCESS;
+}
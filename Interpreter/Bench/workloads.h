@@ -0,0 +1,53 @@
+// Programas sintéticos usados para medir o desempenho do interpretador
+// (ver sap2_bench.c). Cada programa repete um corpo que exercita uma
+// parte do interpretador (laços curtos, memória, chamadas, operações
+// lógicas/aritméticas ou um programa que ocupa quase toda a memória)
+// dentro de um laço externo, cuja contagem fica na memória.
+//
+// Author: André
+// Date: 01/11/2025
+//
+
+#ifndef SAP2_COMPILER_WORKLOADS_H
+#define SAP2_COMPILER_WORKLOADS_H
+
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Endereço da contagem do laço externo
+#define WORKLOAD_COUNTER_ADDRESS 0xFFF0
+// Maior quantidade de voltas do laço externo (a contagem tem 1 byte)
+#define WORKLOAD_MAX_ITERATIONS 255
+
+// Programa sintético
+typedef struct {
+    // Nome (usado no filtro e nos resultados)
+    const char * name;
+    // O que o programa exercita
+    const char * description;
+    // Endereço do começo do programa
+    uhex2_t start;
+    // Voltas do laço externo na escala 1
+    int iterations;
+    // Escreve o corpo do laço externo (pode usar A, B e C)
+    void (*body)(FILE * out);
+    // Escreve o que fica depois do HLT, como sub-rotinas (NULL se não houver)
+    void (*after)(FILE * out);
+} workload_t;
+
+// Programas sintéticos
+extern const workload_t WORKLOADS[];
+extern const int WORKLOAD_COUNT;
+
+/**
+ * Escreve o código do programa sintético
+ * @param workload o programa
+ * @param scale multiplica as voltas do laço externo (até WORKLOAD_MAX_ITERATIONS)
+ * @param out onde o código é escrito
+ * @return o código de erro
+ */
+ErrorCode_t workload_write(const workload_t * workload, int scale, FILE * out);
+
+#endif //SAP2_COMPILER_WORKLOADS_H
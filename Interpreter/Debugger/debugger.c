@@ -0,0 +1,857 @@
+// Depurador do SAP2 com "viagem no tempo"
+//
+// Author: André
+// Date: 27/10/2025
+//
+
+#include <ctype.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debugger.h"
+#include "../Instructions/Instructions.h"
+#include "../Runtime/evaluate.h"
+#include "../Utils/Utils.h"
+
+// Cópia do ambiente feita durante a depuração
+typedef struct {
+    // Quantidade de instruções executadas quando a cópia foi feita
+    long instruction;
+    Environment * env;
+    // Posição do registro de entradas quando a cópia foi feita
+    size_t inputPosition;
+    // Endereços escritos entre essa cópia e a próxima (em ordem). Os
+    // da última cópia ficam no depurador (ver "written").
+    uhex2_t * writes;
+    size_t writeCount;
+} checkpoint_t;
+
+// O que a condição de uma parada compara
+typedef enum {
+    OPERAND_NONE = -1, // parada sem condição
+    OPERAND_A = REGISTER_A,
+    OPERAND_B = REGISTER_B,
+    OPERAND_C = REGISTER_C,
+    OPERAND_S,
+    OPERAND_Z
+} operand_t;
+
+typedef enum { CMP_EQ, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE } comparison_t;
+
+// Parada antes da instrução de um endereço
+typedef struct {
+    uhex2_t address;
+    operand_t operand;
+    comparison_t comparison;
+    int value;
+    // Texto da condição (para listar as paradas)
+    char condition[16];
+} breakpoint_t;
+
+struct debugger_s {
+    checkpoint_t checkpoints[DEBUGGER_MAX_CHECKPOINTS];
+    size_t checkpointCount;
+    // Instruções entre uma cópia e a próxima
+    long interval;
+    // Maior quantidade de instruções já executadas. Antes desse ponto,
+    // a execução está sendo repetida.
+    long furthest;
+
+    // Endereços escritos depois da última cópia (mapa de bits e lista)
+    uint8_t written[(UHEX2_MAX + 1) / 8];
+    uhex2_t writtenList[UHEX2_MAX + 1];
+    size_t writtenCount;
+
+    // Entradas do IN, em ordem
+    hex1_t * inputs;
+    size_t inputCount;
+    size_t inputCapacity;
+    // Próxima entrada que será usada
+    size_t inputPosition;
+
+    // Busca da última escrita em um endereço
+    bool searching;
+    uhex2_t searchAddress;
+    long searchHit;
+
+    // Para onde vão as saídas e os avisos da execução repetida
+    FILE * null;
+    // Se a execução está sendo movida por um comando (voltar, ir...).
+    // Nesse caso, as paradas são ignoradas.
+    bool traveling;
+
+    // Paradas e endereços vigiados (mapas de bits por endereço)
+    breakpoint_t breakpoints[DEBUGGER_MAX_BREAKPOINTS];
+    int breakpointCount;
+    uint8_t breakMap[(UHEX2_MAX + 1) / 8];
+    uint8_t watchMap[(UHEX2_MAX + 1) / 8];
+    int watchCount;
+
+    // Se a execução está correndo (sem parar depois de cada instrução)
+    bool running;
+    // Para quando essa quantidade de instruções for executada (-1 se não houver)
+    long stopAt;
+    // Se para depois do RET da sub-rotina atual (e quantos CALLs a mais há)
+    bool untilReturn;
+    int depth;
+    // Endereço vigiado que foi escrito pela última instrução (-1 se não houver)
+    long watchHit;
+    hex1_t watchValue;
+    // Se a execução normal espera o tempo dos T-States (enquanto a
+    // execução corre, o tempo não é esperado)
+    bool paced;
+};
+
+#define bit_test(bits, i) ((bits)[(i) >> 3] & (1 << ((i) & 7)))
+#define bit_set(bits, i) ((bits)[(i) >> 3] |= (uint8_t)(1 << ((i) & 7)))
+#define bit_clear(bits, i) ((bits)[(i) >> 3] &= (uint8_t)~(1 << ((i) & 7)))
+
+ErrorCode_t debugger_attach(Environment * env) {
+    if (env->debugger != NULL)
+        return EXIT_SUCCESS;
+
+    debugger_t * dbg = calloc(1, sizeof(debugger_t));
+    if (dbg == NULL)
+        return EXIT_NO_MEMORY;
+    dbg->interval = DEBUGGER_CHECKPOINT_INTERVAL;
+    dbg->furthest = env->totalInstructions;
+    dbg->null = open_null_stream();
+    dbg->stopAt = -1;
+    dbg->watchHit = -1;
+    dbg->paced = env_params->paced;
+
+    Environment * copy = env_clone(env);
+    if (copy == NULL || dbg->null == NULL) {
+        env_destroy(copy);
+        if (dbg->null != NULL) fclose(dbg->null);
+        free(dbg);
+        return EXIT_NO_MEMORY;
+    }
+    dbg->checkpoints[0] = (checkpoint_t){ .instruction = env->totalInstructions, .env = copy };
+    dbg->checkpointCount = 1;
+
+    env->debugger = dbg;
+    return EXIT_SUCCESS;
+}
+
+void debugger_detach(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    if (dbg == NULL)
+        return;
+
+    for (size_t i = 0; i < dbg->checkpointCount; i++) {
+        env_destroy(dbg->checkpoints[i].env);
+        free(dbg->checkpoints[i].writes);
+    }
+    free(dbg->inputs);
+    fclose(dbg->null);
+    free(dbg);
+    env->debugger = NULL;
+}
+
+/**
+ * Compara dois endereços (para o qsort e o bsearch)
+ */
+static int compare_address(const void * a, const void * b) {
+    return (int)*(const uhex2_t *)a - (int)*(const uhex2_t *)b;
+}
+
+/**
+ * Junta os endereços escritos de "from" (a cópia seguinte) nos de "into"
+ * @return o código de erro
+ */
+static ErrorCode_t merge_writes(checkpoint_t * into, const checkpoint_t * from) {
+    if (from->writeCount == 0)
+        return EXIT_SUCCESS;
+
+    uhex2_t * merged = malloc((into->writeCount + from->writeCount) * sizeof(uhex2_t));
+    if (merged == NULL)
+        return EXIT_NO_MEMORY;
+
+    size_t i = 0, j = 0, n = 0;
+    while (i < into->writeCount || j < from->writeCount) {
+        uhex2_t next;
+        if (j >= from->writeCount || (i < into->writeCount && into->writes[i] <= from->writes[j])) {
+            next = into->writes[i++];
+            if (j < from->writeCount && from->writes[j] == next) j++;
+        } else {
+            next = from->writes[j++];
+        }
+        merged[n++] = next;
+    }
+
+    free(into->writes);
+    into->writes = merged;
+    into->writeCount = n;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Guarda os endereços escritos depois da última cópia nela e limpa o mapa
+ * @return o código de erro
+ */
+static ErrorCode_t commit_writes(debugger_t * dbg) {
+    checkpoint_t * last = &dbg->checkpoints[dbg->checkpointCount - 1];
+    if (dbg->writtenCount > 0) {
+        last->writes = malloc(dbg->writtenCount * sizeof(uhex2_t));
+        if (last->writes == NULL)
+            return EXIT_NO_MEMORY;
+        qsort(dbg->writtenList, dbg->writtenCount, sizeof(uhex2_t), compare_address);
+        memcpy(last->writes, dbg->writtenList, dbg->writtenCount * sizeof(uhex2_t));
+        last->writeCount = dbg->writtenCount;
+    }
+
+    for (size_t i = 0; i < dbg->writtenCount; i++)
+        bit_clear(dbg->written, dbg->writtenList[i]);
+    dbg->writtenCount = 0;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Descarta metade das cópias (uma sim, outra não) e dobra o intervalo
+ * entre elas. A primeira cópia é sempre mantida.
+ * @return o código de erro
+ */
+static ErrorCode_t thin_checkpoints(debugger_t * dbg) {
+    size_t kept = 0;
+    for (size_t i = 0; i < dbg->checkpointCount; i++) {
+        checkpoint_t * cp = &dbg->checkpoints[i];
+        if (i % 2 == 0) {
+            dbg->checkpoints[kept++] = *cp;
+            continue;
+        }
+        // Os endereços escritos depois da cópia descartada passam a ser
+        // da anterior
+        if (merge_writes(&dbg->checkpoints[kept - 1], cp) != EXIT_SUCCESS)
+            return EXIT_NO_MEMORY;
+        env_destroy(cp->env);
+        free(cp->writes);
+    }
+
+    // Se a última cópia foi descartada, os endereços da que sobrou no
+    // fim voltam para o mapa (que é sempre o da última cópia)
+    if (dbg->checkpointCount % 2 == 0) {
+        checkpoint_t * last = &dbg->checkpoints[kept - 1];
+        for (size_t i = 0; i < last->writeCount; i++) {
+            if (!bit_test(dbg->written, last->writes[i])) {
+                bit_set(dbg->written, last->writes[i]);
+                dbg->writtenList[dbg->writtenCount++] = last->writes[i];
+            }
+        }
+        free(last->writes);
+        last->writes = NULL;
+        last->writeCount = 0;
+    }
+
+    dbg->checkpointCount = kept;
+    dbg->interval *= 2;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Faz uma cópia do ambiente no ponto atual (que é o mais distante já
+ * alcançado)
+ */
+static void take_checkpoint(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->checkpointCount == DEBUGGER_MAX_CHECKPOINTS && thin_checkpoints(dbg) != EXIT_SUCCESS)
+        E_EXIT_ERR(EXIT_NO_MEMORY);
+    if (commit_writes(dbg) != EXIT_SUCCESS)
+        E_EXIT_ERR(EXIT_NO_MEMORY);
+
+    Environment * copy = env_clone(env);
+    if (copy == NULL)
+        E_EXIT_ERR(EXIT_NO_MEMORY);
+    dbg->checkpoints[dbg->checkpointCount++] = (checkpoint_t){
+        .instruction = env->totalInstructions,
+        .env = copy,
+        .inputPosition = dbg->inputPosition
+    };
+}
+
+static void print_position(Environment * env);
+
+/**
+ * Para a execução que estava correndo e pergunta o que fazer
+ * @param env o ambiente do SAP2
+ * @param reason o motivo da parada
+ */
+static void stop(Environment * env, const char * reason) {
+    debugger_t * dbg = env->debugger;
+    dbg->running = false;
+    dbg->stopAt = -1;
+    dbg->untilReturn = false;
+    dbg->watchHit = -1;
+    env_params->debug_mode = true;
+    env_params->paced = dbg->paced;
+
+    // O tempo parado não conta como tempo de execução
+    stopWatch_s stop_sw;
+    stopWatch_start(&stop_sw);
+    fprintf(env->out, "\n>> %s\n", reason);
+    print_position(env);
+    debugger_prompt(env);
+    fprintf(env->out, "\n\n\n\n");
+    stopWatch_end(&stop_sw);
+    env_params->real_max_time += seg_to_ms(stopWatch_timeElapsed(&stop_sw));
+}
+
+/**
+ * Retorna se a condição da parada é verdadeira
+ */
+static bool breakpoint_matches(const Environment * env, const breakpoint_t * bp) {
+    if (bp->operand == OPERAND_NONE)
+        return true;
+
+    int value;
+    switch (bp->operand) {
+        case OPERAND_S: value = env->flags[FLAG_S]; break;
+        case OPERAND_Z: value = env->flags[FLAG_Z]; break;
+        default: value = (uhex1_t)env->registers[bp->operand]; break;
+    }
+    switch (bp->comparison) {
+        case CMP_EQ: return value == bp->value;
+        case CMP_NE: return value != bp->value;
+        case CMP_LT: return value < bp->value;
+        case CMP_LE: return value <= bp->value;
+        case CMP_GT: return value > bp->value;
+        default:     return value >= bp->value;
+    }
+}
+
+/**
+ * Verifica se a execução que está correndo deve parar antes da
+ * próxima instrução
+ */
+static void check_stop(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    uhex2_t pc = env->programCounter;
+    char reason[160];
+
+    if (dbg->watchHit >= 0) {
+        snprintf(reason, sizeof(reason), "Escrita no endereco vigiado %lxH (valor: %02xH)",
+            (unsigned long)dbg->watchHit, (uhex1_t)dbg->watchValue);
+        stop(env, reason);
+    } else if (dbg->stopAt >= 0 && env->totalInstructions >= dbg->stopAt) {
+        stop(env, dbg->untilReturn ? "Fim da sub-rotina" : "Fim dos passos");
+    } else if (bit_test(dbg->breakMap, pc)) {
+        for (int i = 0; i < dbg->breakpointCount; i++) {
+            const breakpoint_t * bp = &dbg->breakpoints[i];
+            if (bp->address != pc || !breakpoint_matches(env, bp))
+                continue;
+
+            int label = getLabelFromAddress(env, pc);
+            const char * annotation = env_read_unit(env, pc).annotation;
+            snprintf(reason, sizeof(reason), "Parada em %xH%s%s%s%s%s: %s", pc,
+                label >= 0 ? " (" : "", label >= 0 ? env->symbolTable[label].name : "", label >= 0 ? ")" : "",
+                bp->operand != OPERAND_NONE ? " se " : "", bp->condition,
+                annotation != NULL ? annotation : "?");
+            stop(env, reason);
+            break;
+        }
+    }
+
+    // A próxima instrução conta para o "retornar" (mesmo que ele tenha
+    // sido pedido agora, na parada acima)
+    if (dbg->running && dbg->untilReturn && dbg->stopAt < 0) {
+        uhex1_t opcode = (uhex1_t)env_read_unit(env, env->programCounter).value;
+        if (opcode == OPCODE_CALL) {
+            dbg->depth++;
+        } else if (opcode == OPCODE_RET) {
+            // Para depois do RET da sub-rotina em que a execução estava
+            if (dbg->depth == 0)
+                dbg->stopAt = env->totalInstructions + 1;
+            else
+                dbg->depth--;
+        }
+    }
+}
+
+void debugger_before_instruction(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    // Depois de voltar, as instruções até o ponto mais distante são
+    // refeitas (mesmo fora do run_to, como ao continuar a execução)
+    env->replaying = env->totalInstructions < dbg->furthest;
+    // Só faz cópias de pontos novos
+    if (env->totalInstructions >= dbg->furthest) {
+        dbg->furthest = env->totalInstructions;
+        if (env->totalInstructions >= dbg->checkpoints[dbg->checkpointCount - 1].instruction + dbg->interval)
+            take_checkpoint(env);
+    }
+
+    if (dbg->running && !dbg->traveling)
+        check_stop(env);
+}
+
+void debugger_write(Environment * env, uhex2_t address, hex1_t value) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->searching && address == dbg->searchAddress)
+        dbg->searchHit = env->totalInstructions;
+    if (!dbg->traveling && bit_test(dbg->watchMap, address)) {
+        dbg->watchHit = address;
+        dbg->watchValue = value;
+    }
+
+    // Escritas repetidas já foram registradas
+    if (env->totalInstructions >= dbg->furthest && !bit_test(dbg->written, address)) {
+        bit_set(dbg->written, address);
+        dbg->writtenList[dbg->writtenCount++] = address;
+    }
+}
+
+bool debugger_logged_in(Environment * env, hex1_t * value) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->inputPosition >= dbg->inputCount)
+        return false;
+    *value = dbg->inputs[dbg->inputPosition++];
+    return true;
+}
+
+void debugger_log_in(Environment * env, hex1_t value) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->inputCount == dbg->inputCapacity) {
+        size_t capacity = dbg->inputCapacity > 0 ? dbg->inputCapacity * 2 : 16;
+        hex1_t * temp = realloc(dbg->inputs, capacity * sizeof(hex1_t));
+        if (temp == NULL)
+            E_EXIT_ERR(EXIT_NO_MEMORY);
+        dbg->inputs = temp;
+        dbg->inputCapacity = capacity;
+    }
+    dbg->inputs[dbg->inputCount++] = value;
+    dbg->inputPosition = dbg->inputCount;
+}
+
+/**
+ * Retorna a última cópia feita até a instrução dada
+ */
+static size_t find_checkpoint(const debugger_t * dbg, long instruction) {
+    size_t low = 0, high = dbg->checkpointCount;
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (dbg->checkpoints[middle].instruction <= instruction)
+            low = middle;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * Volta o ambiente para a cópia dada
+ */
+static void restore_checkpoint(Environment * env, const checkpoint_t * cp) {
+    env_copy_state(env, cp->env);
+    env->debugger->inputPosition = cp->inputPosition;
+}
+
+/**
+ * Executa até que "target" instruções tenham sido executadas, o mais
+ * rápido possível. As saídas e os avisos das instruções que já tinham
+ * sido executadas antes não são impressos de novo. Para antes de um HLT
+ * ou do fim do programa.
+ */
+static void run_to(Environment * env, long target) {
+    debugger_t * dbg = env->debugger;
+    FILE * out = env->out;
+    FILE * warnings = env->diagnostics.warnings;
+    Parametros params = env->params;
+    env->params.debug_mode = false;
+    env->params.paced = false;
+    bool traveling = dbg->traveling;
+    dbg->traveling = true;
+
+    // Se a execução for encerrada por um erro, o ambiente volta ao normal antes
+    jmp_buf * outer = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    if (outer != NULL) {
+        int code = setjmp(on_fatal);
+        if (code != 0) {
+            env->out = out;
+            env->diagnostics.warnings = warnings;
+            env->replaying = false;
+            env->params = params;
+            dbg->traveling = traveling;
+            env->diagnostics.on_fatal = outer;
+            longjmp(*outer, code);
+        }
+        env->diagnostics.on_fatal = &on_fatal;
+    }
+
+    while (env->totalInstructions < target) {
+        debugger_before_instruction(env);
+        env->out = env->replaying ? dbg->null : out;
+        env->diagnostics.warnings = env->replaying ? dbg->null : warnings;
+
+        const memoryUnit_t * unit = &env_read_unit(env, env->programCounter);
+        if ((uhex1_t)unit->value == OPCODE_HLT || (unit->value == OPCODE_NOP && unit->annotation == NULL))
+            break;
+        if (execute_instruction(env) != EXIT_SUCCESS)
+            break;
+    }
+
+    env->out = out;
+    env->diagnostics.warnings = warnings;
+    env->replaying = false;
+    // O tempo esperado pelas entradas novas continua contando
+    params.real_max_time = env->params.real_max_time;
+    env->params = params;
+    dbg->traveling = traveling;
+    env->diagnostics.on_fatal = outer;
+}
+
+long debugger_goto(Environment * env, long instruction) {
+    debugger_t * dbg = env->debugger;
+    if (instruction < dbg->checkpoints[0].instruction)
+        instruction = dbg->checkpoints[0].instruction;
+    // A instrução que acabou de ser executada também já foi (o ponto mais
+    // distante só é atualizado antes de cada instrução)
+    if (env->totalInstructions > dbg->furthest)
+        dbg->furthest = env->totalInstructions;
+
+    // Se o ponto atual estiver entre a cópia e o destino, continua dele
+    const checkpoint_t * cp = &dbg->checkpoints[find_checkpoint(dbg, instruction)];
+    if (env->totalInstructions > instruction || env->totalInstructions < cp->instruction)
+        restore_checkpoint(env, cp);
+    run_to(env, instruction);
+    return env->totalInstructions;
+}
+
+long debugger_step_back(Environment * env, long count) {
+    return debugger_goto(env, env->totalInstructions - count);
+}
+
+/**
+ * Retorna se o endereço foi escrito entre a cópia dada e a próxima
+ */
+static bool segment_writes(const debugger_t * dbg, size_t index, uhex2_t address) {
+    if (index == dbg->checkpointCount - 1)
+        return bit_test(dbg->written, address);
+    const checkpoint_t * cp = &dbg->checkpoints[index];
+    return cp->writeCount > 0
+        && bsearch(&address, cp->writes, cp->writeCount, sizeof(uhex2_t), compare_address) != NULL;
+}
+
+long debugger_last_write(Environment * env, uhex2_t address) {
+    debugger_t * dbg = env->debugger;
+    long now = env->totalInstructions;
+    if (now <= dbg->checkpoints[0].instruction)
+        return -1;
+
+    // Procura, da cópia atual para trás, um trecho que escreveu no
+    // endereço e o executa de novo para achar a instrução exata
+    long hit = -1;
+    for (size_t i = find_checkpoint(dbg, now - 1) + 1; i-- > 0 && hit < 0;) {
+        if (!segment_writes(dbg, i, address))
+            continue;
+
+        long end = i + 1 < dbg->checkpointCount ? dbg->checkpoints[i + 1].instruction : now;
+        if (end > now)
+            end = now;
+        restore_checkpoint(env, &dbg->checkpoints[i]);
+        dbg->searching = true;
+        dbg->searchAddress = address;
+        dbg->searchHit = -1;
+        run_to(env, end);
+        dbg->searching = false;
+        hit = dbg->searchHit;
+    }
+
+    if (hit < 0) {
+        debugger_goto(env, now);
+        return -1;
+    }
+    return debugger_goto(env, hit + 1);
+}
+
+ErrorCode_t debugger_add_breakpoint(Environment * env, uhex2_t address, const char * condition) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->breakpointCount == DEBUGGER_MAX_BREAKPOINTS)
+        return EXIT_NO_MEMORY;
+
+    breakpoint_t bp = { .address = address, .operand = OPERAND_NONE };
+    if (condition != NULL) {
+        // Operando (A, B, C, S ou Z)
+        switch (toupper((unsigned char)condition[0])) {
+            case 'A': bp.operand = OPERAND_A; break;
+            case 'B': bp.operand = OPERAND_B; break;
+            case 'C': bp.operand = OPERAND_C; break;
+            case 'S': bp.operand = OPERAND_S; break;
+            case 'Z': bp.operand = OPERAND_Z; break;
+            default: return EXIT_INVALID_ARGUMENT;
+        }
+
+        // Comparação
+        const char * text = condition + 1;
+        static const struct { const char * text; comparison_t comparison; } COMPARISONS[] = {
+            { "==", CMP_EQ }, { "!=", CMP_NE }, { "<=", CMP_LE }, { ">=", CMP_GE },
+            { "=", CMP_EQ }, { "<", CMP_LT }, { ">", CMP_GT }
+        };
+        size_t i = 0, n = sizeof(COMPARISONS) / sizeof(COMPARISONS[0]);
+        while (i < n && strncmp(text, COMPARISONS[i].text, strlen(COMPARISONS[i].text)) != 0)
+            i++;
+        if (i == n)
+            return EXIT_INVALID_ARGUMENT;
+        bp.comparison = COMPARISONS[i].comparison;
+        text += strlen(COMPARISONS[i].text);
+
+        // Valor (hexadecimal, como 5H, ou 0/1 para os flags)
+        hex1_t value;
+        char * end = NULL;
+        if (str_to_hex1(text, &value) == EXIT_SUCCESS) {
+            bp.value = (uhex1_t)value;
+        } else {
+            bp.value = (int)strtol(text, &end, 10);
+            if (end == text || *end != '\0')
+                return EXIT_INVALID_ARGUMENT;
+        }
+        snprintf(bp.condition, sizeof(bp.condition), "%s", condition);
+    }
+
+    dbg->breakpoints[dbg->breakpointCount++] = bp;
+    bit_set(dbg->breakMap, address);
+    return EXIT_SUCCESS;
+}
+
+int debugger_remove_breakpoints(Environment * env, uhex2_t address) {
+    debugger_t * dbg = env->debugger;
+    int kept = 0;
+    for (int i = 0; i < dbg->breakpointCount; i++) {
+        if (dbg->breakpoints[i].address != address)
+            dbg->breakpoints[kept++] = dbg->breakpoints[i];
+    }
+    int removed = dbg->breakpointCount - kept;
+    dbg->breakpointCount = kept;
+    bit_clear(dbg->breakMap, address);
+    return removed;
+}
+
+void debugger_watch(Environment * env, uhex2_t address, bool watch) {
+    debugger_t * dbg = env->debugger;
+    if (watch == (bit_test(dbg->watchMap, address) != 0))
+        return;
+    if (watch) {
+        bit_set(dbg->watchMap, address);
+        dbg->watchCount++;
+    } else {
+        bit_clear(dbg->watchMap, address);
+        dbg->watchCount--;
+    }
+}
+
+bool debugger_should_break(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    if (!bit_test(dbg->breakMap, env->programCounter))
+        return false;
+    for (int i = 0; i < dbg->breakpointCount; i++) {
+        if (dbg->breakpoints[i].address == env->programCounter && breakpoint_matches(env, &dbg->breakpoints[i]))
+            return true;
+    }
+    return false;
+}
+
+long debugger_take_watch_hit(Environment * env) {
+    long hit = env->debugger->watchHit;
+    env->debugger->watchHit = -1;
+    return hit;
+}
+
+/**
+ * Imprime as paradas e os endereços vigiados
+ */
+static void print_points(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    if (dbg->breakpointCount == 0 && dbg->watchCount == 0) {
+        fprintf(env->out, "Nao ha paradas nem enderecos vigiados.\n");
+        return;
+    }
+
+    for (int i = 0; i < dbg->breakpointCount; i++) {
+        const breakpoint_t * bp = &dbg->breakpoints[i];
+        int label = getLabelFromAddress(env, bp->address);
+        fprintf(env->out, "Parada em %xH", bp->address);
+        if (label >= 0)
+            fprintf(env->out, " (%s)", env->symbolTable[label].name);
+        if (bp->operand != OPERAND_NONE)
+            fprintf(env->out, " se %s", bp->condition);
+        fprintf(env->out, "\n");
+    }
+    for (int address = 0; address <= UHEX2_MAX; address++) {
+        if (bit_test(dbg->watchMap, address))
+            fprintf(env->out, "Endereco vigiado: %xH\n", address);
+    }
+}
+
+/**
+ * Obtém o endereço de um rótulo ou de um hexadecimal (ex.: 9000H)
+ * @return se o texto é um rótulo ou endereço válido
+ */
+static bool parse_address(Environment * env, char * text, uhex2_t * address) {
+    int label = getLabelFromName(env, text);
+    if (label >= 0) {
+        *address = env->symbolTable[label].value;
+        return true;
+    }
+    hex2_t value;
+    if (str_to_hex2(text, &value) != EXIT_SUCCESS)
+        return false;
+    *address = (uhex2_t)value;
+    return true;
+}
+
+/**
+ * Imprime onde a execução está depois de um comando
+ */
+static void print_position(Environment * env) {
+    fprintf(env->out, "\n===========================\nInstrucao atual: %s\nInstrucoes executadas: %ld\n===========================\n",
+        env->last_instruction.annotation != NULL ? env->last_instruction.annotation : "(nenhuma)",
+        env->totalInstructions);
+    print_debug_info(env);
+}
+
+static void print_help(Environment * env) {
+    fprintf(env->out,
+        "Comandos:\n"
+        "  (enter)                executa a proxima instrucao\n"
+        "  continuar / c          executa ate a proxima parada (ou ate o fim)\n"
+        "  passos N / p N         executa N instrucoes\n"
+        "  retornar / r           executa ate o RET da sub-rotina atual\n"
+        "  parada X [cond] / b    para antes da instrucao do rotulo ou endereco X,\n"
+        "                         se a condicao for verdadeira (ex.: A=5H, B!=0H, C>=10H, Z=1)\n"
+        "  remover X / rb X       remove as paradas de X\n"
+        "  vigiar X / w X         para depois de cada escrita no endereco X\n"
+        "  desvigiar X / dw X     deixa de vigiar o endereco X\n"
+        "  pontos / l             mostra as paradas e os enderecos vigiados\n"
+        "  voltar [N] / v [N]     volta N instrucoes (padrao: 1)\n"
+        "  ir K / i K             vai para o ponto em que K instrucoes foram executadas\n"
+        "  escrita X / e X        volta ate a ultima escrita no endereco X (ex.: 9000H)\n"
+        "  ajuda / ?              mostra esses comandos\n");
+}
+
+// Compara o comando com o nome dado e a forma reduzida dele
+#define is_command(name, shortName) \
+    (strcmp(command, name) == 0 || strcmp(command, shortName) == 0)
+
+/**
+ * Faz a execução correr, o mais rápido possível, até a próxima parada
+ */
+static void run(Environment * env) {
+    env->debugger->running = true;
+    env->debugger->watchHit = -1;
+    env_params->debug_mode = false;
+    env_params->paced = false;
+}
+
+void debugger_prompt(Environment * env) {
+    debugger_t * dbg = env->debugger;
+    char line[160];
+    while (true) {
+        fprintf(env->out, ">> Pressione enter para continuar (ou digite um comando, \"ajuda\" para ver os comandos): ");
+        fflush(env->out);
+        if (fgets(line, sizeof(line), env->in) == NULL)
+            return;
+        // Descarta o resto de uma linha muito longa
+        if (strchr(line, '\n') == NULL)
+            enter_to_continue(env->in);
+
+        char command[16] = { 0 };
+        char argument[64] = { 0 };
+        char condition[64] = { 0 };
+        int n = sscanf(line, "%15s %63s %63s", command, argument, condition);
+        if (n <= 0)
+            return;
+
+        uhex2_t address;
+        if (is_command("ajuda", "?")) {
+            print_help(env);
+        }
+        else if (is_command("continuar", "c")) {
+            run(env);
+            return;
+        }
+        else if (is_command("passos", "p")) {
+            char * end = NULL;
+            long count = n > 1 ? strtol(argument, &end, 10) : -1;
+            if (count <= 0 || *end != '\0') {
+                fprintf(env->out, "A quantidade de instrucoes deve ser um inteiro positivo.\n");
+                continue;
+            }
+            dbg->stopAt = env->totalInstructions + count;
+            run(env);
+            return;
+        }
+        else if (is_command("retornar", "r")) {
+            dbg->untilReturn = true;
+            dbg->depth = 0;
+            run(env);
+            return;
+        }
+        else if (is_command("parada", "b")) {
+            if (n <= 1 || !parse_address(env, argument, &address)) {
+                fprintf(env->out, "O comando \"%s\" espera um rotulo ou um endereco (ex.: 8003H).\n", command);
+                continue;
+            }
+            ErrorCode_t err = debugger_add_breakpoint(env, address, n > 2 ? condition : NULL);
+            if (err == EXIT_INVALID_ARGUMENT)
+                fprintf(env->out, "Condicao invalida: \"%s\" (ex.: A=5H, B!=0H, C>=10H, Z=1).\n", condition);
+            else if (err != EXIT_SUCCESS)
+                fprintf(env->out, "Nao cabem mais paradas (maximo: %d).\n", DEBUGGER_MAX_BREAKPOINTS);
+            else
+                fprintf(env->out, "Parada adicionada em %xH.\n", address);
+        }
+        else if (is_command("remover", "rb")) {
+            if (n <= 1 || !parse_address(env, argument, &address)) {
+                fprintf(env->out, "O comando \"%s\" espera um rotulo ou um endereco (ex.: 8003H).\n", command);
+                continue;
+            }
+            fprintf(env->out, "%d parada(s) removida(s).\n", debugger_remove_breakpoints(env, address));
+        }
+        else if (is_command("vigiar", "w") || is_command("desvigiar", "dw")) {
+            if (n <= 1 || !parse_address(env, argument, &address)) {
+                fprintf(env->out, "O comando \"%s\" espera um rotulo ou um endereco (ex.: 9000H).\n", command);
+                continue;
+            }
+            bool watch = is_command("vigiar", "w");
+            debugger_watch(env, address, watch);
+            fprintf(env->out, watch ? "Vigiando o endereco %xH.\n" : "O endereco %xH nao e mais vigiado.\n", address);
+        }
+        else if (is_command("pontos", "l")) {
+            print_points(env);
+        }
+        else if (is_command("voltar", "v")) {
+            long count = n > 1 ? strtol(argument, NULL, 10) : 1;
+            if (count <= 0) {
+                fprintf(env->out, "A quantidade de instrucoes deve ser um inteiro positivo.\n");
+                continue;
+            }
+            debugger_step_back(env, count);
+            print_position(env);
+        }
+        else if (is_command("ir", "i")) {
+            char * end = NULL;
+            long instruction = n > 1 ? strtol(argument, &end, 10) : -1;
+            if (instruction < 0 || *end != '\0') {
+                fprintf(env->out, "O comando \"%s\" espera a quantidade de instrucoes executadas (inteiro positivo).\n", command);
+                continue;
+            }
+            if (debugger_goto(env, instruction) < instruction)
+                fprintf(env->out, "\nO programa termina antes desse ponto.");
+            print_position(env);
+        }
+        else if (is_command("escrita", "e")) {
+            if (n <= 1 || !parse_address(env, argument, &address)) {
+                fprintf(env->out, "O comando \"%s\" espera um rotulo ou um endereco (ex.: 9000H).\n", command);
+                continue;
+            }
+            if (debugger_last_write(env, address) < 0) {
+                fprintf(env->out, "O endereco %xH nao foi escrito antes desse ponto.\n", address);
+                continue;
+            }
+            print_position(env);
+        }
+        else {
+            fprintf(env->out, "Comando desconhecido: \"%s\". Digite \"ajuda\" para ver os comandos.\n", command);
+        }
+    }
+}
@@ -0,0 +1,171 @@
+// Depurador do SAP2 com "viagem no tempo": durante a depuração, cópias
+// do ambiente são feitas periodicamente (as páginas de memória são
+// compartilhadas, então cada cópia é barata) e os endereços escritos
+// entre uma cópia e a próxima são registrados. Voltar instruções, ir
+// para uma instrução ou voltar até a última escrita em um endereço é
+// feito voltando para a cópia mais próxima e executando de novo a
+// partir dela. As entradas do IN também são registradas, então a
+// execução repetida é igual à original.
+//
+// Também há paradas (em endereços ou rótulos, com ou sem uma condição
+// sobre os registradores e flags), endereços vigiados (a execução para
+// depois de uma escrita neles) e comandos para executar até a próxima
+// parada, por N instruções ou até o RET da sub-rotina atual. Entre uma
+// parada e outra, a execução não imprime nada do depurador.
+//
+// Author: André
+// Date: 27/10/2025
+//
+
+#ifndef SAP2_COMPILER_DEBUGGER_H
+#define SAP2_COMPILER_DEBUGGER_H
+
+#include <stdbool.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade inicial de instruções entre uma cópia e a próxima
+#define DEBUGGER_CHECKPOINT_INTERVAL 4096
+// Quantidade máxima de cópias. Quando esse valor é atingido, metade das
+// cópias é descartada e o intervalo entre elas dobra.
+#define DEBUGGER_MAX_CHECKPOINTS 1024
+
+// Quantidade máxima de paradas
+#define DEBUGGER_MAX_BREAKPOINTS 64
+
+// Depurador de um ambiente (ver debugger.c)
+typedef struct debugger_s debugger_t;
+
+// Ganchos usados pela execução. Não custam nada além da comparação
+// quando não há depurador.
+#define DEBUGGER_BEFORE_INSTRUCTION() \
+    do { if (env->debugger != NULL) debugger_before_instruction(env); } while (0)
+#define DEBUGGER_WRITE(address, value) \
+    do { if (env->debugger != NULL) debugger_write(env, address, value); } while (0)
+
+/**
+ * Cria o depurador do ambiente. A primeira cópia é a do estado atual,
+ * então não é possível voltar para antes dele.
+ * @param env o ambiente do SAP2
+ * @return o código de erro
+ */
+ErrorCode_t debugger_attach(Environment * env);
+
+/**
+ * Libera o depurador do ambiente (e as cópias), se houver
+ * @param env o ambiente do SAP2
+ */
+void debugger_detach(Environment * env);
+
+/**
+ * Chamado antes de cada instrução: faz uma cópia do ambiente quando
+ * necessário e, se a execução estiver correndo (ver "continuar"),
+ * para nas paradas, nos endereços vigiados e no fim dos passos pedidos
+ * @param env o ambiente do SAP2
+ */
+void debugger_before_instruction(Environment * env);
+
+/**
+ * Chamado a cada escrita na memória
+ * @param env o ambiente do SAP2
+ * @param address o endereço escrito
+ * @param value o valor escrito
+ */
+void debugger_write(Environment * env, uhex2_t address, hex1_t value);
+
+/**
+ * Se a execução está sendo repetida, obtém a entrada registrada da
+ * próxima instrução IN
+ * @param env o ambiente do SAP2
+ * @param value onde a entrada é guardada
+ * @return se havia uma entrada registrada
+ */
+bool debugger_logged_in(Environment * env, hex1_t * value);
+
+/**
+ * Registra uma entrada nova (lida do fluxo de entrada)
+ * @param env o ambiente do SAP2
+ * @param value a entrada
+ */
+void debugger_log_in(Environment * env, hex1_t value);
+
+/**
+ * Vai para o ponto em que "instruction" instruções foram executadas. Se
+ * o ponto ainda não foi alcançado, a execução continua até ele (parando
+ * antes de um HLT ou do fim do programa).
+ * @param env o ambiente do SAP2
+ * @param instruction a quantidade de instruções executadas
+ * @return a quantidade de instruções executadas no ponto alcançado
+ */
+long debugger_goto(Environment * env, long instruction);
+
+/**
+ * Volta "count" instruções
+ * @param env o ambiente do SAP2
+ * @param count quantidade de instruções
+ * @return a quantidade de instruções executadas no ponto alcançado
+ */
+long debugger_step_back(Environment * env, long count);
+
+/**
+ * Volta até logo depois da última instrução que escreveu no endereço
+ * dado
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @return a quantidade de instruções executadas no ponto alcançado (-1
+ * se o endereço não foi escrito antes do ponto atual, que não é alterado)
+ */
+long debugger_last_write(Environment * env, uhex2_t address);
+
+/**
+ * Adiciona uma parada antes da instrução do endereço dado
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @param condition a condição (ex.: "A=5H", "B!=0H", "C>=10H", "Z=1")
+ * ou NULL para sempre parar
+ * @return o código de erro (EXIT_INVALID_ARGUMENT se a condição for
+ * inválida, EXIT_NO_MEMORY se não couberem mais paradas)
+ */
+ErrorCode_t debugger_add_breakpoint(Environment * env, uhex2_t address, const char * condition);
+
+/**
+ * Remove as paradas do endereço dado
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @return quantas paradas foram removidas
+ */
+int debugger_remove_breakpoints(Environment * env, uhex2_t address);
+
+/**
+ * Vigia (ou deixa de vigiar) as escritas no endereço dado
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @param watch se o endereço passa a ser vigiado
+ */
+void debugger_watch(Environment * env, uhex2_t address, bool watch);
+
+/**
+ * Retorna se há uma parada (com a condição verdadeira) na instrução do
+ * contador de programa
+ * @param env o ambiente do SAP2
+ */
+bool debugger_should_break(Environment * env);
+
+/**
+ * Retorna o endereço vigiado escrito desde a última chamada (e esquece
+ * essa escrita)
+ * @param env o ambiente do SAP2
+ * @return o endereço (-1 se nenhum endereço vigiado foi escrito)
+ */
+long debugger_take_watch_hit(Environment * env);
+
+/**
+ * Pergunta o que fazer depois de uma instrução no modo de depuração:
+ * enter continua para a próxima instrução e os comandos do depurador
+ * (ver "ajuda") movem a execução para outro ponto.
+ * @param env o ambiente do SAP2
+ */
+void debugger_prompt(Environment * env);
+
+#endif //SAP2_COMPILER_DEBUGGER_H
@@ -0,0 +1,680 @@
+// Servidor do protocolo remoto do GDB (RSP) para o SAP2
+//
+// Author: André
+// Date: 28/10/2025
+//
+
+#define _DEFAULT_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <netinet/in.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "gdbstub.h"
+#include "debugger.h"
+#include "../interpreter.h"
+#include "../Instructions/Instructions.h"
+#include "../Runtime/evaluate.h"
+
+#ifdef _WIN32
+
+ErrorCode_t gdbstub_serve(Environment * env, const char * address) {
+    (void)env;
+    (void)address;
+    fprintf(stderr, "[ERRO] O servidor do GDB ainda nao existe no Windows.\n");
+    return EXIT_INVALID_ARGUMENT;
+}
+
+#else
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+
+// Descrição dos registradores para o depurador
+static const char TARGET_XML[] =
+    "<?xml version=\"1.0\"?>"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+    "<target version=\"1.0\">"
+    "<feature name=\"org.sap2.core\">"
+    "<reg name=\"a\" bitsize=\"8\" type=\"uint8\" regnum=\"0\"/>"
+    "<reg name=\"b\" bitsize=\"8\" type=\"uint8\"/>"
+    "<reg name=\"c\" bitsize=\"8\" type=\"uint8\"/>"
+    "<reg name=\"flags\" bitsize=\"8\" type=\"uint8\"/>"
+    "<reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>"
+    "</feature>"
+    "</target>";
+
+#define REGISTER_FLAGS 3
+#define REGISTER_PC 4
+#define FLAG_S_BIT 0x80
+#define FLAG_Z_BIT 0x40
+
+// Como a execução parou
+typedef enum {
+    STOP_STEP,      // fim do passo
+    STOP_BREAK,     // parada
+    STOP_WATCH,     // escrita em um endereço vigiado
+    STOP_INTERRUPT, // Ctrl-C do depurador
+    STOP_EXITED     // o programa terminou
+} stopReason_t;
+
+// Conexão com o depurador
+typedef struct {
+    Environment * env;
+    int fd;
+    // Se os pacotes são confirmados com '+' (até o QStartNoAckMode)
+    bool ack;
+    // Bytes recebidos e ainda não lidos
+    unsigned char received[4096];
+    size_t receivedStart;
+    size_t receivedEnd;
+    // Pacote atual (sem o '$' e o checksum)
+    char packet[GDBSTUB_PACKET_SIZE + 1];
+    // Resposta atual
+    char reply[GDBSTUB_PACKET_SIZE + 1];
+    // Se o programa terminou (e com qual código)
+    bool exited;
+    ErrorCode_t exitCode;
+    // Endereço vigiado da última parada
+    long watchAddress;
+    // Se o depurador se desconectou deixando o programa continuar (D)
+    bool detached;
+} gdbstub_t;
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/**
+ * Lê um número hexadecimal do texto e avança o texto
+ * @return se havia um número
+ */
+static bool parse_hex(const char ** text, unsigned long * value) {
+    const char * start = *text;
+    *value = 0;
+    while (hex_value(**text) >= 0) {
+        *value = *value * 16 + (unsigned long)hex_value(**text);
+        (*text)++;
+    }
+    return *text != start;
+}
+
+/**
+ * Lê o próximo byte da conexão
+ * @return o byte (-1 se a conexão foi fechada)
+ */
+static int stub_getc(gdbstub_t * stub) {
+    if (stub->receivedStart == stub->receivedEnd) {
+        ssize_t n;
+        do {
+            n = recv(stub->fd, stub->received, sizeof(stub->received), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return -1;
+        stub->receivedStart = 0;
+        stub->receivedEnd = (size_t)n;
+    }
+    return stub->received[stub->receivedStart++];
+}
+
+static bool stub_write(gdbstub_t * stub, const char * data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(stub->fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Envia um pacote (e espera a confirmação, se ela estiver ativa)
+ * @return se o pacote foi enviado
+ */
+static bool stub_send(gdbstub_t * stub, const char * payload) {
+    size_t size = strlen(payload);
+    char * frame = malloc(size + 5);
+    if (frame == NULL)
+        return false;
+
+    unsigned char checksum = 0;
+    for (size_t i = 0; i < size; i++)
+        checksum += (unsigned char)payload[i];
+    frame[0] = '$';
+    memcpy(frame + 1, payload, size);
+    frame[size + 1] = '#';
+    frame[size + 2] = HEX_DIGITS[checksum >> 4];
+    frame[size + 3] = HEX_DIGITS[checksum & 0xF];
+
+    bool sent;
+    while ((sent = stub_write(stub, frame, size + 4)) && stub->ack) {
+        int c = stub_getc(stub);
+        // Reenvia se o depurador não recebeu direito
+        if (c != '-') {
+            sent = c == '+';
+            break;
+        }
+    }
+    free(frame);
+    return sent;
+}
+
+/**
+ * Lê o próximo pacote (em stub->packet)
+ * @return se um pacote foi lido (false se a conexão foi fechada)
+ */
+static bool stub_receive(gdbstub_t * stub) {
+    while (true) {
+        int c;
+        // Ignora tudo até o começo de um pacote (inclusive um Ctrl-C
+        // quando a execução já está parada)
+        do {
+            c = stub_getc(stub);
+            if (c < 0) return false;
+        } while (c != '$');
+
+        size_t size = 0;
+        unsigned char checksum = 0;
+        bool overflow = false;
+        while ((c = stub_getc(stub)) != '#') {
+            if (c < 0) return false;
+            checksum += (unsigned char)c;
+            if (size < GDBSTUB_PACKET_SIZE) stub->packet[size++] = (char)c;
+            else overflow = true;
+        }
+        stub->packet[size] = '\0';
+
+        int high = stub_getc(stub), low = stub_getc(stub);
+        if (high < 0 || low < 0) return false;
+        bool valid = !overflow && hex_value((char)high) * 16 + hex_value((char)low) == checksum;
+        if (stub->ack && !stub_write(stub, valid ? "+" : "-", 1))
+            return false;
+        if (valid)
+            return true;
+    }
+}
+
+/**
+ * Retorna se o depurador pediu para interromper a execução (Ctrl-C).
+ * Os outros bytes que chegarem ficam guardados para o próximo pacote.
+ */
+static bool stub_interrupted(gdbstub_t * stub) {
+    struct pollfd pfd = { .fd = stub->fd, .events = POLLIN };
+    if (poll(&pfd, 1, 0) > 0) {
+        // Junta os bytes não lidos no começo para caber o que chegou
+        size_t pending = stub->receivedEnd - stub->receivedStart;
+        memmove(stub->received, stub->received + stub->receivedStart, pending);
+        stub->receivedStart = 0;
+        stub->receivedEnd = pending;
+        if (pending < sizeof(stub->received)) {
+            ssize_t n;
+            do {
+                n = recv(stub->fd, stub->received + pending, sizeof(stub->received) - pending, 0);
+            } while (n < 0 && errno == EINTR);
+            // A conexão fechada também interrompe (o próximo pacote não vem)
+            if (n <= 0)
+                return true;
+            stub->receivedEnd += (size_t)n;
+        }
+    }
+
+    unsigned char * start = stub->received + stub->receivedStart;
+    unsigned char * interrupt = memchr(start, 0x03, stub->receivedEnd - stub->receivedStart);
+    if (interrupt == NULL)
+        return false;
+    // Tira só o Ctrl-C do que foi recebido
+    memmove(interrupt, interrupt + 1, (size_t)(stub->received + stub->receivedEnd - interrupt - 1));
+    stub->receivedEnd--;
+    return true;
+}
+
+/**
+ * Executa uma instrução (ou até a próxima parada) de forma que um erro
+ * fatal só encerre o programa, e não o servidor
+ */
+static stopReason_t stub_resume(gdbstub_t * stub, bool step) {
+    Environment * env = stub->env;
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    int code = setjmp(on_fatal);
+    if (code != 0) {
+        env->diagnostics.on_fatal = previous;
+        stub->exited = true;
+        stub->exitCode = (ErrorCode_t)code;
+        return STOP_EXITED;
+    }
+    env->diagnostics.on_fatal = &on_fatal;
+
+    stopReason_t reason = STOP_STEP;
+    for (long n = 0;; n++) {
+        debugger_before_instruction(env);
+        // A parada de onde a execução continua não para de novo
+        if (n > 0 && debugger_should_break(env)) {
+            reason = STOP_BREAK;
+            break;
+        }
+
+        ErrorCode_t err = execute_instruction(env);
+        if (err != EXIT_SUCCESS) {
+            // Como na execução normal, HLT e o fim do código são sucesso
+            if (err == EXIT_HLT || err == EXIT_NO_INSTRUCTION) {
+                if (env->usedAddressesSize > 0 && env_params->hlt_prints_memory)
+                    print_info(env);
+                err = EXIT_SUCCESS;
+            }
+            stub->exited = true;
+            stub->exitCode = err;
+            reason = STOP_EXITED;
+            break;
+        }
+
+        stub->watchAddress = debugger_take_watch_hit(env);
+        if (stub->watchAddress >= 0) {
+            reason = STOP_WATCH;
+            break;
+        }
+        if (step)
+            break;
+        if ((n + 1) % GDBSTUB_POLL_INTERVAL == 0 && stub_interrupted(stub)) {
+            reason = STOP_INTERRUPT;
+            break;
+        }
+    }
+
+    env->diagnostics.on_fatal = previous;
+    return reason;
+}
+
+/**
+ * Monta a resposta de uma parada
+ */
+static void stop_reply(gdbstub_t * stub, stopReason_t reason) {
+    switch (reason) {
+        case STOP_BREAK:
+            snprintf(stub->reply, sizeof(stub->reply), "T05swbreak:;");
+            break;
+        case STOP_WATCH:
+            snprintf(stub->reply, sizeof(stub->reply), "T05watch:%lx;", (unsigned long)stub->watchAddress);
+            break;
+        case STOP_INTERRUPT:
+            snprintf(stub->reply, sizeof(stub->reply), "S02");
+            break;
+        case STOP_EXITED:
+            snprintf(stub->reply, sizeof(stub->reply), "W%02x", (unsigned)stub->exitCode & 0xFF);
+            break;
+        default:
+            snprintf(stub->reply, sizeof(stub->reply), "S05");
+            break;
+    }
+}
+
+static unsigned read_register(const Environment * env, unsigned long number) {
+    switch (number) {
+        case REGISTER_A:
+        case REGISTER_B:
+        case REGISTER_C:
+            return (uhex1_t)env->registers[number];
+        case REGISTER_FLAGS:
+            return (env->flags[FLAG_S] ? FLAG_S_BIT : 0) | (env->flags[FLAG_Z] ? FLAG_Z_BIT : 0);
+        default:
+            return env->programCounter;
+    }
+}
+
+static void write_register(Environment * env, unsigned long number, unsigned value) {
+    switch (number) {
+        case REGISTER_A:
+        case REGISTER_B:
+        case REGISTER_C:
+            env->registers[number] = (hex1_t)(uhex1_t)value;
+            break;
+        case REGISTER_FLAGS:
+            env->flags[FLAG_S] = (value & FLAG_S_BIT) != 0;
+            env->flags[FLAG_Z] = (value & FLAG_Z_BIT) != 0;
+            break;
+        default:
+            env->programCounter = (uhex2_t)value;
+            break;
+    }
+}
+
+/**
+ * Escreve o registrador na resposta (em hexadecimal, little-endian)
+ */
+static char * put_register(char * out, const Environment * env, unsigned long number) {
+    unsigned value = read_register(env, number);
+    int bytes = number == REGISTER_PC ? 2 : 1;
+    for (int i = 0; i < bytes; i++, value >>= 8) {
+        *out++ = HEX_DIGITS[(value >> 4) & 0xF];
+        *out++ = HEX_DIGITS[value & 0xF];
+    }
+    *out = '\0';
+    return out;
+}
+
+/**
+ * Lê o valor de um registrador do texto (em hexadecimal, little-endian)
+ * @return se o valor é válido
+ */
+static bool take_register(const char ** text, unsigned long number, unsigned * value) {
+    int bytes = number == REGISTER_PC ? 2 : 1;
+    *value = 0;
+    for (int i = 0; i < bytes; i++) {
+        int high = hex_value((*text)[0]);
+        int low = high >= 0 ? hex_value((*text)[1]) : -1;
+        if (low < 0)
+            return false;
+        *value |= (unsigned)(high * 16 + low) << (8 * i);
+        *text += 2;
+    }
+    return true;
+}
+
+/**
+ * Responde um pacote
+ * @return false se a conexão deve ser encerrada
+ */
+static bool stub_handle(gdbstub_t * stub) {
+    Environment * env = stub->env;
+    const char * packet = stub->packet;
+    char * reply = stub->reply;
+    reply[0] = '\0';
+    unsigned long address, length, number;
+
+    switch (packet[0]) {
+        case '?':
+            if (stub->exited) stop_reply(stub, STOP_EXITED);
+            else strcpy(reply, "S05");
+            break;
+
+        case 'g': {
+            char * out = reply;
+            for (unsigned long i = 0; i <= REGISTER_PC; i++)
+                out = put_register(out, env, i);
+            break;
+        }
+
+        case 'G': {
+            const char * text = packet + 1;
+            unsigned values[REGISTER_PC + 1];
+            bool valid = true;
+            for (unsigned long i = 0; i <= REGISTER_PC && valid; i++)
+                valid = take_register(&text, i, &values[i]);
+            if (!valid) { strcpy(reply, "E01"); break; }
+            for (unsigned long i = 0; i <= REGISTER_PC; i++)
+                write_register(env, i, values[i]);
+            strcpy(reply, "OK");
+            break;
+        }
+
+        case 'p': {
+            const char * text = packet + 1;
+            if (!parse_hex(&text, &number) || number > REGISTER_PC) { strcpy(reply, "E01"); break; }
+            put_register(reply, env, number);
+            break;
+        }
+
+        case 'P': {
+            const char * text = packet + 1;
+            unsigned value;
+            if (!parse_hex(&text, &number) || number > REGISTER_PC || *text++ != '='
+                || !take_register(&text, number, &value)) {
+                strcpy(reply, "E01");
+                break;
+            }
+            write_register(env, number, value);
+            strcpy(reply, "OK");
+            break;
+        }
+
+        case 'm': {
+            const char * text = packet + 1;
+            if (!parse_hex(&text, &address) || *text++ != ',' || !parse_hex(&text, &length)) {
+                strcpy(reply, "E01");
+                break;
+            }
+            // A memória tem 64 KiB; o resto é lido como erro
+            if (address > UHEX2_MAX) { strcpy(reply, "E02"); break; }
+            if (length > GDBSTUB_PACKET_SIZE / 2) length = GDBSTUB_PACKET_SIZE / 2;
+            if (address + length > UHEX2_MAX + 1) length = UHEX2_MAX + 1 - address;
+            char * out = reply;
+            for (unsigned long i = 0; i < length; i++) {
+                uhex1_t value = (uhex1_t)env_read_unit(env, address + i).value;
+                *out++ = HEX_DIGITS[value >> 4];
+                *out++ = HEX_DIGITS[value & 0xF];
+            }
+            *out = '\0';
+            break;
+        }
+
+        case 'M': {
+            const char * text = packet + 1;
+            if (!parse_hex(&text, &address) || *text++ != ',' || !parse_hex(&text, &length) || *text++ != ':'
+                || address + length > UHEX2_MAX + 1 || strlen(text) < length * 2) {
+                strcpy(reply, "E01");
+                break;
+            }
+            for (unsigned long i = 0; i < length; i++) {
+                int high = hex_value(text[2 * i]), low = hex_value(text[2 * i + 1]);
+                if (high < 0 || low < 0) { strcpy(reply, "E01"); return true; }
+            }
+            for (unsigned long i = 0; i < length; i++) {
+                memoryUnit_t * unit = env_write_unit(env, (uhex2_t)(address + i));
+                unit->value = (hex1_t)(uhex1_t)(hex_value(text[2 * i]) * 16 + hex_value(text[2 * i + 1]));
+            }
+            strcpy(reply, "OK");
+            break;
+        }
+
+        case 'Z':
+        case 'z': {
+            // Z0/Z1: parada; Z2: escrita em um endereço vigiado
+            const char * text = packet + 1;
+            unsigned long type;
+            if (!parse_hex(&text, &type) || *text++ != ',' || !parse_hex(&text, &address) || address > UHEX2_MAX) {
+                strcpy(reply, "E01");
+                break;
+            }
+            bool insert = packet[0] == 'Z';
+            if (type == 0 || type == 1) {
+                if (!insert) debugger_remove_breakpoints(env, (uhex2_t)address);
+                else if (debugger_add_breakpoint(env, (uhex2_t)address, NULL) != EXIT_SUCCESS) {
+                    strcpy(reply, "E03");
+                    break;
+                }
+            } else if (type == 2) {
+                // Vigia todos os endereços do trecho pedido
+                if (*text++ != ',' || !parse_hex(&text, &length) || length == 0)
+                    length = 1;
+                for (unsigned long i = 0; i < length && address + i <= UHEX2_MAX; i++)
+                    debugger_watch(env, (uhex2_t)(address + i), insert);
+            } else {
+                break; // não suportado
+            }
+            strcpy(reply, "OK");
+            break;
+        }
+
+        case 's':
+        case 'c': {
+            if (stub->exited) { strcpy(reply, "E01"); break; }
+            const char * text = packet + 1;
+            if (parse_hex(&text, &address))
+                env->programCounter = (uhex2_t)address;
+            stop_reply(stub, stub_resume(stub, packet[0] == 's'));
+            break;
+        }
+
+        case 'H':
+            strcpy(reply, "OK");
+            break;
+
+        case 'k':
+            return false;
+
+        case 'D':
+            stub_send(stub, "OK");
+            stub->detached = true;
+            return false;
+
+        case 'q':
+            if (strncmp(packet, "qSupported", 10) == 0) {
+                snprintf(reply, GDBSTUB_PACKET_SIZE, "PacketSize=%x;qXfer:features:read+;swbreak+;QStartNoAckMode+",
+                    GDBSTUB_PACKET_SIZE);
+            } else if (strcmp(packet, "qAttached") == 0) {
+                strcpy(reply, "1");
+            } else if (strcmp(packet, "qC") == 0) {
+                strcpy(reply, "QC1");
+            } else if (strcmp(packet, "qfThreadInfo") == 0) {
+                strcpy(reply, "m1");
+            } else if (strcmp(packet, "qsThreadInfo") == 0) {
+                strcpy(reply, "l");
+            } else if (strncmp(packet, "qXfer:features:read:target.xml:", 31) == 0) {
+                const char * text = packet + 31;
+                unsigned long offset;
+                if (!parse_hex(&text, &offset) || *text++ != ',' || !parse_hex(&text, &length)) {
+                    strcpy(reply, "E01");
+                    break;
+                }
+                size_t total = sizeof(TARGET_XML) - 1;
+                if (offset >= total) { strcpy(reply, "l"); break; }
+                if (length > GDBSTUB_PACKET_SIZE - 1) length = GDBSTUB_PACKET_SIZE - 1;
+                if (length > total - offset) length = total - offset;
+                reply[0] = offset + length < total ? 'm' : 'l';
+                memcpy(reply + 1, TARGET_XML + offset, length);
+                reply[length + 1] = '\0';
+            }
+            break;
+
+        case 'Q':
+            if (strcmp(packet, "QStartNoAckMode") == 0) {
+                bool sent = stub_send(stub, "OK");
+                stub->ack = false;
+                return sent;
+            }
+            break;
+
+        default:
+            break; // resposta vazia: pacote não suportado
+    }
+
+    return stub_send(stub, reply);
+}
+
+/**
+ * Abre o endereço dado (porta TCP ou caminho de socket Unix) e espera
+ * uma conexão
+ * @return a conexão (-1 se houver erro)
+ */
+static int stub_accept(const char * address) {
+    char * end = NULL;
+    long port = strtol(address, &end, 10);
+    bool tcp = *address != '\0' && *end == '\0';
+
+    int server;
+    if (tcp) {
+        if (port <= 0 || port > 65535)
+            return -1;
+        server = socket(AF_INET, SOCK_STREAM, 0);
+        if (server < 0)
+            return -1;
+        int yes = 1;
+        setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        struct sockaddr_in in = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(server, (struct sockaddr *)&in, sizeof(in)) != 0 || listen(server, 1) != 0) {
+            close(server);
+            return -1;
+        }
+        fprintf(stderr, "Esperando o depurador em 127.0.0.1:%ld (ex.: \"target remote :%ld\")...\n", port, port);
+    } else {
+        struct sockaddr_un un = { .sun_family = AF_UNIX };
+        if (strlen(address) >= sizeof(un.sun_path))
+            return -1;
+        strcpy(un.sun_path, address);
+        server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0)
+            return -1;
+        unlink(address);
+        if (bind(server, (struct sockaddr *)&un, sizeof(un)) != 0 || listen(server, 1) != 0) {
+            close(server);
+            return -1;
+        }
+        fprintf(stderr, "Esperando o depurador em \"%s\"...\n", address);
+    }
+
+    int fd;
+    do {
+        fd = accept(server, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+    close(server);
+    if (!tcp)
+        unlink(address);
+    return fd;
+}
+
+ErrorCode_t gdbstub_serve(Environment * env, const char * address) {
+    gdbstub_t * stub = calloc(1, sizeof(gdbstub_t));
+    if (stub == NULL)
+        return EXIT_NO_MEMORY;
+    stub->env = env;
+    stub->ack = true;
+    stub->watchAddress = -1;
+
+    // O depurador controla a execução: sem limites e sem esperar os T-States
+    bool paced = env->params.paced;
+    env->params.debug_mode = false;
+    env->params.paced = false;
+    ErrorCode_t err = debugger_attach(env);
+    if (err != EXIT_SUCCESS) {
+        free(stub);
+        return err;
+    }
+
+    stub->fd = stub_accept(address);
+    if (stub->fd < 0) {
+        fprintf(stderr, "[ERRO] Nao foi possivel esperar o depurador em \"%s\".\n", address);
+        free(stub);
+        return EXIT_INVALID_ARGUMENT;
+    }
+    fprintf(stderr, "Depurador conectado.\n");
+
+    while (stub_receive(stub) && stub_handle(stub))
+        ;
+
+    close(stub->fd);
+    err = stub->exited ? stub->exitCode : EXIT_SUCCESS;
+
+    // Sem o depurador, o programa continua como numa execução normal
+    if (stub->detached && !stub->exited) {
+        fprintf(stderr, "Depurador desconectado. O programa continua.\n");
+        debugger_detach(env);
+        env->params.paced = paced;
+        err = run_env(env);
+    }
+    free(stub);
+    return err;
+}
+
+#endif // _WIN32
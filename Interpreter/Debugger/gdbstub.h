@@ -0,0 +1,40 @@
+// Servidor do protocolo remoto do GDB (RSP) para o SAP2: permite
+// depurar um programa com ferramentas que falam esse protocolo ao invés
+// do modo de depuração do terminal. Só existe em sistemas POSIX.
+//
+// Registradores (na ordem dos pacotes "g"/"G"/"p"/"P"):
+//   0 a, 1 b, 2 c (8 bits), 3 flags (8 bits: S no bit 7, Z no bit 6,
+//   como no PSW do 8085), 4 pc (16 bits, little-endian)
+// A descrição deles é enviada como "target.xml" (qXfer:features:read).
+// Também há paradas (Z0/Z1), endereços vigiados para escrita (Z2),
+// passo (s), continuar (c) e interrupção (Ctrl-C).
+//
+// Author: André
+// Date: 28/10/2025
+//
+
+#ifndef SAP2_COMPILER_GDBSTUB_H
+#define SAP2_COMPILER_GDBSTUB_H
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Maior pacote aceito (em bytes)
+#define GDBSTUB_PACKET_SIZE 4096
+// A cada quantas instruções a conexão é verificada (Ctrl-C) durante o "c"
+#define GDBSTUB_POLL_INTERVAL 65536
+
+/**
+ * Espera a conexão de um depurador e atende os pacotes dele até ele
+ * desconectar (ou encerrar o programa). O programa já deve estar
+ * montado no ambiente. A execução não tem limite de tempo nem de
+ * instruções e não espera o tempo dos T-States. Se o depurador se
+ * desconectar com "D" (detach), o programa continua até o fim como
+ * numa execução normal (com os limites dos parâmetros).
+ * @param env o ambiente do SAP2
+ * @param address a porta TCP (em 127.0.0.1) ou o caminho de um socket Unix
+ * @return o código de erro
+ */
+ErrorCode_t gdbstub_serve(Environment * env, const char * address);
+
+#endif //SAP2_COMPILER_GDBSTUB_H
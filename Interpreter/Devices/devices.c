@@ -0,0 +1,337 @@
+// Dispositivos de entrada e saída ligados às portas do IN/OUT
+//
+// Author: André
+// Date: 06/11/2025
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "devices.h"
+#include "../Input/input.h"
+#include "../Utils/Utils.h"
+
+// Tipos de dispositivo //
+
+static bool read_zero(device_t * device, hex1_t * value) {
+    (void)device;
+    *value = 0;
+    return true;
+}
+
+static bool read_none(device_t * device, hex1_t * value) {
+    (void)device;
+    (void)value;
+    return false;
+}
+
+static void write_discard(device_t * device, hex1_t value) {
+    (void)value;
+    device->lost++;
+}
+
+static void write_ignore(device_t * device, hex1_t value) {
+    (void)device;
+    (void)value;
+}
+
+static bool read_constant(device_t * device, hex1_t * value) {
+    *value = device->value;
+    return true;
+}
+
+static bool read_counter(device_t * device, hex1_t * value) {
+    *value = device->value;
+    device->value = (hex1_t)(device->value + device->step);
+    return true;
+}
+
+static void write_counter(device_t * device, hex1_t value) {
+    device->value = value;
+}
+
+static bool read_ring(device_t * device, hex1_t * value) {
+    if (device->count == 0)
+        return false;
+    size_t tail = (device->head + device->capacity - device->count) % device->capacity;
+    *value = device->ring[tail];
+    device->count--;
+    return true;
+}
+
+static void write_ring(device_t * device, hex1_t value) {
+    device->ring[device->head] = value;
+    device->head = (device->head + 1) % device->capacity;
+    if (device->count < device->capacity)
+        device->count++;
+    else
+        device->lost++; // o mais antigo foi sobrescrito
+}
+
+static void close_ring(device_t * device) {
+    free(device->ring);
+}
+
+static bool read_file(device_t * device, hex1_t * value) {
+    int c = fgetc(device->stream);
+    if (c == EOF)
+        return false;
+    *value = (hex1_t)c;
+    return true;
+}
+
+static void write_file(device_t * device, hex1_t value) {
+    fputc((uhex1_t)value, device->stream);
+}
+
+static void restart_file(device_t * device) {
+    rewind(device->stream);
+}
+
+static bool read_values(device_t * device, hex1_t * value) {
+    if (device->valuesIndex >= device->valuesSize)
+        return false;
+    *value = device->values[device->valuesIndex++];
+    return true;
+}
+
+static void restart_values(device_t * device) {
+    device->valuesIndex = 0;
+}
+
+static void close_values(device_t * device) {
+    free(device->values);
+    free(device->path);
+}
+
+/**
+ * Guarda uma cópia do caminho do arquivo (para o relatório)
+ */
+static void copy_path(device_t * device, const char * path) {
+    size_t pathSize = strlen(path) + 1;
+    device->path = malloc(pathSize);
+    if (device->path != NULL)
+        memcpy(device->path, path, pathSize);
+}
+
+static void close_file(device_t * device) {
+    if (device->stream != NULL)
+        fclose(device->stream);
+    free(device->path);
+}
+
+// Criação //
+
+/**
+ * Lê um hexadecimal no formato 12H
+ * @return se conseguiu ler
+ */
+static bool parse_hex(const char * text, hex1_t * value) {
+    return text != NULL && str_to_hex1(text, value) == EXIT_SUCCESS;
+}
+
+/**
+ * Cria o dispositivo descrito (a parte depois do '=')
+ * @return o código de erro
+ */
+static ErrorCode_t create_device(const char * description, device_t * device, char * error, size_t size) {
+    memset(device, 0, sizeof(device_t));
+    char kind[32];
+    const char * argument = strchr(description, ':');
+    size_t length = argument != NULL ? (size_t)(argument - description) : strlen(description);
+    if (length >= sizeof(kind)) {
+        snprintf(error, size, "dispositivo desconhecido: \"%s\"", description);
+        return EXIT_INVALID_ARGUMENT;
+    }
+    memcpy(kind, description, length);
+    kind[length] = '\0';
+    if (argument != NULL)
+        argument++;
+
+    if (strcmp(kind, "nulo") == 0) {
+        device->kind = "nulo";
+        device->read = read_zero;
+        device->write = write_ignore;
+    } else if (strcmp(kind, "constante") == 0) {
+        device->kind = "constante";
+        device->read = read_constant;
+        device->write = write_discard;
+        if (!parse_hex(argument, &device->value)) {
+            snprintf(error, size, "\"constante\" espera um hexadecimal (ex.: constante:12H)");
+            return EXIT_INVALID_ARGUMENT;
+        }
+    } else if (strcmp(kind, "contador") == 0) {
+        device->kind = "contador";
+        device->read = read_counter;
+        device->write = write_counter;
+        device->step = 1;
+        char start[16] = { 0 };
+        const char * step = argument != NULL ? strchr(argument, ':') : NULL;
+        if (argument != NULL)
+            snprintf(start, sizeof(start), "%.*s", (int)(step != NULL ? step - argument : (long)strlen(argument)), argument);
+        if (!parse_hex(start, &device->value) || (step != NULL && !parse_hex(step + 1, &device->step))) {
+            snprintf(error, size, "\"contador\" espera o valor inicial e o passo opcional (ex.: contador:00H:2H)");
+            return EXIT_INVALID_ARGUMENT;
+        }
+    } else if (strcmp(kind, "anel") == 0) {
+        device->kind = "anel";
+        device->read = read_ring;
+        device->write = write_ring;
+        device->close = close_ring;
+        char * endptr = NULL;
+        long capacity = argument != NULL ? strtol(argument, &endptr, 10) : 0;
+        if (argument == NULL || strlen(endptr) > 0 || capacity < 1 || capacity > DEVICE_RING_MAX) {
+            snprintf(error, size, "\"anel\" espera a quantidade de valores, de 1 a %d (ex.: anel:16)", DEVICE_RING_MAX);
+            return EXIT_INVALID_ARGUMENT;
+        }
+        device->capacity = (size_t)capacity;
+        device->ring = calloc(device->capacity, sizeof(hex1_t));
+        if (device->ring == NULL)
+            return EXIT_NO_MEMORY;
+    } else if (strcmp(kind, "saida") == 0 || strcmp(kind, "entrada") == 0) {
+        bool output = kind[0] == 's';
+        device->kind = output ? "saida" : "entrada";
+        device->read = output ? read_none : read_file;
+        device->write = output ? write_file : write_discard;
+        device->restart = output ? NULL : restart_file;
+        device->close = close_file;
+        if (argument == NULL || *argument == '\0') {
+            snprintf(error, size, "\"%s\" espera o caminho do arquivo (ex.: %s:valores.bin)", kind, kind);
+            return EXIT_INVALID_ARGUMENT;
+        }
+        device->stream = fopen(argument, output ? "wb" : "rb");
+        if (device->stream == NULL) {
+            snprintf(error, size, "nao foi possivel abrir o arquivo \"%s\"", argument);
+            return EXIT_FILE_NOT_FOUND;
+        }
+        setvbuf(device->stream, NULL, _IOFBF, DEVICE_FILE_BUFFER_SIZE);
+        copy_path(device, argument);
+    } else if (strcmp(kind, "valores") == 0) {
+        device->kind = "valores";
+        device->read = read_values;
+        device->write = write_discard;
+        device->restart = restart_values;
+        device->close = close_values;
+        if (argument == NULL || *argument == '\0') {
+            snprintf(error, size, "\"valores\" espera o caminho do arquivo (ex.: valores:entradas.txt)");
+            return EXIT_INVALID_ARGUMENT;
+        }
+        char reason[128];
+        ErrorCode_t err = input_load(argument, &device->values, &device->valuesSize, reason, sizeof(reason));
+        if (err != EXIT_SUCCESS) {
+            snprintf(error, size, "%s", reason);
+            return err;
+        }
+        copy_path(device, argument);
+    } else {
+        snprintf(error, size, "dispositivo desconhecido: \"%s\" (use nulo, constante, contador, anel, saida, entrada ou valores)", kind);
+        return EXIT_INVALID_ARGUMENT;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Fecha e libera o dispositivo
+ */
+static void destroy_device(device_t * device) {
+    if (device == NULL)
+        return;
+    if (device->close != NULL)
+        device->close(device);
+    free(device);
+}
+
+deviceTable_t * devices_create(void) {
+    return calloc(1, sizeof(deviceTable_t));
+}
+
+ErrorCode_t devices_attach(deviceTable_t * table, const char * spec, char * error, size_t size) {
+    const char * equals = strchr(spec, '=');
+    char port[16];
+    if (equals == NULL || (size_t)(equals - spec) >= sizeof(port)) {
+        snprintf(error, size, "esperado \"<porta>=<dispositivo>\" (ex.: 04H=anel:16), mas foi encontrado \"%s\"", spec);
+        return EXIT_INVALID_ARGUMENT;
+    }
+    memcpy(port, spec, equals - spec);
+    port[equals - spec] = '\0';
+    hex1_t number;
+    if (!parse_hex(port, &number)) {
+        snprintf(error, size, "a porta \"%s\" nao eh um hexadecimal de 00H a 0FFH", port);
+        return EXIT_INVALID_ARGUMENT;
+    }
+
+    device_t * device = malloc(sizeof(device_t));
+    if (device == NULL)
+        return EXIT_NO_MEMORY;
+    ErrorCode_t err = create_device(equals + 1, device, error, size);
+    if (err != EXIT_SUCCESS) {
+        if (device->close != NULL)
+            device->close(device);
+        free(device);
+        return err;
+    }
+    destroy_device(table->ports[(uhex1_t)number]);
+    table->ports[(uhex1_t)number] = device;
+    return EXIT_SUCCESS;
+}
+
+bool device_read(device_t * device, hex1_t * value) {
+    if (!device->read(device, value))
+        return false;
+    device->reads++;
+    return true;
+}
+
+bool device_restart(device_t * device) {
+    if (device->restart == NULL)
+        return false;
+    device->restart(device);
+    return true;
+}
+
+void device_write(device_t * device, hex1_t value) {
+    device->writes++;
+    device->write(device, value);
+}
+
+void devices_report(const deviceTable_t * table, FILE * out) {
+    fprintf(out, "\nDispositivos ==============================\n");
+    fprintf(out, "%-6s| %-10s| %-10s| %-10s| %-11s| %s\n", "Porta", "Tipo", "Escritos", "Lidos", "Descartados", "Estado");
+    for (int port = 0; port < DEVICE_PORT_COUNT; port++) {
+        const device_t * device = table->ports[port];
+        if (device == NULL)
+            continue;
+        fprintf(out, "%02XH   | %-10s| %-10llu| %-10llu| %-11llu| ", port, device->kind,
+            (unsigned long long)device->writes, (unsigned long long)device->reads, (unsigned long long)device->lost);
+
+        if (device->ring != NULL) {
+            // Os últimos valores que ainda estão no anel (do mais antigo ao mais novo)
+            size_t shown = device->count < DEVICE_REPORT_VALUES ? device->count : DEVICE_REPORT_VALUES;
+            fprintf(out, "%lu/%lu:", (unsigned long)device->count, (unsigned long)device->capacity);
+            for (size_t i = shown; i > 0; i--)
+                fprintf(out, " %02XH", (uhex1_t)device->ring[(device->head + device->capacity - i) % device->capacity]);
+        } else if (device->read == read_values) {
+            fprintf(out, "%lu/%lu: %s", (unsigned long)device->valuesIndex, (unsigned long)device->valuesSize,
+                device->path != NULL ? device->path : "");
+        } else if (device->path != NULL) {
+            fprintf(out, "%s", device->path);
+        } else if (device->read == read_constant || device->read == read_counter) {
+            fprintf(out, "%02XH", (uhex1_t)device->value);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void devices_flush(deviceTable_t * table) {
+    for (int port = 0; port < DEVICE_PORT_COUNT; port++)
+        if (table->ports[port] != NULL && table->ports[port]->stream != NULL)
+            fflush(table->ports[port]->stream);
+}
+
+void devices_destroy(deviceTable_t * table) {
+    if (table == NULL)
+        return;
+    for (int port = 0; port < DEVICE_PORT_COUNT; port++)
+        destroy_device(table->ports[port]);
+    free(table);
+}
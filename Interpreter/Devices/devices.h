@@ -0,0 +1,147 @@
+// Dispositivos de entrada e saída ligados às portas do IN/OUT. Cada
+// porta (00H a FFH) pode ter um dispositivo, que recebe os valores do
+// OUT e fornece os do IN daquela porta no lugar do terminal:
+//     nulo                   descarta o OUT, o IN lê 0
+//     constante:<hex>        o IN sempre lê o valor dado
+//     contador:<hex>[:<hex>] o IN lê o valor e soma o passo (padrão 1H);
+//                            o OUT troca o valor
+//     anel:<n>               buffer circular com n valores: o OUT coloca
+//                            (descartando o mais antigo se estiver cheio)
+//                            e o IN tira, na ordem
+//     saida:<arquivo>        o OUT escreve um byte por valor no arquivo
+//     entrada:<arquivo>      o IN lê um byte por valor do arquivo
+//     valores:<arquivo>      o IN lê os hexadecimais do arquivo (no
+//                            formato do --entrada), carregados de uma vez
+// Os arquivos têm o próprio buffer, então nenhum OUT/IN de uma porta
+// com dispositivo passa pelo terminal.
+//
+// Author: André
+// Date: 06/11/2025
+//
+
+#ifndef SAP2_COMPILER_DEVICES_H
+#define SAP2_COMPILER_DEVICES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade de portas
+#define DEVICE_PORT_COUNT 256
+// Tamanho do buffer dos arquivos dos dispositivos
+#define DEVICE_FILE_BUFFER_SIZE (16 * 1024)
+// Maior buffer circular
+#define DEVICE_RING_MAX 65536
+// Quantos valores do buffer circular aparecem no relatório
+#define DEVICE_REPORT_VALUES 16
+
+// Dispositivo de uma porta
+typedef struct device_s device_t;
+struct device_s {
+    // Nome do tipo do dispositivo ("nulo", "anel", ...)
+    const char * kind;
+    // Lê o próximo valor (retorna false se não houver mais valores)
+    bool (*read)(device_t * device, hex1_t * value);
+    // Recebe um valor do OUT
+    void (*write)(device_t * device, hex1_t value);
+    // Volta para o primeiro valor (NULL se o dispositivo não puder voltar)
+    void (*restart)(device_t * device);
+    // Libera o que for do dispositivo (NULL se não houver nada)
+    void (*close)(device_t * device);
+
+    // Arquivo (saida/entrada)
+    FILE * stream;
+    char * path;
+    // Buffer circular (anel)
+    hex1_t * ring;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    // Valores carregados do arquivo (valores)
+    hex1_t * values;
+    size_t valuesSize;
+    size_t valuesIndex;
+    // Valor e passo (constante/contador)
+    hex1_t value;
+    hex1_t step;
+
+    // Estatísticas
+    uint64_t reads;
+    uint64_t writes;
+    // Valores descartados (anel cheio, OUT em um dispositivo só de entrada...)
+    uint64_t lost;
+};
+
+// Tabela de dispositivos (indexada pela porta)
+typedef struct deviceTable_s {
+    device_t * ports[DEVICE_PORT_COUNT];
+} deviceTable_t;
+
+// Dispositivo da porta dada (NULL se não houver tabela ou dispositivo)
+#define device_at(table, port) \
+    ((table) != NULL ? (table)->ports[(uhex1_t)(port)] : NULL)
+
+/**
+ * Cria uma tabela sem dispositivos
+ * @return a tabela (NULL se não houver memória)
+ */
+deviceTable_t * devices_create(void);
+
+/**
+ * Liga um dispositivo a uma porta, a partir do texto "<porta>=<dispositivo>"
+ * (ex.: "04H=anel:16"). Se a porta já tiver um dispositivo, ele é trocado.
+ * @param table a tabela
+ * @param spec o texto
+ * @param error onde o motivo do erro é escrito (se houver)
+ * @param size o tamanho de "error"
+ * @return o código de erro
+ */
+ErrorCode_t devices_attach(deviceTable_t * table, const char * spec, char * error, size_t size);
+
+/**
+ * Lê um valor do dispositivo
+ * @param device o dispositivo
+ * @param value onde o valor é guardado
+ * @return se havia um valor
+ */
+bool device_read(device_t * device, hex1_t * value);
+
+/**
+ * Faz o dispositivo voltar para o primeiro valor (usado quando os
+ * valores acabam e o fim das entradas é "repetir")
+ * @param device o dispositivo
+ * @return se o dispositivo conseguiu voltar
+ */
+bool device_restart(device_t * device);
+
+/**
+ * Envia um valor do OUT ao dispositivo
+ * @param device o dispositivo
+ * @param value o valor
+ */
+void device_write(device_t * device, hex1_t value);
+
+/**
+ * Imprime o estado de cada dispositivo (valores lidos, escritos e, nos
+ * buffers circulares, os últimos valores)
+ * @param table a tabela
+ * @param out onde o relatório é impresso
+ */
+void devices_report(const deviceTable_t * table, FILE * out);
+
+/**
+ * Descarrega os arquivos dos dispositivos
+ * @param table a tabela
+ */
+void devices_flush(deviceTable_t * table);
+
+/**
+ * Fecha os dispositivos e libera a tabela
+ * @param table a tabela
+ */
+void devices_destroy(deviceTable_t * table);
+
+#endif //SAP2_COMPILER_DEVICES_H
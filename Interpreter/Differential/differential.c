@@ -0,0 +1,390 @@
+// Testes diferenciais dos motores de execução do SAP2
+//
+// Author: André
+// Date: 04/11/2025
+//
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "differential.h"
+#include "../Runtime/evaluate.h"
+#include "../Snapshot/snapshot.h"
+
+// Motores //
+
+/**
+ * Executa o ambiente com o evaluate, voltando para cá nos erros fatais
+ * @return o código de saída da execução
+ */
+static ErrorCode_t evaluate_guarded(Environment * env) {
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    ErrorCode_t err;
+    int code = setjmp(on_fatal);
+    if (code == 0) {
+        env->diagnostics.on_fatal = &on_fatal;
+        err = evaluate(env);
+    } else {
+        err = (ErrorCode_t)code;
+    }
+    env->diagnostics.on_fatal = previous;
+    return err;
+}
+
+/**
+ * Executa o ambiente uma instrução por vez (como o depurador), sem o
+ * evaluate. Conta as instruções executadas se "counts" não for NULL.
+ * @return o código de saída da execução
+ */
+static ErrorCode_t step_guarded(Environment * env, uint64_t * counts) {
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    ErrorCode_t err = EXIT_SUCCESS;
+    int code = setjmp(on_fatal);
+    if (code == 0) {
+        env->diagnostics.on_fatal = &on_fatal;
+        while (env->programCounter < MEMORY_SIZE) {
+            if (env_params->max_evaluated != -1 && env->totalInstructions >= env_params->max_evaluated) {
+                err = EXIT_INSTRUCTION_LIMIT_REACHED;
+                break;
+            }
+            uhex1_t opcode = (uhex1_t)env_read_unit(env, env->programCounter).value;
+            err = execute_instruction(env);
+            if (err == EXIT_SUCCESS || err == EXIT_HLT) {
+                if (counts != NULL)
+                    counts[opcode]++;
+            }
+            if (err != EXIT_SUCCESS) {
+                if (err == EXIT_HLT || err == EXIT_NO_INSTRUCTION)
+                    err = EXIT_SUCCESS;
+                break;
+            }
+        }
+    } else {
+        err = (ErrorCode_t)code;
+    }
+    env->diagnostics.on_fatal = previous;
+    return err;
+}
+
+/**
+ * Referência: o evaluate, do começo ao fim
+ */
+static ErrorCode_t engine_reference(Environment ** env) {
+    return evaluate_guarded(*env);
+}
+
+/**
+ * Uma instrução por vez, com execute_instruction
+ */
+static ErrorCode_t engine_step(Environment ** env) {
+    return step_guarded(*env, NULL);
+}
+
+/**
+ * Executa o ambiente em partes de DIFFERENTIAL_SLICE instruções. Entre
+ * as partes, "resume" pode trocar o ambiente por outro.
+ * @return o código de saída da execução
+ */
+static ErrorCode_t run_in_slices(Environment ** env, ErrorCode_t (*resume)(Environment ** env)) {
+    long limit = (*env)->params.max_evaluated;
+    for (;;) {
+        long slice = (*env)->totalInstructions + DIFFERENTIAL_SLICE;
+        (*env)->params.max_evaluated = limit != -1 && limit < slice ? limit : slice;
+        ErrorCode_t err = evaluate_guarded(*env);
+        (*env)->params.max_evaluated = limit;
+        if (err != EXIT_INSTRUCTION_LIMIT_REACHED || (limit != -1 && (*env)->totalInstructions >= limit))
+            return err;
+        err = resume(env);
+        if (err != EXIT_SUCCESS)
+            return err;
+    }
+}
+
+/**
+ * Grava o estado do ambiente e continua a execução em um ambiente
+ * carregado desse estado (com os mesmos recursos)
+ */
+static ErrorCode_t resume_from_state(Environment ** env) {
+    Environment * old = *env;
+    FILE * f = tmpfile();
+    if (f == NULL)
+        return EXIT_STATE_FILE;
+
+    ErrorCode_t err = env_save_state(old, f);
+    char * data = NULL;
+    long size = 0;
+    if (err == EXIT_SUCCESS && fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0) {
+        rewind(f);
+        data = malloc(size);
+        if (data == NULL || fread(data, 1, size, f) != (size_t)size)
+            err = EXIT_STATE_FILE;
+    } else if (err == EXIT_SUCCESS) {
+        err = EXIT_STATE_FILE;
+    }
+    fclose(f);
+
+    Environment * restored = NULL;
+    if (err == EXIT_SUCCESS)
+        err = env_restore_state(data, size, NULL, &restored);
+    free(data);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    // O estado não guarda os recursos do ambiente
+    restored->in = old->in;
+    restored->out = old->out;
+    restored->diagnostics = old->diagnostics;
+    restored->input = old->input;
+    restored->inputSize = old->inputSize;
+    restored->inputIndex = old->inputIndex;
+    restored->capturedOutput = old->capturedOutput;
+    restored->params = old->params;
+    env_destroy(old);
+    *env = restored;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Continua a execução em uma cópia (env_clone) do ambiente
+ */
+static ErrorCode_t resume_from_clone(Environment ** env) {
+    Environment * copy = env_clone(*env);
+    if (copy == NULL)
+        return EXIT_NO_MEMORY;
+    // A cópia não leva os destinos da execução
+    copy->capturedOutput = (*env)->capturedOutput;
+    copy->output = (*env)->output;
+    copy->devices = (*env)->devices;
+    copy->dump = (*env)->dump;
+    env_destroy(*env);
+    *env = copy;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Em partes, gravando e carregando o estado entre elas
+ */
+static ErrorCode_t engine_state(Environment ** env) {
+    return run_in_slices(env, resume_from_state);
+}
+
+/**
+ * Em partes, cada uma em uma cópia da anterior (páginas compartilhadas)
+ */
+static ErrorCode_t engine_clone(Environment ** env) {
+    return run_in_slices(env, resume_from_clone);
+}
+
+const diffEngine_t DIFFERENTIAL_ENGINES[] = {
+    { "referencia", "evaluate, do comeco ao fim", engine_reference },
+    { "passo", "uma instrucao por vez (como o depurador)", engine_step },
+    { "estado", "em partes, gravando e carregando o estado entre elas", engine_state },
+    { "copia", "em partes, cada uma em uma copia da anterior", engine_clone },
+};
+const int DIFFERENTIAL_ENGINE_COUNT = sizeof(DIFFERENTIAL_ENGINES) / sizeof(DIFFERENTIAL_ENGINES[0]);
+
+const diffEngine_t * differential_find_engine(const char * name) {
+    for (int i = 0; i < DIFFERENTIAL_ENGINE_COUNT; i++)
+        if (strcmp(DIFFERENTIAL_ENGINES[i].name, name) == 0)
+            return &DIFFERENTIAL_ENGINES[i];
+    return NULL;
+}
+
+// Execução e comparação //
+
+/**
+ * Prepara uma cópia do programa para ser executada sem imprimir nada
+ * @return a cópia (NULL se não houver memória)
+ */
+static Environment * prepare(const Environment * image, FILE * discard, hexBuffer_t * output) {
+    Environment * env = env_clone(image);
+    if (env == NULL)
+        return NULL;
+    env->in = discard;
+    env->out = discard;
+    env->diagnostics.warnings = discard;
+    env->diagnostics.errors = discard;
+    env->capturedOutput = output;
+    env->params.hlt_prints_memory = false;
+    env->params.debug_mode = false;
+    env->params.paced = false;
+    env->params.max_evaluated = DIFFERENTIAL_MAX_INSTRUCTIONS;
+    return env;
+}
+
+ErrorCode_t differential_run(const Environment * image, const diffEngine_t * engine, FILE * discard, diffRun_t * run) {
+    memset(run, 0, sizeof(diffRun_t));
+    run->env = prepare(image, discard, &run->output);
+    if (run->env == NULL)
+        return EXIT_NO_MEMORY;
+    run->exitCode = engine->run(&run->env);
+    return EXIT_SUCCESS;
+}
+
+bool differential_compare(const diffRun_t * expected, const diffRun_t * actual, char * description, size_t size) {
+    const Environment * a = expected->env;
+    const Environment * b = actual->env;
+    char unused[8];
+    if (description == NULL) {
+        description = unused;
+        size = sizeof(unused);
+    }
+
+    if (expected->exitCode != actual->exitCode) {
+        snprintf(description, size, "codigo de saida: esperado %d, obtido %d", expected->exitCode, actual->exitCode);
+        return false;
+    }
+    if (a->programCounter != b->programCounter) {
+        snprintf(description, size, "contador de programa: esperado %04XH, obtido %04XH", a->programCounter, b->programCounter);
+        return false;
+    }
+    static const char * REGISTER_NAMES[NUMBER_OF_REGISTERS] = { "A", "B", "C" };
+    for (int i = 0; i < NUMBER_OF_REGISTERS; i++) {
+        if (a->registers[i] != b->registers[i]) {
+            snprintf(description, size, "registrador %s: esperado %02XH, obtido %02XH",
+                REGISTER_NAMES[i], (uhex1_t)a->registers[i], (uhex1_t)b->registers[i]);
+            return false;
+        }
+    }
+    static const char * FLAG_NAMES[NUMBER_OF_FLAGS] = { "S", "Z" };
+    for (int i = 0; i < NUMBER_OF_FLAGS; i++) {
+        if (a->flags[i] != b->flags[i]) {
+            snprintf(description, size, "flag %s: esperado %d, obtido %d", FLAG_NAMES[i], a->flags[i], b->flags[i]);
+            return false;
+        }
+    }
+    if (a->totalInstructions != b->totalInstructions) {
+        snprintf(description, size, "instrucoes executadas: esperado %ld, obtido %ld", a->totalInstructions, b->totalInstructions);
+        return false;
+    }
+    if (a->totalTStates != b->totalTStates) {
+        snprintf(description, size, "T-States: esperado %llu, obtido %llu",
+            (unsigned long long)a->totalTStates, (unsigned long long)b->totalTStates);
+        return false;
+    }
+    if (a->inputIndex != b->inputIndex) {
+        snprintf(description, size, "entradas usadas pelo IN: esperado %lu, obtido %lu",
+            (unsigned long)a->inputIndex, (unsigned long)b->inputIndex);
+        return false;
+    }
+
+    const hexBuffer_t * x = &expected->output;
+    const hexBuffer_t * y = &actual->output;
+    for (size_t i = 0; i < x->count && i < y->count; i++) {
+        if (x->values[i] != y->values[i]) {
+            snprintf(description, size, "saida %lu do OUT: esperado %02XH, obtido %02XH",
+                (unsigned long)i + 1, (uhex1_t)x->values[i], (uhex1_t)y->values[i]);
+            return false;
+        }
+    }
+    if (x->count != y->count) {
+        snprintf(description, size, "quantidade de saidas do OUT: esperado %lu, obtido %lu",
+            (unsigned long)x->count, (unsigned long)y->count);
+        return false;
+    }
+
+    for (int page = 0; page < MEMORY_PAGE_COUNT; page++) {
+        // Páginas compartilhadas são iguais
+        if (a->pages[page] == b->pages[page])
+            continue;
+        for (int i = 0; i < MEMORY_PAGE_SIZE; i++) {
+            hex1_t va = a->pages[page]->units[i].value;
+            hex1_t vb = b->pages[page]->units[i].value;
+            if (va != vb) {
+                snprintf(description, size, "memoria em %04XH: esperado %02XH, obtido %02XH",
+                    (page << MEMORY_PAGE_BITS) | i, (uhex1_t)va, (uhex1_t)vb);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void differential_free_run(diffRun_t * run) {
+    if (run->env != NULL)
+        env_destroy(run->env);
+    free(run->output.values);
+    memset(run, 0, sizeof(diffRun_t));
+}
+
+ErrorCode_t differential_check(const genProgram_t * program, const diffEngine_t * candidate, const Parametros * params,
+                               FILE * discard, bool * mismatch, char * description, size_t size) {
+    *mismatch = false;
+    Environment * image = generator_load(program, params);
+    if (image == NULL)
+        return EXIT_NO_MEMORY;
+
+    diffRun_t expected, actual;
+    ErrorCode_t err = differential_run(image, &DIFFERENTIAL_ENGINES[0], discard, &expected);
+    if (err == EXIT_SUCCESS) {
+        err = differential_run(image, candidate, discard, &actual);
+        if (err == EXIT_SUCCESS)
+            *mismatch = !differential_compare(&expected, &actual, description, size);
+        differential_free_run(&actual);
+    }
+    differential_free_run(&expected);
+    env_destroy(image);
+    return err;
+}
+
+ErrorCode_t differential_shrink(const genProgram_t * program, const diffEngine_t * candidate, const Parametros * params,
+                                FILE * discard, genProgram_t * out) {
+    // Uma cópia do original
+    ErrorCode_t err = generator_remove(program, 0, 0, out);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    size_t chunk = out->count / 2 > 0 ? out->count / 2 : 1;
+    for (;;) {
+        bool removed = false;
+        for (size_t i = 0; i < out->count;) {
+            genProgram_t smaller;
+            err = generator_remove(out, i, chunk, &smaller);
+            if (err != EXIT_SUCCESS)
+                return err;
+
+            bool mismatch = false;
+            if (smaller.count < out->count)
+                err = differential_check(&smaller, candidate, params, discard, &mismatch, NULL, 0);
+            if (err != EXIT_SUCCESS) {
+                generator_free(&smaller);
+                return err;
+            }
+            if (mismatch) {
+                // A diferença continua sem esse trecho
+                generator_free(out);
+                *out = smaller;
+                removed = true;
+            } else {
+                generator_free(&smaller);
+                i += chunk;
+            }
+        }
+        if (!removed) {
+            if (chunk == 1)
+                break;
+            chunk /= 2;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t differential_coverage(const genProgram_t * program, const Parametros * params, FILE * discard, uint64_t * counts) {
+    Environment * image = generator_load(program, params);
+    if (image == NULL)
+        return EXIT_NO_MEMORY;
+    hexBuffer_t output = { 0 };
+    Environment * env = prepare(image, discard, &output);
+    if (env == NULL) {
+        env_destroy(image);
+        return EXIT_NO_MEMORY;
+    }
+    step_guarded(env, counts);
+    env_destroy(env);
+    env_destroy(image);
+    free(output.values);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+// Testes diferenciais dos motores de execução do SAP2: o mesmo programa
+// (gerado aleatoriamente, ver generator.h) é executado pelo motor de
+// referência (evaluate) e por um motor candidato, e o estado final dos
+// dois é comparado (código de saída, registradores, flags, contador de
+// programa, memória inteira, valores do OUT, entradas usadas, instruções
+// executadas e T-States). Quando há diferença, o programa é reduzido
+// até o menor programa que ainda mostra a diferença.
+//
+// Os motores ficam na tabela DIFFERENTIAL_ENGINES. Um motor novo (por
+// exemplo, um que traduza o programa antes de executar) só precisa ser
+// adicionado a ela para ser testado.
+//
+// Author: André
+// Date: 04/11/2025
+//
+
+#ifndef SAP2_COMPILER_DIFFERENTIAL_H
+#define SAP2_COMPILER_DIFFERENTIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "generator.h"
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade de instruções que os motores em partes executam de cada vez
+#define DIFFERENTIAL_SLICE 37
+// Limite de instruções de cada execução (os programas reduzidos podem não terminar)
+#define DIFFERENTIAL_MAX_INSTRUCTIONS 200000
+
+// Motor de execução. Executa o ambiente até o fim (ou até o limite de
+// instruções dos parâmetros dele) e pode trocá-lo por outro ambiente,
+// que passa a ser o resultado da execução.
+typedef struct {
+    const char * name;
+    const char * description;
+    ErrorCode_t (*run)(Environment ** env);
+} diffEngine_t;
+
+// Motores conhecidos (o primeiro é a referência)
+extern const diffEngine_t DIFFERENTIAL_ENGINES[];
+extern const int DIFFERENTIAL_ENGINE_COUNT;
+
+// Resultado da execução de um programa por um motor
+typedef struct {
+    ErrorCode_t exitCode;
+    // O ambiente no fim da execução
+    Environment * env;
+    // Os valores do OUT
+    hexBuffer_t output;
+} diffRun_t;
+
+/**
+ * Procura o motor pelo nome
+ * @param name o nome do motor
+ * @return o motor (NULL se não houver)
+ */
+const diffEngine_t * differential_find_engine(const char * name);
+
+/**
+ * Executa o programa já carregado com o motor dado, em uma cópia do
+ * ambiente, sem imprimir nada
+ * @param image o ambiente com o programa (ver generator_load)
+ * @param engine o motor
+ * @param discard fluxo para onde vão as saídas, os avisos e os erros
+ * @param run onde o resultado é guardado
+ * @return o código de erro (do teste, não da execução)
+ */
+ErrorCode_t differential_run(const Environment * image, const diffEngine_t * engine, FILE * discard, diffRun_t * run);
+
+/**
+ * Compara o resultado de duas execuções
+ * @param expected o resultado da referência
+ * @param actual o resultado do candidato
+ * @param description onde a primeira diferença é descrita
+ * @param size o tamanho de "description"
+ * @return se os resultados são iguais
+ */
+bool differential_compare(const diffRun_t * expected, const diffRun_t * actual, char * description, size_t size);
+
+/**
+ * Libera o resultado de uma execução
+ * @param run o resultado
+ */
+void differential_free_run(diffRun_t * run);
+
+/**
+ * Executa o programa com a referência e com o candidato e compara os resultados
+ * @param program o programa
+ * @param candidate o motor candidato
+ * @param params os parâmetros dos ambientes
+ * @param discard fluxo para onde vão as saídas, os avisos e os erros
+ * @param mismatch onde é guardado se houve diferença
+ * @param description onde a diferença é descrita (pode ser NULL)
+ * @param size o tamanho de "description"
+ * @return o código de erro (do teste, não da execução)
+ */
+ErrorCode_t differential_check(const genProgram_t * program, const diffEngine_t * candidate, const Parametros * params,
+                               FILE * discard, bool * mismatch, char * description, size_t size);
+
+/**
+ * Reduz um programa que mostra diferença entre os motores, removendo
+ * trechos (cada vez menores) enquanto a diferença continuar
+ * @param program o programa com diferença
+ * @param candidate o motor candidato
+ * @param params os parâmetros dos ambientes
+ * @param discard fluxo para onde vão as saídas, os avisos e os erros
+ * @param out onde o programa reduzido é guardado
+ * @return o código de erro
+ */
+ErrorCode_t differential_shrink(const genProgram_t * program, const diffEngine_t * candidate, const Parametros * params,
+                                FILE * discard, genProgram_t * out);
+
+/**
+ * Conta as instruções executadas pelo programa, por código de operação
+ * (para saber se todas as instruções foram testadas)
+ * @param program o programa
+ * @param params os parâmetros dos ambientes
+ * @param discard fluxo para onde vão as saídas, os avisos e os erros
+ * @param counts onde as contagens são somadas (256 posições)
+ * @return o código de erro
+ */
+ErrorCode_t differential_coverage(const genProgram_t * program, const Parametros * params, FILE * discard, uint64_t * counts);
+
+#endif //SAP2_COMPILER_DIFFERENTIAL_H
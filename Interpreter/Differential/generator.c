@@ -0,0 +1,354 @@
+// Gerador de programas aleatórios do SAP2
+//
+// Author: André
+// Date: 04/11/2025
+//
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "generator.h"
+#include "../Instructions/Instructions.h"
+
+// Todas as instruções. As SIMPLE_COUNT primeiras não pulam (são as
+// usadas nos trechos em linha reta).
+const uhex1_t GENERATOR_OPCODES[] = {
+    OPCODE_ADD_B, OPCODE_ADD_C, OPCODE_ANA_B, OPCODE_ANA_C, OPCODE_ANI, OPCODE_CMA,
+    OPCODE_DCR_A, OPCODE_DCR_B, OPCODE_DCR_C, OPCODE_IN, OPCODE_INR_A, OPCODE_INR_B,
+    OPCODE_INR_C, OPCODE_LDA, OPCODE_MOV_A_B, OPCODE_MOV_A_C, OPCODE_MOV_B_A, OPCODE_MOV_B_C,
+    OPCODE_MOV_C_A, OPCODE_MOV_C_B, OPCODE_MVI_A, OPCODE_MVI_B, OPCODE_MVI_C, OPCODE_NOP,
+    OPCODE_ORA_B, OPCODE_ORA_C, OPCODE_ORI, OPCODE_OUT, OPCODE_RAL, OPCODE_RAR,
+    OPCODE_STA, OPCODE_SUB_B, OPCODE_SUB_C, OPCODE_XRA_B, OPCODE_XRA_C, OPCODE_XRI,
+    OPCODE_CALL, OPCODE_HLT, OPCODE_JM, OPCODE_JMP, OPCODE_JNZ, OPCODE_JZ, OPCODE_RET
+};
+const int GENERATOR_OPCODE_COUNT = sizeof(GENERATOR_OPCODES) / sizeof(GENERATOR_OPCODES[0]);
+#define SIMPLE_COUNT 36
+
+// Pulos para frente
+static const uhex1_t JUMP_OPCODES[] = { OPCODE_JMP, OPCODE_JM, OPCODE_JNZ, OPCODE_JZ };
+#define JUMP_COUNT ((int)(sizeof(JUMP_OPCODES) / sizeof(JUMP_OPCODES[0])))
+
+// Limites do tamanho das partes do programa
+#define MAX_RUN 8
+#define MAX_LOOP_COUNT 10
+#define MAX_SUBROUTINES 3
+
+// Estado da geração
+typedef struct {
+    uint32_t random;
+    // Baralho das instruções simples: todas saem antes de alguma repetir
+    uhex1_t deck[SIMPLE_COUNT];
+    int deckLeft;
+    genInstruction_t * code;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} generator_t;
+
+/**
+ * Próximo número pseudoaleatório (xorshift32)
+ */
+static uint32_t next_random(generator_t * gen) {
+    uint32_t x = gen->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->random = x;
+    return x;
+}
+
+// Número de 0 até n-1
+#define random_below(gen, n) ((int)(next_random(gen) % (uint32_t)(n)))
+
+/**
+ * Adiciona uma instrução ao programa
+ * @return a posição da instrução
+ */
+static size_t emit(generator_t * gen, uhex1_t opcode, uhex2_t operand, int target) {
+    if (gen->count == gen->capacity) {
+        size_t capacity = gen->capacity > 0 ? gen->capacity * 2 : 64;
+        genInstruction_t * temp = realloc(gen->code, sizeof(genInstruction_t) * capacity);
+        if (temp == NULL) {
+            gen->failed = true;
+            return gen->count;
+        }
+        gen->code = temp;
+        gen->capacity = capacity;
+    }
+    gen->code[gen->count] = (genInstruction_t) { opcode, operand, target };
+    return gen->count++;
+}
+
+/**
+ * Operando aleatório para a instrução simples dada
+ */
+static uhex2_t random_operand(generator_t * gen, uhex1_t opcode) {
+    switch (opcode) {
+        case OPCODE_STA:
+            return GENERATOR_DATA_ADDRESS + random_below(gen, GENERATOR_DATA_SIZE);
+        case OPCODE_LDA:
+            // Quase sempre a região de dados; às vezes, o próprio código
+            // ou as contagens dos laços
+            switch (random_below(gen, 4)) {
+                case 0: return GENERATOR_START_ADDRESS + random_below(gen, 64);
+                case 1: return GENERATOR_COUNTER_ADDRESS + random_below(gen, 16);
+                default: return GENERATOR_DATA_ADDRESS + random_below(gen, GENERATOR_DATA_SIZE);
+            }
+        default:
+            return (uhex2_t)random_below(gen, 0x100);
+    }
+}
+
+/**
+ * Trecho em linha reta com instruções simples
+ */
+static void emit_run(generator_t * gen, int length) {
+    for (int i = 0; i < length; i++) {
+        if (gen->deckLeft == 0) {
+            memcpy(gen->deck, GENERATOR_OPCODES, sizeof(gen->deck));
+            gen->deckLeft = SIMPLE_COUNT;
+        }
+        int pick = random_below(gen, gen->deckLeft);
+        uhex1_t opcode = gen->deck[pick];
+        gen->deck[pick] = gen->deck[--gen->deckLeft];
+        emit(gen, opcode, random_operand(gen, opcode), -1);
+    }
+}
+
+/**
+ * Pulo para frente por cima de um trecho em linha reta
+ */
+static void emit_forward_jump(generator_t * gen) {
+    size_t jump = emit(gen, JUMP_OPCODES[random_below(gen, JUMP_COUNT)], 0, -1);
+    emit_run(gen, 1 + random_below(gen, MAX_RUN));
+    if (!gen->failed)
+        gen->code[jump].target = (int)gen->count;
+}
+
+/**
+ * Laço que repete um trecho em linha reta de 1 a MAX_LOOP_COUNT vezes,
+ * contando na memória
+ */
+static void emit_loop(generator_t * gen, int loop) {
+    uhex2_t counter = GENERATOR_COUNTER_ADDRESS + loop;
+    emit(gen, OPCODE_MVI_A, 1 + random_below(gen, MAX_LOOP_COUNT), -1);
+    emit(gen, OPCODE_STA, counter, -1);
+    size_t head = gen->count;
+    emit_run(gen, 1 + random_below(gen, MAX_RUN));
+    emit(gen, OPCODE_LDA, counter, -1);
+    emit(gen, OPCODE_DCR_A, 0, -1);
+    emit(gen, OPCODE_STA, counter, -1);
+    emit(gen, OPCODE_JNZ, 0, (int)head);
+}
+
+ErrorCode_t generator_generate(uint32_t seed, int size, genProgram_t * program) {
+    memset(program, 0, sizeof(genProgram_t));
+    generator_t gen;
+    memset(&gen, 0, sizeof(gen));
+    gen.random = seed != 0 ? seed : 1;
+
+    for (int i = 0; i < GENERATOR_INPUT_COUNT; i++)
+        program->inputs[i] = (hex1_t)next_random(&gen);
+
+    // CALLs do programa principal: "target" guarda o número da sub-rotina
+    // até elas serem escritas
+    int subroutines = 1 + random_below(&gen, MAX_SUBROUTINES);
+    size_t * calls = malloc(sizeof(size_t) * (size > 0 ? size : 1));
+    size_t callCount = 0;
+    if (calls == NULL)
+        return EXIT_NO_MEMORY;
+
+    int loops = 0;
+    for (int block = 0; block < size; block++) {
+        switch (random_below(&gen, 5)) {
+            case 0: emit_run(&gen, 1 + random_below(&gen, MAX_RUN)); break;
+            case 1: emit_forward_jump(&gen); break;
+            case 2:
+                // Cada laço tem a própria contagem (até 16)
+                if (loops < 16) emit_loop(&gen, loops++);
+                else emit_run(&gen, 1 + random_below(&gen, MAX_RUN));
+                break;
+            default:
+                calls[callCount++] = emit(&gen, OPCODE_CALL, 0, random_below(&gen, subroutines));
+                emit_run(&gen, 1 + random_below(&gen, 2));
+                break;
+        }
+    }
+    emit(&gen, OPCODE_HLT, 0, -1);
+
+    // Sub-rotinas (depois do HLT), sem CALL dentro delas
+    int * starts = malloc(sizeof(int) * subroutines);
+    if (starts == NULL) {
+        free(calls);
+        free(gen.code);
+        return EXIT_NO_MEMORY;
+    }
+    for (int s = 0; s < subroutines; s++) {
+        starts[s] = (int)gen.count;
+        emit_run(&gen, 1 + random_below(&gen, MAX_RUN));
+        if (random_below(&gen, 2))
+            emit_forward_jump(&gen);
+        emit(&gen, OPCODE_RET, 0, -1);
+    }
+    for (size_t i = 0; i < callCount && !gen.failed; i++)
+        gen.code[calls[i]].target = starts[gen.code[calls[i]].target];
+    free(starts);
+    free(calls);
+
+    if (gen.failed) {
+        free(gen.code);
+        return EXIT_NO_MEMORY;
+    }
+    program->code = gen.code;
+    program->count = gen.count;
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t generator_remove(const genProgram_t * program, size_t index, size_t count, genProgram_t * out) {
+    memset(out, 0, sizeof(genProgram_t));
+    memcpy(out->inputs, program->inputs, sizeof(out->inputs));
+    if (index + count > program->count)
+        count = program->count - index;
+
+    // Nova posição de cada instrução (as removidas vão para a próxima que sobrou)
+    int * position = malloc(sizeof(int) * (program->count + 1));
+    if (position == NULL)
+        return EXIT_NO_MEMORY;
+    int next = 0;
+    for (size_t i = 0; i < program->count; i++) {
+        position[i] = next;
+        if (i < index || i >= index + count)
+            next++;
+    }
+    position[program->count] = next;
+
+    // +1: um HLT no fim, se algum pulo ficar sem destino
+    out->code = malloc(sizeof(genInstruction_t) * (program->count + 1));
+    if (out->code == NULL) {
+        free(position);
+        return EXIT_NO_MEMORY;
+    }
+    bool dangling = false;
+    for (size_t i = 0; i < program->count; i++) {
+        if (i >= index && i < index + count)
+            continue;
+        genInstruction_t instruction = program->code[i];
+        if (instruction.target >= 0) {
+            instruction.target = position[instruction.target];
+            dangling |= instruction.target == next;
+        }
+        out->code[out->count++] = instruction;
+    }
+    if (dangling)
+        out->code[out->count++] = (genInstruction_t) { OPCODE_HLT, 0, -1 };
+    free(position);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Quantidade de bytes do operando da instrução
+ */
+static int operand_size(uhex1_t opcode) {
+    switch (opcode) {
+        case OPCODE_MVI_A: case OPCODE_MVI_B: case OPCODE_MVI_C:
+        case OPCODE_ANI: case OPCODE_ORI: case OPCODE_XRI:
+        case OPCODE_IN: case OPCODE_OUT:
+            return 1;
+        case OPCODE_CALL: case OPCODE_JMP: case OPCODE_JM: case OPCODE_JNZ: case OPCODE_JZ:
+        case OPCODE_LDA: case OPCODE_STA:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Endereço de cada instrução (e do fim do programa, na última posição)
+ * @return os endereços (NULL se não houver memória)
+ */
+static uhex2_t * layout(const genProgram_t * program) {
+    uhex2_t * addresses = malloc(sizeof(uhex2_t) * (program->count + 1));
+    if (addresses == NULL)
+        return NULL;
+    uhex2_t address = GENERATOR_START_ADDRESS;
+    for (size_t i = 0; i < program->count; i++) {
+        addresses[i] = address;
+        address += 1 + operand_size(program->code[i].opcode);
+    }
+    addresses[program->count] = address;
+    return addresses;
+}
+
+Environment * generator_load(const genProgram_t * program, const Parametros * params) {
+    Parametros own = *params;
+    own.start_address = GENERATOR_START_ADDRESS;
+    Environment * env = env_create(&own, NULL);
+    uhex2_t * addresses = layout(program);
+    if (env == NULL || addresses == NULL) {
+        if (env != NULL)
+            env_destroy(env);
+        free(addresses);
+        return NULL;
+    }
+
+    // Como a segunda passagem do parser
+    env->isFirstPass = false;
+    env->programCounter = GENERATOR_START_ADDRESS;
+    for (size_t i = 0; i < program->count; i++) {
+        const genInstruction_t * instruction = &program->code[i];
+        env->currentInstruction = (int)i + 1;
+        uhex2_t operand = instruction->target >= 0 ? addresses[instruction->target] : instruction->operand;
+        switch (operand_size(instruction->opcode)) {
+            case 0: addInstruction(env, instruction->opcode); break;
+            case 1: addInstructionWithHex1(env, instruction->opcode, (hex1_t)operand); break;
+            default: addInstructionWithHex2(env, instruction->opcode, (hex2_t)operand); break;
+        }
+    }
+    free(addresses);
+
+    env->programCounter = GENERATOR_START_ADDRESS;
+    env->currentInstruction = 1;
+    env_set_input(env, program->inputs, GENERATOR_INPUT_COUNT);
+    return env;
+}
+
+/**
+ * Escreve um hexadecimal no formato do montador (ex.: 0FFH, 12H)
+ */
+static void write_hex(FILE * out, unsigned value, int digits) {
+    char text[8];
+    snprintf(text, sizeof(text), "%0*X", digits, value);
+    fprintf(out, "%s%sH", text[0] >= 'A' ? "0" : "", text);
+}
+
+void generator_write_asm(const genProgram_t * program, FILE * out) {
+    bool * labeled = calloc(program->count + 1, sizeof(bool));
+    for (size_t i = 0; labeled != NULL && i < program->count; i++)
+        if (program->code[i].target >= 0)
+            labeled[program->code[i].target] = true;
+
+    fprintf(out, "; Programa gerado pelo sap2_diff (%lu instrucoes)\n", (unsigned long)program->count);
+    for (size_t i = 0; i < program->count; i++) {
+        const genInstruction_t * instruction = &program->code[i];
+        if (labeled != NULL && labeled[i])
+            fprintf(out, "L%lu: ", (unsigned long)i);
+        const char * name = getInstructionName(instruction->opcode);
+        fprintf(out, "%s", name);
+        if (instruction->target >= 0) {
+            fprintf(out, " L%d", instruction->target);
+        } else if (operand_size(instruction->opcode) > 0) {
+            // "MVI A" vira "MVI A, 12H"; "ANI" vira "ANI 12H"
+            fprintf(out, strchr(name, ' ') != NULL ? ", " : " ");
+            write_hex(out, instruction->operand, operand_size(instruction->opcode) * 2);
+        }
+        fprintf(out, "\n");
+    }
+    free(labeled);
+}
+
+void generator_free(genProgram_t * program) {
+    free(program->code);
+    program->code = NULL;
+    program->count = 0;
+}
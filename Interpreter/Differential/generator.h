@@ -0,0 +1,95 @@
+// Gerador de programas aleatórios do SAP2 para os testes diferenciais
+// (ver differential.h). Os programas sempre terminam: os pulos só vão
+// para frente, os laços contam até zero com uma contagem guardada na
+// memória (que o corpo não altera) e as sub-rotinas não chamam outras.
+// Todos os códigos de operação aparecem nos programas.
+//
+// Author: André
+// Date: 04/11/2025
+//
+
+#ifndef SAP2_COMPILER_GENERATOR_H
+#define SAP2_COMPILER_GENERATOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Endereço do começo dos programas gerados
+#define GENERATOR_START_ADDRESS 0x8000
+// Região que os STA podem escrever (os LDA leem qualquer lugar)
+#define GENERATOR_DATA_ADDRESS 0xE000
+#define GENERATOR_DATA_SIZE 0x100
+// Contagens dos laços (uma por laço, fora da região de dados)
+#define GENERATOR_COUNTER_ADDRESS 0xF000
+// Quantidade de entradas do IN de cada programa
+#define GENERATOR_INPUT_COUNT 256
+
+// Todas as instruções do SAP2
+extern const uhex1_t GENERATOR_OPCODES[];
+extern const int GENERATOR_OPCODE_COUNT;
+
+// Instrução de um programa gerado
+typedef struct {
+    uhex1_t opcode;
+    // Imediato, porta ou endereço (conforme a instrução)
+    uhex2_t operand;
+    // Instrução para onde o pulo ou o CALL vai (-1 se não for um pulo)
+    int target;
+} genInstruction_t;
+
+// Programa gerado
+typedef struct {
+    genInstruction_t * code;
+    size_t count;
+    // Entradas do IN
+    hex1_t inputs[GENERATOR_INPUT_COUNT];
+} genProgram_t;
+
+/**
+ * Gera um programa aleatório que termina
+ * @param seed a semente (o mesmo programa sai da mesma semente)
+ * @param size quantidade aproximada de blocos do programa principal
+ * @param program onde o programa é guardado
+ * @return o código de erro
+ */
+ErrorCode_t generator_generate(uint32_t seed, int size, genProgram_t * program);
+
+/**
+ * Copia o programa sem a instrução "index" e as "count" seguintes. Os
+ * pulos para as instruções removidas passam a ir para a próxima que
+ * sobrou (se não sobrar nenhuma, um HLT é colocado no fim).
+ * @param program o programa original
+ * @param index a primeira instrução removida
+ * @param count quantidade de instruções removidas
+ * @param out onde a cópia é guardada
+ * @return o código de erro
+ */
+ErrorCode_t generator_remove(const genProgram_t * program, size_t index, size_t count, genProgram_t * out);
+
+/**
+ * Coloca o programa na memória de um ambiente novo (já montado, como
+ * se viesse do parser)
+ * @param program o programa
+ * @param params os parâmetros do ambiente
+ * @return o ambiente (NULL se não houver memória)
+ */
+Environment * generator_load(const genProgram_t * program, const Parametros * params);
+
+/**
+ * Escreve o programa em assembly (com rótulos nos destinos dos pulos),
+ * para ser executado de novo pelo interpretador
+ * @param program o programa
+ * @param out onde o código é escrito
+ */
+void generator_write_asm(const genProgram_t * program, FILE * out);
+
+/**
+ * Libera o programa
+ * @param program o programa
+ */
+void generator_free(genProgram_t * program);
+
+#endif //SAP2_COMPILER_GENERATOR_H
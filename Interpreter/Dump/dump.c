@@ -0,0 +1,273 @@
+// Impressão da memória no fim da execução
+//
+// Author: André
+// Date: 09/11/2025
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dump.h"
+#include "../Utils/Utils.h"
+
+// Texto montado antes de ser escrito
+typedef struct {
+    char * data;
+    size_t size;
+    size_t capacity;
+    // Se faltou memória em algum momento
+    bool failed;
+} dumpBuffer_t;
+
+/**
+ * Garante espaço para mais "extra" bytes no buffer
+ * @return se há espaço
+ */
+static bool reserve(dumpBuffer_t * buffer, size_t extra) {
+    if (buffer->size + extra <= buffer->capacity)
+        return true;
+    if (buffer->failed)
+        return false;
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 64 * 1024;
+    while (capacity < buffer->size + extra)
+        capacity *= 2;
+    char * temp = realloc(buffer->data, capacity);
+    if (temp == NULL) {
+        buffer->failed = true;
+        return false;
+    }
+    buffer->data = temp;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static void append(dumpBuffer_t * buffer, const char * text, size_t length) {
+    if (reserve(buffer, length)) {
+        memcpy(buffer->data + buffer->size, text, length);
+        buffer->size += length;
+    }
+}
+
+#define append_literal(buffer, text) append(buffer, text, sizeof(text) - 1)
+
+/**
+ * Escreve o número em hexadecimal (minúsculo), com pelo menos "digits" dígitos
+ */
+static void append_hex(dumpBuffer_t * buffer, unsigned value, int digits) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    char text[8];
+    int length = 0;
+    while ((value >> (4 * length)) > 0 && length < 4)
+        length++;
+    if (length < digits)
+        length = digits;
+    for (int i = 0; i < length; i++)
+        text[i] = HEX_DIGITS[(value >> (4 * (length - 1 - i))) & 0xF];
+    append(buffer, text, length);
+}
+
+// Se o endereço foi escrito durante a execução (ver setMemory)
+static bool is_changed(const memoryUnit_t * unit) {
+    return unit->annotation != NULL && strcmp(unit->annotation, EVAL_DEFINED_MEMORY_ANNOTATION) == 0;
+}
+
+static bool in_ranges(const memoryDump_t * dump, unsigned address) {
+    if (dump->rangeCount == 0)
+        return true;
+    for (int i = 0; i < dump->rangeCount; i++)
+        if (address >= dump->ranges[i].start && address <= dump->ranges[i].end)
+            return true;
+    return false;
+}
+
+/**
+ * Se o endereço é impresso: está em uma das faixas pedidas (ou, sem
+ * faixas, foi usado pelo programa) e, se for só o que foi alterado, foi
+ * escrito durante a execução
+ * @param used mapa (um bit por endereço) dos endereços usados
+ */
+static bool is_selected(const Environment * env, const memoryDump_t * dump, const uint8_t * used, unsigned address) {
+    if (!in_ranges(dump, address))
+        return false;
+    if (dump->changedOnly)
+        return is_changed(&env_read_unit(env, address));
+    return dump->rangeCount > 0 || ((used[address >> 3] >> (address & 7)) & 1);
+}
+
+/**
+ * Se a página pode ter endereços impressos. As páginas que nunca foram
+ * usadas só entram se alguma faixa foi pedida (e são impressas zeradas).
+ */
+static bool is_page_visited(const Environment * env, const memoryDump_t * dump, int page) {
+    return dump->rangeCount > 0 || env_is_page_used(env, page);
+}
+
+static void dump_table(const Environment * env, const memoryDump_t * dump, const uint8_t * used, dumpBuffer_t * buffer) {
+    append_literal(buffer, "\nMemoria RAM ================================\nEndereco\t| Conteudo\t| Simbolico\n");
+    for (int page = 0; page < MEMORY_PAGE_COUNT; page++) {
+        if (!is_page_visited(env, dump, page))
+            continue;
+        for (unsigned address = page * MEMORY_PAGE_SIZE; address < (unsigned)(page + 1) * MEMORY_PAGE_SIZE; address++) {
+            if (!is_selected(env, dump, used, address))
+                continue;
+            const memoryUnit_t * unit = &env_read_unit(env, address);
+            // Igual à tabela de sempre: "%xH\t\t| %02xH \t\t| %s\n"
+            append_hex(buffer, address, 1);
+            append_literal(buffer, "H\t\t| ");
+            append_hex(buffer, (uhex1_t)unit->value, 2);
+            append_literal(buffer, "H \t\t| ");
+            if (unit->annotation != NULL)
+                append(buffer, unit->annotation, strlen(unit->annotation));
+            append_literal(buffer, "\n");
+        }
+    }
+    append_literal(buffer, "\n");
+}
+
+static void dump_hex(const Environment * env, const memoryDump_t * dump, const uint8_t * used, dumpBuffer_t * buffer) {
+    append_literal(buffer, "\nMemoria RAM (hex) ==========================\n");
+    for (int page = 0; page < MEMORY_PAGE_COUNT; page++) {
+        if (!is_page_visited(env, dump, page))
+            continue;
+        for (unsigned line = page * MEMORY_PAGE_SIZE; line < (unsigned)(page + 1) * MEMORY_PAGE_SIZE; line += DUMP_HEX_LINE) {
+            bool selected[DUMP_HEX_LINE];
+            bool any = false;
+            for (int i = 0; i < DUMP_HEX_LINE; i++)
+                any |= selected[i] = is_selected(env, dump, used, line + i);
+            if (!any)
+                continue;
+
+            append_hex(buffer, line, 4);
+            append_literal(buffer, "H:");
+            for (int i = 0; i < DUMP_HEX_LINE; i++) {
+                if (i == DUMP_HEX_LINE / 2)
+                    append_literal(buffer, " ");
+                append_literal(buffer, " ");
+                if (selected[i])
+                    append_hex(buffer, (uhex1_t)env_read_unit(env, line + i).value, 2);
+                else
+                    append_literal(buffer, "..");
+            }
+            append_literal(buffer, "\n");
+        }
+    }
+    append_literal(buffer, "\n");
+}
+
+/**
+ * Escreve os bytes de "start" até "end" (incluindo os dois)
+ */
+static void append_bytes(const Environment * env, unsigned start, unsigned end, dumpBuffer_t * buffer) {
+    if (!reserve(buffer, end - start + 1))
+        return;
+    for (unsigned address = start; address <= end; address++)
+        buffer->data[buffer->size++] = (char)env_read_unit(env, address).value;
+}
+
+static void dump_raw(const Environment * env, const memoryDump_t * dump, const uint8_t * used, dumpBuffer_t * buffer) {
+    if (dump->rangeCount > 0) {
+        for (int i = 0; i < dump->rangeCount; i++)
+            append_bytes(env, dump->ranges[i].start, dump->ranges[i].end, buffer);
+        return;
+    }
+
+    // Do primeiro ao último endereço escolhido
+    long first = -1, last = -1;
+    for (int page = 0; page < MEMORY_PAGE_COUNT; page++) {
+        if (!is_page_visited(env, dump, page))
+            continue;
+        for (unsigned address = page * MEMORY_PAGE_SIZE; address < (unsigned)(page + 1) * MEMORY_PAGE_SIZE; address++) {
+            if (is_selected(env, dump, used, address)) {
+                if (first < 0)
+                    first = address;
+                last = address;
+            }
+        }
+    }
+    if (first >= 0)
+        append_bytes(env, (unsigned)first, (unsigned)last, buffer);
+}
+
+ErrorCode_t dump_parse_format(const char * text, dumpFormat_t * format) {
+    if (strcmp(text, "tabela") == 0)
+        *format = DUMP_FORMAT_TABLE;
+    else if (strcmp(text, "hex") == 0)
+        *format = DUMP_FORMAT_HEX;
+    else if (strcmp(text, "bruto") == 0)
+        *format = DUMP_FORMAT_RAW;
+    else
+        return EXIT_INVALID_ARGUMENT;
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t dump_add_range(memoryDump_t * dump, const char * text) {
+    if (dump->rangeCount >= DUMP_MAX_RANGES)
+        return EXIT_INVALID_ARGUMENT;
+
+    char start[16];
+    const char * dash = strchr(text, '-');
+    size_t length = dash != NULL ? (size_t)(dash - text) : strlen(text);
+    if (length >= sizeof(start))
+        return EXIT_INVALID_ARGUMENT;
+    memcpy(start, text, length);
+    start[length] = '\0';
+
+    hex2_t first, last;
+    if (str_to_hex2(start, &first) != EXIT_SUCCESS)
+        return EXIT_INVALID_ARGUMENT;
+    if (dash == NULL)
+        last = first;
+    else if (str_to_hex2(dash + 1, &last) != EXIT_SUCCESS)
+        return EXIT_INVALID_ARGUMENT;
+    if ((uhex2_t)first > (uhex2_t)last)
+        return EXIT_INVALID_ARGUMENT;
+
+    dump->ranges[dump->rangeCount++] = (dumpRange_t) {
+        .start = (uhex2_t)first,
+        .end = (uhex2_t)last
+    };
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t dump_memory(const Environment * env, const memoryDump_t * dump, FILE * out) {
+    static const memoryDump_t STANDARD_DUMP = { .format = DUMP_FORMAT_TABLE };
+    if (dump == NULL)
+        dump = &STANDARD_DUMP;
+
+    // Mapa dos endereços usados (um bit por endereço)
+    uint8_t used[(UHEX2_MAX + 1) / 8] = { 0 };
+    for (size_t i = 0; i < env->usedAddressesSize; i++)
+        used[env->usedAddresses[i] >> 3] |= (uint8_t)(1 << (env->usedAddresses[i] & 7));
+
+    dumpBuffer_t buffer = { 0 };
+    switch (dump->format) {
+        case DUMP_FORMAT_TABLE:
+            dump_table(env, dump, used, &buffer);
+            break;
+        case DUMP_FORMAT_HEX:
+            dump_hex(env, dump, used, &buffer);
+            break;
+        case DUMP_FORMAT_RAW:
+            dump_raw(env, dump, used, &buffer);
+            break;
+    }
+    if (buffer.failed) {
+        free(buffer.data);
+        return EXIT_NO_MEMORY;
+    }
+
+    // Tudo de uma vez
+    ErrorCode_t err = EXIT_SUCCESS;
+    if (dump->path != NULL) {
+        FILE * file = fopen(dump->path, dump->format == DUMP_FORMAT_RAW ? "wb" : "w");
+        if (file == NULL || fwrite(buffer.data, 1, buffer.size, file) != buffer.size)
+            err = EXIT_FILE_NOT_FOUND;
+        if (file != NULL && fclose(file) != 0)
+            err = EXIT_FILE_NOT_FOUND;
+    } else if (buffer.size > 0) {
+        fwrite(buffer.data, 1, buffer.size, out);
+    }
+    free(buffer.data);
+    return err;
+}
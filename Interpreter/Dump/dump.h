@@ -0,0 +1,85 @@
+// Impressão da memória no fim da execução (no HLT). O texto inteiro é
+// montado em um buffer e escrito de uma vez (no fluxo de saída ou em
+// um arquivo), sem um printf por endereço.
+//
+// Formatos:
+//     tabela   "8000H | 0eH | MVI C, ffH", um endereço por linha (o de sempre)
+//     hex      16 bytes por linha ("8000H: 0e ff 06 ..."), com ".." nos
+//              endereços que não foram escolhidos
+//     bruto    os bytes da memória, sem texto
+//
+// Author: André
+// Date: 09/11/2025
+//
+
+#ifndef SAP2_COMPILER_DUMP_H
+#define SAP2_COMPILER_DUMP_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade máxima de faixas de endereços
+#define DUMP_MAX_RANGES 16
+// Bytes por linha no formato hex
+#define DUMP_HEX_LINE 16
+
+// Formato da impressão da memória
+typedef enum {
+    DUMP_FORMAT_TABLE,
+    DUMP_FORMAT_HEX,
+    DUMP_FORMAT_RAW
+} dumpFormat_t;
+
+// Faixa de endereços (inclui o início e o fim)
+typedef struct {
+    uhex2_t start;
+    uhex2_t end;
+} dumpRange_t;
+
+// Como a memória é impressa
+typedef struct memoryDump_s {
+    dumpFormat_t format;
+    // Faixas de endereços impressas (nenhuma para a memória toda)
+    dumpRange_t ranges[DUMP_MAX_RANGES];
+    int rangeCount;
+    // Se só imprime os endereços escritos durante a execução (ao invés
+    // dos endereços usados pelo programa)
+    bool changedOnly;
+    // Arquivo onde a memória é escrita (NULL para o fluxo de saída)
+    const char * path;
+} memoryDump_t;
+
+/**
+ * Lê o nome de um formato ("tabela", "hex" ou "bruto")
+ * @param text o nome
+ * @param format onde o formato é guardado
+ * @return o código de erro
+ */
+ErrorCode_t dump_parse_format(const char * text, dumpFormat_t * format);
+
+/**
+ * Adiciona uma faixa no formato "<inicio>-<fim>" (ex.: 8000H-80FFH) ou
+ * um endereço só (ex.: 9000H)
+ * @param dump a configuração
+ * @param text a faixa
+ * @return o código de erro
+ */
+ErrorCode_t dump_add_range(memoryDump_t * dump, const char * text);
+
+/**
+ * Imprime a memória do ambiente conforme a configuração. Os endereços
+ * escolhidos são todos os das faixas ou, sem faixas, os usados pelo
+ * programa; com "changedOnly", só os escritos durante a execução. No
+ * formato bruto, são todos os bytes das faixas (ou do primeiro ao último
+ * endereço escolhido, se não houver faixas).
+ * @param env o ambiente do SAP2
+ * @param dump a configuração (NULL para a tabela de sempre)
+ * @param out o fluxo usado quando a configuração não tem um arquivo
+ * @return o código de erro
+ */
+ErrorCode_t dump_memory(const Environment * env, const memoryDump_t * dump, FILE * out);
+
+#endif //SAP2_COMPILER_DUMP_H
@@ -26,7 +26,11 @@ typedef enum {
     EXIT_TIME_LIMIT_REACHED = 9,        // quando o programa alcança o limite de tempo
     EXIT_ILLEGAL_HEX = 10,              // quando tenta colocar um hexadecimal de tamanho maior que aguenta
     EXIT_NO_INSTRUCTION = 11,           // quando tenta ler uma instrução a partir de algo que não é uma instrução
-    EXIT_INVALID_TOKEN = 12             // o respectivo token é inválido/inesperado naquela situação
+    EXIT_INVALID_TOKEN = 12,            // o respectivo token é inválido/inesperado naquela situação
+    EXIT_STATE_FILE = 13,               // não foi possível salvar/carregar o arquivo de estado
+    EXIT_TRACE = 14,                    // o traço é inválido ou a execução não é igual à gravada
+    EXIT_REGRESSION = 15,               // a medição de desempenho ficou pior que a base
+    EXIT_MISMATCH = 16                  // um motor de execução não chegou ao mesmo resultado que a referência
 } ErrorCode_t;
 
 // As mensagens de erro //
@@ -37,6 +41,10 @@ typedef enum {
 #define EXIT_INVALID_INSTRUCTION_MESSAGE "Instrucao Invalida"
 #define EXIT_ILLEGAL_HEX_MESSAGE "Numero hexadecimal excedeu o limite aceito"
 #define EXIT_INVALID_TOKEN_MESSAGE "Token inesperado"
+#define EXIT_STATE_FILE_MESSAGE "Nao foi possivel salvar ou carregar o arquivo de estado.\nVerifique se o arquivo existe, se foi gerado por esta versao do programa e se ha espaco disponivel."
+#define EXIT_TRACE_MESSAGE "O arquivo de traco eh invalido, nao pode ser gravado ou a execucao nao eh igual a gravada."
+#define EXIT_REGRESSION_MESSAGE "O desempenho ficou pior que o da base (alem do ruido da medicao)."
+#define EXIT_MISMATCH_MESSAGE "Um motor de execucao nao chegou ao mesmo resultado que a referencia."
 
 // Macros //
 
@@ -72,12 +80,10 @@ typedef enum {
             fprintf(stderr, "[ERRO] Instrucao %d: %s\n", state->env.currentInstruction, E##_MESSAGE);   \
             exit(E);                                                                             \
 } while (0)
-// Com variadic args (estilo printf) e mostra em que instrução está
-#define VI_EXIT(E, format, ...) do {                                                                \
-    fprintf(stderr, "[ERRO] Instrucao %d: %s\n\t", state->env->currentInstruction > 0 ? state->env->currentInstruction : 1 , E##_MESSAGE);    \
-    fprintf(stderr, format, __VA_ARGS__); fprintf(stdout, "\n");                                    \
-    exit(E);                                                                                        \
-} while (0)
+// Com variadic args (estilo printf) e mostra em que instrução está.
+// Usa o destino de diagnósticos do ambiente do parser (ver diagnostics.h)
+#define VI_EXIT(E, format, ...) \
+    diagnostics_instruction_fatal(&state->env->diagnostics, E, state->env->currentInstruction, E##_MESSAGE, format, __VA_ARGS__)
 
 // Imprime uma mensagem de aviso ao usuário //
 #define WARN(format, ...) do {              \
@@ -86,11 +92,7 @@ typedef enum {
     fprintf(stdout, "\n");                  \
     } while(0)
 // Mostra em que instrução está
-#define I_WARN(format, ...) {                                                           \
-    fprintf(stdout, "[AVISO] Instrucao %d:\n\t", state->env->currentInstruction);       \
-    fprintf(stdout, format, __VA_ARGS__);                                               \
-    fprintf(stdout, "\n");                                                              \
-} while (0)
-
+#define I_WARN(format, ...) \
+    diagnostics_warn(&state->env->diagnostics, "Instrucao %d:\n\t" format, state->env->currentInstruction, __VA_ARGS__)
 
 #endif //SAP2_COMPILER_ERRORCODES_H
\ No newline at end of file
@@ -0,0 +1,120 @@
+// Entradas do IN fornecidas antes da execução
+//
+// Author: André
+// Date: 07/11/2025
+//
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input.h"
+#include "../Utils/Utils.h"
+
+// Maior hexadecimal aceito (o resto da palavra é um erro)
+#define INPUT_MAX_WORD 16
+
+ErrorCode_t input_parse(const char * text, size_t length, hex1_t ** values, size_t * size, char * error, size_t errorSize) {
+    *values = NULL;
+    *size = 0;
+    size_t capacity = 0;
+    int line = 1;
+    size_t i = 0;
+    while (i < length) {
+        char c = text[i];
+        if (c == '\n') {
+            line++;
+            i++;
+            continue;
+        }
+        if (isspace((unsigned char)c) || c == ',') {
+            i++;
+            continue;
+        }
+        if (c == ';') {
+            while (i < length && text[i] != '\n') i++;
+            continue;
+        }
+
+        // Uma palavra: tem que ser um hexadecimal
+        char word[INPUT_MAX_WORD + 1];
+        size_t n = 0;
+        while (i < length && !isspace((unsigned char)text[i]) && text[i] != ',' && text[i] != ';') {
+            if (n < INPUT_MAX_WORD)
+                word[n] = text[i];
+            n++;
+            i++;
+        }
+        word[n < INPUT_MAX_WORD ? n : INPUT_MAX_WORD] = '\0';
+
+        hex1_t value;
+        if (n > INPUT_MAX_WORD || str_to_hex1(word, &value) != EXIT_SUCCESS) {
+            snprintf(error, errorSize, "linha %d: \"%s\" nao eh um hexadecimal valido (como 12H)", line, word);
+            free(*values);
+            *values = NULL;
+            *size = 0;
+            return EXIT_INVALID_ARGUMENT;
+        }
+
+        if (*size == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 256;
+            hex1_t * temp = realloc(*values, sizeof(hex1_t) * capacity);
+            if (temp == NULL) {
+                free(*values);
+                *values = NULL;
+                *size = 0;
+                return EXIT_NO_MEMORY;
+            }
+            *values = temp;
+        }
+        (*values)[(*size)++] = value;
+    }
+
+    // Sem valores (arquivo vazio ou só com comentários): as entradas
+    // continuam fornecidas, só que já acabaram
+    if (*values == NULL && (*values = malloc(sizeof(hex1_t))) == NULL)
+        return EXIT_NO_MEMORY;
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t input_load(const char * path, hex1_t ** values, size_t * size, char * error, size_t errorSize) {
+    *values = NULL;
+    *size = 0;
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        snprintf(error, errorSize, "nao foi possivel abrir o arquivo \"%s\"", path);
+        return EXIT_FILE_NOT_FOUND;
+    }
+
+    // O arquivo inteiro de uma vez
+    char * text = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0) {
+        rewind(file);
+        text = malloc(length > 0 ? length : 1);
+        if (text != NULL && fread(text, 1, length, file) != (size_t)length)
+            length = -1;
+    }
+    fclose(file);
+    if (text == NULL || length < 0) {
+        free(text);
+        snprintf(error, errorSize, "nao foi possivel ler o arquivo \"%s\"", path);
+        return text == NULL && length >= 0 ? EXIT_NO_MEMORY : EXIT_FILE_NOT_FOUND;
+    }
+
+    ErrorCode_t err = input_parse(text, (size_t)length, values, size, error, errorSize);
+    free(text);
+    return err;
+}
+
+ErrorCode_t input_parse_end(const char * text, inputEnd_t * end) {
+    if (strcmp(text, "erro") == 0)
+        *end = INPUT_END_ERROR;
+    else if (strcmp(text, "zero") == 0)
+        *end = INPUT_END_ZERO;
+    else if (strcmp(text, "repetir") == 0)
+        *end = INPUT_END_REPEAT;
+    else
+        return EXIT_INVALID_ARGUMENT;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+// Entradas do IN fornecidas antes da execução. O arquivo é lido de uma
+// vez e os valores são convertidos antes de o programa começar, então
+// o IN só pega o próximo valor da memória (sem pedir nada no terminal).
+//
+// Formato do arquivo: hexadecimais como os do IN (12H, 0FFH), separados
+// por espaços, vírgulas ou linhas. O que vem depois de ';' é comentário.
+//
+// Author: André
+// Date: 07/11/2025
+//
+
+#ifndef SAP2_COMPILER_INPUT_H
+#define SAP2_COMPILER_INPUT_H
+
+#include <stddef.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+/**
+ * Lê e converte todos os valores do arquivo
+ * @param path o caminho do arquivo
+ * @param values onde os valores são guardados (liberados com free; nunca
+ * NULL se der certo, mesmo sem valores, para que as entradas contem como
+ * fornecidas e o fim delas siga o --fim-entrada)
+ * @param size onde a quantidade de valores é guardada
+ * @param error onde o motivo do erro é escrito (se houver)
+ * @param errorSize o tamanho de "error"
+ * @return o código de erro
+ */
+ErrorCode_t input_load(const char * path, hex1_t ** values, size_t * size, char * error, size_t errorSize);
+
+/**
+ * Converte os valores do texto dado (no formato do arquivo)
+ * @param text o texto
+ * @param length o tamanho do texto
+ * @param values onde os valores são guardados (liberados com free; nunca
+ * NULL se der certo, mesmo sem valores, para que as entradas contem como
+ * fornecidas e o fim delas siga o --fim-entrada)
+ * @param size onde a quantidade de valores é guardada
+ * @param error onde o motivo do erro é escrito (se houver)
+ * @param errorSize o tamanho de "error"
+ * @return o código de erro
+ */
+ErrorCode_t input_parse(const char * text, size_t length, hex1_t ** values, size_t * size, char * error, size_t errorSize);
+
+/**
+ * Lê o que o IN faz quando as entradas acabam ("erro", "zero" ou "repetir")
+ * @param text o texto
+ * @param end onde o comportamento é guardado
+ * @return o código de erro
+ */
+ErrorCode_t input_parse_end(const char * text, inputEnd_t * end);
+
+#endif //SAP2_COMPILER_INPUT_H
@@ -11,9 +11,12 @@
 #include "../Utils/Utils.h"
 #include "../ErrorCodes.h"
 #include "../environment.h"
+#include "../Devices/devices.h"
+#include "../Output/output.h"
+#include "../Trace/trace.h"
 
-// env->memory[address].value
-#define env_getmemval(address) env->memory[address].value
+// env_read_unit(env, address).value
+#define env_getmemval(address) env_read_unit(env, address).value
 
 #define env_setmemval(address, value) setMemory(env, address, value)
 
@@ -42,7 +45,11 @@ ex_fn_reg(execute_dcr) {
 
 ex_fn(execute_hlt) {
     // Tira do buffer e coloca na saida
-    fflush(stdout);
+    if (env->output != NULL)
+        output_flush(env->output);
+    if (env->devices != NULL)
+        devices_flush(env->devices);
+    fflush(stdoutflow);
 
     return EXIT_HLT;
 }
@@ -56,7 +63,7 @@ ex_fn_hex2(execute_call) {
     // Verifica se já tem coisa escrita
 
     if (env_getmemval(RET_ADDRESS_LSB) != 0 || env_getmemval(RET_ADDRESS_MSB) != 0) {
-        WARN(
+        E_WARN_AT(env->currentInstruction,
 "Instrucao %d: A instrucao \"CALL\" foi chamada durante uma subrotina.\nPor causa disso, o endereco de memoria para retornar (RET) foi sobrescrito.\nIsso nao eh recomendado, uma vez que seu programa pode \"se perder\".",
             env->currentInstruction);
     }
@@ -78,11 +85,24 @@ ex_fn_rv(execute_mvi) {
 }
 
 ex_fn_val(execute_out) {
-    if (!env_params->debug_mode) {
+    TRACE_OUT((uhex1_t)value, REG_A);
+    // Se a saída estiver sendo capturada, só guarda o valor
+    if (env->capturedOutput != NULL) {
+        if (hexBuffer_push(env->capturedOutput, REG_A) != EXIT_SUCCESS)
+            E_EXIT_ERR(EXIT_NO_MEMORY);
+    } else if (device_at(env->devices, value) != NULL) {
+        // O dispositivo já recebeu o valor quando a instrução foi executada antes
+        if (!env->replaying)
+            device_write(device_at(env->devices, value), REG_A);
+    } else if (env_params->debug_mode) {
+        env->hex_print_buffer = REG_A;
+    } else if (env->output != NULL) {
+        // O valor já foi enviado quando a instrução foi executada antes
+        if (!env->replaying)
+            output_write(env->output, (uhex1_t)value, REG_A);
+    } else {
         print_hex(stdoutflow, REG_A);
         fflush(stdoutflow);
-    } else {
-        env->hex_print_buffer = REG_A;
     }
     return EXIT_SUCCESS;
 }
@@ -129,7 +149,7 @@ ex_fn_reg(execute_inr) {
 ex_fn_hex2(execute_jm) {
     if (env->flags[FLAG_S]) {
         env->programCounter = value;
-        sleep_us(_ts_to_change_pc);
+        env_spend_tstates(_ts_to_change_pc);
     }
     return EXIT_SUCCESS;
 }
@@ -138,7 +158,7 @@ ex_fn_hex2(execute_jm) {
 ex_fn_hex2(execute_jnz) {
     if (!env->flags[FLAG_Z]) {
         env->programCounter = value;
-        sleep_us(_ts_to_change_pc);
+        env_spend_tstates(_ts_to_change_pc);
     }
     return EXIT_SUCCESS;
 }
@@ -147,7 +167,7 @@ ex_fn_hex2(execute_jnz) {
 ex_fn_hex2(execute_jz) {
     if (env->flags[FLAG_Z]) {
         env->programCounter = value;
-        sleep_us(_ts_to_change_pc);
+        env_spend_tstates(_ts_to_change_pc);
     }
     return EXIT_SUCCESS;
 }
@@ -204,7 +224,7 @@ ex_fn(execute_ret) {
     // É seguro ver se ambos são 0 para ver se
     // aponta para um lugar.
     if (lsb == 0 && msb == 0) {
-        WARN(
+        E_WARN_AT(env->currentInstruction,
 "Instrucao %d: a instrucao RET foi chamada mesmo nao havendo\nnada salvo nos enderecos de memoria de retorno.", env->currentInstruction);
     }
 
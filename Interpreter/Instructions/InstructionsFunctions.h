@@ -44,6 +44,7 @@ ex_fn(execute_hlt);
 ex_fn_hex2(execute_jmp);
 ex_fn_rv(execute_mvi);
 ex_fn_val(execute_out);
+ex_fn_val(execute_in);
 ex_fn_reg(execute_sub);
 
 ex_fn_reg(execute_ana);
@@ -0,0 +1,253 @@
+// Destino dos valores do OUT
+//
+// Author: André
+// Date: 05/11/2025
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "output.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define popen _popen
+#define pclose _pclose
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+ErrorCode_t output_parse_format(const char * text, outputFormat_t * format) {
+    if (strcmp(text, "humano") == 0)
+        *format = OUTPUT_FORMAT_HUMAN;
+    else if (strcmp(text, "bruto") == 0)
+        *format = OUTPUT_FORMAT_RAW;
+    else if (strcmp(text, "csv") == 0)
+        *format = OUTPUT_FORMAT_CSV;
+    else
+        return EXIT_INVALID_ARGUMENT;
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t output_parse_flush(const char * text, outputFlush_t * flush, int * every) {
+    if (strcmp(text, "auto") == 0) {
+        *flush = OUTPUT_FLUSH_AUTO;
+    } else if (strcmp(text, "valor") == 0) {
+        *flush = OUTPUT_FLUSH_VALUE;
+    } else if (strcmp(text, "hlt") == 0) {
+        *flush = OUTPUT_FLUSH_HLT;
+    } else {
+        char * endptr = NULL;
+        long v = strtol(text, &endptr, 10);
+        if (strlen(endptr) > 0 || v < 1 || v > 1000000000)
+            return EXIT_INVALID_ARGUMENT;
+        *flush = v == 1 ? OUTPUT_FLUSH_VALUE : OUTPUT_FLUSH_EVERY;
+        *every = (int)v;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Thread que tira os valores do anel e escreve no destino
+static void * output_writer(void * arg);
+
+ErrorCode_t output_open(outputSink_t * sink, const char * target, FILE * fallback,
+                        outputFormat_t format, outputFlush_t flush, int every,
+                        size_t ringCapacity, outputFull_t full) {
+    memset(sink, 0, sizeof(outputSink_t));
+    atomic_init(&sink->flushRequests, 0);
+    atomic_init(&sink->flushesDone, 0);
+    atomic_init(&sink->stopping, false);
+    sink->format = format;
+    sink->flush = flush;
+    sink->flushEvery = every > 0 ? every : 1;
+
+    const char * mode = format == OUTPUT_FORMAT_RAW ? "wb" : "w";
+    if (target == NULL) {
+        sink->stream = fallback;
+        #ifdef _WIN32
+        // Senão, o Windows troca os '\n' dos bytes por "\r\n"
+        if (format == OUTPUT_FORMAT_RAW)
+            _setmode(fileno(fallback), _O_BINARY);
+        #endif // _WIN32
+    } else if (target[0] == '|') {
+        sink->stream = popen(target + 1, "w");
+        sink->isPipe = true;
+    } else {
+        sink->stream = fopen(target, mode);
+    }
+    if (sink->stream == NULL)
+        return EXIT_FILE_NOT_FOUND;
+    if (target != NULL) {
+        sink->ownsStream = true;
+        setvbuf(sink->stream, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+    }
+
+    if (sink->flush == OUTPUT_FLUSH_AUTO)
+        sink->flush = isatty(fileno(sink->stream)) ? OUTPUT_FLUSH_VALUE : OUTPUT_FLUSH_HLT;
+    if (format == OUTPUT_FORMAT_CSV)
+        fputs(ringCapacity > 0 ? "porta,valor,tempo_us\n" : "porta,valor\n", sink->stream);
+
+    if (ringCapacity > 0) {
+        sink->ring = outputRing_create(ringCapacity, full);
+        if (sink->ring == NULL)
+            return EXIT_NO_MEMORY;
+        stopWatch_start(&sink->clock);
+        // Se não conseguir criar a thread, o OUT escreve direto
+        if (pthread_create(&sink->writer, NULL, output_writer, sink) != 0) {
+            outputRing_destroy(sink->ring);
+            sink->ring = NULL;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Escreve o número em decimal no fim do buffer
+ * @return a quantidade de caracteres escritos
+ */
+static int write_decimal(char * buffer, long long value) {
+    char digits[20];
+    int length = 0, count = 0;
+    if (value < 0) {
+        buffer[count++] = '-';
+        value = -value;
+    }
+    do {
+        digits[length++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (length > 0)
+        buffer[count++] = digits[--length];
+    return count;
+}
+
+/**
+ * Escreve um valor no fluxo e descarrega conforme a política
+ * @param time o tempo do OUT em microssegundos (negativo se não houver)
+ */
+static void write_value(outputSink_t * sink, uhex1_t port, hex1_t value, long long time) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    char line[48];
+    int n = 0;
+    uhex1_t u = (uhex1_t)value;
+
+    // Sem printf: a formatação pesa quando o programa faz muitos OUT
+    switch (sink->format) {
+        case OUTPUT_FORMAT_HUMAN:
+            // Igual a print_hex: "%xH (Decimal: %d)\n"
+            if (u > 0xF)
+                line[n++] = HEX_DIGITS[u >> 4];
+            line[n++] = HEX_DIGITS[u & 0xF];
+            memcpy(line + n, "H (Decimal: ", 12);
+            n += 12;
+            n += write_decimal(line + n, value);
+            line[n++] = ')';
+            line[n++] = '\n';
+            fwrite(line, 1, n, sink->stream);
+            break;
+        case OUTPUT_FORMAT_RAW:
+            fputc(u, sink->stream);
+            break;
+        case OUTPUT_FORMAT_CSV:
+            n += write_decimal(line + n, port);
+            line[n++] = ',';
+            n += write_decimal(line + n, u);
+            if (time >= 0) {
+                line[n++] = ',';
+                n += write_decimal(line + n, time);
+            }
+            line[n++] = '\n';
+            fwrite(line, 1, n, sink->stream);
+            break;
+    }
+
+    switch (sink->flush) {
+        case OUTPUT_FLUSH_VALUE:
+            fflush(sink->stream);
+            break;
+        case OUTPUT_FLUSH_EVERY:
+            if (++sink->pending >= sink->flushEvery) {
+                fflush(sink->stream);
+                sink->pending = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void * output_writer(void * arg) {
+    outputSink_t * sink = arg;
+    outputRecord_t record;
+    for (;;) {
+        // Lidos antes de esvaziar o anel: tudo que a VM colocou antes de
+        // pedir a descarga (ou o fim) é escrito antes de atendê-la
+        bool stopping = atomic_load(&sink->stopping);
+        unsigned requests = atomic_load(&sink->flushRequests);
+
+        while (outputRing_pop(sink->ring, &record))
+            write_value(sink, record.port, record.value, (long long)(record.time * 1000000.0));
+
+        if (requests != atomic_load_explicit(&sink->flushesDone, memory_order_relaxed)) {
+            fflush(sink->stream);
+            sink->pending = 0;
+            atomic_store(&sink->flushesDone, requests);
+        }
+        if (stopping)
+            return NULL;
+        sleep_us(OUTPUT_WRITER_IDLE_US);
+    }
+}
+
+void output_write(outputSink_t * sink, uhex1_t port, hex1_t value) {
+    sink->count++;
+    if (sink->ring != NULL) {
+        outputRecord_t record = {
+            .time = stopWatch_timeElapsed(&sink->clock),
+            .port = port,
+            .value = value
+        };
+        outputRing_push(sink->ring, &record);
+        return;
+    }
+    write_value(sink, port, value, -1);
+}
+
+void output_flush(outputSink_t * sink) {
+    if (sink->ring != NULL) {
+        // Só espera se o fluxo for o mesmo do resto da saída (senão, os
+        // valores poderiam aparecer depois do que é impresso no HLT)
+        unsigned request = atomic_fetch_add(&sink->flushRequests, 1) + 1;
+        while (!sink->ownsStream && (int)(request - atomic_load(&sink->flushesDone)) > 0)
+            sleep_us(OUTPUT_WRITER_IDLE_US);
+        return;
+    }
+    if (sink->stream != NULL)
+        fflush(sink->stream);
+    sink->pending = 0;
+}
+
+ErrorCode_t output_close(outputSink_t * sink) {
+    if (sink->ring != NULL) {
+        atomic_store(&sink->stopping, true);
+        pthread_join(sink->writer, NULL);
+        sink->dropped = sink->ring->dropped;
+        sink->waits = sink->ring->waits;
+        sink->ringCapacity = sink->ring->capacity;
+        outputRing_destroy(sink->ring);
+        sink->ring = NULL;
+    }
+    if (sink->stream == NULL)
+        return EXIT_SUCCESS;
+    ErrorCode_t err = fflush(sink->stream) != 0 || ferror(sink->stream) ? EXIT_FILE_NOT_FOUND : EXIT_SUCCESS;
+    if (sink->ownsStream) {
+        int closed = sink->isPipe ? pclose(sink->stream) : fclose(sink->stream);
+        if (closed != 0 && !sink->isPipe)
+            err = EXIT_FILE_NOT_FOUND;
+    }
+    sink->stream = NULL;
+    return err;
+}
@@ -0,0 +1,147 @@
+// Destino dos valores do OUT. Ao invés de imprimir e descarregar o
+// fluxo a cada OUT, os valores são escritos (no formato escolhido) no
+// buffer do fluxo de destino, que só é descarregado conforme a política
+// escolhida: a cada valor, a cada N valores ou só no HLT.
+//
+// O destino também pode ter um anel (ver ring.h) e uma thread própria
+// que escreve: o OUT só coloca o valor (com o tempo) no anel, então a
+// VM não espera o fluxo de destino (um comando lento, por exemplo).
+//
+// Author: André
+// Date: 05/11/2025
+//
+
+#ifndef SAP2_COMPILER_OUTPUT_H
+#define SAP2_COMPILER_OUTPUT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ring.h"
+#include "../environment.h"
+#include "../ErrorCodes.h"
+#include "../Utils/Utils.h"
+
+// Tamanho do buffer dos arquivos e comandos abertos pelo destino
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+// Quanto a thread que escreve espera (em microssegundos) quando o anel está vazio
+#define OUTPUT_WRITER_IDLE_US 1000
+
+// Formato dos valores
+typedef enum {
+    // "ffH (Decimal: -1)", uma linha por valor (o formato de sempre)
+    OUTPUT_FORMAT_HUMAN,
+    // Um byte por valor
+    OUTPUT_FORMAT_RAW,
+    // "porta,valor" (valor de 0 a 255), com cabeçalho. Com o anel, tem
+    // também o tempo do OUT: "porta,valor,tempo_us"
+    OUTPUT_FORMAT_CSV
+} outputFormat_t;
+
+// Quando o destino é descarregado
+typedef enum {
+    // A cada valor se o destino for um terminal; senão, só no HLT
+    OUTPUT_FLUSH_AUTO,
+    // A cada valor
+    OUTPUT_FLUSH_VALUE,
+    // A cada "flushEvery" valores (e no HLT)
+    OUTPUT_FLUSH_EVERY,
+    // Só no HLT (ou quando o buffer do fluxo encher)
+    OUTPUT_FLUSH_HLT
+} outputFlush_t;
+
+// Destino dos valores do OUT
+typedef struct outputSink_s {
+    FILE * stream;
+    outputFormat_t format;
+    outputFlush_t flush;
+    int flushEvery;
+    // Valores escritos desde a última descarga
+    int pending;
+    // Valores escritos no total
+    uint64_t count;
+    // Se o fluxo foi aberto pelo destino (e é fechado por ele)
+    bool ownsStream;
+    // Se o fluxo é a entrada de um comando (fechado com pclose)
+    bool isPipe;
+
+    // Anel até a thread que escreve (NULL se o OUT escreve direto)
+    outputRing_t * ring;
+    pthread_t writer;
+    // Descargas pedidas pela VM e feitas pela thread que escreve
+    atomic_uint flushRequests;
+    atomic_uint flushesDone;
+    // Se a thread que escreve deve terminar (depois de esvaziar o anel)
+    atomic_bool stopping;
+    // Tempo desde que o destino foi aberto (para o tempo de cada OUT)
+    stopWatch_s clock;
+    // Estatísticas do anel (guardadas quando o destino é fechado)
+    uint64_t dropped;
+    uint64_t waits;
+    size_t ringCapacity;
+} outputSink_t;
+
+/**
+ * Lê o nome de um formato ("humano", "bruto" ou "csv")
+ * @param text o nome
+ * @param format onde o formato é guardado
+ * @return o código de erro
+ */
+ErrorCode_t output_parse_format(const char * text, outputFormat_t * format);
+
+/**
+ * Lê uma política de descarga ("auto", "valor", "hlt" ou a quantidade
+ * de valores entre as descargas)
+ * @param text a política
+ * @param flush onde a política é guardada
+ * @param every onde a quantidade de valores é guardada
+ * @return o código de erro
+ */
+ErrorCode_t output_parse_flush(const char * text, outputFlush_t * flush, int * every);
+
+/**
+ * Abre o destino
+ * @param sink o destino
+ * @param target um arquivo, "|comando" (os valores vão para a entrada
+ * do comando) ou NULL para usar "fallback"
+ * @param fallback o fluxo usado quando não há "target" (não é fechado)
+ * @param format o formato dos valores
+ * @param flush a política de descarga
+ * @param every a quantidade de valores entre as descargas (OUTPUT_FLUSH_EVERY)
+ * @param ringCapacity o tamanho do anel até a thread que escreve (0 para
+ * o OUT escrever direto)
+ * @param full o que o OUT faz quando o anel está cheio
+ * @return o código de erro
+ */
+ErrorCode_t output_open(outputSink_t * sink, const char * target, FILE * fallback,
+                        outputFormat_t format, outputFlush_t flush, int every,
+                        size_t ringCapacity, outputFull_t full);
+
+/**
+ * Escreve um valor do OUT
+ * @param sink o destino
+ * @param port a porta do OUT
+ * @param value o valor
+ */
+void output_write(outputSink_t * sink, uhex1_t port, hex1_t value);
+
+/**
+ * Descarrega o destino (chamado no HLT e no fim da execução). Com o
+ * anel, pede a descarga à thread que escreve e, se o destino for o
+ * fluxo padrão, espera ela esvaziar o anel e descarregar.
+ * @param sink o destino
+ */
+void output_flush(outputSink_t * sink);
+
+/**
+ * Descarrega e fecha o destino (se o fluxo for dele), terminando a
+ * thread que escreve (se houver)
+ * @param sink o destino
+ * @return o código de erro (EXIT_FILE_NOT_FOUND se algo não foi escrito)
+ */
+ErrorCode_t output_close(outputSink_t * sink);
+
+#endif //SAP2_COMPILER_OUTPUT_H
@@ -0,0 +1,145 @@
+// Anel de valores do OUT entre a VM e a thread que escreve
+//
+// Author: André
+// Date: 08/11/2025
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+#include "../Utils/Utils.h"
+
+ErrorCode_t outputRing_parse_full(const char * text, outputFull_t * full) {
+    if (strcmp(text, "bloquear") == 0)
+        *full = OUTPUT_FULL_BLOCK;
+    else if (strcmp(text, "descartar") == 0)
+        *full = OUTPUT_FULL_DROP;
+    else if (strcmp(text, "crescer") == 0)
+        *full = OUTPUT_FULL_GROW;
+    else
+        return EXIT_INVALID_ARGUMENT;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Cria um segmento vazio
+ * @param capacity a quantidade de valores (uma potência de 2)
+ * @return o segmento (NULL se não houver memória)
+ */
+static outputSegment_t * create_segment(size_t capacity) {
+    outputSegment_t * segment = malloc(sizeof(outputSegment_t));
+    if (segment == NULL)
+        return NULL;
+    segment->records = malloc(sizeof(outputRecord_t) * capacity);
+    if (segment->records == NULL) {
+        free(segment);
+        return NULL;
+    }
+    segment->mask = capacity - 1;
+    atomic_init(&segment->next, NULL);
+    atomic_init(&segment->head, 0);
+    atomic_init(&segment->tail, 0);
+    segment->cachedTail = 0;
+    segment->cachedHead = 0;
+    return segment;
+}
+
+static void destroy_segment(outputSegment_t * segment) {
+    free(segment->records);
+    free(segment);
+}
+
+outputRing_t * outputRing_create(size_t capacity, outputFull_t full) {
+    size_t size = 1;
+    while (size < capacity && size < OUTPUT_RING_MAX_CAPACITY)
+        size <<= 1;
+
+    outputRing_t * ring = calloc(1, sizeof(outputRing_t));
+    if (ring == NULL)
+        return NULL;
+    ring->write = ring->read = create_segment(size);
+    if (ring->write == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->full = full;
+    ring->capacity = size;
+    return ring;
+}
+
+bool outputRing_push(outputRing_t * ring, const outputRecord_t * record) {
+    outputSegment_t * segment = ring->write;
+    size_t head = atomic_load_explicit(&segment->head, memory_order_relaxed);
+
+    // Só lê o índice da outra thread quando o anel parece cheio
+    if (head - segment->cachedTail > segment->mask) {
+        segment->cachedTail = atomic_load_explicit(&segment->tail, memory_order_acquire);
+    }
+    if (head - segment->cachedTail > segment->mask) {
+        if (ring->full == OUTPUT_FULL_DROP) {
+            ring->dropped++;
+            return false;
+        }
+
+        outputSegment_t * bigger = NULL;
+        if (ring->full == OUTPUT_FULL_GROW && segment->mask + 1 < OUTPUT_RING_MAX_CAPACITY)
+            bigger = create_segment((segment->mask + 1) * 2);
+        if (bigger != NULL) {
+            // A thread que escreve passa para o novo segmento depois de esvaziar esse
+            atomic_store_explicit(&segment->next, bigger, memory_order_release);
+            ring->write = segment = bigger;
+            ring->capacity = segment->mask + 1;
+            head = 0;
+        } else {
+            // Espera a thread que escreve tirar algum valor
+            ring->waits++;
+            do {
+                sleep_us(OUTPUT_RING_WAIT_US);
+                segment->cachedTail = atomic_load_explicit(&segment->tail, memory_order_acquire);
+            } while (head - segment->cachedTail > segment->mask);
+        }
+    }
+
+    segment->records[head & segment->mask] = *record;
+    atomic_store_explicit(&segment->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool outputRing_pop(outputRing_t * ring, outputRecord_t * record) {
+    for (;;) {
+        outputSegment_t * segment = ring->read;
+        size_t tail = atomic_load_explicit(&segment->tail, memory_order_relaxed);
+        if (tail == segment->cachedHead)
+            segment->cachedHead = atomic_load_explicit(&segment->head, memory_order_acquire);
+
+        if (tail != segment->cachedHead) {
+            *record = segment->records[tail & segment->mask];
+            atomic_store_explicit(&segment->tail, tail + 1, memory_order_release);
+            return true;
+        }
+
+        // Vazio: se a VM já passou para outro segmento, esse não recebe
+        // mais nada (mas ela pode ter colocado algo antes de passar)
+        outputSegment_t * next = atomic_load_explicit(&segment->next, memory_order_acquire);
+        if (next == NULL)
+            return false;
+        segment->cachedHead = atomic_load_explicit(&segment->head, memory_order_acquire);
+        if (tail != segment->cachedHead)
+            continue;
+        ring->read = next;
+        destroy_segment(segment);
+    }
+}
+
+void outputRing_destroy(outputRing_t * ring) {
+    if (ring == NULL)
+        return;
+    outputSegment_t * segment = ring->read;
+    while (segment != NULL) {
+        outputSegment_t * next = atomic_load_explicit(&segment->next, memory_order_relaxed);
+        destroy_segment(segment);
+        segment = next;
+    }
+    free(ring);
+}
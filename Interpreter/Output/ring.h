@@ -0,0 +1,121 @@
+// Anel de valores do OUT entre a VM (que coloca) e a thread que
+// escreve no destino (que tira). Só uma thread coloca e só uma tira,
+// então o anel não usa trava: cada lado só escreve o próprio índice e
+// lê o do outro com memória atômica.
+//
+// O anel é uma lista de segmentos. Quando ele cresce, a VM passa a
+// colocar em um segmento novo (com o dobro do tamanho) e a thread que
+// escreve troca de segmento quando esvazia o antigo.
+//
+// Author: André
+// Date: 08/11/2025
+//
+
+#ifndef SAP2_COMPILER_RING_H
+#define SAP2_COMPILER_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Tamanho de uma linha de cache (os índices de cada lado ficam em linhas diferentes)
+#define OUTPUT_RING_CACHE_LINE 64
+// Maior segmento criado quando o anel cresce (depois disso, a VM espera)
+#define OUTPUT_RING_MAX_CAPACITY ((size_t)1 << 24)
+// Quanto a VM espera (em microssegundos) antes de tentar de novo em um anel cheio
+#define OUTPUT_RING_WAIT_US 1000
+
+// O que a VM faz quando o anel está cheio
+typedef enum {
+    // Espera a thread que escreve tirar um valor
+    OUTPUT_FULL_BLOCK,
+    // Descarta o valor (e conta)
+    OUTPUT_FULL_DROP,
+    // Cria um segmento maior
+    OUTPUT_FULL_GROW
+} outputFull_t;
+
+// Um valor do OUT no anel
+typedef struct {
+    // Segundos desde que o destino foi aberto
+    double time;
+    uhex1_t port;
+    hex1_t value;
+} outputRecord_t;
+
+// Um segmento do anel (a capacidade é uma potência de 2)
+typedef struct outputSegment_s {
+    outputRecord_t * records;
+    size_t mask;
+    // Próximo segmento (colocado pela VM quando o anel cresce)
+    _Atomic(struct outputSegment_s *) next;
+
+    // Lado da VM: próxima posição a escrever e a última leitura de "tail"
+    _Alignas(OUTPUT_RING_CACHE_LINE) atomic_size_t head;
+    size_t cachedTail;
+
+    // Lado da thread que escreve: próxima posição a ler e a última leitura de "head"
+    _Alignas(OUTPUT_RING_CACHE_LINE) atomic_size_t tail;
+    size_t cachedHead;
+} outputSegment_t;
+
+// Anel de valores do OUT
+typedef struct outputRing_s {
+    // Segmento onde a VM coloca
+    outputSegment_t * write;
+    // Segmento de onde a thread que escreve tira
+    outputSegment_t * read;
+    outputFull_t full;
+
+    // Estatísticas (escritas só pela VM)
+    // Valores descartados (anel cheio com OUTPUT_FULL_DROP)
+    uint64_t dropped;
+    // Vezes em que a VM esperou (anel cheio com OUTPUT_FULL_BLOCK ou no tamanho máximo)
+    uint64_t waits;
+    // Capacidade do maior segmento
+    size_t capacity;
+} outputRing_t;
+
+/**
+ * Lê o nome de uma política de anel cheio ("bloquear", "descartar" ou "crescer")
+ * @param text o nome
+ * @param full onde a política é guardada
+ * @return o código de erro
+ */
+ErrorCode_t outputRing_parse_full(const char * text, outputFull_t * full);
+
+/**
+ * Cria um anel vazio
+ * @param capacity a quantidade de valores (arredondada para uma potência de 2)
+ * @param full o que fazer quando o anel estiver cheio
+ * @return o anel (NULL se não houver memória)
+ */
+outputRing_t * outputRing_create(size_t capacity, outputFull_t full);
+
+/**
+ * Coloca um valor no anel (só pela VM)
+ * @param ring o anel
+ * @param record o valor
+ * @return se o valor foi colocado (false se ele foi descartado)
+ */
+bool outputRing_push(outputRing_t * ring, const outputRecord_t * record);
+
+/**
+ * Tira o valor mais antigo do anel (só pela thread que escreve)
+ * @param ring o anel
+ * @param record onde o valor é guardado
+ * @return se havia um valor
+ */
+bool outputRing_pop(outputRing_t * ring, outputRecord_t * record);
+
+/**
+ * Libera o anel (depois que as duas threads pararam de usá-lo)
+ * @param ring o anel
+ */
+void outputRing_destroy(outputRing_t * ring);
+
+#endif //SAP2_COMPILER_RING_H
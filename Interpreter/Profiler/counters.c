@@ -0,0 +1,154 @@
+// Contadores de hardware do processador
+//
+// Author: André
+// Date: 31/10/2025
+//
+
+#include <string.h>
+
+#include "counters.h"
+
+#ifdef __linux__
+    #include <errno.h>
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+// Nomes dos contadores (na ordem de counter_t)
+static const char * COUNTER_NAMES[COUNTER_COUNT] = {
+    "Ciclos do host",
+    "Instrucoes do host",
+    "Desvios previstos errado",
+    "Faltas na cache L1D"
+};
+
+#ifdef __linux__
+
+// Tipo e configuração de cada contador (na ordem de counter_t)
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} COUNTER_EVENTS[COUNTER_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+};
+
+bool counters_open(counters_t * counters) {
+    memset(counters, 0, sizeof(counters_t));
+    bool any = false;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = COUNTER_EVENTS[i].type;
+        attr.config = COUNTER_EVENTS[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // O tempo ligado/contando permite corrigir a multiplexação
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        counters->available[i] = counters->fds[i] >= 0;
+        if (!counters->available[i] && counters->error == 0)
+            counters->error = errno;
+        any = any || counters->available[i];
+    }
+    return any;
+}
+
+void counters_start(counters_t * counters) {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (!counters->available[i])
+            continue;
+        ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void counters_stop(counters_t * counters) {
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        if (counters->available[i])
+            ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters->values[i] = 0;
+        if (!counters->available[i])
+            continue;
+        // valor, tempo ligado, tempo contando
+        uint64_t data[3];
+        if (read(counters->fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            counters->available[i] = false;
+            continue;
+        }
+        counters->values[i] = data[2] < data[1]
+            ? (uint64_t)((double)data[0] * (double)data[1] / (double)data[2])
+            : data[0];
+    }
+}
+
+void counters_close(counters_t * counters) {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (counters->fds[i] >= 0)
+            close(counters->fds[i]);
+        counters->fds[i] = -1;
+        counters->available[i] = false;
+    }
+}
+
+#else
+
+bool counters_open(counters_t * counters) {
+    memset(counters, 0, sizeof(counters_t));
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        counters->fds[i] = -1;
+    return false;
+}
+
+void counters_start(counters_t * counters) {
+    (void)counters;
+}
+
+void counters_stop(counters_t * counters) {
+    (void)counters;
+}
+
+void counters_close(counters_t * counters) {
+    (void)counters;
+}
+
+#endif // __linux__
+
+void counters_print(const counters_t * counters, uint64_t guest_instructions, FILE * out) {
+    bool any = false;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        any = any || counters->available[i];
+    if (!any) {
+        if (counters->error != 0)
+            fprintf(out, "Contadores de hardware: indisponiveis (%s)\n", strerror(counters->error));
+        else
+            fprintf(out, "Contadores de hardware: indisponiveis\n");
+        return;
+    }
+
+    double guest = guest_instructions > 0 ? (double)guest_instructions : 1.0;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (!counters->available[i]) {
+            fprintf(out, "%-26s: indisponivel\n", COUNTER_NAMES[i]);
+            continue;
+        }
+        fprintf(out, "%-26s: %llu (%.3f por instrucao do SAP2)\n", COUNTER_NAMES[i],
+            (unsigned long long)counters->values[i], (double)counters->values[i] / guest);
+    }
+    if (counters->available[COUNTER_CYCLES] && counters->available[COUNTER_INSTRUCTIONS]
+        && counters->values[COUNTER_CYCLES] > 0) {
+        fprintf(out, "%-26s: %.3f\n", "IPC do host",
+            (double)counters->values[COUNTER_INSTRUCTIONS] / (double)counters->values[COUNTER_CYCLES]);
+    }
+}
@@ -0,0 +1,74 @@
+// Contadores de hardware do processador (perf_event_open, só no Linux):
+// ciclos, instruções, erros de previsão de desvio e faltas na cache L1
+// de dados do próprio interpretador. Servem para comparar mudanças no
+// laço de execução além do tempo. Se o sistema não permitir algum
+// contador (ex.: perf_event_paranoid, máquina virtual), ele só fica
+// indisponível.
+//
+// Author: André
+// Date: 31/10/2025
+//
+
+#ifndef SAP2_COMPILER_COUNTERS_H
+#define SAP2_COMPILER_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Contadores medidos
+typedef enum {
+    COUNTER_CYCLES = 0,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_COUNT
+} counter_t;
+
+// Contadores abertos
+typedef struct {
+    int fds[COUNTER_COUNT];
+    // Se o contador existe nesse sistema
+    bool available[COUNTER_COUNT];
+    // Valores da última medição (ajustados se o contador foi dividido
+    // com outros programas)
+    uint64_t values[COUNTER_COUNT];
+    // Erro do sistema do primeiro contador indisponível (0 se não houver)
+    int error;
+} counters_t;
+
+/**
+ * Abre os contadores (desligados) do processo atual
+ * @param counters os contadores
+ * @return se algum contador está disponível
+ */
+bool counters_open(counters_t * counters);
+
+/**
+ * Zera e liga os contadores
+ * @param counters os contadores
+ */
+void counters_start(counters_t * counters);
+
+/**
+ * Desliga os contadores e lê os valores
+ * @param counters os contadores
+ */
+void counters_stop(counters_t * counters);
+
+/**
+ * Fecha os contadores
+ * @param counters os contadores
+ */
+void counters_close(counters_t * counters);
+
+/**
+ * Imprime os contadores em relação às instruções do SAP2 executadas
+ * (IPC do host, ciclos, desvios errados e faltas na L1D por instrução)
+ * @param counters os contadores (já medidos)
+ * @param guest_instructions quantidade de instruções do SAP2 executadas
+ * @param out onde os valores são impressos
+ */
+void counters_print(const counters_t * counters, uint64_t guest_instructions, FILE * out);
+
+#endif //SAP2_COMPILER_COUNTERS_H
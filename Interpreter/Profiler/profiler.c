@@ -0,0 +1,414 @@
+// Perfil da execução de um programa do SAP2
+//
+// Author: André
+// Date: 29/10/2025
+//
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profiler.h"
+#include "../Instructions/Instructions.h"
+
+// Tamanho do CALL (o RET volta para o endereço depois dele)
+#define CALL_SIZE 3
+
+// Sub-rotina (o programa principal é a primeira)
+typedef struct {
+    uhex2_t entry;
+    // Custo próprio (sem as sub-rotinas chamadas)
+    uint64_t instructions;
+    uint64_t tstates;
+} profileFunction_t;
+
+// Chamada de uma sub-rotina por outra em um endereço
+typedef struct {
+    int caller;
+    int callee;
+    uhex2_t site;
+    uint64_t calls;
+    // Custo inclusivo (da sub-rotina chamada e das que ela chama)
+    uint64_t instructions;
+    uint64_t tstates;
+} profileArc_t;
+
+// Chamada em andamento
+typedef struct {
+    int function;
+    int arc;
+    uhex2_t returnAddress;
+    // Totais no momento da chamada
+    uint64_t instructions;
+    uint64_t tstates;
+} profileFrame_t;
+
+struct profile_s {
+    // Por endereço (indexados pelo PC)
+    uint64_t count[UHEX2_MAX + 1];
+    uint64_t tstates[UHEX2_MAX + 1];
+    // Sub-rotina em que o endereço foi executado pela primeira vez
+    int function[UHEX2_MAX + 1];
+
+    // Por instrução
+    uint64_t opcodeCount[256];
+    uint64_t opcodeTStates[256];
+
+    // Totais
+    uint64_t instructions;
+    uint64_t totalTStates;
+
+    // Grafo de chamadas
+    profileFunction_t * functions;
+    size_t functionCount;
+    size_t functionCapacity;
+    profileArc_t * arcs;
+    size_t arcCount;
+    size_t arcCapacity;
+    profileFrame_t stack[PROFILER_MAX_DEPTH];
+    int depth;
+    // Sub-rotina atual
+    int current;
+};
+
+/**
+ * Procura (ou cria) a sub-rotina com a entrada dada
+ * @return a posição dela (-1 se não houver memória)
+ */
+static int find_function(profile_t * p, uhex2_t entry) {
+    for (size_t i = 0; i < p->functionCount; i++)
+        if (p->functions[i].entry == entry)
+            return (int)i;
+
+    if (p->functionCount == p->functionCapacity) {
+        size_t capacity = p->functionCapacity == 0 ? 16 : p->functionCapacity * 2;
+        profileFunction_t * functions = realloc(p->functions, capacity * sizeof(profileFunction_t));
+        if (functions == NULL)
+            return -1;
+        p->functions = functions;
+        p->functionCapacity = capacity;
+    }
+    p->functions[p->functionCount] = (profileFunction_t){ .entry = entry };
+    return (int)p->functionCount++;
+}
+
+/**
+ * Procura (ou cria) a chamada dada
+ * @return a posição dela (-1 se não houver memória)
+ */
+static int find_arc(profile_t * p, int caller, int callee, uhex2_t site) {
+    for (size_t i = 0; i < p->arcCount; i++) {
+        const profileArc_t * arc = &p->arcs[i];
+        if (arc->site == site && arc->caller == caller && arc->callee == callee)
+            return (int)i;
+    }
+
+    if (p->arcCount == p->arcCapacity) {
+        size_t capacity = p->arcCapacity == 0 ? 16 : p->arcCapacity * 2;
+        profileArc_t * arcs = realloc(p->arcs, capacity * sizeof(profileArc_t));
+        if (arcs == NULL)
+            return -1;
+        p->arcs = arcs;
+        p->arcCapacity = capacity;
+    }
+    p->arcs[p->arcCount] = (profileArc_t){ .caller = caller, .callee = callee, .site = site };
+    return (int)p->arcCount++;
+}
+
+ErrorCode_t profile_start(Environment * env) {
+    profile_finish(env);
+    profile_t * p = calloc(1, sizeof(profile_t));
+    if (p == NULL)
+        return EXIT_NO_MEMORY;
+    if (find_function(p, env->programCounter) != 0) {
+        free(p);
+        return EXIT_NO_MEMORY;
+    }
+    env->profile = p;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Termina a chamada do topo da pilha, somando o custo dela na chamada
+ */
+static void pop_frame(profile_t * p) {
+    const profileFrame_t * frame = &p->stack[--p->depth];
+    if (frame->arc >= 0) {
+        profileArc_t * arc = &p->arcs[frame->arc];
+        arc->instructions += p->instructions - frame->instructions;
+        arc->tstates += p->totalTStates - frame->tstates;
+    }
+    p->current = p->depth > 0 ? p->stack[p->depth - 1].function : 0;
+}
+
+/**
+ * Termina as chamadas que não voltaram (elas contam até o fim da execução)
+ */
+static void finish_calls(profile_t * p) {
+    while (p->depth > 0)
+        pop_frame(p);
+}
+
+void profile_instruction(Environment * env, uhex2_t pc, uhex1_t opcode, uint64_t tstates) {
+    profile_t * p = env->profile;
+
+    if (p->count[pc]++ == 0)
+        p->function[pc] = p->current;
+    p->tstates[pc] += tstates;
+    p->opcodeCount[opcode]++;
+    p->opcodeTStates[opcode] += tstates;
+    p->functions[p->current].instructions++;
+    p->functions[p->current].tstates += tstates;
+    p->instructions++;
+    p->totalTStates += tstates;
+
+    if (opcode == OPCODE_CALL) {
+        // O PC já é o da sub-rotina chamada
+        int callee = find_function(p, env->programCounter);
+        if (callee < 0)
+            return;
+        int arc = find_arc(p, p->current, callee, pc);
+        if (arc >= 0)
+            p->arcs[arc].calls++;
+        if (p->depth < PROFILER_MAX_DEPTH) {
+            p->stack[p->depth++] = (profileFrame_t){
+                .function = callee,
+                .arc = arc,
+                .returnAddress = (uhex2_t)(pc + CALL_SIZE),
+                .instructions = p->instructions,
+                .tstates = p->totalTStates
+            };
+        }
+        p->current = callee;
+    } else if (opcode == OPCODE_RET && p->depth > 0) {
+        // O SAP2 só guarda um endereço de retorno, então um CALL dentro
+        // de uma sub-rotina faz o RET voltar para o último CALL. As
+        // chamadas que não voltaram terminam junto.
+        int match = p->depth - 1;
+        while (match >= 0 && p->stack[match].returnAddress != env->programCounter)
+            match--;
+        if (match < 0)
+            match = p->depth - 1;
+        while (p->depth > match)
+            pop_frame(p);
+    }
+}
+
+/**
+ * Obtém o nome da sub-rotina (o rótulo da entrada dela ou o endereço)
+ */
+static const char * function_name(Environment * env, int function, char * buffer, size_t size) {
+    uhex2_t entry = env->profile->functions[function].entry;
+    int label = getLabelFromAddress(env, entry);
+    if (label >= 0)
+        return env->symbolTable[label].name;
+    if (function == 0)
+        return "(principal)";
+    snprintf(buffer, size, "%04XH", entry);
+    return buffer;
+}
+
+static double percent(uint64_t part, uint64_t total) {
+    return total == 0 ? 0.0 : 100.0 * (double)part / (double)total;
+}
+
+// Linha de uma tabela do relatório
+typedef struct {
+    int index;
+    uint64_t instructions;
+    uint64_t tstates;
+} reportRow_t;
+
+static int compare_rows(const void * a, const void * b) {
+    const reportRow_t * ra = a;
+    const reportRow_t * rb = b;
+    if (ra->tstates != rb->tstates)
+        return ra->tstates < rb->tstates ? 1 : -1;
+    if (ra->instructions != rb->instructions)
+        return ra->instructions < rb->instructions ? 1 : -1;
+    return ra->index - rb->index;
+}
+
+static int compare_labels(const void * a, const void * b) {
+    const label_t * la = a;
+    const label_t * lb = b;
+    return (int)la->value - (int)lb->value;
+}
+
+/**
+ * Procura o último rótulo antes (ou no) do endereço dado
+ * @return a posição do rótulo (-1 se não houver)
+ */
+static int label_before(const label_t * labels, size_t count, uhex2_t address) {
+    int found = -1;
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (labels[middle].value <= address) {
+            found = (int)middle;
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return found;
+}
+
+void profile_report(Environment * env, FILE * out) {
+    profile_t * p = env->profile;
+    if (p == NULL)
+        return;
+    finish_calls(p);
+
+    fprintf(out, "\n\nPerfil da execucao ================================\n");
+    fprintf(out, "Instrucoes executadas: %llu\nT-States: %llu\n",
+        (unsigned long long)p->instructions, (unsigned long long)p->totalTStates);
+
+    // Por rótulo (cada endereço é do último rótulo antes dele)
+    size_t rowCount = env->symbolCount + 1;
+    reportRow_t * rows = calloc(rowCount > 256 ? rowCount : 256, sizeof(reportRow_t));
+    label_t * labels = env->symbolCount > 0 ? malloc(env->symbolCount * sizeof(label_t)) : NULL;
+    if (rows == NULL || (env->symbolCount > 0 && labels == NULL)) {
+        free(rows);
+        free(labels);
+        return;
+    }
+    if (labels != NULL) {
+        memcpy(labels, env->symbolTable, env->symbolCount * sizeof(label_t));
+        qsort(labels, env->symbolCount, sizeof(label_t), compare_labels);
+    }
+    for (size_t i = 0; i < rowCount; i++)
+        rows[i].index = (int)i - 1; // -1: antes do primeiro rótulo
+    for (uint32_t address = 0; address <= UHEX2_MAX; address++) {
+        if (p->count[address] == 0)
+            continue;
+        reportRow_t * row = &rows[label_before(labels, env->symbolCount, (uhex2_t)address) + 1];
+        row->instructions += p->count[address];
+        row->tstates += p->tstates[address];
+    }
+    qsort(rows, rowCount, sizeof(reportRow_t), compare_rows);
+
+    fprintf(out, "\nPor rotulo (custo proprio) ========================\n");
+    fprintf(out, "%-20s| %-12s| %-8s| %-12s| %s\n", "Rotulo", "Instrucoes", "%", "T-States", "%");
+    for (size_t i = 0; i < rowCount && rows[i].instructions > 0; i++) {
+        fprintf(out, "%-20s| %-12llu| %-8.2f| %-12llu| %.2f\n",
+            rows[i].index < 0 ? "(sem rotulo)" : labels[rows[i].index].name,
+            (unsigned long long)rows[i].instructions, percent(rows[i].instructions, p->instructions),
+            (unsigned long long)rows[i].tstates, percent(rows[i].tstates, p->totalTStates));
+    }
+    free(labels);
+
+    // Por endereço (só os mais custosos)
+    fprintf(out, "\nPor endereco =====================================\n");
+    fprintf(out, "%-9s| %-20s| %-12s| %-12s| %s\n", "Endereco", "Instrucao", "Execucoes", "T-States", "%");
+    reportRow_t top[PROFILER_REPORT_ROWS];
+    int topCount = 0;
+    for (uint32_t address = 0; address <= UHEX2_MAX; address++) {
+        if (p->count[address] == 0)
+            continue;
+        reportRow_t row = { (int)address, p->count[address], p->tstates[address] };
+        // Inserção ordenada nos mais custosos
+        int position = topCount;
+        while (position > 0 && compare_rows(&row, &top[position - 1]) < 0)
+            position--;
+        if (position >= PROFILER_REPORT_ROWS)
+            continue;
+        if (topCount < PROFILER_REPORT_ROWS)
+            topCount++;
+        memmove(&top[position + 1], &top[position], (topCount - 1 - position) * sizeof(reportRow_t));
+        top[position] = row;
+    }
+    for (int i = 0; i < topCount; i++) {
+        // Só a instrução (sem o comentário sobre o rótulo)
+        const char * annotation = env_read_unit(env, top[i].index).annotation;
+        if (annotation == NULL)
+            annotation = "";
+        fprintf(out, "%04XH    | %-20.*s| %-12llu| %-12llu| %.2f\n",
+            top[i].index, (int)strcspn(annotation, "\t"), annotation,
+            (unsigned long long)top[i].instructions, (unsigned long long)top[i].tstates,
+            percent(top[i].tstates, p->totalTStates));
+    }
+
+    // Por instrução
+    int opcodes = 0;
+    for (int op = 0; op < 256; op++) {
+        if (p->opcodeCount[op] == 0)
+            continue;
+        rows[opcodes++] = (reportRow_t){ op, p->opcodeCount[op], p->opcodeTStates[op] };
+    }
+    qsort(rows, opcodes, sizeof(reportRow_t), compare_rows);
+    fprintf(out, "\nPor instrucao ====================================\n");
+    fprintf(out, "%-12s| %-12s| %-8s| %-12s| %s\n", "Instrucao", "Execucoes", "%", "T-States", "%");
+    for (int i = 0; i < opcodes; i++) {
+        const char * name = getInstructionName((uhex1_t)rows[i].index);
+        fprintf(out, "%-12s| %-12llu| %-8.2f| %-12llu| %.2f\n",
+            name != NULL ? name : "?",
+            (unsigned long long)rows[i].instructions, percent(rows[i].instructions, p->instructions),
+            (unsigned long long)rows[i].tstates, percent(rows[i].tstates, p->totalTStates));
+    }
+    free(rows);
+
+    // Chamadas
+    if (p->arcCount > 0) {
+        fprintf(out, "\nChamadas (custo inclusivo) =======================\n");
+        fprintf(out, "%-20s| %-20s| %-9s| %-10s| %-12s| %s\n", "Chamador", "Chamado", "Endereco", "Chamadas", "Instrucoes", "T-States");
+        for (size_t i = 0; i < p->arcCount; i++) {
+            const profileArc_t * arc = &p->arcs[i];
+            char callerBuffer[8], calleeBuffer[8];
+            fprintf(out, "%-20s| %-20s| %04XH    | %-10llu| %-12llu| %llu\n",
+                function_name(env, arc->caller, callerBuffer, sizeof(callerBuffer)),
+                function_name(env, arc->callee, calleeBuffer, sizeof(calleeBuffer)),
+                arc->site, (unsigned long long)arc->calls,
+                (unsigned long long)arc->instructions, (unsigned long long)arc->tstates);
+        }
+    }
+    fflush(out);
+}
+
+ErrorCode_t profile_write_callgrind(Environment * env, const char * path) {
+    profile_t * p = env->profile;
+    if (p == NULL)
+        return EXIT_NULL_ARGUMENT;
+    FILE * file = fopen(path, "w");
+    if (file == NULL)
+        return EXIT_FILE_NOT_FOUND;
+
+    finish_calls(p);
+
+    fprintf(file, "# callgrind format\nversion: 1\ncreator: SAP2-Compiler\n");
+    fprintf(file, "positions: instr\nevents: Instrucoes TStates\n");
+    fprintf(file, "summary: %llu %llu\n", (unsigned long long)p->instructions, (unsigned long long)p->totalTStates);
+
+    char buffer[8];
+    for (size_t f = 0; f < p->functionCount; f++) {
+        fprintf(file, "\nfn=%s\n", function_name(env, (int)f, buffer, sizeof(buffer)));
+        for (uint32_t address = 0; address <= UHEX2_MAX; address++) {
+            if (p->count[address] == 0 || p->function[address] != (int)f)
+                continue;
+            fprintf(file, "0x%04x %llu %llu\n", address,
+                (unsigned long long)p->count[address], (unsigned long long)p->tstates[address]);
+        }
+        for (size_t i = 0; i < p->arcCount; i++) {
+            const profileArc_t * arc = &p->arcs[i];
+            if (arc->caller != (int)f)
+                continue;
+            fprintf(file, "cfn=%s\n", function_name(env, arc->callee, buffer, sizeof(buffer)));
+            fprintf(file, "calls=%llu 0x%04x\n", (unsigned long long)arc->calls, p->functions[arc->callee].entry);
+            fprintf(file, "0x%04x %llu %llu\n", arc->site,
+                (unsigned long long)arc->instructions, (unsigned long long)arc->tstates);
+        }
+    }
+
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FILE_NOT_FOUND;
+}
+
+void profile_finish(Environment * env) {
+    if (env->profile == NULL)
+        return;
+    free(env->profile->functions);
+    free(env->profile->arcs);
+    free(env->profile);
+    env->profile = NULL;
+}
@@ -0,0 +1,74 @@
+// Perfil da execução de um programa do SAP2: conta, para cada endereço,
+// quantas vezes a instrução dele foi executada e quantos T-States ela
+// gastou (contando os pulos tomados), além da quantidade de cada
+// instrução usada. As chamadas (CALL/RET) formam o grafo de chamadas.
+//
+// No fim, há um relatório em texto (por rótulo, por endereço, por
+// instrução e por chamada) e um arquivo no formato do callgrind, que
+// pode ser aberto no kcachegrind/qcachegrind.
+//
+// Author: André
+// Date: 29/10/2025
+//
+
+#ifndef SAP2_COMPILER_PROFILER_H
+#define SAP2_COMPILER_PROFILER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Quantidade máxima de chamadas aninhadas acompanhadas
+#define PROFILER_MAX_DEPTH 256
+// Quantidade de linhas das tabelas do relatório
+#define PROFILER_REPORT_ROWS 20
+
+// Perfil de um ambiente (ver profiler.c)
+typedef struct profile_s profile_t;
+
+// Gancho usado pela execução (depois de cada instrução executada). Não
+// custa nada além da comparação quando não há perfil.
+#define PROFILE_INSTRUCTION(pc, opcode, tstates) \
+    do { if (env->profile != NULL) profile_instruction(env, pc, opcode, tstates); } while (0)
+
+/**
+ * Começa o perfil da execução do ambiente. O programa já deve estar
+ * montado (o ponto atual é a entrada do programa principal).
+ * @param env o ambiente do SAP2
+ * @return o código de erro
+ */
+ErrorCode_t profile_start(Environment * env);
+
+/**
+ * Registra uma instrução executada
+ * @param env o ambiente do SAP2
+ * @param pc o endereço da instrução
+ * @param opcode o código da instrução
+ * @param tstates os T-States gastos pela instrução
+ */
+void profile_instruction(Environment * env, uhex2_t pc, uhex1_t opcode, uint64_t tstates);
+
+/**
+ * Imprime o relatório do perfil (ordenado pelo custo)
+ * @param env o ambiente do SAP2
+ * @param out onde o relatório é impresso
+ */
+void profile_report(Environment * env, FILE * out);
+
+/**
+ * Grava o perfil no formato do callgrind
+ * @param env o ambiente do SAP2
+ * @param path o caminho do arquivo
+ * @return o código de erro
+ */
+ErrorCode_t profile_write_callgrind(Environment * env, const char * path);
+
+/**
+ * Libera o perfil do ambiente, se houver
+ * @param env o ambiente do SAP2
+ */
+void profile_finish(Environment * env);
+
+#endif //SAP2_COMPILER_PROFILER_H
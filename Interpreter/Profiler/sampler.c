@@ -0,0 +1,339 @@
+// Amostrador do próprio interpretador (SIGPROF)
+//
+// Author: André
+// Date: 30/10/2025
+//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sampler.h"
+
+#ifndef __linux__
+
+ErrorCode_t sampler_start(Environment * env, const char * path) {
+    (void)env;
+    (void)path;
+    fprintf(stderr, "[ERRO] O amostrador so existe no Linux.\n");
+    return EXIT_INVALID_ARGUMENT;
+}
+
+ErrorCode_t sampler_stop(Environment * env) {
+    (void)env;
+    return EXIT_SUCCESS;
+}
+
+unsigned long sampler_sample_count(void) {
+    return 0;
+}
+
+#else
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <link.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+// Amostra: funções do interpretador (da mais interna para a mais
+// externa) e o contador de programa do SAP2
+typedef struct {
+    void * frames[SAMPLER_MAX_FRAMES];
+    int depth;
+    uhex2_t guestPc;
+} sample_t;
+
+// Amostrador (só há um por vez, já que o sinal é do processo)
+typedef struct {
+    Environment * env;
+    char * path;
+    sample_t * samples;
+    volatile size_t count;
+    volatile size_t dropped;
+    struct sigaction previousAction;
+    struct itimerval previousTimer;
+} sampler_t;
+
+static sampler_t * volatile active = NULL;
+static unsigned long lastSampleCount = 0;
+
+/**
+ * Retorna o endereço da instrução interrompida pelo sinal
+ */
+static void * interrupted_pc(const ucontext_t * context) {
+    #if defined(__x86_64__)
+        return (void *)context->uc_mcontext.gregs[REG_RIP];
+    #elif defined(__i386__)
+        return (void *)context->uc_mcontext.gregs[REG_EIP];
+    #elif defined(__aarch64__)
+        return (void *)context->uc_mcontext.pc;
+    #else
+        (void)context;
+        return NULL;
+    #endif
+}
+
+static void on_sigprof(int signal, siginfo_t * info, void * context) {
+    (void)signal;
+    (void)info;
+    sampler_t * sampler = active;
+    if (sampler == NULL)
+        return;
+    if (sampler->count >= SAMPLER_MAX_SAMPLES) {
+        sampler->dropped++;
+        return;
+    }
+
+    sample_t * sample = &sampler->samples[sampler->count];
+    sample->guestPc = *(volatile uhex2_t *)&sampler->env->programCounter;
+
+    // A pilha começa no tratador do sinal: as funções até a interrompida
+    // são descartadas
+    void * frames[SAMPLER_MAX_FRAMES + 4];
+    int depth = backtrace(frames, SAMPLER_MAX_FRAMES + 4);
+    void * pc = interrupted_pc(context);
+    int first = 0;
+    while (first < depth && frames[first] != pc)
+        first++;
+    if (first == depth) {
+        // Sem a interrompida na pilha: ela entra no lugar do tratador e
+        // do trampolim do sinal
+        first = depth > 2 ? 2 : depth;
+        if (pc != NULL && first > 0)
+            frames[--first] = pc;
+    }
+
+    int count = depth - first;
+    if (count > SAMPLER_MAX_FRAMES)
+        count = SAMPLER_MAX_FRAMES;
+    // As outras são endereços de retorno: o "- 1" os deixa dentro da
+    // chamada (senão, uma chamada no fim da função cairia na seguinte)
+    sample->frames[0] = frames[first];
+    for (int i = 1; i < count; i++)
+        sample->frames[i] = (char *)frames[first + i] - 1;
+    sample->depth = count;
+    sampler->count++;
+}
+
+ErrorCode_t sampler_start(Environment * env, const char * path) {
+    if (active != NULL)
+        return EXIT_INVALID_ARGUMENT;
+
+    sampler_t * sampler = calloc(1, sizeof(sampler_t));
+    if (sampler == NULL)
+        return EXIT_NO_MEMORY;
+    sampler->samples = calloc(SAMPLER_MAX_SAMPLES, sizeof(sample_t));
+    sampler->path = malloc(strlen(path) + 1);
+    if (sampler->samples == NULL || sampler->path == NULL) {
+        free(sampler->samples);
+        free(sampler->path);
+        free(sampler);
+        return EXIT_NO_MEMORY;
+    }
+    strcpy(sampler->path, path);
+    sampler->env = env;
+
+    // O backtrace carrega a biblioteca dele na primeira chamada, o que
+    // não pode acontecer dentro do tratador do sinal
+    void * warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    active = sampler;
+    if (sigaction(SIGPROF, &action, &sampler->previousAction) != 0) {
+        active = NULL;
+        free(sampler->samples);
+        free(sampler->path);
+        free(sampler);
+        return EXIT_INVALID_ARGUMENT;
+    }
+
+    struct itimerval timer = {
+        .it_interval = { .tv_sec = 0, .tv_usec = SAMPLER_INTERVAL_US },
+        .it_value = { .tv_sec = 0, .tv_usec = SAMPLER_INTERVAL_US }
+    };
+    setitimer(ITIMER_PROF, &timer, &sampler->previousTimer);
+    return EXIT_SUCCESS;
+}
+
+// Nome de uma função do interpretador
+typedef struct {
+    void * address;
+    char * name;
+} symbol_t;
+
+static int compare_addresses(const void * a, const void * b) {
+    uintptr_t x = (uintptr_t)((const symbol_t *)a)->address;
+    uintptr_t y = (uintptr_t)((const symbol_t *)b)->address;
+    return x < y ? -1 : x > y;
+}
+
+static int compare_lines(const void * a, const void * b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * Obtém o nome da função que contém o endereço
+ * @return o nome (alocado)
+ */
+static char * symbolize(void * address) {
+    Dl_info info;
+    const ElfW(Sym) * symbol = NULL;
+    char buffer[256];
+    if (dladdr1(address, &info, (void **)&symbol, RTLD_DL_SYMENT) == 0 || info.dli_fname == NULL) {
+        snprintf(buffer, sizeof(buffer), "%p", address);
+    } else if (info.dli_sname != NULL && symbol != NULL
+               && (uintptr_t)address < (uintptr_t)info.dli_saddr + symbol->st_size) {
+        snprintf(buffer, sizeof(buffer), "%s", info.dli_sname);
+    } else {
+        // Função sem símbolo exportado (ex.: "static"): módulo + deslocamento
+        const char * module = strrchr(info.dli_fname, '/');
+        module = module != NULL ? module + 1 : info.dli_fname;
+        snprintf(buffer, sizeof(buffer), "%s+0x%lx", module,
+            (unsigned long)((uintptr_t)address - (uintptr_t)info.dli_fbase));
+    }
+    char * name = malloc(strlen(buffer) + 1);
+    if (name != NULL)
+        strcpy(name, buffer);
+    return name;
+}
+
+static const char * find_symbol(const symbol_t * symbols, size_t count, void * address) {
+    symbol_t key = { address, NULL };
+    const symbol_t * found = bsearch(&key, symbols, count, sizeof(symbol_t), compare_addresses);
+    return found != NULL && found->name != NULL ? found->name : "?";
+}
+
+/**
+ * Nome do trecho do SAP2 (último rótulo antes do endereço)
+ */
+static void guest_frame(Environment * env, uhex2_t pc, char * buffer, size_t size) {
+    int best = -1;
+    for (size_t i = 0; i < env->symbolCount; i++) {
+        uhex2_t value = env->symbolTable[i].value;
+        if (value <= pc && (best < 0 || value > env->symbolTable[best].value))
+            best = (int)i;
+    }
+    if (best >= 0)
+        snprintf(buffer, size, "[SAP2] %s", env->symbolTable[best].name);
+    else
+        snprintf(buffer, size, "[SAP2] %04XH", pc);
+}
+
+/**
+ * Grava as amostras como pilhas dobradas
+ * @return o código de erro
+ */
+static ErrorCode_t write_folded(sampler_t * sampler) {
+    size_t count = sampler->count;
+    ErrorCode_t err = EXIT_SUCCESS;
+
+    // Nomes dos endereços (cada endereço é procurado uma vez só)
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += sampler->samples[i].depth;
+    symbol_t * symbols = malloc((total > 0 ? total : 1) * sizeof(symbol_t));
+    char ** lines = malloc((count > 0 ? count : 1) * sizeof(char *));
+    if (symbols == NULL || lines == NULL) {
+        free(symbols);
+        free(lines);
+        return EXIT_NO_MEMORY;
+    }
+    size_t symbolCount = 0;
+    for (size_t i = 0; i < count; i++)
+        for (int f = 0; f < sampler->samples[i].depth; f++)
+            symbols[symbolCount++] = (symbol_t){ sampler->samples[i].frames[f], NULL };
+    qsort(symbols, symbolCount, sizeof(symbol_t), compare_addresses);
+    size_t unique = 0;
+    for (size_t i = 0; i < symbolCount; i++)
+        if (unique == 0 || symbols[unique - 1].address != symbols[i].address)
+            symbols[unique++] = symbols[i];
+    for (size_t i = 0; i < unique; i++)
+        symbols[i].name = symbolize(symbols[i].address);
+
+    // Uma linha por amostra (da função mais externa para a mais interna)
+    size_t lineCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        const sample_t * sample = &sampler->samples[i];
+        char line[SAMPLER_MAX_FRAMES * 64 + 64];
+        size_t length = 0;
+        for (int f = sample->depth - 1; f >= 0 && length < sizeof(line); f--)
+            length += snprintf(line + length, sizeof(line) - length, "%s;",
+                find_symbol(symbols, unique, sample->frames[f]));
+        if (length < sizeof(line))
+            guest_frame(sampler->env, sample->guestPc, line + length, sizeof(line) - length);
+        lines[lineCount] = malloc(strlen(line) + 1);
+        if (lines[lineCount] == NULL) {
+            err = EXIT_NO_MEMORY;
+            break;
+        }
+        strcpy(lines[lineCount++], line);
+    }
+
+    // Junta as linhas iguais
+    if (err == EXIT_SUCCESS) {
+        qsort(lines, lineCount, sizeof(char *), compare_lines);
+        FILE * file = fopen(sampler->path, "w");
+        if (file == NULL) {
+            err = EXIT_FILE_NOT_FOUND;
+        } else {
+            for (size_t i = 0; i < lineCount;) {
+                size_t j = i;
+                while (j < lineCount && strcmp(lines[i], lines[j]) == 0)
+                    j++;
+                fprintf(file, "%s %lu\n", lines[i], (unsigned long)(j - i));
+                i = j;
+            }
+            if (ferror(file))
+                err = EXIT_FILE_NOT_FOUND;
+            if (fclose(file) != 0)
+                err = EXIT_FILE_NOT_FOUND;
+        }
+    }
+
+    for (size_t i = 0; i < lineCount; i++)
+        free(lines[i]);
+    for (size_t i = 0; i < unique; i++)
+        free(symbols[i].name);
+    free(lines);
+    free(symbols);
+    return err;
+}
+
+ErrorCode_t sampler_stop(Environment * env) {
+    sampler_t * sampler = active;
+    if (sampler == NULL || sampler->env != env)
+        return EXIT_SUCCESS;
+
+    setitimer(ITIMER_PROF, &sampler->previousTimer, NULL);
+    sigaction(SIGPROF, &sampler->previousAction, NULL);
+    active = NULL;
+
+    lastSampleCount = sampler->count + sampler->dropped;
+    if (sampler->dropped > 0)
+        fprintf(stderr, "[AVISO] %lu amostras foram descartadas (limite de %d).\n",
+            (unsigned long)sampler->dropped, SAMPLER_MAX_SAMPLES);
+    ErrorCode_t err = write_folded(sampler);
+
+    free(sampler->samples);
+    free(sampler->path);
+    free(sampler);
+    return err;
+}
+
+unsigned long sampler_sample_count(void) {
+    return lastSampleCount;
+}
+
+#endif // __linux__
@@ -0,0 +1,51 @@
+// Amostrador do próprio interpretador: a cada tique do SIGPROF (tempo
+// de CPU do processo), guarda a pilha de funções do interpretador e o
+// contador de programa do SAP2. No fim, as amostras são gravadas como
+// "pilhas dobradas" (uma linha por pilha, seguida da quantidade de
+// amostras), que podem virar um flame graph (ex.: flamegraph.pl).
+//
+// Cada linha vai da função mais externa à mais interna do interpretador
+// e termina com o rótulo do SAP2 que estava sendo executado, então a
+// mesma execução mostra onde o interpretador gasta tempo e por causa de
+// qual trecho do programa. Funções sem símbolo aparecem como
+// "modulo+0xdeslocamento" (use addr2line). Só existe no Linux.
+//
+// Author: André
+// Date: 30/10/2025
+//
+
+#ifndef SAP2_COMPILER_SAMPLER_H
+#define SAP2_COMPILER_SAMPLER_H
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Intervalo entre as amostras (em microssegundos de CPU)
+#define SAMPLER_INTERVAL_US 1000
+// Quantidade máxima de amostras guardadas (as seguintes são descartadas)
+#define SAMPLER_MAX_SAMPLES (1 << 17)
+// Quantidade máxima de funções guardadas por amostra
+#define SAMPLER_MAX_FRAMES 32
+
+/**
+ * Começa a amostrar o processo. Só pode haver um amostrador por vez.
+ * @param env o ambiente do SAP2 cujo contador de programa é amostrado
+ * @param path o caminho do arquivo das pilhas dobradas
+ * @return o código de erro
+ */
+ErrorCode_t sampler_start(Environment * env, const char * path);
+
+/**
+ * Para de amostrar e grava as pilhas dobradas
+ * @param env o ambiente do SAP2
+ * @return o código de erro
+ */
+ErrorCode_t sampler_stop(Environment * env);
+
+/**
+ * Quantidade de amostras da última amostragem
+ * @return a quantidade de amostras (contando as descartadas)
+ */
+unsigned long sampler_sample_count(void);
+
+#endif //SAP2_COMPILER_SAMPLER_H
@@ -5,7 +5,10 @@
 //
 
 #include "evaluate.h"
+#include "../Debugger/debugger.h"
 #include "../Instructions/InstructionsFunctions.h"
+#include "../Profiler/profiler.h"
+#include "../Trace/trace.h"
 #include "../Utils/Utils.h"
 
 // Fetches
@@ -59,7 +62,8 @@ case o: l;
  * @return o hexadecimal que leu
  */
 hex1_t consume_hex1(Environment * env) {
-    return env->memory[env->programCounter++].value;
+    uhex2_t address = env->programCounter++;
+    return env_read_unit(env, address).value;
 }
 
 /**
@@ -68,7 +72,8 @@ hex1_t consume_hex1(Environment * env) {
  * @return o hexadecimal que leu
  */
 uhex1_t consume_instruction(Environment * env) {
-    return env->memory[env->programCounter++].value;
+    uhex2_t address = env->programCounter++;
+    return env_read_unit(env, address).value;
 }
 
 /**
@@ -87,9 +92,13 @@ hex2_t consume_hex2(Environment * env) {
 
 
 ErrorCode_t execute_instruction(Environment * env) {
-    if (env->memory[env->programCounter].value == OPCODE_NOP && env->memory[env->programCounter].annotation == NULL)
+    const memoryUnit_t * unit = &env_read_unit(env, env->programCounter);
+    if (unit->value == OPCODE_NOP && unit->annotation == NULL)
         return EXIT_NO_INSTRUCTION;
-    env->last_instruction = env->memory[env->programCounter];
+    uhex2_t pc = env->programCounter;
+    uint64_t tstates_before = env->totalTStates;
+    TRACE_PC(pc);
+    env->last_instruction = *unit;
     env->currentInstruction = env->last_instruction.nInstruction;
     uhex1_t opcode = consume_hex1(env);
 
@@ -122,7 +131,7 @@ ErrorCode_t execute_instruction(Environment * env) {
         }
 
         // IN
-        case OPCODE_IN: EVAL_ENC__HEX1(execute_out)
+        case OPCODE_IN: EVAL_ENC__HEX1(execute_in)
 
         // INR
         case OPCODE_INR_A: EVAL_ENC__REG(execute_inr, ACCUMULATOR)
@@ -182,14 +191,16 @@ ErrorCode_t execute_instruction(Environment * env) {
         case OPCODE_XRI:   EVAL_ENC__HEX1(execute_xri)
 
         default: {
-            fprintf(stderr,"Instrucao %d: Codigo de Operacao \"%x\" desconhecido", env->currentInstruction, opcode);
+            fprintf(env->diagnostics.errors,"Instrucao %d: Codigo de Operacao \"%x\" desconhecido", env->currentInstruction, opcode);
             return EXIT_INVALID_INSTRUCTION;
         }
     }
 
     // Simula o tempo dos T States
-    sleep_us(getInstructionTStates(opcode));
+    unsigned short int tstates = getInstructionTStates(opcode);
+    env_spend_tstates(tstates);
     env->totalInstructions++;
+    PROFILE_INSTRUCTION(pc, opcode, env->totalTStates - tstates_before);
 
     return EXIT_SUCCESS;
 }
@@ -202,27 +213,27 @@ void debugIfOn(Environment * env) {
         stopWatch_s debug_sw;
         stopWatch_start(&debug_sw);
 
-        printf("===========================\nInstrucao atual: %s\n===========================\n", env->last_instruction.annotation);
+        fprintf(env->out, "===========================\nInstrucao atual: %s\n===========================\n", env->last_instruction.annotation);
 
         // Se a última instrução for alguma específica, trata ela de forma diferente
         uhex1_t liv = env->last_instruction.value;
         if (liv == OPCODE_OUT) {
-            printf("Saida atual: ");
+            fprintf(env->out, "Saida atual: ");
             print_binary_hex(_out_flow(env->hex_flow_buffer), sizeof(hex1_t), env->registers[ACCUMULATOR]);
-            printf(">> Pressione enter para ver os dados");
-            enter_to_continue();
+            fprintf(env->out, ">> Pressione enter para ver os dados");
+            enter_to_continue(env->in);
         } else if (liv == OPCODE_IN) {
             setRegister(env, ACCUMULATOR, get_1hex_from_in(env, env->hex_flow_buffer));
-            printf("\n===========================\n");
+            fprintf(env->out, "\n===========================\n");
         }
 
         print_debug_info(env);
 
-        printf(">> Pressione enter para continuar");
-        enter_to_continue();
-        printf("\n\n\n\n");
+        // Espera o enter (ou um comando do depurador)
+        debugger_prompt(env);
+        fprintf(env->out, "\n\n\n\n");
         stopWatch_end(&debug_sw);
-        env->params->real_max_time += seg_to_ms(stopWatch_timeElapsed(&debug_sw));
+        env_params->real_max_time += seg_to_ms(stopWatch_timeElapsed(&debug_sw));
     }
 }
 
@@ -230,9 +241,14 @@ ErrorCode_t evaluate(Environment * env) {
     ErrorCode_t err;
     stopWatch_s local_stopwatch;
     stopWatch_start(&local_stopwatch);
+
+    // No modo de depuração, é possível voltar a execução (ver Debugger/debugger.h)
+    if (env_params->debug_mode && env->debugger == NULL && debugger_attach(env) != EXIT_SUCCESS)
+        E_EXIT_ERR(EXIT_NO_MEMORY);
+
     while (env->programCounter < MEMORY_SIZE) {
-        if (env_params->max_evaluated != -1 && env->currentInstruction > env_params->max_evaluated) {
-            V_EXIT(
+        if (env_params->max_evaluated != -1 && env->totalInstructions >= env_params->max_evaluated) {
+            E_EXIT(
                 EXIT_INSTRUCTION_LIMIT_REACHED,
                 "Instrucao %d: nao foi possivel executar essa instrucao\nporque o programa atingiu o limite de execucao de instrucoes (%i).",
                 env->currentInstruction,
@@ -244,15 +260,17 @@ ErrorCode_t evaluate(Environment * env) {
                 print_info(env);
             }
 
-            WARN(
+            char instruction[64];
+            E_WARN(
                 "Instrucao %d (%s): apos essa instrucao, o programa\natingiu o limite de tempo de execucao (%.3fs). Se quiser alterar\nesse limite, altere o parametro \"--limite-tempo\".",
                 env->currentInstruction,
-                getInstructionByNumber(env, env->currentInstruction),
+                getInstructionByNumber(env, env->currentInstruction, instruction, sizeof(instruction)),
                 ms_to_seg(env_params->max_time)
             );
             return EXIT_TIME_LIMIT_REACHED;
         }
 
+        DEBUGGER_BEFORE_INSTRUCTION();
         err = execute_instruction(env);
         if (err != EXIT_SUCCESS) {
             // nesse caso, HLT e EXIT_NO_INSTRUCTION são SUCESSO.
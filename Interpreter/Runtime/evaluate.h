@@ -18,4 +18,12 @@
  */
 ErrorCode_t evaluate(Environment * env);
 
+/**
+ * Executa a instrução apontada pelo contador de programa
+ * @param env o ambiente do SAP2
+ * @return o código de erro (EXIT_HLT se for um HLT e EXIT_NO_INSTRUCTION
+ * se não houver instrução no endereço)
+ */
+ErrorCode_t execute_instruction(Environment * env);
+
 #endif //SAP2_COMPILER_EVALUATE_H
\ No newline at end of file
@@ -0,0 +1,554 @@
+// Servidor local de simulações (sap2d): recebe pedidos por um socket
+// Unix, executa-os em um grupo fixo de threads e guarda os programas
+// já montados para os próximos pedidos.
+//
+// Author: André
+// Date: 25/10/2025
+//
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <pthread.h>
+    #include <signal.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "daemon.h"
+#include "io.h"
+#include "../interpreter.h"
+#include "../Snapshot/snapshot.h"
+#include "../Utils/Utils.h"
+
+// O protocolo precisa ter o mesmo formato em qualquer compilador
+_Static_assert(sizeof(daemonRequest_t) == 24, "Pedido do sap2d com tamanho inesperado");
+_Static_assert(sizeof(daemonResponse_t) == 40, "Resposta do sap2d com tamanho inesperado");
+
+#ifdef _WIN32
+
+ErrorCode_t daemon_serve(const char * path, int threads) {
+    (void)path;
+    (void)threads;
+    fprintf(stderr, "[ERRO] O sap2d usa sockets Unix e nao existe no Windows.\n");
+    return EXIT_INVALID_ARGUMENT;
+}
+
+void daemon_request_stop(void) {
+}
+
+#else
+
+// Um programa montado guardado
+typedef struct {
+    // Identificação do programa (tipo, endereço inicial e conteúdo)
+    uint64_t hash;
+    uint8_t kind;
+    uint16_t startAddress;
+    uint8_t * program;
+    size_t size;
+
+    // O programa montado (NULL se a posição estiver livre). Nunca é
+    // executado: cada pedido usa uma cópia (env_clone).
+    Environment * image;
+    // Quantos pedidos estão usando o programa agora
+    int users;
+    // Quando foi usado pela última vez (para saber qual descartar)
+    uint64_t lastUse;
+} cacheEntry_t;
+
+// Estado compartilhado entre as threads do servidor
+typedef struct {
+    // Programas montados
+    pthread_mutex_t cacheLock;
+    cacheEntry_t cache[DAEMON_CACHE_SIZE];
+    uint64_t clock;
+
+    // Fila de conexões esperando uma thread
+    pthread_mutex_t queueLock;
+    pthread_cond_t queueReady;
+    int * queue;
+    size_t queueCount;
+    size_t queueCapacity;
+    bool closing;
+
+    // Conexão atendida por cada thread (-1 se nenhuma)
+    int * clients;
+} daemon_t;
+
+// Dados de cada thread
+typedef struct {
+    daemon_t * daemon;
+    int index;
+} worker_t;
+
+// Se o servidor deve parar (ver daemon_request_stop)
+static volatile sig_atomic_t stop_requested = 0;
+
+void daemon_request_stop(void) {
+    stop_requested = 1;
+}
+
+// Hash FNV-1a de 64 bits
+static uint64_t hash_bytes(uint64_t hash, const void * data, size_t size) {
+    const uint8_t * bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/**
+ * Monta o programa do pedido
+ * @param request o pedido
+ * @param program o programa
+ * @param messages onde os avisos e erros da montagem são impressos
+ * @param out onde o programa montado é guardado
+ * @return o código de erro
+ */
+static ErrorCode_t daemon_build_image(const daemonRequest_t * request, const uint8_t * program,
+    FILE * messages, Environment ** out) {
+    *out = NULL;
+
+    if (request->kind == DAEMON_PROGRAM_STATE)
+        return env_restore_state(program, request->programSize, NULL, out);
+    if (request->kind != DAEMON_PROGRAM_SOURCE)
+        return EXIT_INVALID_ARGUMENT;
+    if (request->programSize == 0)
+        return EXIT_NO_INSTRUCTION;
+
+    Parametros * params = get_standard_parameters();
+    if (params == NULL)
+        return EXIT_NO_MEMORY;
+    params->start_address = request->startAddress;
+    Environment * image = env_create(params, NULL);
+    free(params);
+
+    FILE * file = fmemopen((void *)program, request->programSize, "r");
+    if (image == NULL || file == NULL) {
+        env_destroy(image);
+        if (file != NULL) fclose(file);
+        return EXIT_NO_MEMORY;
+    }
+
+    image->diagnostics.warnings = messages;
+    image->diagnostics.errors = messages;
+    ErrorCode_t err = assemble_env(image, file);
+    fclose(file);
+
+    if (err != EXIT_SUCCESS) {
+        env_destroy(image);
+        return err;
+    }
+    // As cópias usam os próprios destinos de diagnósticos
+    image->diagnostics.warnings = stderr;
+    image->diagnostics.errors = stderr;
+    *out = image;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Obtém o programa montado do pedido, usando o guardado se houver
+ * @param daemon o servidor
+ * @param request o pedido
+ * @param program o programa
+ * @param messages onde os avisos e erros da montagem são impressos
+ * @param entry onde a posição do programa guardado é guardada (NULL se
+ * o programa não pôde ser guardado e deve ser liberado depois do uso)
+ * @param image onde o programa montado é guardado
+ * @param cached se o programa já estava guardado
+ * @return o código de erro
+ */
+static ErrorCode_t daemon_acquire(daemon_t * daemon, const daemonRequest_t * request, const uint8_t * program,
+    FILE * messages, cacheEntry_t ** entry, Environment ** image, bool * cached) {
+    uint64_t hash = hash_bytes(0xcbf29ce484222325ull, program, request->programSize);
+    hash = hash_bytes(hash, &request->kind, sizeof(request->kind));
+    hash = hash_bytes(hash, &request->startAddress, sizeof(request->startAddress));
+
+    *entry = NULL;
+    *cached = false;
+
+    // Procura um programa igual já montado
+    pthread_mutex_lock(&daemon->cacheLock);
+    for (int i = 0; i < DAEMON_CACHE_SIZE; i++) {
+        cacheEntry_t * e = &daemon->cache[i];
+        if (e->image != NULL && e->hash == hash && e->kind == request->kind
+            && e->startAddress == request->startAddress && e->size == request->programSize
+            && memcmp(e->program, program, e->size) == 0) {
+            e->users++;
+            e->lastUse = ++daemon->clock;
+            *entry = e;
+            *image = e->image;
+            *cached = true;
+            pthread_mutex_unlock(&daemon->cacheLock);
+            return EXIT_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&daemon->cacheLock);
+
+    // Monta fora da trava, para não atrasar as outras threads
+    ErrorCode_t err = daemon_build_image(request, program, messages, image);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    uint8_t * copy = malloc(request->programSize > 0 ? request->programSize : 1);
+    if (copy == NULL)
+        return EXIT_SUCCESS; // executa sem guardar
+    memcpy(copy, program, request->programSize);
+
+    // Guarda no lugar livre ou no menos usado recentemente que não
+    // está em uso
+    pthread_mutex_lock(&daemon->cacheLock);
+    cacheEntry_t * slot = NULL;
+    for (int i = 0; i < DAEMON_CACHE_SIZE; i++) {
+        cacheEntry_t * e = &daemon->cache[i];
+        if (e->image == NULL) {
+            slot = e;
+            break;
+        }
+        if (e->users == 0 && (slot == NULL || e->lastUse < slot->lastUse))
+            slot = e;
+    }
+    if (slot != NULL) {
+        env_destroy(slot->image);
+        free(slot->program);
+        *slot = (cacheEntry_t) {
+            .hash = hash,
+            .kind = request->kind,
+            .startAddress = request->startAddress,
+            .program = copy,
+            .size = request->programSize,
+            .image = *image,
+            .users = 1,
+            .lastUse = ++daemon->clock
+        };
+        *entry = slot;
+    } else {
+        free(copy);
+    }
+    pthread_mutex_unlock(&daemon->cacheLock);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Devolve o programa montado obtido por daemon_acquire
+ */
+static void daemon_release(daemon_t * daemon, cacheEntry_t * entry, Environment * image) {
+    if (entry == NULL) {
+        env_destroy(image);
+        return;
+    }
+    pthread_mutex_lock(&daemon->cacheLock);
+    entry->users--;
+    pthread_mutex_unlock(&daemon->cacheLock);
+}
+
+/**
+ * Executa um pedido e envia a resposta
+ * @param daemon o servidor
+ * @param client a conexão
+ * @param body o corpo do pedido
+ * @param size o tamanho do corpo
+ * @param null fluxo vazio da thread
+ * @return se a resposta foi enviada
+ */
+static bool daemon_handle(daemon_t * daemon, int client, const uint8_t * body, size_t size, FILE * null) {
+    daemonRequest_t request;
+    daemonResponse_t response = { 0 };
+    hexBuffer_t output = { 0 };
+    uint8_t * pages = NULL;
+
+    char * messages = NULL;
+    size_t messagesSize = 0;
+    FILE * messagesFlow = open_memstream(&messages, &messagesSize);
+
+    if (size < sizeof(request) || messagesFlow == NULL) {
+        response.exitCode = EXIT_INVALID_ARGUMENT;
+    } else {
+        memcpy(&request, body, sizeof(request));
+        const uint8_t * program = body + sizeof(request);
+        const hex1_t * input = (const hex1_t *)(program + request.programSize);
+
+        if ((uint64_t)request.programSize + request.inputCount != size - sizeof(request)) {
+            response.exitCode = EXIT_INVALID_ARGUMENT;
+        } else {
+            cacheEntry_t * entry;
+            Environment * image;
+            bool cached;
+            response.exitCode = daemon_acquire(daemon, &request, program, messagesFlow, &entry, &image, &cached);
+            if (response.exitCode == EXIT_NO_INSTRUCTION)
+                response.exitCode = EXIT_SUCCESS; // programa vazio
+
+            Environment * env = response.exitCode == EXIT_SUCCESS && image != NULL ? env_clone(image) : NULL;
+            if (env != NULL) {
+                env->in = null;
+                env->out = null;
+                env->diagnostics.warnings = messagesFlow;
+                env->diagnostics.errors = messagesFlow;
+                env->params.hlt_prints_memory = false;
+                env->params.debug_mode = false;
+                env->params.paced = (request.flags & DAEMON_FLAG_PACED) != 0;
+                env->params.max_evaluated = request.maxEvaluated;
+                env->params.max_time = request.maxTime > 0 ? request.maxTime : STANDARD_MAX_TIME;
+                env->params.real_max_time = env->params.max_time;
+                env->capturedOutput = &output;
+                env_set_input(env, input, request.inputCount);
+
+                response.exitCode = run_env(env);
+                response.totalInstructions = env->totalInstructions;
+                response.totalTStates = env->totalTStates;
+                response.programCounter = env->programCounter;
+                for (int i = 0; i < NUMBER_OF_REGISTERS; i++) response.registers[i] = env->registers[i];
+                for (int i = 0; i < NUMBER_OF_FLAGS; i++) response.flags[i] = (uint8_t)env->flags[i];
+                response.cached = cached;
+                response.outputCount = (uint32_t)output.count;
+
+                // Páginas escritas: número da página + valores
+                if (request.flags & DAEMON_FLAG_MEMORY) {
+                    pages = malloc((size_t)MEMORY_PAGE_COUNT * (sizeof(uint16_t) + MEMORY_PAGE_SIZE));
+                    if (pages == NULL)
+                        response.exitCode = EXIT_NO_MEMORY;
+                    for (int p = 0; pages != NULL && p < MEMORY_PAGE_COUNT; p++) {
+                        if (!env_is_page_used(env, p))
+                            continue;
+                        uint8_t * record = pages + response.pageCount * (sizeof(uint16_t) + MEMORY_PAGE_SIZE);
+                        uint16_t index = (uint16_t)p;
+                        memcpy(record, &index, sizeof(index));
+                        for (int i = 0; i < MEMORY_PAGE_SIZE; i++) {
+                            record[sizeof(index) + i] = (uint8_t)env->pages[p]->units[i].value;
+                        }
+                        response.pageCount++;
+                    }
+                }
+            } else if (response.exitCode == EXIT_SUCCESS && image != NULL) {
+                response.exitCode = EXIT_NO_MEMORY;
+            }
+
+            env_destroy(env);
+            if (image != NULL)
+                daemon_release(daemon, entry, image);
+        }
+    }
+
+    if (messagesFlow != NULL)
+        fclose(messagesFlow);
+    response.messagesSize = (uint32_t)messagesSize;
+
+    size_t pagesSize = response.pageCount * (sizeof(uint16_t) + MEMORY_PAGE_SIZE);
+    uint32_t length = (uint32_t)(sizeof(response) + response.outputCount + pagesSize + response.messagesSize);
+    bool sent = io_write_all(client, &length, sizeof(length))
+        && io_write_all(client, &response, sizeof(response))
+        && io_write_all(client, output.values, response.outputCount)
+        && io_write_all(client, pages, pagesSize)
+        && io_write_all(client, messages, response.messagesSize);
+
+    free(output.values);
+    free(pages);
+    free(messages);
+    return sent;
+}
+
+/**
+ * Atende os pedidos de uma conexão até ela ser fechada
+ */
+static void daemon_serve_client(daemon_t * daemon, int client, FILE * null) {
+    uint8_t * body = NULL;
+    size_t capacity = 0;
+
+    uint32_t length;
+    while (io_read_exact(client, &length, sizeof(length))) {
+        if (length > DAEMON_MAX_REQUEST)
+            break;
+        if (length > capacity) {
+            uint8_t * temp = realloc(body, length);
+            if (temp == NULL)
+                break;
+            body = temp;
+            capacity = length;
+        }
+        if (!io_read_exact(client, body, length))
+            break;
+        if (!daemon_handle(daemon, client, body, length, null))
+            break;
+    }
+
+    free(body);
+}
+
+// Thread do grupo: atende as conexões da fila até o servidor fechar
+static void * daemon_worker(void * arg) {
+    worker_t * worker = arg;
+    daemon_t * daemon = worker->daemon;
+    FILE * null = open_null_stream();
+
+    for (;;) {
+        pthread_mutex_lock(&daemon->queueLock);
+        while (daemon->queueCount == 0 && !daemon->closing)
+            pthread_cond_wait(&daemon->queueReady, &daemon->queueLock);
+        if (daemon->queueCount == 0) {
+            pthread_mutex_unlock(&daemon->queueLock);
+            break;
+        }
+        int client = daemon->queue[0];
+        memmove(daemon->queue, daemon->queue + 1, --daemon->queueCount * sizeof(int));
+        daemon->clients[worker->index] = client;
+        pthread_mutex_unlock(&daemon->queueLock);
+
+        daemon_serve_client(daemon, client, null);
+
+        pthread_mutex_lock(&daemon->queueLock);
+        daemon->clients[worker->index] = -1;
+        pthread_mutex_unlock(&daemon->queueLock);
+        close(client);
+    }
+
+    if (null != NULL) fclose(null);
+    return NULL;
+}
+
+/**
+ * Coloca uma conexão na fila das threads
+ * @return se conseguiu colocar
+ */
+static bool daemon_enqueue(daemon_t * daemon, int client) {
+    pthread_mutex_lock(&daemon->queueLock);
+    if (daemon->queueCount == daemon->queueCapacity) {
+        size_t capacity = daemon->queueCapacity > 0 ? daemon->queueCapacity * 2 : 16;
+        int * temp = realloc(daemon->queue, capacity * sizeof(int));
+        if (temp == NULL) {
+            pthread_mutex_unlock(&daemon->queueLock);
+            return false;
+        }
+        daemon->queue = temp;
+        daemon->queueCapacity = capacity;
+    }
+    daemon->queue[daemon->queueCount++] = client;
+    pthread_cond_signal(&daemon->queueReady);
+    pthread_mutex_unlock(&daemon->queueLock);
+    return true;
+}
+
+/**
+ * Abre o socket no caminho dado
+ * @return o descritor (-1 se não conseguir)
+ */
+static int daemon_listen(const char * path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+ErrorCode_t daemon_serve(const char * path, int threads) {
+    if (threads <= 0)
+        threads = get_core_count();
+
+    int server = daemon_listen(path);
+    if (server < 0) {
+        fprintf(stderr, "[ERRO] Nao foi possivel escutar o socket \"%s\".\n", path);
+        return EXIT_INVALID_ARGUMENT;
+    }
+
+    daemon_t daemon = { 0 };
+    pthread_mutex_init(&daemon.cacheLock, NULL);
+    pthread_mutex_init(&daemon.queueLock, NULL);
+    pthread_cond_init(&daemon.queueReady, NULL);
+    daemon.clients = malloc(sizeof(int) * threads);
+    pthread_t * workers = malloc(sizeof(pthread_t) * threads);
+    worker_t * data = malloc(sizeof(worker_t) * threads);
+    if (daemon.clients == NULL || workers == NULL || data == NULL) {
+        free(daemon.clients);
+        free(workers);
+        free(data);
+        close(server);
+        unlink(path);
+        return EXIT_NO_MEMORY;
+    }
+
+    // Só a thread principal recebe os sinais de parada
+    sigset_t stopSignals, previous;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+
+    int started = 0;
+    for (; started < threads; started++) {
+        daemon.clients[started] = -1;
+        data[started] = (worker_t) { .daemon = &daemon, .index = started };
+        if (pthread_create(&workers[started], NULL, daemon_worker, &data[started]) != 0)
+            break;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    ErrorCode_t err = EXIT_SUCCESS;
+    if (started == 0) {
+        err = EXIT_NO_MEMORY;
+    } else {
+        printf("sap2d: escutando em \"%s\" (%d threads)\n", path, started);
+        fflush(stdout);
+
+        while (!stop_requested) {
+            int client = accept(server, NULL, NULL);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                break;
+            }
+            if (!daemon_enqueue(&daemon, client))
+                close(client);
+        }
+    }
+
+    // Fecha a fila e acorda as threads que estão esperando um pedido
+    pthread_mutex_lock(&daemon.queueLock);
+    daemon.closing = true;
+    for (size_t i = 0; i < daemon.queueCount; i++) {
+        close(daemon.queue[i]);
+    }
+    daemon.queueCount = 0;
+    for (int i = 0; i < started; i++) {
+        if (daemon.clients[i] >= 0)
+            shutdown(daemon.clients[i], SHUT_RDWR);
+    }
+    pthread_cond_broadcast(&daemon.queueReady);
+    pthread_mutex_unlock(&daemon.queueLock);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    close(server);
+    unlink(path);
+
+    for (int i = 0; i < DAEMON_CACHE_SIZE; i++) {
+        env_destroy(daemon.cache[i].image);
+        free(daemon.cache[i].program);
+    }
+    free(daemon.queue);
+    free(daemon.clients);
+    free(workers);
+    free(data);
+    pthread_mutex_destroy(&daemon.cacheLock);
+    pthread_mutex_destroy(&daemon.queueLock);
+    pthread_cond_destroy(&daemon.queueReady);
+    return err;
+}
+
+#endif // _WIN32
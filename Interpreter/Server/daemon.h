@@ -0,0 +1,88 @@
+// Servidor local de simulações (sap2d): recebe pedidos por um socket
+// Unix, executa-os em um grupo fixo de threads e guarda os programas
+// já montados para os próximos pedidos. Só existe em sistemas POSIX.
+//
+// Protocolo: cada mensagem (pedido ou resposta) é um uint32 com o
+// tamanho do corpo seguido do corpo. Todos os inteiros usam a ordem de
+// bytes da máquina. Uma conexão pode enviar vários pedidos, um depois
+// do outro; cada pedido recebe uma resposta.
+//   Corpo do pedido:   daemonRequest_t, programa (programSize bytes),
+//                      entradas do IN (inputCount bytes)
+//   Corpo da resposta: daemonResponse_t, saídas do OUT (outputCount bytes),
+//                      páginas de memória (pageCount vezes: uint16 número
+//                      da página + 256 valores), mensagens (messagesSize
+//                      bytes de texto, com os avisos e erros)
+//
+// Author: André
+// Date: 25/10/2025
+//
+
+#ifndef SAP2_COMPILER_DAEMON_H
+#define SAP2_COMPILER_DAEMON_H
+
+#include <stdint.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Caminho padrão do socket
+#define DAEMON_SOCKET_PATH "/tmp/sap2d.sock"
+// Quantidade de programas montados guardados
+#define DAEMON_CACHE_SIZE 64
+// Maior corpo de pedido aceito
+#define DAEMON_MAX_REQUEST (16 * 1024 * 1024)
+
+// Tipos de programa do pedido
+#define DAEMON_PROGRAM_SOURCE 0 // código assembly
+#define DAEMON_PROGRAM_STATE 1  // arquivo de estado (ver Snapshot/snapshot.h)
+
+// Opções do pedido
+#define DAEMON_FLAG_MEMORY 0x01 // envia as páginas de memória escritas
+#define DAEMON_FLAG_PACED 0x02  // espera o tempo de cada T-State
+
+// Cabeçalho do pedido
+typedef struct {
+    uint8_t kind;
+    uint8_t flags;
+    // Endereço inicial (só para código assembly)
+    uint16_t startAddress;
+    // Limite de instruções (-1 para ilimitado)
+    int32_t maxEvaluated;
+    // Limite de tempo em milissegundos (0 para o padrão)
+    double maxTime;
+    uint32_t programSize;
+    uint32_t inputCount;
+} daemonRequest_t;
+
+// Cabeçalho da resposta
+typedef struct {
+    int64_t totalInstructions;
+    uint64_t totalTStates;
+    int32_t exitCode;
+    uint32_t outputCount;
+    uint32_t pageCount;
+    uint32_t messagesSize;
+    uint16_t programCounter;
+    int8_t registers[NUMBER_OF_REGISTERS];
+    uint8_t flags[NUMBER_OF_FLAGS];
+    // Se o programa já estava montado (guardado de um pedido anterior)
+    uint8_t cached;
+} daemonResponse_t;
+
+/**
+ * Escuta o socket dado e atende os pedidos até daemon_request_stop() ser
+ * chamada. Os sinais não são tratados aqui: quem chama deve ignorar o
+ * SIGPIPE e chamar daemon_request_stop() no tratador do SIGINT/SIGTERM
+ * (sem SA_RESTART, para interromper a espera por conexões).
+ * @param path o caminho do socket (um arquivo antigo é removido)
+ * @param threads quantidade de threads (0 para a quantidade de núcleos)
+ * @return o código de erro
+ */
+ErrorCode_t daemon_serve(const char * path, int threads);
+
+/**
+ * Pede para o servidor parar. Pode ser chamada de um tratador de sinal.
+ */
+void daemon_request_stop(void);
+
+#endif //SAP2_COMPILER_DAEMON_H
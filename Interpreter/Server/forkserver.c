@@ -0,0 +1,191 @@
+// Servidor de execuções por fork: o programa é montado uma vez só e,
+// para cada pedido, um processo filho (fork) executa a partir do
+// ambiente já pronto.
+//
+// Author: André
+// Date: 24/10/2025
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#include "forkserver.h"
+#include "io.h"
+#include "../interpreter.h"
+#include "../Utils/Utils.h"
+
+#ifdef _WIN32
+
+ErrorCode_t forkserver_serve(Environment * image, FILE * requests, FILE * responses) {
+    (void)image;
+    (void)requests;
+    (void)responses;
+    fprintf(stderr, "[ERRO] O servidor por fork nao existe no Windows. Use --varredura ou --lote.\n");
+    return EXIT_INVALID_ARGUMENT;
+}
+
+#else
+
+/**
+ * Executa um pedido no processo filho e envia o resultado pelo
+ * descritor dado. Nunca retorna.
+ * @param env o ambiente (a cópia do filho)
+ * @param input as entradas do pedido
+ * @param size a quantidade de entradas
+ * @param fd onde o resultado é enviado
+ */
+_Noreturn static void forkserver_child(Environment * env, const hex1_t * input, size_t size, int fd) {
+    // Só os erros são impressos (na saída de erros do servidor)
+    FILE * null = open_null_stream();
+    if (null != NULL) {
+        env->in = null;
+        env->out = null;
+        env->diagnostics.warnings = null;
+    }
+    env->diagnostics.errors = stderr;
+    env->params.hlt_prints_memory = false;
+    env->params.debug_mode = false;
+
+    hexBuffer_t output = { 0 };
+    env->capturedOutput = &output;
+    env_set_input(env, input, size);
+
+    int32_t code = run_env(env);
+    uint32_t count = (uint32_t)output.count;
+
+    // Se não conseguir enviar, o servidor percebe pela resposta incompleta
+    fflush(stderr);
+    if (io_write_all(fd, &code, sizeof(code)) && io_write_all(fd, &count, sizeof(count)))
+        io_write_all(fd, output.values, output.count);
+    _exit(EXIT_SUCCESS);
+}
+
+/**
+ * Lê tudo que for enviado pelo descritor dado até ele ser fechado
+ * @param fd o descritor
+ * @param size onde a quantidade de bytes lidos é guardada
+ * @return os bytes lidos (NULL se não houver memória)
+ */
+static uint8_t * read_until_closed(int fd, size_t * size) {
+    size_t capacity = 256;
+    uint8_t * data = malloc(capacity);
+    *size = 0;
+    while (data != NULL) {
+        if (*size == capacity) {
+            capacity *= 2;
+            uint8_t * temp = realloc(data, capacity);
+            if (temp == NULL) {
+                free(data);
+                return NULL;
+            }
+            data = temp;
+        }
+        ssize_t n = read(fd, data + *size, capacity - *size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        *size += (size_t)n;
+    }
+    return data;
+}
+
+/**
+ * Executa um pedido em um processo filho e escreve a resposta
+ * @param image o ambiente com o programa já montado
+ * @param input as entradas do pedido
+ * @param size a quantidade de entradas
+ * @param responses onde a resposta é escrita
+ * @return o código de erro (do servidor, não da execução)
+ */
+static ErrorCode_t forkserver_run(Environment * image, const hex1_t * input, size_t size, FILE * responses) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return EXIT_NO_MEMORY;
+
+    // O filho não pode herdar nada que ainda esteja no buffer
+    fflush(responses);
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return EXIT_NO_MEMORY;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        forkserver_child(image, input, size, fds[1]);
+    }
+
+    close(fds[1]);
+    size_t received;
+    uint8_t * result = read_until_closed(fds[0], &received);
+    close(fds[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+
+    // Confere se o filho enviou a resposta inteira
+    int32_t code = EXIT_NO_MEMORY;
+    uint32_t count = 0;
+    const uint8_t * values = NULL;
+    if (result != NULL && received >= sizeof(code) + sizeof(count)) {
+        memcpy(&code, result, sizeof(code));
+        memcpy(&count, result + sizeof(code), sizeof(count));
+        values = result + sizeof(code) + sizeof(count);
+        if (received - sizeof(code) - sizeof(count) != count) {
+            code = EXIT_NO_MEMORY;
+            count = 0;
+        }
+    } else if (WIFSIGNALED(status)) {
+        code = FORKSERVER_SIGNAL_BASE + WTERMSIG(status);
+    }
+
+    fwrite(&code, sizeof(code), 1, responses);
+    fwrite(&count, sizeof(count), 1, responses);
+    if (count > 0)
+        fwrite(values, 1, count, responses);
+    fflush(responses);
+
+    free(result);
+    return EXIT_SUCCESS;
+}
+
+ErrorCode_t forkserver_serve(Environment * image, FILE * requests, FILE * responses) {
+    hex1_t * input = NULL;
+    size_t capacity = 0;
+    ErrorCode_t err = EXIT_SUCCESS;
+
+    uint32_t size;
+    while (err == EXIT_SUCCESS && fread(&size, sizeof(size), 1, requests) == 1) {
+        if (size > capacity) {
+            hex1_t * temp = realloc(input, size);
+            if (temp == NULL) {
+                err = EXIT_NO_MEMORY;
+                break;
+            }
+            input = temp;
+            capacity = size;
+        }
+        if (size > 0 && fread(input, 1, size, requests) != size) {
+            err = EXIT_INVALID_ARGUMENT; // pedido incompleto
+            break;
+        }
+
+        err = forkserver_run(image, input, size, responses);
+    }
+
+    free(input);
+    return err;
+}
+
+#endif // _WIN32
@@ -0,0 +1,39 @@
+// Servidor de execuções por fork: o programa é montado uma vez só e,
+// para cada pedido, um processo filho (fork) executa a partir do
+// ambiente já pronto. Só existe em sistemas POSIX.
+//
+// Protocolo (todos os inteiros na ordem de bytes da máquina):
+//   Pedido:   uint32 quantidade de entradas, seguida das entradas (1 byte cada)
+//   Resposta: int32 código de saída, uint32 quantidade de saídas (OUT),
+//             seguida das saídas (1 byte cada)
+// O servidor termina quando a entrada de pedidos acaba.
+//
+// Author: André
+// Date: 24/10/2025
+//
+
+#ifndef SAP2_COMPILER_FORKSERVER_H
+#define SAP2_COMPILER_FORKSERVER_H
+
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Código de saída enviado quando o filho termina por um sinal
+// (somado ao número do sinal, como no shell)
+#define FORKSERVER_SIGNAL_BASE 128
+
+/**
+ * Atende os pedidos de execução até a entrada de pedidos acabar. Cada
+ * pedido é executado em um processo filho que começa com uma cópia do
+ * ambiente dado (feita pelo próprio fork), então o ambiente dado nunca
+ * é executado nem alterado.
+ * @param image o ambiente com o programa já montado
+ * @param requests de onde os pedidos são lidos
+ * @param responses onde as respostas são escritas
+ * @return o código de erro (EXIT_INVALID_ARGUMENT se não houver fork)
+ */
+ErrorCode_t forkserver_serve(Environment * image, FILE * requests, FILE * responses);
+
+#endif //SAP2_COMPILER_FORKSERVER_H
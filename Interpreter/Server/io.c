@@ -0,0 +1,59 @@
+// Leitura e escrita de descritores (pipes e sockets) usadas pelos
+// servidores.
+//
+// Author: André
+// Date: 25/10/2025
+//
+
+#include <stdint.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+#include "io.h"
+
+#ifndef _WIN32
+
+// Sem MSG_NOSIGNAL (macOS), o SIGPIPE fica por conta de quem chama
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+
+bool io_read_exact(int fd, void * data, size_t size) {
+    uint8_t * bytes = data;
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool io_write_all(int fd, const void * data, size_t size) {
+    const uint8_t * bytes = data;
+    bool socket = true;
+    while (size > 0) {
+        ssize_t n = socket ? send(fd, bytes, size, MSG_NOSIGNAL) : write(fd, bytes, size);
+        if (n < 0 && errno == ENOTSOCK && socket) {
+            // Um pipe: escreve normalmente
+            socket = false;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+#endif // _WIN32
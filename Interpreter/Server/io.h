@@ -0,0 +1,34 @@
+// Leitura e escrita de descritores (pipes e sockets) usadas pelos
+// servidores. Só existe em sistemas POSIX.
+//
+// Author: André
+// Date: 25/10/2025
+//
+
+#ifndef SAP2_COMPILER_IO_H
+#define SAP2_COMPILER_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Lê exatamente "size" bytes do descritor dado
+ * @param fd o descritor
+ * @param data onde os bytes são guardados
+ * @param size a quantidade de bytes
+ * @return se conseguiu ler tudo
+ */
+bool io_read_exact(int fd, void * data, size_t size);
+
+/**
+ * Escreve todos os bytes dados no descritor dado. Em sockets, uma
+ * conexão fechada do outro lado faz a escrita falhar em vez de gerar
+ * SIGPIPE.
+ * @param fd o descritor
+ * @param data os bytes
+ * @param size a quantidade de bytes
+ * @return se conseguiu escrever tudo
+ */
+bool io_write_all(int fd, const void * data, size_t size);
+
+#endif //SAP2_COMPILER_IO_H
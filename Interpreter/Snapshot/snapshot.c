@@ -0,0 +1,512 @@
+// Salva o estado de um ambiente do SAP2 em um arquivo e o carrega
+// depois, para continuar a execução de onde ela parou.
+//
+// Formato do arquivo (todos os campos têm tamanho fixo e usam a ordem
+// de bytes da máquina que gravou):
+//   cabeçalho (snapshotHeader_t)
+//   páginas escritas (snapshotPage_t, uma por vez)
+//   endereços usados (uint16_t, completados até múltiplo de 4 bytes)
+//   rótulos (snapshotLabel_t)
+//   entradas fornecidas (int8_t, se houver)
+//   textos (anotações e nomes dos rótulos, terminados em '\0')
+//
+// Author: André
+// Date: 23/10/2025
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "snapshot.h"
+
+// Valor usado para verificar a ordem dos bytes
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+// Posição de texto que representa uma anotação nula
+#define SNAPSHOT_NO_STRING UINT32_MAX
+// Quantidade de entradas que representa "sem entradas fornecidas" (o IN
+// lê do fluxo de entrada)
+#define SNAPSHOT_NO_INPUT UINT32_MAX
+// Capacidade inicial da tabela de textos
+#define STRING_TABLE_CAPACITY 256
+
+// Cabeçalho do arquivo de estado
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    // Quantidade de cada seção
+    uint32_t pageCount;
+    uint32_t usedAddressesCount;
+    uint32_t symbolCount;
+    uint32_t stringsSize;
+    uint32_t inputCount;
+    // Próxima entrada que será usada
+    uint32_t inputIndex;
+    // Parâmetros
+    double maxTime;
+    // Estado da execução
+    uint64_t totalTStates;
+    int64_t totalInstructions;
+    int32_t maxEvaluated;
+    int32_t currentInstruction;
+    int32_t lastNInstruction;
+    uint32_t lastAnnotation;
+    uint16_t programCounter;
+    uint16_t startAddress;
+    int16_t hexFlowBuffer;
+    int8_t registers[NUMBER_OF_REGISTERS];
+    uint8_t flags[NUMBER_OF_FLAGS];
+    int8_t hexPrintBuffer;
+    int8_t lastValue;
+    uint8_t hltPrintsMemory;
+    uint8_t debugMode;
+    uint8_t reserved;
+} snapshotHeader_t;
+
+// Uma página de memória escrita
+typedef struct {
+    uint32_t index;
+    int32_t nInstruction[MEMORY_PAGE_SIZE];
+    // Posição da anotação na seção de textos
+    uint32_t annotation[MEMORY_PAGE_SIZE];
+    int8_t values[MEMORY_PAGE_SIZE];
+} snapshotPage_t;
+
+// Um rótulo
+typedef struct {
+    // Posição do nome na seção de textos
+    uint32_t name;
+    uint16_t value;
+    uint16_t reserved;
+} snapshotLabel_t;
+
+// O arquivo precisa ter o mesmo formato em qualquer compilador
+_Static_assert(sizeof(snapshotHeader_t) == 96, "Cabecalho do estado com tamanho inesperado");
+_Static_assert(sizeof(snapshotPage_t) == 2308, "Pagina do estado com tamanho inesperado");
+_Static_assert(sizeof(snapshotLabel_t) == 8, "Rotulo do estado com tamanho inesperado");
+
+// Textos que serão gravados. Cada texto (pelo endereço dele) é
+// gravado uma vez só, já que várias anotações usam o mesmo texto.
+typedef struct {
+    const char ** keys;
+    uint32_t * offsets;
+    size_t capacity;
+    size_t count;
+    // Conteúdo da seção de textos
+    char * data;
+    size_t size;
+    size_t dataCapacity;
+} stringTable_t;
+
+// Tamanho dos endereços usados no arquivo (completado até múltiplo de 4)
+#define used_addresses_size(count) ((((size_t)(count) * sizeof(uint16_t)) + 3) & ~(size_t)3)
+
+static void string_table_free(stringTable_t * table) {
+    free(table->keys);
+    free(table->offsets);
+    free(table->data);
+}
+
+/**
+ * Aumenta a tabela de textos (o dobro da capacidade)
+ * @return o código de erro
+ */
+static ErrorCode_t string_table_grow(stringTable_t * table) {
+    size_t capacity = table->capacity > 0 ? table->capacity * 2 : STRING_TABLE_CAPACITY;
+    const char ** keys = calloc(capacity, sizeof(const char *));
+    uint32_t * offsets = malloc(capacity * sizeof(uint32_t));
+    if (keys == NULL || offsets == NULL) {
+        free(keys);
+        free(offsets);
+        return EXIT_NO_MEMORY;
+    }
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->keys[i] == NULL)
+            continue;
+        size_t j = ((uintptr_t)table->keys[i] >> 3) & (capacity - 1);
+        while (keys[j] != NULL) j = (j + 1) & (capacity - 1);
+        keys[j] = table->keys[i];
+        offsets[j] = table->offsets[i];
+    }
+
+    free(table->keys);
+    free(table->offsets);
+    table->keys = keys;
+    table->offsets = offsets;
+    table->capacity = capacity;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Retorna a posição do texto na seção de textos, adicionando-o se
+ * ainda não estiver lá
+ * @param table a tabela de textos
+ * @param text o texto (pode ser NULL)
+ * @param offset onde a posição é guardada
+ * @return o código de erro
+ */
+static ErrorCode_t string_table_add(stringTable_t * table, const char * text, uint32_t * offset) {
+    if (text == NULL) {
+        *offset = SNAPSHOT_NO_STRING;
+        return EXIT_SUCCESS;
+    }
+    if ((table->count + 1) * 2 > table->capacity && string_table_grow(table) != EXIT_SUCCESS)
+        return EXIT_NO_MEMORY;
+
+    // Procura o texto (pelo endereço)
+    size_t i = ((uintptr_t)text >> 3) & (table->capacity - 1);
+    while (table->keys[i] != NULL) {
+        if (table->keys[i] == text) {
+            *offset = table->offsets[i];
+            return EXIT_SUCCESS;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+
+    // Adiciona o texto ao fim da seção
+    size_t len = strlen(text) + 1;
+    if (table->size + len > table->dataCapacity) {
+        size_t capacity = table->dataCapacity > 0 ? table->dataCapacity : 4096;
+        while (table->size + len > capacity) capacity *= 2;
+        char * temp = realloc(table->data, capacity);
+        if (temp == NULL)
+            return EXIT_NO_MEMORY;
+        table->data = temp;
+        table->dataCapacity = capacity;
+    }
+    memcpy(table->data + table->size, text, len);
+
+    table->keys[i] = text;
+    table->offsets[i] = (uint32_t)table->size;
+    table->count++;
+    *offset = (uint32_t)table->size;
+    table->size += len;
+    return EXIT_SUCCESS;
+}
+
+// Grava "size" bytes no arquivo, indo para o fim se houver erro
+#define write_or_fail(ptr, size) \
+    do { if (fwrite(ptr, 1, size, f) != (size)) { err = EXIT_STATE_FILE; goto end; } } while (0)
+
+ErrorCode_t env_save_state(const Environment * env, FILE * f) {
+    ErrorCode_t err = EXIT_SUCCESS;
+    stringTable_t strings = { 0 };
+    if (env->input != NULL && (env->inputSize >= SNAPSHOT_NO_INPUT || env->inputIndex > env->inputSize))
+        return EXIT_STATE_FILE;
+
+    long start = ftell(f);
+    if (start < 0)
+        return EXIT_STATE_FILE;
+
+    snapshotHeader_t header = { 0 };
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.usedAddressesCount = (uint32_t)env->usedAddressesSize;
+    header.symbolCount = (uint32_t)env->symbolCount;
+    header.inputCount = env->input != NULL ? (uint32_t)env->inputSize : SNAPSHOT_NO_INPUT;
+    header.inputIndex = (uint32_t)env->inputIndex;
+    header.maxTime = env->params.max_time;
+    header.totalTStates = env->totalTStates;
+    header.totalInstructions = env->totalInstructions;
+    header.maxEvaluated = env->params.max_evaluated;
+    header.currentInstruction = env->currentInstruction;
+    header.lastNInstruction = env->last_instruction.nInstruction;
+    header.programCounter = env->programCounter;
+    header.startAddress = env->params.start_address;
+    header.hexFlowBuffer = env->hex_flow_buffer;
+    for (int i = 0; i < NUMBER_OF_REGISTERS; i++) header.registers[i] = env->registers[i];
+    for (int i = 0; i < NUMBER_OF_FLAGS; i++) header.flags[i] = (uint8_t)env->flags[i];
+    header.hexPrintBuffer = env->hex_print_buffer;
+    header.lastValue = env->last_instruction.value;
+    header.hltPrintsMemory = env->params.hlt_prints_memory;
+    header.debugMode = env->params.debug_mode;
+    if (string_table_add(&strings, env->last_instruction.annotation, &header.lastAnnotation) != EXIT_SUCCESS) {
+        err = EXIT_NO_MEMORY;
+        goto end;
+    }
+
+    // O cabeçalho é gravado de novo no fim, quando as quantidades já
+    // forem conhecidas
+    write_or_fail(&header, sizeof(header));
+
+    // Páginas (só as que já foram escritas)
+    snapshotPage_t record;
+    for (int p = 0; p < MEMORY_PAGE_COUNT; p++) {
+        if (!env_is_page_used(env, p))
+            continue;
+
+        const memoryPage_t * page = env->pages[p];
+        record.index = (uint32_t)p;
+        for (int i = 0; i < MEMORY_PAGE_SIZE; i++) {
+            record.values[i] = page->units[i].value;
+            record.nInstruction[i] = page->units[i].nInstruction;
+            if (string_table_add(&strings, page->units[i].annotation, &record.annotation[i]) != EXIT_SUCCESS) {
+                err = EXIT_NO_MEMORY;
+                goto end;
+            }
+        }
+        write_or_fail(&record, sizeof(record));
+        header.pageCount++;
+    }
+
+    // Endereços usados
+    if (env->usedAddressesSize > 0) {
+        write_or_fail(env->usedAddresses, env->usedAddressesSize * sizeof(uint16_t));
+    }
+    uint8_t padding[4] = { 0 };
+    size_t paddingSize = used_addresses_size(env->usedAddressesSize) - env->usedAddressesSize * sizeof(uint16_t);
+    write_or_fail(padding, paddingSize);
+
+    // Rótulos
+    for (size_t i = 0; i < env->symbolCount; i++) {
+        snapshotLabel_t label = {
+            .value = env->symbolTable[i].value
+        };
+        if (string_table_add(&strings, env->symbolTable[i].name, &label.name) != EXIT_SUCCESS) {
+            err = EXIT_NO_MEMORY;
+            goto end;
+        }
+        write_or_fail(&label, sizeof(label));
+    }
+
+    // Entradas fornecidas
+    if (env->input != NULL && env->inputSize > 0)
+        write_or_fail(env->input, env->inputSize * sizeof(hex1_t));
+
+    // Textos
+    header.stringsSize = (uint32_t)strings.size;
+    write_or_fail(strings.data, strings.size);
+
+    // Cabeçalho completo
+    long finish = ftell(f);
+    if (finish < 0 || fseek(f, start, SEEK_SET) != 0) {
+        err = EXIT_STATE_FILE;
+        goto end;
+    }
+    write_or_fail(&header, sizeof(header));
+    if (fseek(f, finish, SEEK_SET) != 0 || fflush(f) != 0)
+        err = EXIT_STATE_FILE;
+
+end:
+    string_table_free(&strings);
+    return err;
+}
+
+ErrorCode_t env_save_state_path(const Environment * env, const char * path) {
+    FILE * f = fopen(path, "wb");
+    if (f == NULL)
+        return EXIT_STATE_FILE;
+    ErrorCode_t err = env_save_state(env, f);
+    if (fclose(f) != 0 && err == EXIT_SUCCESS)
+        err = EXIT_STATE_FILE;
+    return err;
+}
+
+/**
+ * Retorna o texto na posição dada da seção de textos
+ * @param strings a seção de textos (copiada para o ambiente)
+ * @param size o tamanho da seção
+ * @param offset a posição do texto
+ * @param out onde o texto é guardado (NULL para SNAPSHOT_NO_STRING)
+ * @return se a posição é válida
+ */
+static bool get_string(const char * strings, uint32_t size, uint32_t offset, char ** out) {
+    if (offset == SNAPSHOT_NO_STRING) {
+        *out = NULL;
+        return true;
+    }
+    if (offset >= size)
+        return false;
+    *out = (char *)strings + offset;
+    return true;
+}
+
+ErrorCode_t env_restore_state(const void * data, size_t size, const allocator_t * allocator, Environment ** out) {
+    const uint8_t * bytes = data;
+    *out = NULL;
+
+    // Verifica o cabeçalho e o tamanho de cada seção
+    snapshotHeader_t header;
+    if (size < sizeof(header))
+        return EXIT_STATE_FILE;
+    memcpy(&header, bytes, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+        || header.version != SNAPSHOT_VERSION
+        || header.byteOrder != SNAPSHOT_BYTE_ORDER
+        || header.pageCount > MEMORY_PAGE_COUNT)
+        return EXIT_STATE_FILE;
+
+    size_t pagesOffset = sizeof(header);
+    size_t usedOffset = pagesOffset + (size_t)header.pageCount * sizeof(snapshotPage_t);
+    size_t labelsOffset = usedOffset + used_addresses_size(header.usedAddressesCount);
+    size_t inputOffset = labelsOffset + (size_t)header.symbolCount * sizeof(snapshotLabel_t);
+    size_t inputCount = header.inputCount != SNAPSHOT_NO_INPUT ? header.inputCount : 0;
+    if (inputOffset + inputCount * sizeof(hex1_t) + header.stringsSize != size
+        || (header.inputCount != SNAPSHOT_NO_INPUT && header.inputIndex > header.inputCount)
+        || (header.stringsSize > 0 && bytes[size - 1] != '\0'))
+        return EXIT_STATE_FILE;
+
+    // Cria o ambiente com os parâmetros salvos
+    Parametros params = {
+        .start_address = header.startAddress,
+        .hlt_prints_memory = header.hltPrintsMemory != 0,
+        .max_evaluated = header.maxEvaluated,
+        .max_time = header.maxTime,
+        .real_max_time = header.maxTime,
+        .debug_mode = header.debugMode != 0,
+        .paced = STANDARD_PACED
+    };
+    Environment * env = env_create(&params, allocator);
+    if (env == NULL)
+        return EXIT_NO_MEMORY;
+
+    // Ponto de recuperação, caso falte memória para alguma página
+    jmp_buf on_fatal;
+    if (setjmp(on_fatal) != 0) {
+        env_destroy(env);
+        return EXIT_NO_MEMORY;
+    }
+    env->diagnostics.on_fatal = &on_fatal;
+
+    // Os textos são copiados de uma vez só para a arena do ambiente
+    char * strings = header.stringsSize > 0
+        ? env_memdup(env, bytes + inputOffset + inputCount * sizeof(hex1_t), header.stringsSize)
+        : NULL;
+
+    // Entradas fornecidas (copiadas para a arena, como os textos). Um
+    // buffer vazio ainda conta como entradas fornecidas.
+    if (header.inputCount != SNAPSHOT_NO_INPUT) {
+        const hex1_t none = 0;
+        hex1_t * input = inputCount > 0
+            ? env_memdup(env, bytes + inputOffset, inputCount * sizeof(hex1_t))
+            : env_memdup(env, &none, sizeof(none));
+        env_set_input(env, input, inputCount);
+        env->inputIndex = header.inputIndex;
+    }
+
+    // Páginas
+    snapshotPage_t record;
+    for (uint32_t p = 0; p < header.pageCount; p++) {
+        memcpy(&record, bytes + pagesOffset + (size_t)p * sizeof(record), sizeof(record));
+        if (record.index >= MEMORY_PAGE_COUNT)
+            goto invalid;
+
+        memoryUnit_t * units = env_write_unit(env, (uhex2_t)(record.index << MEMORY_PAGE_BITS));
+        for (int i = 0; i < MEMORY_PAGE_SIZE; i++) {
+            units[i].value = record.values[i];
+            units[i].nInstruction = record.nInstruction[i];
+            if (!get_string(strings, header.stringsSize, record.annotation[i], &units[i].annotation))
+                goto invalid;
+        }
+    }
+
+    // Endereços usados
+    if (header.usedAddressesCount > 0) {
+        env->usedAddresses = env->allocator.alloc(env->allocator.ctx, header.usedAddressesCount * sizeof(uhex2_t));
+        if (env->usedAddresses == NULL) {
+            env_destroy(env);
+            return EXIT_NO_MEMORY;
+        }
+        memcpy(env->usedAddresses, bytes + usedOffset, header.usedAddressesCount * sizeof(uhex2_t));
+        env->usedAddressesSize = header.usedAddressesCount;
+    }
+
+    // Rótulos
+    if (header.symbolCount > 0) {
+        env->symbolTable = env->allocator.alloc(env->allocator.ctx, header.symbolCount * sizeof(label_t));
+        if (env->symbolTable == NULL) {
+            env_destroy(env);
+            return EXIT_NO_MEMORY;
+        }
+        for (uint32_t i = 0; i < header.symbolCount; i++) {
+            snapshotLabel_t label;
+            memcpy(&label, bytes + labelsOffset + (size_t)i * sizeof(label), sizeof(label));
+            if (!get_string(strings, header.stringsSize, label.name, &env->symbolTable[i].name))
+                goto invalid;
+            env->symbolTable[i].value = label.value;
+            env->symbolCount++;
+        }
+    }
+
+    // Estado da execução
+    env->programCounter = header.programCounter;
+    for (int i = 0; i < NUMBER_OF_REGISTERS; i++) env->registers[i] = header.registers[i];
+    for (int i = 0; i < NUMBER_OF_FLAGS; i++) env->flags[i] = header.flags[i];
+    env->currentInstruction = header.currentInstruction;
+    env->totalInstructions = (long)header.totalInstructions;
+    env->totalTStates = header.totalTStates;
+    env->hex_print_buffer = header.hexPrintBuffer;
+    env->hex_flow_buffer = header.hexFlowBuffer;
+    env->last_instruction.value = header.lastValue;
+    env->last_instruction.nInstruction = header.lastNInstruction;
+    if (!get_string(strings, header.stringsSize, header.lastAnnotation, &env->last_instruction.annotation))
+        goto invalid;
+
+    env->diagnostics.on_fatal = NULL;
+    *out = env;
+    return EXIT_SUCCESS;
+
+invalid:
+    env_destroy(env);
+    return EXIT_STATE_FILE;
+}
+
+ErrorCode_t env_load_state(const char * path, Environment ** out) {
+    ErrorCode_t err;
+    *out = NULL;
+
+    #ifdef __linux__
+        // Mapeia o arquivo na memória (sem copiar o arquivo inteiro)
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return EXIT_STATE_FILE;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return EXIT_STATE_FILE;
+        }
+        void * data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+            return EXIT_STATE_FILE;
+
+        err = env_restore_state(data, (size_t)st.st_size, NULL, out);
+        munmap(data, (size_t)st.st_size);
+    #else
+        // Lê o arquivo inteiro
+        FILE * f = fopen(path, "rb");
+        if (f == NULL)
+            return EXIT_STATE_FILE;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        rewind(f);
+        if (size <= 0) {
+            fclose(f);
+            return EXIT_STATE_FILE;
+        }
+        void * data = malloc((size_t)size);
+        if (data == NULL) {
+            fclose(f);
+            return EXIT_NO_MEMORY;
+        }
+        size_t read = fread(data, 1, (size_t)size, f);
+        fclose(f);
+
+        err = read == (size_t)size
+            ? env_restore_state(data, (size_t)size, NULL, out)
+            : EXIT_STATE_FILE;
+        free(data);
+    #endif
+
+    return err;
+}
@@ -0,0 +1,63 @@
+// Salva o estado de um ambiente do SAP2 em um arquivo e o carrega
+// depois, para continuar a execução de onde ela parou.
+//
+// Author: André
+// Date: 23/10/2025
+//
+
+#ifndef SAP2_COMPILER_SNAPSHOT_H
+#define SAP2_COMPILER_SNAPSHOT_H
+
+#include <stdio.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Identificação do arquivo de estado
+#define SNAPSHOT_MAGIC "SAP2EST"
+#define SNAPSHOT_VERSION 2
+
+/**
+ * Grava o estado do ambiente no arquivo dado: memória (valores,
+ * anotações e números das instruções), registradores, flags, contador
+ * de programa, instruções executadas, T-States simulados, rótulos,
+ * parâmetros e as entradas fornecidas (com a próxima que será usada).
+ * O que o IN faz quando elas acabam (--fim-entrada) não é gravado. As
+ * páginas de memória são gravadas uma por vez; só as páginas que já
+ * foram escritas ocupam espaço.
+ * @param env o ambiente do SAP2
+ * @param f o arquivo (aberto em modo binário, com suporte a fseek)
+ * @return o código de erro
+ */
+ErrorCode_t env_save_state(const Environment * env, FILE * f);
+
+/**
+ * Grava o estado do ambiente no caminho dado (ver env_save_state)
+ * @param env o ambiente do SAP2
+ * @param path o caminho do arquivo
+ * @return o código de erro
+ */
+ErrorCode_t env_save_state_path(const Environment * env, const char * path);
+
+/**
+ * Cria um ambiente a partir de um estado já lido para a memória (o
+ * conteúdo de um arquivo gravado por env_save_state). Os dados não
+ * precisam continuar existindo depois que a função retornar.
+ * @param data o conteúdo do arquivo de estado
+ * @param size o tamanho do conteúdo
+ * @param allocator o alocador que o ambiente usará (NULL para o padrão)
+ * @param out onde o ambiente criado é guardado
+ * @return o código de erro
+ */
+ErrorCode_t env_restore_state(const void * data, size_t size, const allocator_t * allocator, Environment ** out);
+
+/**
+ * Cria um ambiente a partir do arquivo de estado dado. No Linux, o
+ * arquivo é mapeado na memória (mmap) ao invés de lido.
+ * @param path o caminho do arquivo
+ * @param out onde o ambiente criado é guardado
+ * @return o código de erro
+ */
+ErrorCode_t env_load_state(const char * path, Environment ** out);
+
+#endif //SAP2_COMPILER_SNAPSHOT_H
@@ -0,0 +1,426 @@
+// Traço da execução: grava, de forma compacta, tudo que acontece em
+// uma execução para que ela possa ser reproduzida depois.
+//
+// Author: André
+// Date: 26/10/2025
+//
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+// Maior tamanho de um evento (inteiro de 3 bytes + 1 byte de valor)
+#define TRACE_MAX_EVENT_SIZE 8
+
+// Cabeçalho do arquivo de traço
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    // Identificação do programa montado (ver program_checksum)
+    uint32_t reserved;
+    uint64_t checksum;
+    // Endereço da primeira instrução
+    uint16_t startPc;
+    uint16_t reserved2[3];
+} traceHeader_t;
+
+// Fim do traço
+typedef struct {
+    int32_t exitCode;
+    uint32_t reserved;
+    int64_t totalInstructions;
+    uint64_t totalTStates;
+} traceTrailer_t;
+
+_Static_assert(sizeof(traceHeader_t) == 32, "Cabecalho do traco com tamanho inesperado");
+_Static_assert(sizeof(traceTrailer_t) == 24, "Fim do traco com tamanho inesperado");
+
+struct trace_s {
+    FILE * file;
+    bool replay;
+    // Bloco atual
+    uint8_t buffer[TRACE_BLOCK_SIZE];
+    size_t size;
+    size_t position;
+    uint32_t blockEvents;
+    // Último PC registrado
+    uhex2_t lastPc;
+    uint64_t events;
+    // Se houve erro ao gravar
+    bool failed;
+
+    // Reprodução //
+    // Se o bloco final já foi lido
+    bool ended;
+    traceTrailer_t trailer;
+};
+
+/**
+ * Identificação do programa montado: hash FNV-1a dos endereços usados
+ * e dos valores neles
+ */
+static uint64_t program_checksum(const Environment * env) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < env->usedAddressesSize; i++) {
+        uhex2_t address = env->usedAddresses[i];
+        uint8_t bytes[3] = {
+            (uint8_t)(address & 0xFF),
+            (uint8_t)(address >> 8),
+            (uint8_t)env_read_unit(env, address).value
+        };
+        for (int b = 0; b < 3; b++) {
+            hash ^= bytes[b];
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+// Zigzag: inteiros com sinal pequenos viram inteiros sem sinal pequenos
+#define zigzag(v) ((uint32_t)(((v) << 1) ^ ((v) >> 31)))
+#define unzigzag(v) ((int32_t)((v) >> 1) ^ -(int32_t)((v) & 1))
+
+/**
+ * Inicializa o traço do ambiente
+ * @return o código de erro
+ */
+static ErrorCode_t trace_create(Environment * env, const char * path, bool replay) {
+    trace_t * trace = calloc(1, sizeof(trace_t));
+    if (trace == NULL)
+        return EXIT_NO_MEMORY;
+    trace->file = fopen(path, replay ? "rb" : "wb");
+    if (trace->file == NULL) {
+        free(trace);
+        return EXIT_TRACE;
+    }
+    trace->replay = replay;
+    trace->lastPc = env->programCounter;
+    env->trace = trace;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Libera o traço do ambiente
+ */
+static void trace_destroy(Environment * env) {
+    if (env->trace == NULL)
+        return;
+    if (env->trace->file != NULL)
+        fclose(env->trace->file);
+    free(env->trace);
+    env->trace = NULL;
+}
+
+// Gravação //
+
+/**
+ * Grava o bloco atual (se não estiver vazio)
+ */
+static void trace_flush_block(trace_t * trace) {
+    if (trace->size == 0)
+        return;
+    uint32_t header[2] = { (uint32_t)trace->size, trace->blockEvents };
+    if (fwrite(header, sizeof(header), 1, trace->file) != 1
+        || fwrite(trace->buffer, 1, trace->size, trace->file) != trace->size)
+        trace->failed = true;
+    trace->size = 0;
+    trace->blockEvents = 0;
+}
+
+/**
+ * Adiciona um evento ao bloco atual
+ * @param trace o traço
+ * @param event o tipo do evento
+ * @param data o inteiro do evento (sem o tipo)
+ * @param value o byte de valor (se has_value)
+ */
+static void trace_push(trace_t * trace, traceEvent_t event, uint32_t data, bool has_value, hex1_t value) {
+    if (trace->size + TRACE_MAX_EVENT_SIZE > TRACE_BLOCK_SIZE)
+        trace_flush_block(trace);
+
+    uint32_t v = (data << 2) | (uint32_t)event;
+    do {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        trace->buffer[trace->size++] = v != 0 ? (byte | 0x80) : byte;
+    } while (v != 0);
+    if (has_value)
+        trace->buffer[trace->size++] = (uint8_t)value;
+
+    trace->blockEvents++;
+    trace->events++;
+}
+
+ErrorCode_t trace_record_start(Environment * env, const char * path) {
+    ErrorCode_t err = trace_create(env, path, false);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    traceHeader_t header = { 0 };
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.checksum = program_checksum(env);
+    header.startPc = env->programCounter;
+    if (fwrite(&header, sizeof(header), 1, env->trace->file) != 1) {
+        trace_destroy(env);
+        return EXIT_TRACE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Reprodução //
+
+/**
+ * Lê o próximo bloco do traço
+ * @return se leu um bloco com eventos (false no fim do traço)
+ */
+static bool trace_read_block(Environment * env) {
+    trace_t * trace = env->trace;
+    uint32_t header[2];
+    if (fread(header, sizeof(header), 1, trace->file) != 1)
+        E_EXIT(EXIT_TRACE, "O traco acabou antes do fim da execucao gravada (arquivo incompleto). Eventos reproduzidos: %llu.",
+            (unsigned long long)trace->events);
+
+    // Bloco final
+    if (header[0] == 0) {
+        if (fread(&trace->trailer, sizeof(trace->trailer), 1, trace->file) != 1)
+            E_EXIT(EXIT_TRACE, "O fim do traco esta incompleto. Eventos reproduzidos: %llu.",
+                (unsigned long long)trace->events);
+        trace->ended = true;
+        return false;
+    }
+
+    if (header[0] > TRACE_BLOCK_SIZE || fread(trace->buffer, 1, header[0], trace->file) != header[0])
+        E_EXIT(EXIT_TRACE, "Bloco invalido no traco. Eventos reproduzidos: %llu.", (unsigned long long)trace->events);
+    trace->size = header[0];
+    trace->position = 0;
+    trace->blockEvents = header[1];
+    return true;
+}
+
+/**
+ * Lê o próximo evento do traço
+ * @param env o ambiente do SAP2
+ * @param event onde o tipo do evento é guardado
+ * @param data onde o inteiro do evento é guardado
+ * @return se há um evento (false no fim do traço)
+ */
+static bool trace_next(Environment * env, traceEvent_t * event, uint32_t * data) {
+    trace_t * trace = env->trace;
+    if (trace->ended)
+        return false;
+    if (trace->position >= trace->size && !trace_read_block(env))
+        return false;
+
+    uint32_t v = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        if (trace->position >= trace->size || shift > 28)
+            E_EXIT(EXIT_TRACE, "Evento invalido no traco (evento %llu).", (unsigned long long)trace->events);
+        byte = trace->buffer[trace->position++];
+        v |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    *event = (traceEvent_t)(v & 3);
+    *data = v >> 2;
+    trace->events++;
+    return true;
+}
+
+/**
+ * Lê o byte de valor do evento atual
+ */
+static hex1_t trace_next_value(Environment * env) {
+    trace_t * trace = env->trace;
+    if (trace->position >= trace->size)
+        E_EXIT(EXIT_TRACE, "Evento invalido no traco (evento %llu).", (unsigned long long)trace->events);
+    return (hex1_t)trace->buffer[trace->position++];
+}
+
+/**
+ * Encerra a reprodução no ponto em que a execução gravada terminou
+ * (com o código de saída gravado)
+ */
+_Noreturn static void trace_replay_end(Environment * env) {
+    trace_t * trace = env->trace;
+    ErrorCode_t code = trace->trailer.exitCode != EXIT_SUCCESS ? trace->trailer.exitCode : EXIT_TRACE;
+    E_EXIT(code, "Instrucao %d: a execucao gravada terminou aqui (Saida de Erro: %d, instrucoes executadas: %lld).",
+        env->currentInstruction, trace->trailer.exitCode, (long long)trace->trailer.totalInstructions);
+}
+
+static const char * event_name(traceEvent_t event) {
+    switch (event) {
+        case TRACE_EVENT_PC: return "instrucao";
+        case TRACE_EVENT_WRITE: return "escrita na memoria";
+        case TRACE_EVENT_IN: return "IN";
+        default: return "OUT";
+    }
+}
+
+/**
+ * Lê o próximo evento, que deve ser do tipo dado
+ * @return o inteiro do evento
+ */
+static uint32_t trace_expect(Environment * env, traceEvent_t expected) {
+    traceEvent_t event;
+    uint32_t data;
+    if (!trace_next(env, &event, &data))
+        trace_replay_end(env);
+    if (event != expected)
+        E_EXIT(EXIT_TRACE, "Instrucao %d: a execucao divergiu do traco (evento %llu).\n\tGravado: %s\n\tExecutado: %s",
+            env->currentInstruction, (unsigned long long)env->trace->events, event_name(event), event_name(expected));
+    return data;
+}
+
+ErrorCode_t trace_replay_start(Environment * env, const char * path) {
+    ErrorCode_t err = trace_create(env, path, true);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    traceHeader_t header;
+    if (fread(&header, sizeof(header), 1, env->trace->file) != 1
+        || memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0
+        || header.version != TRACE_VERSION) {
+        trace_destroy(env);
+        return EXIT_TRACE;
+    }
+    if (header.checksum != program_checksum(env) || header.startPc != env->programCounter) {
+        E_WARN("O traco foi gravado com outro programa (ou com outro endereco inicial).");
+        trace_destroy(env);
+        return EXIT_TRACE;
+    }
+
+    // A execução para onde a gravada parou
+    env->params.max_evaluated = STANDARD_MAX_EVALUATE;
+    env->params.max_time = DBL_MAX;
+    env->params.real_max_time = DBL_MAX;
+    env->params.paced = false;
+    env->params.debug_mode = false;
+    return EXIT_SUCCESS;
+}
+
+// Ganchos //
+
+void trace_instruction(Environment * env, uhex2_t pc) {
+    trace_t * trace = env->trace;
+    int32_t delta = (int16_t)(uhex2_t)(pc - trace->lastPc);
+
+    if (!trace->replay) {
+        trace_push(trace, TRACE_EVENT_PC, zigzag(delta), false, 0);
+    } else {
+        uint32_t data = trace_expect(env, TRACE_EVENT_PC);
+        int32_t recorded = unzigzag(data);
+        if (recorded != delta)
+            E_EXIT(EXIT_TRACE, "Instrucao %d: a execucao divergiu do traco (evento %llu).\n\tPC gravado: %xH\n\tPC executado: %xH",
+                env->currentInstruction, (unsigned long long)trace->events,
+                (uhex2_t)(trace->lastPc + recorded), pc);
+    }
+    trace->lastPc = pc;
+}
+
+void trace_write(Environment * env, uhex2_t address, hex1_t value) {
+    trace_t * trace = env->trace;
+    if (!trace->replay) {
+        trace_push(trace, TRACE_EVENT_WRITE, address, true, value);
+        return;
+    }
+
+    uint32_t recorded = trace_expect(env, TRACE_EVENT_WRITE);
+    hex1_t recordedValue = trace_next_value(env);
+    if (recorded != address || recordedValue != value)
+        E_EXIT(EXIT_TRACE, "Instrucao %d: a execucao divergiu do traco (evento %llu).\n\tGravado: %02xH em %xH\n\tExecutado: %02xH em %xH",
+            env->currentInstruction, (unsigned long long)trace->events,
+            (uhex1_t)recordedValue, recorded, (uhex1_t)value, address);
+}
+
+void trace_io(Environment * env, traceEvent_t event, uhex1_t port, hex1_t value) {
+    trace_t * trace = env->trace;
+    if (!trace->replay) {
+        trace_push(trace, event, port, true, value);
+        return;
+    }
+
+    uint32_t recorded = trace_expect(env, event);
+    hex1_t recordedValue = trace_next_value(env);
+    if (recorded != port || recordedValue != value)
+        E_EXIT(EXIT_TRACE, "Instrucao %d: a execucao divergiu do traco (evento %llu).\n\t%s gravado: %02xH (porta %xH)\n\t%s executado: %02xH (porta %xH)",
+            env->currentInstruction, (unsigned long long)trace->events,
+            event_name(event), (uhex1_t)recordedValue, recorded,
+            event_name(event), (uhex1_t)value, port);
+}
+
+hex1_t trace_replay_in(Environment * env, uhex1_t port) {
+    uint32_t recorded = trace_expect(env, TRACE_EVENT_IN);
+    hex1_t value = trace_next_value(env);
+    if (recorded != port)
+        E_EXIT(EXIT_TRACE, "Instrucao %d: a execucao divergiu do traco (evento %llu).\n\tPorta do IN gravada: %xH\n\tPorta do IN executada: %xH",
+            env->currentInstruction, (unsigned long long)env->trace->events, recorded, port);
+    return value;
+}
+
+bool trace_is_replay(const Environment * env) {
+    return env->trace != NULL && env->trace->replay;
+}
+
+uint64_t trace_event_count(const Environment * env) {
+    return env->trace != NULL ? env->trace->events : 0;
+}
+
+ErrorCode_t trace_finish(Environment * env, ErrorCode_t exit_code) {
+    trace_t * trace = env->trace;
+    if (trace == NULL)
+        return EXIT_SUCCESS;
+
+    // volatile: o valor precisa sobreviver ao longjmp da verificação abaixo
+    volatile ErrorCode_t err = EXIT_SUCCESS;
+    if (!trace->replay) {
+        trace_flush_block(trace);
+        uint32_t end[2] = { 0, 0 };
+        traceTrailer_t trailer = {
+            .exitCode = exit_code,
+            .totalInstructions = env->totalInstructions,
+            .totalTStates = env->totalTStates
+        };
+        if (fwrite(end, sizeof(end), 1, trace->file) != 1
+            || fwrite(&trailer, sizeof(trailer), 1, trace->file) != 1
+            || fflush(trace->file) != 0)
+            trace->failed = true;
+        err = trace->failed ? EXIT_TRACE : EXIT_SUCCESS;
+    } else if (exit_code == EXIT_TRACE) {
+        // A execução já divergiu do traço (e isso já foi avisado)
+        err = EXIT_TRACE;
+    } else {
+        // Confere se a execução terminou onde e como a gravada terminou.
+        // A verificação fica sob um ponto de recuperação, já que ler o
+        // traço pode encerrar o ambiente.
+        jmp_buf * previous = env->diagnostics.on_fatal;
+        jmp_buf on_fatal;
+        if (setjmp(on_fatal) != 0) {
+            err = EXIT_TRACE;
+        } else {
+            env->diagnostics.on_fatal = &on_fatal;
+            traceEvent_t event;
+            uint32_t data;
+            if (trace_next(env, &event, &data)) {
+                diagnostics_warn(&env->diagnostics, "A execucao terminou antes do fim do traco (evento %llu: %s).",
+                    (unsigned long long)trace->events, event_name(event));
+                err = EXIT_TRACE;
+            } else if (trace->trailer.exitCode != exit_code
+                || trace->trailer.totalInstructions != env->totalInstructions) {
+                diagnostics_warn(&env->diagnostics,
+                    "A execucao terminou de forma diferente da gravada.\n\tGravada: Saida de Erro %d, %lld instrucoes\n\tReproduzida: Saida de Erro %d, %ld instrucoes",
+                    trace->trailer.exitCode, (long long)trace->trailer.totalInstructions,
+                    exit_code, env->totalInstructions);
+                err = EXIT_TRACE;
+            }
+        }
+        env->diagnostics.on_fatal = previous;
+    }
+
+    trace_destroy(env);
+    return err;
+}
@@ -0,0 +1,127 @@
+// Traço da execução: grava, de forma compacta, tudo que acontece em
+// uma execução (contador de programa, escritas na memória, IN e OUT)
+// para que ela possa ser reproduzida depois, sem terminal.
+//
+// Formato do arquivo:
+//   cabeçalho (traceHeader_t)
+//   blocos: uint32 tamanho + uint32 quantidade de eventos + eventos
+//   bloco final (tamanho e quantidade 0) + traceTrailer_t
+// Cada evento começa com um inteiro de tamanho variável (LEB128) cujos
+// 2 bits menores são o tipo do evento:
+//   PC:      resto = diferença (zigzag) para o PC anterior
+//   Escrita: resto = endereço, seguido de 1 byte com o valor
+//   IN/OUT:  resto = porta, seguido de 1 byte com o valor
+//
+// Author: André
+// Date: 26/10/2025
+//
+
+#ifndef SAP2_COMPILER_TRACE_H
+#define SAP2_COMPILER_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../environment.h"
+#include "../ErrorCodes.h"
+
+// Identificação do arquivo de traço
+#define TRACE_MAGIC "SAP2TRC"
+#define TRACE_VERSION 1
+// Tamanho dos blocos gravados
+#define TRACE_BLOCK_SIZE (64 * 1024)
+
+// Tipos de evento
+typedef enum {
+    TRACE_EVENT_PC = 0,
+    TRACE_EVENT_WRITE = 1,
+    TRACE_EVENT_IN = 2,
+    TRACE_EVENT_OUT = 3
+} traceEvent_t;
+
+// Traço sendo gravado ou reproduzido (ver trace.c)
+typedef struct trace_s trace_t;
+
+// Ganchos usados pela execução. Não custam nada além da comparação
+// quando não há traço. As instruções que o depurador refaz (ao voltar
+// a execução) já estão no traço e não entram de novo.
+#define TRACE_PC(pc) \
+    do { if (env->trace != NULL && !env->replaying) trace_instruction(env, pc); } while (0)
+#define TRACE_WRITE(address, value) \
+    do { if (env->trace != NULL && !env->replaying) trace_write(env, address, value); } while (0)
+#define TRACE_OUT(port, value) \
+    do { if (env->trace != NULL && !env->replaying) trace_io(env, TRACE_EVENT_OUT, port, value); } while (0)
+
+/**
+ * Começa a gravar o traço da execução do ambiente no arquivo dado. O
+ * programa já deve estar montado.
+ * @param env o ambiente do SAP2
+ * @param path o caminho do arquivo
+ * @return o código de erro
+ */
+ErrorCode_t trace_record_start(Environment * env, const char * path);
+
+/**
+ * Começa a reproduzir o traço do arquivo dado: as entradas do IN vêm
+ * do traço e cada instrução, escrita e saída é comparada com a gravada.
+ * Os limites de tempo e de instruções são desativados (a execução para
+ * onde a gravada parou) e o tempo dos T-States não é esperado. O
+ * programa já deve estar montado.
+ * @param env o ambiente do SAP2
+ * @param path o caminho do arquivo
+ * @return o código de erro (EXIT_TRACE se o traço for de outro programa)
+ */
+ErrorCode_t trace_replay_start(Environment * env, const char * path);
+
+/**
+ * Termina a gravação (grava o fim do traço) ou a reprodução (confere
+ * se a execução terminou como a gravada) e fecha o arquivo.
+ * @param env o ambiente do SAP2
+ * @param exit_code o código de saída da execução
+ * @return o código de erro (EXIT_TRACE se algo não for igual ao gravado)
+ */
+ErrorCode_t trace_finish(Environment * env, ErrorCode_t exit_code);
+
+/**
+ * Retorna se o traço do ambiente está sendo reproduzido
+ */
+bool trace_is_replay(const Environment * env);
+
+/**
+ * Quantidade de eventos gravados ou reproduzidos até agora
+ */
+uint64_t trace_event_count(const Environment * env);
+
+/**
+ * Registra (ou confere) o início de uma instrução
+ * @param env o ambiente do SAP2
+ * @param pc o endereço da instrução
+ */
+void trace_instruction(Environment * env, uhex2_t pc);
+
+/**
+ * Registra (ou confere) uma escrita na memória
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @param value o valor escrito
+ */
+void trace_write(Environment * env, uhex2_t address, hex1_t value);
+
+/**
+ * Registra (ou confere) um valor de entrada ou saída
+ * @param env o ambiente do SAP2
+ * @param event TRACE_EVENT_IN ou TRACE_EVENT_OUT
+ * @param port a porta
+ * @param value o valor
+ */
+void trace_io(Environment * env, traceEvent_t event, uhex1_t port, hex1_t value);
+
+/**
+ * Retorna o próximo valor de entrada gravado (na reprodução)
+ * @param env o ambiente do SAP2
+ * @param port a porta
+ * @return o valor gravado
+ */
+hex1_t trace_replay_in(Environment * env, uhex1_t port);
+
+#endif //SAP2_COMPILER_TRACE_H
@@ -131,9 +131,9 @@ char* formatString(const char* format, ...) {
     return string;
 }
 
-void enter_to_continue() {
+void enter_to_continue(FILE * in) {
     int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+    while ((c = fgetc(in)) != '\n' && c != EOF);
 }
 
 void windows_sleep_us(long microseconds) {
@@ -251,14 +251,37 @@ double stopWatch_timeElapsed(stopWatch_s* sw) {
     #endif
 }
 
-void print_binary(int size, int num) {
+FILE * open_null_stream() {
+    #ifdef _WIN32
+        return fopen("NUL", "r+");
+    #else
+        return fopen("/dev/null", "r+");
+    #endif
+}
+
+int get_core_count() {
+    #ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+    #else
+    #ifdef __linux__
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+    #else
+        return 1;
+    #endif
+    #endif
+}
+
+void print_binary(FILE * f, int size, int num) {
     size *= 8;
     // Imprime cada bit começando do MSB
     for (int i = size-1; i >= 0; i--) {
         // Arrasta o número i vezes e usa AND com 1
         // para determinar se o valor é 0 ou 1
-        printf("%d", (num >> i) & 1);
+        fprintf(f, "%d", (num >> i) & 1);
         // De 4 em 4 bits, dá um es
-        if (i % 4 == 0 && i != 0) printf(" ");
+        if (i % 4 == 0 && i != 0) fprintf(f, " ");
     }
 }
@@ -16,6 +16,7 @@
 #endif
 
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -94,8 +95,9 @@ char* formatString(const char* format, ...);
 /**
  * Para o programa até o usuário dar enter (quebra de linha),
  * limpando o que o usuário digitou
+ * @param in de onde o enter é lido
  */
-void enter_to_continue();
+void enter_to_continue(FILE * in);
 
 /**
  * Congela o código pelo tempo dado.
@@ -124,10 +126,24 @@ void stopWatch_end(stopWatch_s* sw);
  */
 double stopWatch_timeElapsed(stopWatch_s* sw);
 
+/**
+ * Retorna a quantidade de núcleos (processadores lógicos) da máquina
+ * @return quantidade de núcleos (pelo menos 1)
+ */
+int get_core_count();
+
+/**
+ * Abre um fluxo que descarta tudo que é escrito nele (e está sempre
+ * vazio para leitura)
+ * @return o fluxo (NULL se não conseguir abrir)
+ */
+FILE * open_null_stream();
+
 /**
  * Imprime os bits do número dado
+ * @param f onde os bits são impressos
  * @param size tamanho do número em bytes
  * @param num número que se quer imprimir os bits
  */
-void print_binary(int size, int num);
+void print_binary(FILE * f, int size, int num);
 #endif //SAP2_COMPILER_UTIL_H
@@ -0,0 +1,30 @@
+// Alocador de memória de um ambiente do SAP2 (ver environment.h).
+// Fica separado para que o destino de diagnósticos também possa usá-lo.
+//
+// Author: André
+// Date: 20/10/2025
+//
+#pragma once
+
+#ifndef SAP2_COMPILER_ALLOCATOR_H
+#define SAP2_COMPILER_ALLOCATOR_H
+
+#include <stddef.h>
+
+// Alocador de memória usado por um ambiente. Cada ambiente guarda o
+// seu, então dá para usar, por exemplo, um alocador por thread.
+typedef struct {
+    // Aloca "size" bytes zerados
+    void * (*alloc)(void * ctx, size_t size);
+    // Realoca "ptr" para "size" bytes (como o realloc)
+    void * (*resize)(void * ctx, void * ptr, size_t size);
+    // Libera "ptr"
+    void (*release)(void * ctx, void * ptr);
+    // Dados do alocador (passados para as funções acima)
+    void * ctx;
+} allocator_t;
+
+// Alocador padrão (calloc/realloc/free)
+extern const allocator_t STANDARD_ALLOCATOR;
+
+#endif //SAP2_COMPILER_ALLOCATOR_H
@@ -0,0 +1,248 @@
+// Destino dos avisos e erros de um ambiente do SAP2.
+//
+// Author: André
+// Date: 20/10/2025
+//
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "diagnostics.h"
+
+// Endereço dos avisos que não são de um endereço (agrupados pelo lugar)
+#define DIAGNOSTICS_NO_ADDRESS UINT32_MAX
+
+// Um aviso visto (lugar + endereço)
+typedef struct {
+    // O texto base do aviso (NULL se a posição da tabela estiver livre)
+    const char * site;
+    uint32_t address;
+    // Quantas vezes aconteceu
+    uint64_t count;
+    // Se a primeira ocorrência foi impressa
+    bool printed;
+    // A primeira ocorrência, já formatada
+    char * message;
+} diagnosticsEntry_t;
+
+struct diagnosticsLog_s {
+    diagnosticsEntry_t entries[DIAGNOSTICS_TABLE_SIZE];
+    size_t used;
+    // Quantos avisos diferentes foram impressos
+    size_t printed;
+    // Avisos que não couberam na tabela
+    uint64_t overflow;
+};
+
+void diagnostics_init(diagnostics_t * diagnostics, const allocator_t * allocator) {
+    diagnostics->warnings = stdout;
+    diagnostics->errors = stderr;
+    diagnostics->on_fatal = NULL;
+    diagnostics->level = WARNINGS_FIRST;
+    diagnostics->log = NULL;
+    diagnostics->allocator = *allocator;
+}
+
+ErrorCode_t diagnostics_parse_level(const char * text, warningLevel_t * level) {
+    if (strcmp(text, "primeiro") == 0)
+        *level = WARNINGS_FIRST;
+    else if (strcmp(text, "todos") == 0)
+        *level = WARNINGS_ALL;
+    else if (strcmp(text, "resumo") == 0)
+        *level = WARNINGS_SUMMARY;
+    else if (strcmp(text, "nenhum") == 0)
+        *level = WARNINGS_NONE;
+    else
+        return EXIT_INVALID_ARGUMENT;
+    return EXIT_SUCCESS;
+}
+
+static void print_warning(diagnostics_t * diagnostics, const char * format, va_list args) {
+    fprintf(diagnostics->warnings, "\n[AVISO] ");
+    vfprintf(diagnostics->warnings, format, args);
+    fprintf(diagnostics->warnings, "\n");
+}
+
+/**
+ * Conta uma ocorrência do aviso e, se for a primeira, guarda o texto
+ * (e imprime, se o nível permitir)
+ */
+static void record_warning(diagnostics_t * diagnostics, uint32_t address, const char * format, va_list args) {
+    const allocator_t * allocator = &diagnostics->allocator;
+    if (diagnostics->log == NULL) {
+        diagnostics->log = allocator->alloc(allocator->ctx, sizeof(diagnosticsLog_t));
+        if (diagnostics->log == NULL) {
+            // Sem memória para a tabela: imprime como antes
+            if (diagnostics->level == WARNINGS_FIRST)
+                print_warning(diagnostics, format, args);
+            return;
+        }
+    }
+    diagnosticsLog_t * log = diagnostics->log;
+
+    // O lugar é identificado pelo endereço do texto base
+    uintptr_t hash = ((uintptr_t)format >> 3) * 0x9E3779B1u ^ (uintptr_t)address * 0x85EBCA6Bu;
+    size_t index = (size_t)(hash ^ (hash >> 16)) & (DIAGNOSTICS_TABLE_SIZE - 1);
+    while (log->entries[index].site != NULL) {
+        diagnosticsEntry_t * entry = &log->entries[index];
+        if (entry->site == format && entry->address == address) {
+            entry->count++;
+            return;
+        }
+        index = (index + 1) & (DIAGNOSTICS_TABLE_SIZE - 1);
+    }
+
+    // Primeira ocorrência (a tabela nunca enche mais que 3/4)
+    if (log->used >= DIAGNOSTICS_TABLE_SIZE / 4 * 3) {
+        log->overflow++;
+        return;
+    }
+    diagnosticsEntry_t * entry = &log->entries[index];
+    char message[DIAGNOSTICS_MESSAGE_SIZE];
+    vsnprintf(message, sizeof(message), format, args);
+    entry->site = format;
+    entry->address = address;
+    entry->count = 1;
+    size_t length = strlen(message) + 1;
+    entry->message = allocator->alloc(allocator->ctx, length);
+    if (entry->message != NULL)
+        memcpy(entry->message, message, length);
+    log->used++;
+
+    if (diagnostics->level == WARNINGS_FIRST && log->printed < DIAGNOSTICS_MAX_PRINTED) {
+        fprintf(diagnostics->warnings, "\n[AVISO] %s\n", message);
+        entry->printed = true;
+        log->printed++;
+    }
+}
+
+void diagnostics_warn(diagnostics_t * diagnostics, const char * format, ...) {
+    if (diagnostics->level == WARNINGS_NONE)
+        return;
+    va_list args;
+    va_start(args, format);
+
+    // Os avisos sem endereço são raros: só são agrupados no resumo
+    if (diagnostics->level == WARNINGS_SUMMARY)
+        record_warning(diagnostics, DIAGNOSTICS_NO_ADDRESS, format, args);
+    else
+        print_warning(diagnostics, format, args);
+
+    va_end(args);
+}
+
+void diagnostics_warn_at(diagnostics_t * diagnostics, uint32_t address, const char * format, ...) {
+    if (diagnostics->level == WARNINGS_NONE)
+        return;
+    va_list args;
+    va_start(args, format);
+
+    if (diagnostics->level == WARNINGS_ALL)
+        print_warning(diagnostics, format, args);
+    else
+        record_warning(diagnostics, address, format, args);
+
+    va_end(args);
+}
+
+// Ordena os avisos do mais frequente para o menos frequente
+static int compare_entries(const void * a, const void * b) {
+    const diagnosticsEntry_t * x = *(const diagnosticsEntry_t * const *)a;
+    const diagnosticsEntry_t * y = *(const diagnosticsEntry_t * const *)b;
+    return (x->count < y->count) - (x->count > y->count);
+}
+
+void diagnostics_summary(diagnostics_t * diagnostics) {
+    diagnosticsLog_t * log = diagnostics->log;
+    if (log == NULL)
+        return;
+
+    // Só entram os avisos que têm ocorrências não impressas
+    diagnosticsEntry_t * shown[DIAGNOSTICS_TABLE_SIZE];
+    size_t count = 0;
+    uint64_t hidden = log->overflow;
+    for (size_t i = 0; i < DIAGNOSTICS_TABLE_SIZE; i++) {
+        diagnosticsEntry_t * entry = &log->entries[i];
+        if (entry->site == NULL || (entry->printed && entry->count == 1))
+            continue;
+        shown[count++] = entry;
+        hidden += entry->count - (entry->printed ? 1 : 0);
+    }
+
+    if (hidden > 0) {
+        qsort(shown, count, sizeof(shown[0]), compare_entries);
+        fprintf(diagnostics->warnings, "\n[AVISO] Resumo dos avisos (%llu ocorrencias nao impressas)\n",
+            (unsigned long long)hidden);
+        for (size_t i = 0; i < count; i++) {
+            // Só a primeira linha do aviso
+            const char * message = shown[i]->message != NULL ? shown[i]->message : shown[i]->site;
+            const char * end = strchr(message, '\n');
+            int length = end != NULL ? (int)(end - message) : (int)strlen(message);
+            fprintf(diagnostics->warnings, "%12llux | %.*s\n", (unsigned long long)shown[i]->count, length, message);
+        }
+        if (log->overflow > 0)
+            fprintf(diagnostics->warnings, "%12llux | (outros avisos, que nao couberam na tabela)\n",
+                (unsigned long long)log->overflow);
+    }
+
+    // Esquece os avisos vistos (uma próxima execução começa do zero)
+    diagnostics_free(diagnostics);
+}
+
+void diagnostics_free(diagnostics_t * diagnostics) {
+    diagnosticsLog_t * log = diagnostics->log;
+    if (log == NULL)
+        return;
+    const allocator_t * allocator = &diagnostics->allocator;
+    for (size_t i = 0; i < DIAGNOSTICS_TABLE_SIZE; i++) {
+        if (log->entries[i].message != NULL)
+            allocator->release(allocator->ctx, log->entries[i].message);
+    }
+    allocator->release(allocator->ctx, log);
+    diagnostics->log = NULL;
+}
+
+/**
+ * Encerra a execução com o código de erro dado. Se houver um ponto
+ * de recuperação, volta para ele.
+ * @param diagnostics o destino de diagnósticos
+ * @param code o código de erro
+ */
+_Noreturn static void diagnostics_abort(diagnostics_t * diagnostics, ErrorCode_t code) {
+    fflush(diagnostics->errors);
+    if (diagnostics->on_fatal != NULL) {
+        // longjmp não pode receber 0 (seria confundido com o retorno
+        // direto do setjmp), mas um erro fatal nunca é EXIT_SUCCESS.
+        longjmp(*diagnostics->on_fatal, code);
+    }
+    exit(code);
+}
+
+_Noreturn void diagnostics_fatal(diagnostics_t * diagnostics, ErrorCode_t code, const char * format, ...) {
+    diagnostics_summary(diagnostics);
+    va_list args;
+    va_start(args, format);
+
+    fprintf(diagnostics->errors, "[ERRO] ");
+    vfprintf(diagnostics->errors, format, args);
+    fprintf(diagnostics->errors, "\n");
+
+    va_end(args);
+    diagnostics_abort(diagnostics, code);
+}
+
+_Noreturn void diagnostics_instruction_fatal(diagnostics_t * diagnostics, ErrorCode_t code,
+    int nInstruction, const char * message, const char * format, ...) {
+    diagnostics_summary(diagnostics);
+    va_list args;
+    va_start(args, format);
+
+    fprintf(diagnostics->errors, "[ERRO] Instrucao %d: %s\n\t", nInstruction > 0 ? nInstruction : 1, message);
+    vfprintf(diagnostics->errors, format, args);
+    fprintf(diagnostics->errors, "\n");
+
+    va_end(args);
+    diagnostics_abort(diagnostics, code);
+}
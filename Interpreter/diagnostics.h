@@ -0,0 +1,161 @@
+// Destino dos avisos e erros de um ambiente do SAP2. Cada
+// ambiente tem o seu, para que vários ambientes possam
+// executar ao mesmo tempo sem um interferir no outro.
+//
+// Os avisos das instruções (que podem acontecer milhões de vezes em
+// um laço) são identificados pelo lugar do código que avisa e por um
+// endereço: só a primeira ocorrência é impressa e as outras são
+// contadas, aparecendo no resumo do fim da execução.
+//
+// Author: André
+// Date: 20/10/2025
+//
+#pragma once
+
+#ifndef SAP2_COMPILER_DIAGNOSTICS_H
+#define SAP2_COMPILER_DIAGNOSTICS_H
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "allocator.h"
+#include "ErrorCodes.h"
+
+// Tamanho da tabela de avisos (lugar + endereço) de um ambiente
+#define DIAGNOSTICS_TABLE_SIZE 1024
+// Quantidade máxima de avisos diferentes impressos (os outros só são contados)
+#define DIAGNOSTICS_MAX_PRINTED 100
+// Tamanho máximo da mensagem guardada para o resumo
+#define DIAGNOSTICS_MESSAGE_SIZE 512
+
+// Quais avisos são impressos (--avisos)
+typedef enum {
+    // A primeira ocorrência de cada aviso, com o resumo das repetições no fim
+    WARNINGS_FIRST,
+    // Todas as ocorrências (sem resumo)
+    WARNINGS_ALL,
+    // Só o resumo no fim
+    WARNINGS_SUMMARY,
+    // Nenhum
+    WARNINGS_NONE
+} warningLevel_t;
+
+// Avisos já vistos por um ambiente (ver diagnostics.c)
+typedef struct diagnosticsLog_s diagnosticsLog_t;
+
+// Destino dos diagnósticos (avisos e erros)
+typedef struct {
+    // Onde os avisos são impressos
+    FILE * warnings;
+    // Onde os erros são impressos
+    FILE * errors;
+    // Se não for NULL, um erro fatal volta para esse ponto (com o
+    // código de erro) ao invés de encerrar o programa inteiro.
+    jmp_buf * on_fatal;
+    // Quais avisos são impressos
+    warningLevel_t level;
+    // Avisos já vistos (criado no primeiro aviso, NULL até lá)
+    diagnosticsLog_t * log;
+    // Alocador dos avisos vistos (o mesmo do ambiente)
+    allocator_t allocator;
+} diagnostics_t;
+
+// Imprime um aviso no destino de diagnósticos do ambiente "env" (os
+// argumentos depois do formato são opcionais)
+#define E_WARN(format, ...) \
+    diagnostics_warn(&env->diagnostics, format, ##__VA_ARGS__)
+
+// Imprime um aviso de uma instrução no destino de diagnósticos do
+// ambiente "env", só na primeira vez que ele acontece no endereço dado
+#define E_WARN_AT(address, format, ...) \
+    diagnostics_warn_at(&env->diagnostics, address, format, ##__VA_ARGS__)
+
+// Imprime um erro no destino de diagnósticos do ambiente "env" e
+// encerra a execução desse ambiente
+#define E_EXIT(E, format, ...) \
+    diagnostics_fatal(&env->diagnostics, E, format, ##__VA_ARGS__)
+
+// Imprime a respectiva mensagem de erro interno e encerra a
+// execução do ambiente "env"
+#define E_EXIT_ERR(E) \
+    diagnostics_fatal(&env->diagnostics, E, "Erro Interno: %s", E##_MESSAGE)
+
+// Com mensagem customizada
+#define E_EXIT_CUSTOM_ERR(E, MSG) \
+    diagnostics_fatal(&env->diagnostics, E, "Erro Interno: %s", MSG)
+
+/**
+ * Inicializa o destino de diagnósticos com a saída padrão (avisos)
+ * e a saída de erros padrão (erros), imprimindo a primeira ocorrência
+ * de cada aviso
+ * @param diagnostics o destino de diagnósticos
+ * @param allocator o alocador dos avisos vistos
+ */
+void diagnostics_init(diagnostics_t * diagnostics, const allocator_t * allocator);
+
+/**
+ * Lê o nome de um nível de avisos ("primeiro", "todos", "resumo" ou "nenhum")
+ * @param text o nome
+ * @param level onde o nível é guardado
+ * @return o código de erro
+ */
+ErrorCode_t diagnostics_parse_level(const char * text, warningLevel_t * level);
+
+/**
+ * Imprime um aviso (no estilo "printf")
+ * @param diagnostics o destino de diagnósticos
+ * @param format texto base
+ * @param ... valores do texto
+ */
+void diagnostics_warn(diagnostics_t * diagnostics, const char * format, ...);
+
+/**
+ * Imprime um aviso (no estilo "printf") identificado pelo lugar que
+ * avisa (o próprio texto base) e pelo endereço. Se ele já aconteceu,
+ * só é contado (o texto nem é formatado).
+ * @param diagnostics o destino de diagnósticos
+ * @param address o endereço do aviso
+ * @param format texto base
+ * @param ... valores do texto
+ */
+void diagnostics_warn_at(diagnostics_t * diagnostics, uint32_t address, const char * format, ...);
+
+/**
+ * Imprime quantas vezes cada aviso repetido (ou não impresso)
+ * aconteceu e esquece os avisos vistos
+ * @param diagnostics o destino de diagnósticos
+ */
+void diagnostics_summary(diagnostics_t * diagnostics);
+
+/**
+ * Libera os avisos vistos
+ * @param diagnostics o destino de diagnósticos
+ */
+void diagnostics_free(diagnostics_t * diagnostics);
+
+/**
+ * Imprime o resumo dos avisos e um erro (no estilo "printf") e encerra
+ * a execução. Se houver um ponto de recuperação (on_fatal), volta para
+ * ele. Se não houver, encerra o programa com o código de erro dado.
+ * @param diagnostics o destino de diagnósticos
+ * @param code o código de erro
+ * @param format texto base
+ * @param ... valores do texto
+ */
+_Noreturn void diagnostics_fatal(diagnostics_t * diagnostics, ErrorCode_t code, const char * format, ...);
+
+/**
+ * Imprime um erro de uma instrução (no estilo "printf") e encerra a
+ * execução, da mesma forma que diagnostics_fatal().
+ * @param diagnostics o destino de diagnósticos
+ * @param code o código de erro
+ * @param nInstruction o número da instrução
+ * @param message a mensagem padrão do código de erro
+ * @param format texto base
+ * @param ... valores do texto
+ */
+_Noreturn void diagnostics_instruction_fatal(diagnostics_t * diagnostics, ErrorCode_t code,
+    int nInstruction, const char * message, const char * format, ...);
+
+#endif //SAP2_COMPILER_DIAGNOSTICS_H
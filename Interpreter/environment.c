@@ -4,6 +4,7 @@
 // Date: 19/09/2025
 //
 
+#include <stdarg.h> // VA ARGS
 #include <stdint.h> // uint8_t
 
 #include "environment.h"
@@ -11,9 +12,274 @@
 #include <ctype.h>
 
 #include "ErrorCodes.h"
+#include "Debugger/debugger.h"
+#include "Devices/devices.h"
+#include "Dump/dump.h"
 #include "Instructions/Instructions.h"
+#include "Profiler/profiler.h"
+#include "Trace/trace.h"
 #include "Utils/Utils.h"
 
+// Alocação usando o alocador do ambiente
+#define env_alloc(size) env->allocator.alloc(env->allocator.ctx, size)
+#define env_resize(ptr, size) env->allocator.resize(env->allocator.ctx, ptr, size)
+#define env_release(ptr) env->allocator.release(env->allocator.ctx, ptr)
+
+static void * standard_alloc(void * ctx, size_t size) {
+    (void)ctx;
+    return calloc(1, size);
+}
+
+static void * standard_resize(void * ctx, void * ptr, size_t size) {
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void standard_release(void * ctx, void * ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+const allocator_t STANDARD_ALLOCATOR = {
+    .alloc = standard_alloc,
+    .resize = standard_resize,
+    .release = standard_release,
+    .ctx = NULL
+};
+
+// Página zerada, usada por todas as páginas que ainda não foram
+// escritas. Nunca é alterada nem liberada.
+static memoryPage_t ZERO_PAGE;
+
+Environment * env_create(const Parametros * params, const allocator_t * allocator) {
+    if (allocator == NULL)
+        allocator = &STANDARD_ALLOCATOR;
+
+    Environment * env = allocator->alloc(allocator->ctx, sizeof(Environment));
+    if (env == NULL)
+        return NULL;
+
+    env->allocator = *allocator;
+    // A memória começa zerada: nenhuma página é alocada até ser escrita
+    for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        env->pages[i] = &ZERO_PAGE;
+    }
+
+    env->params = *params;
+    env->params.real_max_time = params->max_time;
+    env->programCounter = params->start_address;
+    env->in = stdin;
+    env->out = stdout;
+    diagnostics_init(&env->diagnostics, &env->allocator);
+
+    env->flags[FLAG_S] = 0;
+    // flag de 0 começa inicializado, uma vez que os valores
+    // começam zerados
+    env->flags[FLAG_Z] = 1;
+
+    return env;
+}
+
+Environment * env_clone(const Environment * image) {
+    const allocator_t * allocator = &image->allocator;
+    Environment * env = allocator->alloc(allocator->ctx, sizeof(Environment));
+    if (env == NULL)
+        return NULL;
+
+    // Copia a tabela de páginas junto com o resto do ambiente
+    *env = *image;
+    env->isClone = true;
+    env->strings = NULL;
+    // O traço, o depurador e o perfil pertencem ao ambiente original
+    env->trace = NULL;
+    env->debugger = NULL;
+    env->profile = NULL;
+    // Os avisos vistos também
+    env->diagnostics.log = NULL;
+    // Os destinos da execução também: várias cópias executadas ao mesmo
+    // tempo não podem escrever neles (nem voltar para o setjmp do original)
+    env->output = NULL;
+    env->devices = NULL;
+    env->dump = NULL;
+    env->capturedOutput = NULL;
+    env->diagnostics.on_fatal = NULL;
+    for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        if (env->pages[i] != &ZERO_PAGE)
+            atomic_fetch_add_explicit(&env->pages[i]->references, 1, memory_order_relaxed);
+    }
+
+    return env;
+}
+
+bool env_is_page_used(const Environment * env, int index) {
+    return env->pages[index] != &ZERO_PAGE;
+}
+
+/**
+ * Libera uma referência à página dada (e a página, se era a última)
+ * @param env o ambiente do SAP2
+ * @param page a página
+ */
+static void env_release_page(Environment * env, memoryPage_t * page) {
+    if (page == &ZERO_PAGE)
+        return;
+    if (atomic_fetch_sub_explicit(&page->references, 1, memory_order_acq_rel) == 1)
+        env_release(page);
+}
+
+void env_copy_state(Environment * env, const Environment * from) {
+    for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        if (env->pages[i] == from->pages[i])
+            continue;
+        if (from->pages[i] != &ZERO_PAGE)
+            atomic_fetch_add_explicit(&from->pages[i]->references, 1, memory_order_relaxed);
+        env_release_page(env, env->pages[i]);
+        env->pages[i] = from->pages[i];
+    }
+
+    env->programCounter = from->programCounter;
+    memcpy(env->registers, from->registers, sizeof(env->registers));
+    memcpy(env->flags, from->flags, sizeof(env->flags));
+    env->currentInstruction = from->currentInstruction;
+    env->totalInstructions = from->totalInstructions;
+    env->totalTStates = from->totalTStates;
+    env->last_instruction = from->last_instruction;
+    env->hex_print_buffer = from->hex_print_buffer;
+    env->hex_flow_buffer = from->hex_flow_buffer;
+    env->inputIndex = from->inputIndex;
+}
+
+memoryUnit_t * env_write_unit(Environment * env, uhex2_t address) {
+    int index = address >> MEMORY_PAGE_BITS;
+    memoryPage_t * page = env->pages[index];
+
+    // Se só esse ambiente usa a página, escreve direto nela
+    if (page == &ZERO_PAGE || atomic_load_explicit(&page->references, memory_order_acquire) != 1) {
+        memoryPage_t * copy = env_alloc(sizeof(memoryPage_t));
+        if (copy == NULL)
+            E_EXIT(EXIT_NO_MEMORY,
+                "Nao ha memoria suficiente para a pagina de memoria do endereco \"%x\".", address);
+
+        // A página alocada já vem zerada
+        if (page != &ZERO_PAGE)
+            memcpy(copy->units, page->units, sizeof(copy->units));
+        atomic_init(&copy->references, 1);
+
+        env->pages[index] = copy;
+        env_release_page(env, page);
+        page = copy;
+    }
+
+    return &page->units[address & (MEMORY_PAGE_SIZE - 1)];
+}
+
+void env_set_input(Environment * env, const hex1_t * values, size_t size) {
+    env->input = values;
+    env->inputSize = size;
+    env->inputIndex = 0;
+}
+
+ErrorCode_t hexBuffer_push(hexBuffer_t * buffer, hex1_t value) {
+    if (buffer->count == buffer->capacity) {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 16;
+        hex1_t * temp = realloc(buffer->values, capacity * sizeof(hex1_t));
+        if (temp == NULL)
+            return EXIT_NO_MEMORY;
+        buffer->values = temp;
+        buffer->capacity = capacity;
+    }
+    buffer->values[buffer->count++] = value;
+    return EXIT_SUCCESS;
+}
+
+void env_destroy(Environment * env) {
+    if (env == NULL)
+        return;
+
+    debugger_detach(env);
+    profile_finish(env);
+    diagnostics_free(&env->diagnostics);
+
+    // Libera a arena de textos
+    arenaBlock_t * block = env->strings;
+    while (block != NULL) {
+        arenaBlock_t * next = block->next;
+        env_release(block);
+        block = next;
+    }
+
+    // A tabela de símbolos e os endereços usados de uma cópia são os do original
+    if (!env->isClone) {
+        env_release(env->symbolTable);
+        env_release(env->usedAddresses);
+    }
+    for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        env_release_page(env, env->pages[i]);
+    }
+
+    allocator_t allocator = env->allocator;
+    allocator.release(allocator.ctx, env);
+}
+
+/**
+ * Reserva espaço para um texto de "size" bytes na arena do ambiente
+ * @param env o ambiente do SAP2
+ * @param size quantidade de bytes (contando com o '\0')
+ * @return o espaço reservado
+ */
+static char * env_arena_reserve(Environment * env, size_t size) {
+    arenaBlock_t * block = env->strings;
+    if (block == NULL || block->capacity - block->used < size) {
+        size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = env_alloc(sizeof(arenaBlock_t) + capacity);
+        if (block == NULL)
+            E_EXIT_ERR(EXIT_NO_MEMORY);
+        block->capacity = capacity;
+        block->used = 0;
+        block->next = env->strings;
+        env->strings = block;
+    }
+
+    char * text = block->data + block->used;
+    block->used += size;
+    return text;
+}
+
+char * env_strdup(Environment * env, const char * text) {
+    size_t size = strlen(text) + 1;
+    char * copy = env_arena_reserve(env, size);
+    memcpy(copy, text, size);
+    return copy;
+}
+
+void * env_memdup(Environment * env, const void * data, size_t size) {
+    void * copy = env_arena_reserve(env, size);
+    memcpy(copy, data, size);
+    return copy;
+}
+
+char * env_formatString(Environment * env, const char * format, ...) {
+    va_list vargs1;
+    va_start(vargs1, format);
+
+    // Cria uma cópia da lista de argumentos
+    va_list vargs2;
+    va_copy(vargs2, vargs1);
+
+    // Mede o tamanho necessario
+    int size = vsnprintf(NULL, 0, format, vargs1);
+    va_end(vargs1);
+    if (size < 0) {
+        va_end(vargs2);
+        return EMPTY_ANNOTATION; // Erro de codificação no formato
+    }
+
+    // Formata o texto direto na arena
+    char * text = env_arena_reserve(env, (size_t)size + 1);
+    vsnprintf(text, (size_t)size + 1, format, vargs2);
+    va_end(vargs2);
+    return text;
+}
 
 /**
  * Função para encontrar o ponto de inserção de um endereço
@@ -92,9 +358,9 @@ int isAddressUsed(Environment * env, uhex2_t address) {
 void addAddressToUsedMemory(Environment * env, uhex2_t address) {
     // Realoca para adicionar o endereço
     size_t newSize = env->usedAddressesSize + 1;
-    uhex2_t * temp = realloc(env->usedAddresses, sizeof(uhex2_t) * newSize);
+    uhex2_t * temp = env_resize(env->usedAddresses, sizeof(uhex2_t) * newSize);
     if (temp == NULL) {
-        WARN("Instrucao %d: os dados dessa instrucao podem nao ter sido corretamente guardados na tabela de memoria usada.",
+        E_WARN("Instrucao %d: os dados dessa instrucao podem nao ter sido corretamente guardados na tabela de memoria usada.",
             env->currentInstruction);
         return;
     }
@@ -108,14 +374,11 @@ void addToMemoryHex1(Environment * env, hex1_t hex) {
         env->programCounter++;
         return;
     }
-    if (env->memory == NULL)
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
-            "Erro interno: a memoria nao foi alocada.\nVerifique se ha memoria disponivel no dispositivo.");
     if (env->programCounter >= MEMORY_SIZE)
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
+        E_EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
             "A memoria RAM esta cheia.\nPossivelmente, seu codigo ultrapassou o limite de memoria.");
     if (env->programCounter < env_params->start_address)
-        V_EXIT(EXIT_READ_ONLY_ADDRESS,
+        E_EXIT(EXIT_READ_ONLY_ADDRESS,
             "A posicao de memoria \"%x\" eh de apenas leitura (Read-Only)\nmas tentaram escrever nela.", env->programCounter);
 
     // Se chegou aqui, a memória ainda está no intervalo
@@ -123,10 +386,10 @@ void addToMemoryHex1(Environment * env, hex1_t hex) {
     // Verifica se tem algo nela (para avisar o usuário que ele
     // está sobrescrevendo algo)
     if (isAddressUsed(env, env->programCounter))
-        WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
+        E_WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
 
     // Sobrescreve e incrementa o contador de programa
-    env->memory[env->programCounter] = (memoryUnit_t) {
+    *env_write_unit(env, env->programCounter) = (memoryUnit_t) {
         .value = hex,
         .annotation = EMPTY_ANNOTATION,
         .nInstruction = 0
@@ -140,14 +403,11 @@ void addToMemoryHex1Annotation(Environment * env, uhex1_t hex, char* text) {
         env->programCounter++;
         return;
     }
-    if (env->memory == NULL)
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
-            "Erro interno: a memoria nao foi alocada.\nVerifique se ha memoria disponivel no dispositivo.");
     if (env->programCounter >= MEMORY_SIZE)
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
+        E_EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
             "A memoria RAM esta cheia.\nPossivelmente, seu codigo ultrapassou o limite de memoria.");
     if (env->programCounter < env_params->start_address)
-        V_EXIT(EXIT_READ_ONLY_ADDRESS,
+        E_EXIT(EXIT_READ_ONLY_ADDRESS,
             "A posicao de memoria \"%x\" eh de apenas leitura (Read-Only)\nmas tentaram escrever nela.", env->programCounter);
 
     // Se chegou aqui, a memória ainda está no intervalo
@@ -155,10 +415,10 @@ void addToMemoryHex1Annotation(Environment * env, uhex1_t hex, char* text) {
     // Verifica se tem algo nela (para avisar o usuário que ele
     // está sobrescrevendo algo)
     if (isAddressUsed(env, env->programCounter))
-        WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
+        E_WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
 
     // Sobrescreve e incrementa o contador de programa
-    env->memory[env->programCounter] = (memoryUnit_t) {
+    *env_write_unit(env, env->programCounter) = (memoryUnit_t) {
         .value = (hex1_t)hex,
         .annotation = text,
         .nInstruction = MEMORY_UNIT_NOT_INSTRUCTION
@@ -172,14 +432,11 @@ void addToMemoryHex2(Environment * env, hex2_t hex) {
         env->programCounter += 2;
         return;
     }
-    if (env->memory == NULL)
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
-            "Erro interno: a memoria nao foi alocada.\nVerifique se ha memoria disponivel no dispositivo.");
     if (env->programCounter+1 >= MEMORY_SIZE) // +1 porque gasta 2 endereços
-        EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
+        E_EXIT_CUSTOM_ERR(EXIT_NO_MEMORY,
             "A memoria RAM esta cheia.\nPossivelmente, seu codigo ultrapassou o limite de memoria.");
     if (env->programCounter < env_params->start_address)
-        V_EXIT(EXIT_READ_ONLY_ADDRESS,
+        E_EXIT(EXIT_READ_ONLY_ADDRESS,
             "A posicao de memoria \"%x\" eh de apenas leitura (Read-Only)\nmas tentaram escrever nela.", env->programCounter);
 
     // Se chegou aqui, a memória ainda está no intervalo
@@ -187,10 +444,10 @@ void addToMemoryHex2(Environment * env, hex2_t hex) {
     // Verifica se tem algo nela (para avisar o usuário que ele
     // está sobrescrevendo algo)
     if (isAddressUsed(env, env->programCounter) || isAddressUsed(env, env->programCounter+1))
-        WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
+        E_WARN("A posicao de memoria \"%x\" vai ser sobrescrita, mas ha conteudo nela.\nIsso pode causar comportamentos inesperados.", env->programCounter);
 
     // Escreve o LSB
-    env->memory[env->programCounter] = (memoryUnit_t) {
+    *env_write_unit(env, env->programCounter) = (memoryUnit_t) {
         .value = (hex1_t)(hex & 0xFF),
         .annotation = EMPTY_ANNOTATION,
         .nInstruction = MEMORY_UNIT_NOT_INSTRUCTION
@@ -199,7 +456,7 @@ void addToMemoryHex2(Environment * env, hex2_t hex) {
     env->programCounter++;
 
     // Escreve o MSB
-    env->memory[env->programCounter] = env->memory[env->programCounter] = (memoryUnit_t) {
+    *env_write_unit(env, env->programCounter) = (memoryUnit_t) {
         .value = (hex1_t)(hex >> 8),
         .annotation = EMPTY_ANNOTATION,
         .nInstruction = MEMORY_UNIT_NOT_INSTRUCTION
@@ -211,9 +468,9 @@ void addToMemoryHex2(Environment * env, hex2_t hex) {
 
 int getLabelFromAddress(Environment * env, uhex2_t address) {
     // Procura o endereço
-    for (int i = 0; i < env->symbolCount; i++) {
+    for (size_t i = 0; i < env->symbolCount; i++) {
         if (env->symbolTable[i].value == address)
-            return i;
+            return (int)i;
     }
 
     return -1;
@@ -221,9 +478,9 @@ int getLabelFromAddress(Environment * env, uhex2_t address) {
 
 int getLabelFromName(Environment * env, char * name) {
     // Procura o endereço
-    for (int i = 0; i < env->symbolCount; i++) {
+    for (size_t i = 0; i < env->symbolCount; i++) {
         if (strcmp(env->symbolTable[i].name, name) == 0)
-            return i;
+            return (int)i;
     }
 
     return -1;
@@ -234,11 +491,12 @@ void addLabel(Environment * env, char * name, uhex2_t address) {
     // Verifica se já não existe esse nome.
     int i = getLabelFromName(env, name);
     if (i != -1)
-        WARN("Instrucao %d: ja existe um rotulo com o nome \"%s\".\n\t O novo rotulo ira sobrescrever o antigo.", env->currentInstruction, name);
+        E_WARN("Instrucao %d: ja existe um rotulo com o nome \"%s\".\n\t O novo rotulo ira sobrescrever o antigo.", env->currentInstruction, name);
 
-    // Salva esse endereço na Tabela de Símbolos com o nome dado
+    // Salva esse endereço na Tabela de Símbolos com o nome dado. O nome
+    // é copiado para o ambiente (não depende do texto do token).
     label_t label = {
-        .name = name,
+        .name = env_strdup(env, name),
         .value = address
     };
 
@@ -251,9 +509,9 @@ void addLabel(Environment * env, char * name, uhex2_t address) {
     // Se chegou até aqui, não encontrou um rótulo com o mesmo nome,
     // então cria um novo
     env->symbolCount++;
-    label_t * temp = realloc(env->symbolTable, sizeof(label_t) * env->symbolCount);
+    label_t * temp = env_resize(env->symbolTable, sizeof(label_t) * env->symbolCount);
     if (temp == NULL)
-        V_EXIT(EXIT_NO_MEMORY,"Nao ha memoria suficiente para salvar o rotulo \"%s\"", name);
+        E_EXIT(EXIT_NO_MEMORY,"Nao ha memoria suficiente para salvar o rotulo \"%s\"", name);
 
     temp[env->symbolCount - 1] = label;
 
@@ -268,7 +526,7 @@ uhex2_t getValueOfLabel(Environment * env, char * name) {
     // Procura o rótulo
     int label = getLabelFromName(env, name);
     if (label == -1) // se não encontrou, dá erro
-        V_EXIT(EXIT_INVALID_ARGUMENT, "Instrucao %d: O rotulo \"%s\" nao existe. ", env->currentInstruction, name);
+        E_EXIT(EXIT_INVALID_ARGUMENT, "Instrucao %d: O rotulo \"%s\" nao existe. ", env->currentInstruction, name);
 
     // Se chegou até aqui, encontrou, então retorna o endereço.
     return env->symbolTable[label].value;
@@ -276,7 +534,7 @@ uhex2_t getValueOfLabel(Environment * env, char * name) {
 
 void setInstructionNumberToLastMemoryUnit(Environment * env, int val) {
     if (env->isFirstPass) return;
-    env->memory[env->programCounter-1].nInstruction = val;
+    env_write_unit(env, env->programCounter-1)->nInstruction = val;
 }
 
 
@@ -287,7 +545,7 @@ void addInstruction(Environment * env, uhex1_t opcode) {
 
 void addInstructionWithHex1(Environment * env, uhex1_t opcode, hex1_t value) {
     addToMemoryHex1Annotation(env, opcode,
-        formatString("%s %xH", (char*)getInstructionName(opcode), (uhex1_t)value)
+        env_formatString(env, "%s %xH", (char*)getInstructionName(opcode), (uhex1_t)value)
         );
     setInstructionNumberToLastMemoryUnit(env, env->currentInstruction);
     addToMemoryHex1(env, value);
@@ -298,7 +556,7 @@ void addInstructionWithHex2(Environment * env, uhex1_t opcode, hex2_t value) {
         int i = getLabelFromAddress(env, value);
         if (i != -1) {
             addToMemoryHex1Annotation(env, opcode,
-        formatString(
+        env_formatString(env,
                 "%s %s\t\t(%s aponta para %xH)",
                 (char*)getInstructionName(opcode),
                 env->symbolTable[i].name,
@@ -308,42 +566,56 @@ void addInstructionWithHex2(Environment * env, uhex1_t opcode, hex2_t value) {
         );
         } else {
             addToMemoryHex1Annotation(env, opcode,
-        formatString("%s %x", (char*)getInstructionName(opcode), (uhex2_t)value)
+        env_formatString(env, "%s %x", (char*)getInstructionName(opcode), (uhex2_t)value)
         );
         }
 
     } else {
         addToMemoryHex1Annotation(env, opcode,
-        formatString("%s %xH", (char*)getInstructionName(opcode), (uhex2_t)value)
+        env_formatString(env, "%s %xH", (char*)getInstructionName(opcode), (uhex2_t)value)
         );
     }
     setInstructionNumberToLastMemoryUnit(env, env->currentInstruction);
     addToMemoryHex2(env, value);
 }
 
-char* getOnlyInstructionFromAnnotation(char* annotation) {
-    char* inst;
-    if (annotation == NULL || strcmp(annotation, EMPTY_ANNOTATION) == 0) {
-        inst = EMPTY_ANNOTATION;
-    } else {
-        inst = strtok(annotation, "\t");
+/**
+ * Copia para o buffer apenas a instrução da anotação (o texto até o
+ * primeiro '\t'), sem alterar a anotação.
+ * @param annotation a anotação
+ * @param buffer onde o texto será copiado
+ * @param size tamanho do buffer
+ * @return o buffer
+ */
+char* getOnlyInstructionFromAnnotation(const char* annotation, char* buffer, size_t size) {
+    if (size == 0)
+        return buffer;
+    if (annotation == NULL) {
+        buffer[0] = '\0';
+        return buffer;
     }
-    return inst;
+
+    size_t len = strcspn(annotation, "\t");
+    if (len >= size)
+        len = size - 1;
+    memcpy(buffer, annotation, len);
+    buffer[len] = '\0';
+    return buffer;
 }
 
-char* getInstructionByNumber(Environment * env, int n) {
+char* getInstructionByNumber(Environment * env, int n, char * buffer, size_t size) {
     for (size_t i = 0; i < env->usedAddressesSize; i++) {
-        int ni = env->memory[env->usedAddresses[i]].nInstruction;
-        if (ni != MEMORY_UNIT_NOT_INSTRUCTION && env->memory[env->usedAddresses[i]].nInstruction == n)
-            return getOnlyInstructionFromAnnotation(env->memory[env->usedAddresses[i]].annotation);
+        const memoryUnit_t * unit = &env_read_unit(env, env->usedAddresses[i]);
+        if (unit->nInstruction != MEMORY_UNIT_NOT_INSTRUCTION && unit->nInstruction == n)
+            return getOnlyInstructionFromAnnotation(unit->annotation, buffer, size);
     }
-    return EMPTY_ANNOTATION;
+    return getOnlyInstructionFromAnnotation(EMPTY_ANNOTATION, buffer, size);
 }
 
 void appendAnnotationToLastMemoryUnit(Environment * env, char * text) {
     if (env->isFirstPass) return;
-    env->memory[env->programCounter-1].annotation = formatString("%s, %s",
-        env->memory[env->programCounter-1].annotation, text);
+    memoryUnit_t * unit = env_write_unit(env, env->programCounter-1);
+    unit->annotation = env_formatString(env, "%s, %s", unit->annotation, text);
 }
 
 void setRegister(Environment * env, int reg, hex1_t value) {
@@ -371,29 +643,30 @@ void setRegister(Environment * env, int reg, hex1_t value) {
 
 void setMemory(Environment * env, uhex2_t address, hex1_t value) {
     if (isAddressUsed(env, address)) {
-        char* comp;
-        if (strcmp(env->memory[address].annotation,EMPTY_ANNOTATION) != 0) {
-            comp = formatString(
-                "Antes: %02xH\t(Anotacao: %s)\n\tDepois: %02xH\t(Anotacao: %s)",
-                (uhex1_t)env->memory[address].value,
-                env->memory[address].annotation,
+        const memoryUnit_t * unit = &env_read_unit(env, address);
+        if (strcmp(unit->annotation,EMPTY_ANNOTATION) != 0) {
+            E_WARN_AT(address,
+                "O endereco \"%4x\" da memoria esta sendo sobrescrito.\n\tAntes: %02xH\t(Anotacao: %s)\n\tDepois: %02xH\t(Anotacao: %s)",
+                address,
+                (uhex1_t)unit->value,
+                unit->annotation,
                 (uhex1_t)value,
                 EVAL_DEFINED_MEMORY_ANNOTATION);
         } else {
-            comp = formatString(
-                "Antes: %02xH\n\tDepois: %02xH(Anotacao: %s)",
-                (uhex1_t)env->memory[address].value,
+            E_WARN_AT(address,
+                "O endereco \"%4x\" da memoria esta sendo sobrescrito.\n\tAntes: %02xH\n\tDepois: %02xH(Anotacao: %s)",
+                address,
+                (uhex1_t)unit->value,
                 (uhex1_t)value,
                 EVAL_DEFINED_MEMORY_ANNOTATION);
         }
-        WARN(
-            "O endereco \"%4x\" da memoria esta sendo sobrescrito.\n\t%s",
-            address,
-            comp);
     }
 
-    env->memory[address].value = value;
-    env->memory[address].annotation = EVAL_DEFINED_MEMORY_ANNOTATION;
+    TRACE_WRITE(address, value);
+    DEBUGGER_WRITE(address, value);
+    memoryUnit_t * unit = env_write_unit(env, address);
+    unit->value = value;
+    unit->annotation = EVAL_DEFINED_MEMORY_ANNOTATION;
 }
 
 void setMemoryHex2(Environment * env, uhex2_t address, hex2_t value) {
@@ -405,47 +678,35 @@ void setMemoryHex2(Environment * env, uhex2_t address, hex2_t value) {
 }
 
 void setMemoryWithAnnotation(Environment * env, uhex2_t address, hex1_t value, const char * annotation) {
-    env->memory[address].value = value;
-    env->memory[address].annotation = strdup(annotation);
+    memoryUnit_t * unit = env_write_unit(env, address);
+    unit->value = value;
+    unit->annotation = env_strdup(env, annotation);
 }
 
-// env->memory[address]
-#define env_memory(address) env->memory[address]
-// env->memory[address].value
-#define env_memval(address) env_memory(address).value
-
 void print_memory(Environment * env) {
-    printf("\nMemoria RAM ================================\nEndereco\t| Conteudo\t| Simbolico\n");
-
-    qsort(env->usedAddresses, env->usedAddressesSize, sizeof(hex2_t), comp_hex2);
-
-    for (size_t i = 0; i < env->usedAddressesSize; i++) {
-        char* annotation = env_memory(env->usedAddresses[i]).annotation;
-        // é instrução
-        printf("%xH\t\t| %02xH \t\t| %s\n",
-        env->usedAddresses[i],
-        // Se for instrução, o valor guardado deverá ser lido como
-        // unsigned hex.
-        (uhex1_t)env_memval(env->usedAddresses[i]),
-        env_memory(env->usedAddresses[i]).annotation);
-    }
-    printf("\n");
+    // O texto inteiro é montado antes e escrito de uma vez (ver Dump/dump.h)
+    ErrorCode_t err = dump_memory(env, env->dump, env->out);
+    const char * path = env->dump != NULL ? env->dump->path : NULL;
+    if (err != EXIT_SUCCESS)
+        E_WARN("Nao foi possivel escrever a memoria em \"%s\".", path != NULL ? path : "saida padrao");
+    else if (path != NULL)
+        fprintf(env->out, "\nMemoria escrita em \"%s\"\n", path);
 }
 
 void print_flags(Environment * env) {
-    printf("Flags ================\nFlag           | Valor\n");
-    printf("S (Sinal)      | %d\n", env->flags[FLAG_S]);
-    printf("Z (Zero)       | %d\n\n", env->flags[FLAG_Z]);
+    fprintf(env->out, "Flags ================\nFlag           | Valor\n");
+    fprintf(env->out, "S (Sinal)      | %d\n", env->flags[FLAG_S]);
+    fprintf(env->out, "Z (Zero)       | %d\n\n", env->flags[FLAG_Z]);
 }
 
 void print_regs(Environment * env) {
-    printf("Registradores ========\nRegistrador    | Valor\n");
-    printf("A (Acumulador) | %xH\t\t(Binario: ", (uhex1_t)env->registers[ACCUMULATOR]);
-    print_binary(1, env->registers[ACCUMULATOR]); printf(")\n");
-    printf("B              | %xH\t\t(Binario: ", (uhex1_t)env->registers[REGISTER_B]);
-    print_binary(1, env->registers[REGISTER_B]); printf(")\n");
-    printf("C              | %xH\t\t(Binario: ", (uhex1_t)env->registers[REGISTER_C]);
-    print_binary(1, env->registers[REGISTER_C]); printf(")\n");
+    fprintf(env->out, "Registradores ========\nRegistrador    | Valor\n");
+    fprintf(env->out, "A (Acumulador) | %xH\t\t(Binario: ", (uhex1_t)env->registers[ACCUMULATOR]);
+    print_binary(env->out, 1, env->registers[ACCUMULATOR]); fprintf(env->out, ")\n");
+    fprintf(env->out, "B              | %xH\t\t(Binario: ", (uhex1_t)env->registers[REGISTER_B]);
+    print_binary(env->out, 1, env->registers[REGISTER_B]); fprintf(env->out, ")\n");
+    fprintf(env->out, "C              | %xH\t\t(Binario: ", (uhex1_t)env->registers[REGISTER_C]);
+    print_binary(env->out, 1, env->registers[REGISTER_C]); fprintf(env->out, ")\n");
 
 }
 
@@ -453,7 +714,7 @@ void print_regs(Environment * env) {
 void print_info(Environment * env) {
     print_memory(env);
     print_flags(env);
-    printf("Quantidade de instrucoes executadas: %ld\n", env->totalInstructions);
+    fprintf(env->out, "Quantidade de instrucoes executadas: %ld\n", env->totalInstructions);
 }
 
 void print_debug_info(Environment * env) {
@@ -463,12 +724,46 @@ void print_debug_info(Environment * env) {
     print_flags(env);
 }
 
-hex1_t get_1hex_from_in(Environment * env, uhex1_t flow) {
+/**
+ * Lê o próximo valor de entrada (das entradas fornecidas ou do fluxo)
+ */
+static hex1_t read_1hex_from_in(Environment * env, uhex1_t flow) {
+    // Se a porta tiver um dispositivo, o valor vem dele
+    device_t * device = device_at(env->devices, flow);
+    if (device != NULL) {
+        hex1_t value;
+        if (device_read(device, &value))
+            return value;
+        if (env->inputEnd == INPUT_END_ZERO)
+            return 0;
+        if (env->inputEnd == INPUT_END_REPEAT && device_restart(device) && device_read(device, &value))
+            return value;
+        E_EXIT(EXIT_NULL_ARGUMENT,
+            "Instrucao %d: a instrucao IN foi executada, mas o dispositivo \"%s\" da porta %02XH nao tem mais valores.",
+            env->currentInstruction, device->kind, flow);
+    }
+
+    // Se as entradas já foram fornecidas, usa a próxima
+    if (env->input != NULL) {
+        if (env->inputIndex >= env->inputSize) {
+            if (env->inputEnd == INPUT_END_ZERO)
+                return 0;
+            if (env->inputEnd == INPUT_END_REPEAT && env->inputSize > 0)
+                env->inputIndex = 0;
+            else
+                E_EXIT(EXIT_NULL_ARGUMENT,
+                    "Instrucao %d: a instrucao IN foi executada, mas todas as %zu entradas fornecidas ja foram usadas.",
+                    env->currentInstruction, env->inputSize);
+        }
+        return env->input[env->inputIndex++];
+    }
+
     stopWatch_s scanf_sw;
     stopWatch_start(&scanf_sw);
-    char in[MAX_LENGTH_SINGLE_HEX + 1 + 1];
-    if (_in_flow(flow) == stdinflow)
-        printf("\nEntrada atual: ");
+    char in[MAX_LENGTH_SINGLE_HEX + 1 + 1] = { 0 };
+    // Só pede a entrada se ela vier do terminal
+    if (_in_flow(flow) == stdin)
+        fprintf(env->out, "\nEntrada atual: ");
 
     fgets(in, MAX_LENGTH_SINGLE_HEX + 1 + 1, _in_flow(flow));
     // Remove o 'H' (e o \n)
@@ -483,21 +778,44 @@ hex1_t get_1hex_from_in(Environment * env, uhex1_t flow) {
     switch (c_exit) {
         case EXIT_SUCCESS: break;
         case EXIT_INVALID_ARGUMENT:
-            V_EXIT(EXIT_INVALID_ARGUMENT,
+            E_EXIT(EXIT_INVALID_ARGUMENT,
                 "A instrucao IN esperava um hexadecimal, mas recebeu \"%s\".\nVerifique se o numero esta na forma 12H.", in);
         case EXIT_NULL_ARGUMENT:
-            EXIT_CUSTOM_ERR(EXIT_NULL_ARGUMENT,
+            E_EXIT_CUSTOM_ERR(EXIT_NULL_ARGUMENT,
                 "A instrucao IN esperava um hexadecimal, mas recebeu nada.\nVerifique se o numero foi digitado corretamente e esta na forma 12H.");
 
         default: {
-            V_EXIT(EXIT_INVALID_ARGUMENT,
+            E_EXIT(EXIT_INVALID_ARGUMENT,
                 "A instrucao IN esperava um hexadecimal, mas recebeu um termo desconhecido: \"%s\"", in);
         }
     }
 
     // Para o cronômetro e não conta esse tempo como tempo de execução
     stopWatch_end(&scanf_sw);
-    env->params->real_max_time += seg_to_ms(stopWatch_timeElapsed(&scanf_sw));
+    env_params->real_max_time += seg_to_ms(stopWatch_timeElapsed(&scanf_sw));
     // Retorna o hexadecimal obtido
     return temp;
-}
\ No newline at end of file
+}
+
+hex1_t get_1hex_from_in(Environment * env, uhex1_t flow) {
+    // Ao voltar a execução no depurador, a entrada é a que já foi dada
+    // (antes do traço, que já passou dessa entrada)
+    hex1_t value;
+    if (env->debugger != NULL && debugger_logged_in(env, &value))
+        return value;
+
+    // Na reprodução de um traço, a entrada é a gravada
+    if (trace_is_replay(env)) {
+        value = trace_replay_in(env, flow);
+        if (env->debugger != NULL)
+            debugger_log_in(env, value);
+        return value;
+    }
+
+    value = read_1hex_from_in(env, flow);
+    if (env->trace != NULL)
+        trace_io(env, TRACE_EVENT_IN, flow, value);
+    if (env->debugger != NULL)
+        debugger_log_in(env, value);
+    return value;
+}
@@ -8,8 +8,14 @@
 #ifndef SAP2_COMPILER_ENVIRONMENT_H
 #define SAP2_COMPILER_ENVIRONMENT_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+
+#include "allocator.h"
+#include "diagnostics.h"
 
 #define NUMBER_OF_REGISTERS 3
 #define REGISTER_A 0
@@ -39,9 +45,10 @@
 // Maior quantidade de algarismos de um número com 1 hexadecimal
 #define MAX_LENGTH_SINGLE_HEX (2 + 1) // FFH
 
-// Macros que retornam a entrada/saída de cada byte
-#define _in_flow(x) stdin
-#define _out_flow(x) stdout
+// Macros que retornam a entrada/saída de cada byte (do ambiente "env"),
+// usadas pelas portas sem dispositivo (ver env->devices)
+#define _in_flow(x) (env->in)
+#define _out_flow(x) (env->out)
 
 #define stdoutflow _out_flow(0)
 #define stdinflow _in_flow(0)
@@ -49,14 +56,24 @@
 // Quantos T-States são precisos para alterar o PC
 #define _ts_to_change_pc 3
 
-#define env_params env->params
+#define env_params (&env->params)
+
+// Frequência do relógio do SAP2 (1 T-State = 1 microssegundo)
+#define SAP2_CLOCK_HZ 1000000
+
+// Simula a passagem de "ts" T-States (1 T-State = 1 microssegundo, se
+// a execução for cadenciada) e os conta no ambiente "env"
+#define env_spend_tstates(ts) do { \
+    if (env_params->paced) sleep_us(ts); \
+    env->totalTStates += (ts); \
+} while (0)
 
 #define print_hex(f, xv) do { \
     fprintf(f, "%xH (Decimal: %d)\n", (uhex1_t)xv, xv); \
     } while (0);
 #define print_binary_hex(f, sz, xv) do { \
     fprintf(f, "%xH (Decimal: %d  | Binario: ", (uhex1_t)xv, xv); \
-    print_binary(sz, xv); fprintf(f, ")\n"); \
+    print_binary(f, sz, xv); fprintf(f, ")\n"); \
 } while (0);
 
 // Valor de um hexadecimal (0xFF)
@@ -74,6 +91,7 @@ typedef uint16_t uhex2_t;
 #define STANDARD_MAX_EVALUATE (-1)
 #define STANDARD_MAX_TIME (10000)
 #define STANDARD_DEBUG false
+#define STANDARD_PACED true
 // Os parâmetros para a interpretação do arquivo dado
 typedef struct {
     // Endereço que o contador de programa iniciará
@@ -91,8 +109,37 @@ typedef struct {
     double real_max_time;
     // Se o modo de depuração está ativo
     bool debug_mode;
+    // Se a execução espera o tempo de cada T-State (como um relógio de
+    // 1 MHz). Se não, executa o mais rápido possível.
+    bool paced;
 } Parametros;
 
+// Bloco da arena de textos de um ambiente (anotações, nomes dos rótulos...)
+typedef struct arenaBlock_s {
+    struct arenaBlock_s * next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} arenaBlock_t;
+#define ARENA_BLOCK_SIZE 4096
+
+// Vetor de valores (usado para guardar as saídas em memória)
+typedef struct {
+    hex1_t * values;
+    size_t count;
+    size_t capacity;
+} hexBuffer_t;
+
+// O que o IN faz quando as entradas fornecidas acabam
+typedef enum {
+    // Encerra a execução com um erro
+    INPUT_END_ERROR,
+    // Lê 0
+    INPUT_END_ZERO,
+    // Volta para a primeira entrada
+    INPUT_END_REPEAT
+} inputEnd_t;
+
 // Rótulo
 typedef struct {
     char* name;
@@ -111,14 +158,33 @@ typedef struct {
 #define EVAL_DEFINED_MEMORY_ANNOTATION "Valor definido por uma instrucao" // Quando o trecho é definido por um setMemory()
 #define MEMORY_UNIT_NOT_INSTRUCTION (-1)
 
+// A memória é dividida em páginas de 256 endereços. As páginas podem
+// ser compartilhadas entre um ambiente e as suas cópias (env_clone):
+// uma página só é duplicada quando alguém escreve nela enquanto ela
+// ainda está sendo usada por outro ambiente (copy-on-write).
+#define MEMORY_PAGE_BITS 8
+#define MEMORY_PAGE_SIZE (1 << MEMORY_PAGE_BITS) // 256 endereços
+#define MEMORY_PAGE_COUNT ((UHEX2_MAX + 1) / MEMORY_PAGE_SIZE) // 256 páginas
+typedef struct {
+    // Quantos ambientes usam essa página
+    atomic_int references;
+    memoryUnit_t units[MEMORY_PAGE_SIZE];
+} memoryPage_t;
+
+// Unidade de memória do endereço dado, apenas para leitura. Para
+// escrever, use env_write_unit.
+#define env_read_unit(env, address) \
+    ((env)->pages[(uhex2_t)(address) >> MEMORY_PAGE_BITS]->units[(uhex2_t)(address) & (MEMORY_PAGE_SIZE - 1)])
+
 // Ambiente do SAP2
 typedef struct {
-    // A memória RAM
-    memoryUnit_t * memory;
+    // A memória RAM (tabela de páginas). Páginas que nunca foram
+    // escritas apontam para uma página zerada compartilhada.
+    memoryPage_t * pages[MEMORY_PAGE_COUNT];
     // Último endereço usado no escopo principal do programa
     uhex2_t programCounter;
     // Registradores
-    hex1_t * registers;
+    hex1_t registers[NUMBER_OF_REGISTERS];
     // Tabela de Símbolos
     label_t * symbolTable;
     size_t symbolCount;
@@ -128,11 +194,13 @@ typedef struct {
     bool isFirstPass;
 
     // Extras //
-    // Os parâmetros passados para o usuário
-    Parametros * params;
+    // Os parâmetros passados pelo usuário (cópia própria do ambiente)
+    Parametros params;
     // Instrução atual (quantas instruções já se passaram)
     int currentInstruction;
     long totalInstructions;
+    // Quantidade de T-States simulados (contando os pulos tomados)
+    uint64_t totalTStates;
     // Endereços usados
     uhex2_t * usedAddresses;
     // Quantidade de endereços usados
@@ -145,8 +213,156 @@ typedef struct {
     hex1_t hex_print_buffer;
     // O valor do fluxo de dados que está esperando para ser usado.
     hex2_t hex_flow_buffer;
+
+    // Recursos do ambiente //
+    // Entrada (IN) e saída (OUT) de dados
+    FILE * in;
+    FILE * out;
+    // Onde os avisos e erros são impressos
+    diagnostics_t diagnostics;
+    // Alocador de memória
+    allocator_t allocator;
+    // Arena dos textos (anotações e nomes de rótulos)
+    arenaBlock_t * strings;
+    // Se é uma cópia de outro ambiente (ver env_clone). A cópia usa os
+    // rótulos, as anotações e os endereços usados do original.
+    bool isClone;
+
+    // Entradas já fornecidas, usadas pelo IN no lugar de "in" (NULL se não houver)
+    const hex1_t * input;
+    size_t inputSize;
+    // Próxima entrada que será usada
+    size_t inputIndex;
+    // O que o IN faz quando as entradas (ou os valores de um dispositivo) acabam
+    inputEnd_t inputEnd;
+    // Se não for NULL, os valores do OUT são guardados aqui ao invés de impressos
+    hexBuffer_t * capturedOutput;
+    // Destino dos valores do OUT (NULL para imprimir em "out" a cada
+    // valor, ver Output/output.h)
+    struct outputSink_s * output;
+    // Se o depurador está refazendo instruções que já tinham sido
+    // executadas: o OUT não é enviado de novo ao destino nem aos
+    // dispositivos
+    bool replaying;
+    // Dispositivos ligados às portas do IN/OUT (NULL se não houver,
+    // ver Devices/devices.h). As portas sem dispositivo usam "in"/"out".
+    struct deviceTable_s * devices;
+    // Como a memória é impressa no HLT (NULL para a tabela de sempre,
+    // ver Dump/dump.h)
+    const struct memoryDump_s * dump;
+    // Traço sendo gravado ou reproduzido (NULL se não houver, ver Trace/trace.h)
+    struct trace_s * trace;
+    // Depurador do ambiente (NULL se não houver, ver Debugger/debugger.h)
+    struct debugger_s * debugger;
+    // Perfil da execução (NULL se não houver, ver Profiler/profiler.h)
+    struct profile_s * profile;
 } Environment;
 
+/**
+ * Cria um ambiente do SAP2 com a memória zerada. O ambiente usa a
+ * entrada/saída padrão até que "in"/"out" sejam alterados.
+ * @param params os parâmetros da execução (são copiados)
+ * @param allocator o alocador que o ambiente usará (NULL para o padrão)
+ * @return o ambiente (NULL se não houver memória)
+ */
+Environment * env_create(const Parametros * params, const allocator_t * allocator);
+
+/**
+ * Libera o ambiente e tudo que pertence a ele (memória, rótulos, anotações...)
+ * @param env o ambiente do SAP2
+ */
+void env_destroy(Environment * env);
+
+/**
+ * Cria uma cópia do ambiente dado (um programa já montado), com os
+ * próprios registradores e flags. A cópia só copia a tabela de páginas:
+ * as páginas de memória são compartilhadas e só são duplicadas quando
+ * alguém escreve nelas. Os rótulos e as anotações continuam sendo do
+ * original, então ele não pode ser alterado nem liberado enquanto
+ * houver cópias. Várias cópias podem ser criadas e executadas ao mesmo
+ * tempo a partir do mesmo original. O destino da saída, os dispositivos,
+ * a impressão da memória, a saída capturada e o tratamento dos erros
+ * fatais não são copiados (ficam NULL): quem executa a cópia define os
+ * dele.
+ * @param image o ambiente original
+ * @return a cópia (NULL se não houver memória)
+ */
+Environment * env_clone(const Environment * image);
+
+/**
+ * Volta o estado da máquina (memória, registradores, flags, contador de
+ * programa e contadores da execução) para o de uma cópia feita antes
+ * com env_clone. Os recursos do ambiente (entrada, saída, parâmetros...)
+ * não são alterados e as páginas passam a ser compartilhadas com a cópia.
+ * @param env o ambiente do SAP2
+ * @param from a cópia
+ */
+void env_copy_state(Environment * env, const Environment * from);
+
+/**
+ * Retorna a unidade de memória do endereço dado para escrita. Se a
+ * página do endereço for compartilhada com outro ambiente (ou for a
+ * página zerada), ela é duplicada antes.
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @return a unidade de memória, que só pertence a esse ambiente
+ */
+memoryUnit_t * env_write_unit(Environment * env, uhex2_t address);
+
+/**
+ * Retorna se a página dada já foi escrita (se não é a página zerada)
+ * @param env o ambiente do SAP2
+ * @param index o número da página (endereço >> MEMORY_PAGE_BITS)
+ * @return se a página já foi escrita
+ */
+bool env_is_page_used(const Environment * env, int index);
+
+/**
+ * Define as entradas que o IN vai usar (em ordem) ao invés de ler do
+ * fluxo de entrada. Os valores não são copiados.
+ * @param env o ambiente do SAP2
+ * @param values os valores de entrada
+ * @param size a quantidade de valores
+ */
+void env_set_input(Environment * env, const hex1_t * values, size_t size);
+
+/**
+ * Adiciona um valor ao fim do vetor
+ * @param buffer o vetor
+ * @param value o valor
+ * @return o código de erro
+ */
+ErrorCode_t hexBuffer_push(hexBuffer_t * buffer, hex1_t value);
+
+/**
+ * Copia o texto dado para a arena do ambiente. O texto é liberado
+ * junto com o ambiente.
+ * @param env o ambiente do SAP2
+ * @param text o texto
+ * @return a cópia do texto
+ */
+char * env_strdup(Environment * env, const char * text);
+
+/**
+ * Copia os bytes dados para a arena do ambiente. A cópia é liberada
+ * junto com o ambiente.
+ * @param env o ambiente do SAP2
+ * @param data os bytes
+ * @param size a quantidade de bytes
+ * @return a cópia
+ */
+void * env_memdup(Environment * env, const void * data, size_t size);
+
+/**
+ * Formata um texto no estilo "printf" na arena do ambiente. O texto é
+ * liberado junto com o ambiente.
+ * @param env o ambiente do SAP2
+ * @param format texto base
+ * @param ... valores do texto
+ * @return o texto formatado
+ */
+char * env_formatString(Environment * env, const char * format, ...);
+
 /**
  * Retorna o inteiro que representa o respectivo registrador
  * @param c caractere com a letra que representa um registrador
@@ -187,6 +403,22 @@ int isAddressUsed(Environment * env, uhex2_t address);
  */
 void addLabel(Environment * env, char * name, uhex2_t address);
 
+/**
+ * Procura o rótulo ligado ao endereço dado
+ * @param env o ambiente do SAP2
+ * @param address o endereço
+ * @return a posição do rótulo na tabela de símbolos (-1 se não houver)
+ */
+int getLabelFromAddress(Environment * env, uhex2_t address);
+
+/**
+ * Procura o rótulo com o nome dado
+ * @param env o ambiente do SAP2
+ * @param name o nome do rótulo
+ * @return a posição do rótulo na tabela de símbolos (-1 se não houver)
+ */
+int getLabelFromName(Environment * env, char * name);
+
 /**
  * Obtém o endereço de memória ligado ao nome dado
  * @param env o ambiente do SAP2
@@ -227,12 +459,14 @@ void addInstructionWithHex1(Environment * env, uhex1_t opcode, hex1_t value);
 void addInstructionWithHex2(Environment * env, uhex1_t opcode, hex2_t value);
 
 /**
- * Retorna o simbólico da n-ésima instrução.
+ * Copia o simbólico da n-ésima instrução para o buffer dado.
  * @param env o ambiente do SAP2
  * @param n o número da instrução
- * @return o texto da instrução (simbólico)
+ * @param buffer onde o texto será copiado
+ * @param size tamanho do buffer
+ * @return o texto da instrução (simbólico), que é o próprio buffer
  */
-char* getInstructionByNumber(Environment * env, int n);
+char* getInstructionByNumber(Environment * env, int n, char * buffer, size_t size);
 
 /**
  * Define o registrador dado com o valor dado e, se for o
@@ -270,7 +504,8 @@ void setMemoryHex2(Environment * env, uhex2_t address, hex2_t value);
 void setMemoryWithAnnotation(Environment * env, uhex2_t address, hex1_t value, const char * annotation);
 
 /**
- * Imprime a memória do SAP2
+ * Imprime a memória do SAP2 (no formato, nas faixas e no destino do
+ * "dump" do ambiente)
  * @param env o ambiente do SAP2
  */
 void print_memory(Environment * env);
@@ -294,7 +529,8 @@ void print_info(Environment * env);
 void print_debug_info(Environment * env);
 
 /**
- * Lê um hexadecimal do fluxo de dados de entrada dado
+ * Lê um hexadecimal do fluxo de dados de entrada dado (ou a próxima
+ * entrada já fornecida, se houver)
  * @param flow o número que representa o lugar do fluxo de dados
  * @return Hexadecimal lido
  */
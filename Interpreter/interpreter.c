@@ -5,6 +5,7 @@
 // Date: 19/09/2025
 //
 
+#include <setjmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +14,8 @@
 #include "environment.h"
 #include "Analysis/tokenizer.h"
 #include "Analysis/parser.h"
+#include "Devices/devices.h"
+#include "Output/output.h"
 #include "Runtime/evaluate.h"
 #include "Utils/Utils.h"
 
@@ -24,61 +27,49 @@ Parametros * get_standard_parameters() {
     params->hlt_prints_memory = STANDARD_HLT_PRINTS_MEMORY;
     params->max_evaluated = STANDARD_MAX_EVALUATE;
     params->max_time = STANDARD_MAX_TIME;
+    params->real_max_time = STANDARD_MAX_TIME;
     params->debug_mode = STANDARD_DEBUG;
+    params->paced = STANDARD_PACED;
 
     return params;
 }
 
-// Interpreta o arquivo
-ErrorCode_t interpret(FILE * file, Parametros * params) {
-
-    // Inicializa os parâmetros
-    params->real_max_time = params->max_time;
+/**
+ * Libera os tokens e o vetor deles
+ * @param tokens o vetor de tokens
+ * @param size o tamanho do vetor
+ */
+static void free_tokens(Token_t * tokens, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        free(tokens[i].value);
+    }
+    free(tokens);
+}
 
+ErrorCode_t assemble(Environment * env, FILE * file) {
     // Obtem os tokens do arquivo
     Token_t * tokens = NULL;
     size_t tokens_size = 0;
 
-    ErrorCode_t err = tokenize(file, &tokens, &tokens_size);
+    ErrorCode_t err = tokenize(file, &tokens, &tokens_size, &env->diagnostics);
     if (err != EXIT_SUCCESS || tokens == NULL || tokens[0].type == TokenType_EOF) {
+        free_tokens(tokens, tokens_size);
         // Retorna o erro
-        return err;
+        return err != EXIT_SUCCESS ? err : EXIT_NO_INSTRUCTION;
     }
 
-    // Inicializa o ambiente do SAP2
-    Environment env = {
-        .memory = calloc(MEMORY_SIZE, sizeof(memoryUnit_t)),
-        .programCounter = params->start_address,
-        .registers = calloc(NUMBER_OF_REGISTERS, sizeof(hex1_t)),
-        .symbolTable = NULL,
-        .symbolCount = 0,
-
-        .params = params,
-        .currentInstruction = 0,
-        .totalInstructions = 0,
-        .usedAddresses = NULL,
-        .usedAddressesSize = 0,
-        .hex_print_buffer = 0,
-    };
-    env.flags[FLAG_S] = 0;
-    // flag de 0 começa inicializado, uma vez que os valores
-    // começam zerados
-    env.flags[FLAG_Z] = 1;
-
-    // Se não conseguir alocar, retorna um erro
-    if (env.memory == NULL || env.registers == NULL) {
-        // Libera os tokens
-        for (size_t i = 0; i < tokens_size; i++) {
-            free(tokens[i].value);
+    // Se o ambiente tem um ponto de recuperação, os tokens precisam
+    // ser liberados antes de voltar para ele
+    jmp_buf * outer = env->diagnostics.on_fatal;
+    jmp_buf on_parse_fatal;
+    if (outer != NULL) {
+        int code = setjmp(on_parse_fatal);
+        if (code != 0) {
+            env->diagnostics.on_fatal = outer;
+            free_tokens(tokens, tokens_size);
+            longjmp(*outer, code);
         }
-        free(tokens);
-
-        // Libera o ambiente
-        free(env.memory);
-        free(env.registers);
-
-        // Avisa o usuário e retorna
-        RETURN_ERR(EXIT_NO_MEMORY);
+        env->diagnostics.on_fatal = &on_parse_fatal;
     }
 
     // Chama o parser para entender o código.
@@ -86,14 +77,28 @@ ErrorCode_t interpret(FILE * file, Parametros * params) {
     // que é uma representação do código. No entanto, como
     // estamos lidando com uma simulação do SAP2, eu preferi
     // fazer essa "representação" na memória.
-    parse(tokens, tokens_size, &env);
+    parse(tokens, tokens_size, env);
+    env->diagnostics.on_fatal = outer;
+
+    // O ambiente não depende dos tokens (os rótulos e anotações
+    // são copiados), então eles já podem ser liberados
+    free_tokens(tokens, tokens_size);
 
     // Reinicia o contador de programa
-    env.programCounter = params->start_address;
-    env.currentInstruction = 1;
+    env->programCounter = env_params->start_address;
+    env->currentInstruction = 1;
+
+    return EXIT_SUCCESS;
+}
 
+ErrorCode_t run(Environment * env) {
     // Avalia(executa) o código
-    ErrorCode_t exit_code = evaluate(&env);
+    ErrorCode_t exit_code = evaluate(env);
+    // Os valores do OUT que ainda estão no buffer (se não parou no HLT)
+    if (env->output != NULL)
+        output_flush(env->output);
+    if (env->devices != NULL)
+        devices_flush(env->devices);
 
     // Fim do código //
 
@@ -101,29 +106,103 @@ ErrorCode_t interpret(FILE * file, Parametros * params) {
     // Obs.: A verificação de "env->usedAddressesSize > 0" é praticamente desnecessária,
     // já que, para chegar aqui, precisaria de ter o OPCODE do HLT na memória
     // (portanto, algum endereço da memória foi usado).
-    if (env.usedAddressesSize > 0 && env.params->hlt_prints_memory) {
-        print_info(&env);
+    if (env->usedAddressesSize > 0 && env_params->hlt_prints_memory) {
+        print_info(env);
     }
 
     // Verifica se a última instrução foi um HLT. Se
     // não for, avisa ao usuário.
-    if (env.last_instruction.value != OPCODE_HLT) {
-        WARN(
+    if (env->last_instruction.value != OPCODE_HLT) {
+        E_WARN(
             "A ultima instrucao do codigo foi \"%s\" (Instrucao %d)\nao inves de um HLT! Certifique-se de colocar uma instrucao HLT\nno fim de seu codigo.",
-            env.last_instruction.annotation,
-            env.last_instruction.nInstruction);
+            env->last_instruction.annotation,
+            env->last_instruction.nInstruction);
     }
 
-    // Libera os tokens
-    for (size_t i = 0; i < tokens_size; i++) {
-        free(tokens[i].value);
+    // Quantas vezes os avisos se repetiram
+    diagnostics_summary(&env->diagnostics);
+
+    return exit_code;
+}
+
+ErrorCode_t interpret_env(Environment * env, FILE * file) {
+    // Ponto de recuperação dos erros fatais desse ambiente
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    int code = setjmp(on_fatal);
+    if (code != 0) {
+        env->diagnostics.on_fatal = previous;
+        return (ErrorCode_t)code;
     }
-    free(tokens);
+    env->diagnostics.on_fatal = &on_fatal;
+
+    ErrorCode_t exit_code = assemble(env, file);
+    if (exit_code == EXIT_SUCCESS)
+        exit_code = run(env);
+    else if (exit_code == EXIT_NO_INSTRUCTION)
+        exit_code = EXIT_SUCCESS; // arquivo vazio
+
+    env->diagnostics.on_fatal = previous;
+    return exit_code;
+}
+
+ErrorCode_t assemble_env(Environment * env, FILE * file) {
+    // Ponto de recuperação dos erros fatais desse ambiente
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    int code = setjmp(on_fatal);
+    if (code != 0) {
+        env->diagnostics.on_fatal = previous;
+        return (ErrorCode_t)code;
+    }
+    env->diagnostics.on_fatal = &on_fatal;
+
+    ErrorCode_t exit_code = assemble(env, file);
+
+    env->diagnostics.on_fatal = previous;
+    return exit_code;
+}
+
+ErrorCode_t run_env(Environment * env) {
+    // Ponto de recuperação dos erros fatais desse ambiente
+    jmp_buf * previous = env->diagnostics.on_fatal;
+    jmp_buf on_fatal;
+    int code = setjmp(on_fatal);
+    if (code != 0) {
+        env->diagnostics.on_fatal = previous;
+        return (ErrorCode_t)code;
+    }
+    env->diagnostics.on_fatal = &on_fatal;
+
+    ErrorCode_t exit_code = run(env);
+
+    env->diagnostics.on_fatal = previous;
+    return exit_code;
+}
+
+// Interpreta o arquivo
+ErrorCode_t interpret(FILE * file, Parametros * params) {
+
+    // Inicializa o ambiente do SAP2
+    Environment * env = env_create(params, NULL);
+
+    // Se não conseguir alocar, retorna um erro
+    if (env == NULL) {
+        RETURN_ERR(EXIT_NO_MEMORY);
+    }
+
+    ErrorCode_t exit_code = assemble(env, file);
+    if (exit_code == EXIT_SUCCESS)
+        exit_code = run(env);
+    else if (exit_code == EXIT_NO_INSTRUCTION)
+        exit_code = EXIT_SUCCESS; // arquivo vazio
+
+    // Devolve os parâmetros finais (o tempo máximo pode ter sido
+    // estendido pela depuração ou pelas entradas)
+    *params = env->params;
 
     // Libera o ambiente depois das execuções
-    free(env.memory);
-    free(env.registers);
+    env_destroy(env);
 
-    // Retorna sucesso
     return exit_code;
-}
\ No newline at end of file
+}
@@ -13,9 +13,55 @@
 #include "ErrorCodes.h"
 #include "environment.h"
 
-// Interpreta o arquivo
+// Interpreta o arquivo. Ao terminar, "parametros" recebe os
+// valores finais dos parâmetros do ambiente (como o real_max_time).
 ErrorCode_t interpret(FILE * file, Parametros * parametros);
 
 Parametros * get_standard_parameters();
 
-#endif //SAP2_COMPILER_INTERPRETER_H
\ No newline at end of file
+/**
+ * Monta (tokeniza e analisa) o código do arquivo na memória do ambiente
+ * e deixa o contador de programa no endereço inicial.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo com o código
+ * @return o código de erro (EXIT_NO_INSTRUCTION se o arquivo estiver vazio)
+ */
+ErrorCode_t assemble(Environment * env, FILE * file);
+
+/**
+ * Executa o código já montado no ambiente e, no fim, imprime as
+ * informações do ambiente (se os parâmetros pedirem).
+ * @param env o ambiente do SAP2
+ * @return o código de erro
+ */
+ErrorCode_t run(Environment * env);
+
+/**
+ * Monta e executa o arquivo no ambiente dado. Diferente de interpret(),
+ * um erro fatal não encerra o programa: ele só encerra esse ambiente e
+ * o código do erro é retornado. Pode ser usado em várias threads ao
+ * mesmo tempo (um ambiente por thread).
+ * @param env o ambiente do SAP2
+ * @param file o arquivo com o código
+ * @return o código de erro
+ */
+ErrorCode_t interpret_env(Environment * env, FILE * file);
+
+/**
+ * Monta o arquivo no ambiente dado (como assemble()), mas um erro
+ * fatal só encerra esse ambiente e o código do erro é retornado.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo com o código
+ * @return o código de erro (EXIT_NO_INSTRUCTION se o arquivo estiver vazio)
+ */
+ErrorCode_t assemble_env(Environment * env, FILE * file);
+
+/**
+ * Executa o código já montado no ambiente dado (como run()), mas um
+ * erro fatal só encerra esse ambiente e o código do erro é retornado.
+ * @param env o ambiente do SAP2
+ * @return o código de erro
+ */
+ErrorCode_t run_env(Environment * env);
+
+#endif //SAP2_COMPILER_INTERPRETER_H
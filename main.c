@@ -4,6 +4,19 @@
 
 #include "Interpreter/ErrorCodes.h"
 #include "Interpreter/interpreter.h"
+#include "Interpreter/Batch/batch.h"
+#include "Interpreter/Batch/sweep.h"
+#include "Interpreter/Bench/bench.h"
+#include "Interpreter/Debugger/gdbstub.h"
+#include "Interpreter/Devices/devices.h"
+#include "Interpreter/Dump/dump.h"
+#include "Interpreter/Input/input.h"
+#include "Interpreter/Output/output.h"
+#include "Interpreter/Profiler/profiler.h"
+#include "Interpreter/Profiler/sampler.h"
+#include "Interpreter/Server/forkserver.h"
+#include "Interpreter/Snapshot/snapshot.h"
+#include "Interpreter/Trace/trace.h"
 #include "Interpreter/Utils/Utils.h"
 
 // Compara o argumento atual com a string dada
@@ -12,24 +25,103 @@
 // Compara o argumento atual com a string dada e a forma reduzida dela
 #define cmp_curr_str_r(s, r) \
     (strcmp(argv[i], s) == 0 || strcmp(argv[i], r) == 0)
+// Erro em um parâmetro (dentro de readParametros): encerra o programa
+// ou, se foi dado onde guardar o erro, guarda a mensagem e retorna
+#define PARAM_ERROR(E, format, ...) do { \
+    if (erro == NULL) \
+        V_EXIT(E, format, __VA_ARGS__); \
+    snprintf(erro, tamanho_erro, format, __VA_ARGS__); \
+    return E; \
+} while (0)
 // Incrementa e verifica o i
 #define inr \
     i++; \
     if (i >= argc) { \
-        V_EXIT(EXIT_NULL_ARGUMENT, "Um valor eh esperado depois do parametro %s.", argv[i-1]);   \
+        PARAM_ERROR(EXIT_NULL_ARGUMENT, "Um valor eh esperado depois do parametro %s.", argv[i-1]);   \
     } \
 
-Parametros * getParametros(int argc, char ** argv) {
-    Parametros * parametros = get_standard_parameters();
+// Quantidade máxima de parâmetros em uma linha da lista do lote
+#define MAX_JOB_ARGS 64
+
+// Opções da linha de comando que não são parâmetros da interpretação
+typedef struct {
+    // Diretório ou lista de programas do modo lote (NULL se não for lote)
+    char * lote;
+    // Quantidade de threads do modo lote (0 para a quantidade de núcleos)
+    int threads;
+    // Se o relatório do lote mostra a saída de cada programa
+    bool mostrar_saidas;
+    // Arquivo com os vetores de entrada da varredura (NULL se não for varredura)
+    char * varredura;
+    // Se a varredura usa todos os 256 valores de um byte
+    bool varredura_completa;
+    // Arquivo onde o estado é salvo no fim da execução (NULL se não for salvo)
+    char * salvar_estado;
+    // Se atende pedidos de execução pela entrada padrão (um fork por pedido)
+    bool servidor_fork;
+    // Arquivo onde o traço da execução é gravado (NULL se não for gravado)
+    char * gravar_traco;
+    // Arquivo do traço que é reproduzido (NULL se não for reproduzido)
+    char * reproduzir_traco;
+    // Porta TCP ou socket Unix onde o depurador (GDB) conecta (NULL se não houver)
+    char * gdb;
+    // Arquivo onde o perfil da execução é gravado (NULL se não houver perfil)
+    char * perfil;
+    // Arquivo onde as amostras do interpretador são gravadas (NULL se não houver)
+    char * amostrar;
+    // Se mede o desempenho da execução (sem esperar os T-States)
+    bool desempenho;
+    // Se o resumo do fim também é impresso em uma linha para outros programas
+    bool resumo_linha;
+    // Formato dos valores do OUT
+    outputFormat_t formato_saida;
+    // Arquivo ou "|comando" que recebe os valores do OUT (NULL para a saída padrão)
+    char * destino_saida;
+    // Quando os valores do OUT são descarregados
+    outputFlush_t descarga_saida;
+    // Quantidade de valores entre as descargas (se for a cada N valores)
+    int descarga_valores;
+    // Tamanho do anel até a thread que escreve os valores do OUT (0 se o OUT escreve direto)
+    size_t anel_saida;
+    // O que o OUT faz quando o anel está cheio
+    outputFull_t anel_cheio;
+    // Dispositivos ligados às portas (NULL se não houver)
+    deviceTable_t * dispositivos;
+    // Entradas do IN lidas do arquivo do --entrada (NULL se não houver)
+    hex1_t * entrada;
+    size_t entrada_tamanho;
+    // O que o IN faz quando as entradas (ou os valores de um dispositivo) acabam
+    inputEnd_t fim_entrada;
+    // Como a memória é impressa no HLT
+    memoryDump_t memoria;
+    // Quais avisos são impressos
+    warningLevel_t avisos;
+} OpcoesCLI;
 
-    for (int i = 2; i < argc; i++) {
+/**
+ * Lê os parâmetros dados (a partir do argumento "first") e os guarda
+ * nos parâmetros dados.
+ * @param parametros onde os parâmetros são guardados
+ * @param opcoes onde as opções da linha de comando são guardadas
+ * (NULL se elas não forem permitidas, como em uma linha do lote)
+ * @param argc quantidade de argumentos
+ * @param argv os argumentos
+ * @param first o primeiro argumento que é um parâmetro
+ * @param erro onde a mensagem de um parâmetro inválido é guardada (NULL
+ * para encerrar o programa)
+ * @param tamanho_erro o tamanho de "erro"
+ * @return o código de erro (só se "erro" foi dado)
+ */
+ErrorCode_t readParametros(Parametros * parametros, OpcoesCLI * opcoes, int argc, char ** argv, int first,
+                           char * erro, size_t tamanho_erro) {
+    for (int i = first; i < argc; i++) {
         if (strcmp(argv[i], "--inicio") == 0 || strcmp(argv[i], "-i") == 0) {
             inr;
             hex2_t inicio;
             if (str_to_hex2(argv[i], &inicio) == EXIT_SUCCESS ) {
                 parametros->start_address = (uhex2_t)inicio;
             } else {
-                V_EXIT(
+                PARAM_ERROR(
                 EXIT_INVALID_ARGUMENT,
 "O parametro \"%s\" espera um hexadecimal mas foi encontrado o valor \"%s\".\n       Verifique se:\n\t- Esse valor esta no formato de um hexadecimal \"1234H\";\n\t- Se esse valor nao foi escrito no lugar errado;\n\t- Se ha apenas um espaco entre o parametro e o valor.",
                 argv[i-1],
@@ -42,7 +134,7 @@ Parametros * getParametros(int argc, char ** argv) {
             char* endptr = NULL;
             int v = (int) strtol(argv[i], &endptr, 10);
             if (strlen(endptr) > 0) {
-                V_EXIT(EXIT_INVALID_ARGUMENT,
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
                 "O parametro \"%s\" espera um inteiro positivo depois mas foi encontrado o valor \"%s\".\nVerifique se esse valor eh um numero inteiro positivo.",
                 argv[i-1],
                 argv[i]
@@ -55,7 +147,7 @@ Parametros * getParametros(int argc, char ** argv) {
             char* endptr = NULL;
             double v = strtod(argv[i], &endptr);
             if (strlen(endptr) > 0 || v < 0) {
-                V_EXIT(EXIT_INVALID_ARGUMENT,
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
                 "O parametro \"%s\" espera um double positivo depois mas foi encontrado o valor \"%s\".\nVerifique se esse valor eh um numero inteiro positivo.",
                 argv[i-1],
                 argv[i]
@@ -69,6 +161,177 @@ Parametros * getParametros(int argc, char ** argv) {
         else if (cmp_curr_str_r("--debug", "-d") || cmp_curr_str_r("--passo-a-passo", "-p")) {
             parametros->debug_mode = true;
         }
+        else if (opcoes != NULL && cmp_curr_str_r("--threads", "-t")) {
+            inr;
+            char* endptr = NULL;
+            int v = (int) strtol(argv[i], &endptr, 10);
+            if (strlen(endptr) > 0 || v < 0) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera um inteiro positivo depois mas foi encontrado o valor \"%s\".\nVerifique se esse valor eh um numero inteiro positivo.",
+                argv[i-1],
+                argv[i]
+                );
+            }
+            opcoes->threads = v;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--mostrar-saidas", "-ms")) {
+            opcoes->mostrar_saidas = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--varredura", "-v")) {
+            inr;
+            opcoes->varredura = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--varredura-completa", "-vc")) {
+            opcoes->varredura_completa = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--servidor-fork", "-sf")) {
+            opcoes->servidor_fork = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--salvar-estado", "-se")) {
+            inr;
+            opcoes->salvar_estado = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--gravar-traco", "-gt")) {
+            inr;
+            opcoes->gravar_traco = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--reproduzir-traco", "-rt")) {
+            inr;
+            opcoes->reproduzir_traco = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--gdb", "-gdb")) {
+            inr;
+            opcoes->gdb = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--perfil", "-pf")) {
+            inr;
+            opcoes->perfil = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--amostrar", "-am")) {
+            inr;
+            opcoes->amostrar = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--desempenho", "-de")) {
+            opcoes->desempenho = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--resumo-linha", "-rl")) {
+            opcoes->resumo_linha = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--formato-saida", "-fs")) {
+            inr;
+            if (output_parse_format(argv[i], &opcoes->formato_saida) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"humano\", \"bruto\" ou \"csv\" mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--destino-saida", "-ds")) {
+            inr;
+            opcoes->destino_saida = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--anel-saida", "-as")) {
+            inr;
+            char * endptr = NULL;
+            long v = strtol(argv[i], &endptr, 10);
+            if (strlen(endptr) > 0 || v < 1 || (size_t)v > OUTPUT_RING_MAX_CAPACITY) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera uma quantidade de valores de 1 a %lu mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                (unsigned long)OUTPUT_RING_MAX_CAPACITY,
+                argv[i]
+                );
+            }
+            opcoes->anel_saida = (size_t)v;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--anel-cheio", "-ac")) {
+            inr;
+            if (outputRing_parse_full(argv[i], &opcoes->anel_cheio) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"bloquear\", \"descartar\" ou \"crescer\" mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--porta", "-po")) {
+            inr;
+            if (opcoes->dispositivos == NULL && (opcoes->dispositivos = devices_create()) == NULL)
+                PARAM_ERROR(EXIT_NO_MEMORY, "%s", EXIT_NO_MEMORY_MESSAGE);
+            char motivo[256];
+            ErrorCode_t err = devices_attach(opcoes->dispositivos, argv[i], motivo, sizeof(motivo));
+            if (err != EXIT_SUCCESS)
+                PARAM_ERROR(err, "O parametro \"%s\": %s.", argv[i-1], motivo);
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--avisos", "-av")) {
+            inr;
+            if (diagnostics_parse_level(argv[i], &opcoes->avisos) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"primeiro\", \"todos\", \"resumo\" ou \"nenhum\" mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--formato-memoria", "-fm")) {
+            inr;
+            if (dump_parse_format(argv[i], &opcoes->memoria.format) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"tabela\", \"hex\" ou \"bruto\" mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--faixa-memoria", "-fa")) {
+            inr;
+            if (dump_add_range(&opcoes->memoria, argv[i]) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera uma faixa como 8000H-80FFH (ate %d faixas) mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                DUMP_MAX_RANGES,
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--memoria-alterada", "-ma")) {
+            opcoes->memoria.changedOnly = true;
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--destino-memoria", "-dm")) {
+            inr;
+            opcoes->memoria.path = argv[i];
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--entrada", "-en")) {
+            inr;
+            free(opcoes->entrada);
+            char motivo[256];
+            ErrorCode_t err = input_load(argv[i], &opcoes->entrada, &opcoes->entrada_tamanho, motivo, sizeof(motivo));
+            if (err == EXIT_NO_MEMORY)
+                PARAM_ERROR(EXIT_NO_MEMORY, "%s", EXIT_NO_MEMORY_MESSAGE);
+            if (err != EXIT_SUCCESS)
+                PARAM_ERROR(err, "O parametro \"%s\": %s.", argv[i-1], motivo);
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--fim-entrada", "-fe")) {
+            inr;
+            if (input_parse_end(argv[i], &opcoes->fim_entrada) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"erro\", \"zero\" ou \"repetir\" mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
+        else if (opcoes != NULL && cmp_curr_str_r("--descarga-saida", "-dc")) {
+            inr;
+            if (output_parse_flush(argv[i], &opcoes->descarga_saida, &opcoes->descarga_valores) != EXIT_SUCCESS) {
+                PARAM_ERROR(EXIT_INVALID_ARGUMENT,
+                "O parametro \"%s\" espera \"auto\", \"valor\", \"hlt\" ou uma quantidade de valores mas foi encontrado o valor \"%s\".",
+                argv[i-1],
+                argv[i]
+                );
+            }
+        }
         else {
             // Verifica se é algum tipo de valor para um parâmetro //
             // Verifica se é um número
@@ -87,53 +350,639 @@ Parametros * getParametros(int argc, char ** argv) {
             WARN("Parametro desconhecido: %s", argv[i]);
         }
     }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Lê os parâmetros de um programa do lote (texto "args" da lista). Um
+ * parâmetro inválido só impede esse programa de ser executado: o erro
+ * fica no resultado dele (ver batchJob_t).
+ * @param job o programa do lote
+ */
+void readJobParametros(batchJob_t * job) {
+    if (job->args == NULL)
+        return;
 
-    return parametros;
+    // Separa o texto em argumentos (o texto é alterado)
+    char * argv[MAX_JOB_ARGS];
+    int argc = 0;
+    char * c = job->args;
+    while (*c != '\0' && argc < MAX_JOB_ARGS) {
+        while (*c == ' ' || *c == '\t') *c++ = '\0';
+        if (*c == '\0') break;
+        argv[argc++] = c;
+        while (*c != '\0' && *c != ' ' && *c != '\t') c++;
+    }
+    char erro[512];
+    ErrorCode_t err = readParametros(&job->params, NULL, argc, argv, 0, erro, sizeof(erro));
+    if (err != EXIT_SUCCESS) {
+        job->exit_code = err;
+        size_t tamanho = strlen("[ERRO] ") + strlen(erro) + 1;
+        if ((job->output = malloc(tamanho)) != NULL) {
+            snprintf(job->output, tamanho, "[ERRO] %s", erro);
+            job->outputSize = tamanho - 1;
+        }
+    }
 }
 
-int main(int argc, char ** argv) {
+// Opções que só alguns modos usam (ver rejeitarOpcoes)
+#define OPCAO_ENTRADA (1 << 0)
+#define OPCAO_PORTA (1 << 1)
+#define OPCAO_SAIDA (1 << 2)
+#define OPCAO_ANEL (1 << 3)
+#define OPCAO_MEMORIA (1 << 4)
+#define OPCAO_TRACO (1 << 5)
+#define OPCAO_PERFIL (1 << 6)
+#define OPCAO_AMOSTRAR (1 << 7)
+#define OPCAO_DESEMPENHO (1 << 8)
+#define OPCAO_SALVAR_ESTADO (1 << 9)
+// As opções de entrada e saída de uma execução (ver abrirSaida)
+#define OPCAO_ES (OPCAO_ENTRADA | OPCAO_PORTA | OPCAO_SAIDA | OPCAO_ANEL | OPCAO_MEMORIA)
 
-    // Se tiver apenas 1 argumento(só a localização do executável),
-    // mostra como funciona
-    if (argc <= 1)
-        RETURN_ERR(EXIT_NO_FILE);
+/**
+ * Encerra o programa se foi dada alguma opção que o modo não usa
+ * (como o --entrada na varredura ou o --perfil junto com o
+ * --gravar-traco), ao invés de ignorá-la.
+ * @param opcoes as opções da linha de comando
+ * @param modo o nome do modo (usado na mensagem)
+ * @param usadas as opções que o modo usa (OPCAO_*)
+ */
+void rejeitarOpcoes(const OpcoesCLI * opcoes, const char * modo, unsigned usadas) {
+    const char * opcao = NULL;
+    if (!(usadas & OPCAO_ENTRADA) && opcoes->entrada != NULL)
+        opcao = "o parametro --entrada";
+    else if (!(usadas & OPCAO_PORTA) && opcoes->dispositivos != NULL)
+        opcao = "o parametro --porta";
+    else if (!(usadas & OPCAO_SAIDA) && (opcoes->destino_saida != NULL
+        || opcoes->formato_saida != OUTPUT_FORMAT_HUMAN || opcoes->descarga_saida != OUTPUT_FLUSH_AUTO))
+        opcao = "os parametros --destino-saida, --formato-saida e --descarga-saida";
+    else if (!(usadas & OPCAO_ANEL) && (opcoes->anel_saida > 0 || opcoes->anel_cheio != OUTPUT_FULL_BLOCK))
+        opcao = "os parametros --anel-saida e --anel-cheio";
+    else if (!(usadas & OPCAO_MEMORIA) && (opcoes->memoria.format != DUMP_FORMAT_TABLE
+        || opcoes->memoria.rangeCount > 0 || opcoes->memoria.changedOnly || opcoes->memoria.path != NULL))
+        opcao = "os parametros --formato-memoria, --faixa-memoria, --memoria-alterada e --destino-memoria";
+    else if (!(usadas & OPCAO_TRACO) && (opcoes->gravar_traco != NULL || opcoes->reproduzir_traco != NULL))
+        opcao = "os parametros --gravar-traco e --reproduzir-traco";
+    else if (!(usadas & OPCAO_PERFIL) && opcoes->perfil != NULL)
+        opcao = "o parametro --perfil";
+    else if (!(usadas & OPCAO_AMOSTRAR) && opcoes->amostrar != NULL)
+        opcao = "o parametro --amostrar";
+    else if (!(usadas & OPCAO_DESEMPENHO) && opcoes->desempenho)
+        opcao = "o parametro --desempenho";
+    else if (!(usadas & OPCAO_SALVAR_ESTADO) && opcoes->salvar_estado != NULL)
+        opcao = "o parametro --salvar-estado";
 
-    // Obtém o arquivo
-    FILE * file = fopen(argv[1], "r");
-    if (file == NULL)
-        RETURN_ERR(EXIT_FILE_NOT_FOUND);
+    if (opcao != NULL)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O modo %s nao usa %s.", modo, opcao);
+}
 
-    // Obtém os parâmetros
-    Parametros * parametros = getParametros(argc, argv);
+/**
+ * Executa o modo lote: encontra os programas, executa todos eles
+ * e imprime o relatório.
+ * @param parametros os parâmetros iniciais de cada programa
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro (o primeiro diferente de sucesso, se houver)
+ */
+ErrorCode_t runLote(Parametros * parametros, OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "lote", OPCAO_ENTRADA);
+    batch_t batch;
+    ErrorCode_t err = batch_discover(opcoes->lote, parametros, &batch);
+    if (err != EXIT_SUCCESS) {
+        batch_free(&batch);
+        if (err == EXIT_FILE_NOT_FOUND)
+            RETURN_ERR(EXIT_FILE_NOT_FOUND);
+        RETURN_ERR(EXIT_NO_MEMORY);
+    }
 
-    // Interpreta e calcula o tempo que demorou para interpretar
-    stopWatch_s stopWatch;
-    stopWatch_start(&stopWatch);
+    for (size_t i = 0; i < batch.count; i++) {
+        readJobParametros(&batch.jobs[i]);
+    }
+    batch.input = opcoes->entrada;
+    batch.inputSize = opcoes->entrada_tamanho;
+    batch.inputEnd = opcoes->fim_entrada;
+    batch.warningLevel = opcoes->avisos;
 
-    // Interpreta o arquivo usando os parâmetros dados
-    ErrorCode_t err = interpret(file, parametros);
-    stopWatch_end(&stopWatch);
+    batch_run(&batch, opcoes->threads);
+    batch_report(&batch, stdout, opcoes->mostrar_saidas);
+
+    err = EXIT_SUCCESS;
+    for (size_t i = 0; i < batch.count && err == EXIT_SUCCESS; i++) {
+        err = batch.jobs[i].exit_code;
+    }
+    batch_free(&batch);
+    free(opcoes->entrada);
+    opcoes->entrada = NULL;
+    return err;
+}
+
+/**
+ * Executa o modo varredura: executa o programa já montado para cada
+ * vetor de entrada, imprimindo a tabela de resultados.
+ * @param image o ambiente com o programa já montado (ou carregado)
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro (o da primeira execução que não terminou
+ * bem, se houver)
+ */
+ErrorCode_t runVarredura(const Environment * image, OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "varredura", 0);
+    sweep_t sweep = { 0 };
+    sweep.inputEnd = opcoes->fim_entrada;
+    sweep.warningLevel = opcoes->avisos;
+    ErrorCode_t err;
+
+    // Obtém os vetores de entrada
+    if (opcoes->varredura_completa) {
+        err = sweep_exhaustive(&sweep);
+    } else {
+        FILE * vetores = fopen(opcoes->varredura, "r");
+        if (vetores == NULL)
+            RETURN_ERR(EXIT_FILE_NOT_FOUND);
+        err = sweep_read_vectors(vetores, &sweep);
+        fclose(vetores);
+    }
+
+    // Cada execução usa uma cópia do programa
+    if (err == EXIT_SUCCESS) {
+        sweep_run(&sweep, image, opcoes->threads);
+        sweep_report(&sweep, stdout);
+        for (size_t i = 0; i < sweep.count && err == EXIT_SUCCESS; i++) {
+            err = sweep.runs[i].exit_code;
+        }
+    }
+
+    sweep_free(&sweep);
+    return err;
+}
+
+/**
+ * Executa o ambiente (montando o arquivo antes, se houver) sem encerrar
+ * o programa em um erro fatal e, no fim, salva o estado do ambiente.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo do programa (NULL se o ambiente foi carregado)
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro da execução
+ */
+ErrorCode_t runSalvandoEstado(Environment * env, FILE * file, OpcoesCLI * opcoes) {
+    ErrorCode_t err = file != NULL ? interpret_env(env, file) : run_env(env);
+
+    // O estado é salvo mesmo se a execução parou por um limite, para
+    // que ela possa continuar depois (--carregar-estado)
+    if (opcoes->salvar_estado != NULL) {
+        ErrorCode_t save = env_save_state_path(env, opcoes->salvar_estado);
+        if (save != EXIT_SUCCESS) {
+            fprintf(stderr, "Erro: %s\n", EXIT_STATE_FILE_MESSAGE);
+        } else {
+            printf("\nEstado salvo em \"%s\" (Instrucoes executadas: %ld)", opcoes->salvar_estado, env->totalInstructions);
+        }
+    }
+    return err;
+}
+
+/**
+ * Monta o arquivo e executa o programa gravando o traço da execução
+ * ou reproduzindo um traço gravado antes (ver Trace/trace.h).
+ * @param env o ambiente do SAP2
+ * @param file o arquivo do programa
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro da execução (EXIT_TRACE se o traço não
+ * puder ser gravado ou se a reprodução não for igual à gravação)
+ */
+ErrorCode_t runComTraco(Environment * env, FILE * file, OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "traco", OPCAO_ES | OPCAO_TRACO);
+    if (opcoes->gravar_traco != NULL && opcoes->reproduzir_traco != NULL)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "Os parametros %s e %s nao podem ser usados juntos.", "--gravar-traco", "--reproduzir-traco");
+    ErrorCode_t err = assemble_env(env, file);
+    if (err == EXIT_NO_INSTRUCTION)
+        return EXIT_SUCCESS; // arquivo vazio
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    bool replay = opcoes->reproduzir_traco != NULL;
+    const char * path = replay ? opcoes->reproduzir_traco : opcoes->gravar_traco;
+    err = replay ? trace_replay_start(env, path) : trace_record_start(env, path);
+    if (err != EXIT_SUCCESS) {
+        fprintf(stderr, "Erro: %s (\"%s\")\n", EXIT_TRACE_MESSAGE, path);
+        return err;
+    }
+
+    err = run_env(env);
+    uint64_t events = trace_event_count(env);
+    ErrorCode_t trace_err = trace_finish(env, err);
+    if (trace_err != EXIT_SUCCESS) {
+        fprintf(stderr, "Erro: %s (\"%s\")\n", EXIT_TRACE_MESSAGE, path);
+        return EXIT_TRACE;
+    }
+
+    if (replay)
+        printf("\nTraco reproduzido: %llu eventos, execucao identica a gravada", (unsigned long long)events);
+    else
+        printf("\nTraco gravado em \"%s\" (%llu eventos)", path, (unsigned long long)events);
+    return err;
+}
+
+/**
+ * Monta o arquivo e executa o programa com o perfil da execução (ver
+ * Profiler/profiler.h). No fim, imprime o relatório e grava o perfil
+ * no formato do callgrind.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo do programa
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro da execução (ou o da gravação, se o perfil
+ * não puder ser gravado)
+ */
+ErrorCode_t runComPerfil(Environment * env, FILE * file, OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "perfil", OPCAO_ES | OPCAO_PERFIL);
+    ErrorCode_t err = assemble_env(env, file);
+    if (err == EXIT_NO_INSTRUCTION)
+        return EXIT_SUCCESS; // arquivo vazio
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    if (profile_start(env) != EXIT_SUCCESS)
+        RETURN_ERR(EXIT_NO_MEMORY);
+    err = run_env(env);
+
+    profile_report(env, stdout);
+    ErrorCode_t write_err = profile_write_callgrind(env, opcoes->perfil);
+    if (write_err != EXIT_SUCCESS) {
+        fprintf(stderr, "Erro: nao foi possivel gravar o perfil em \"%s\"\n", opcoes->perfil);
+        return write_err;
+    }
+    printf("\nPerfil gravado em \"%s\" (formato do callgrind)", opcoes->perfil);
+    return err;
+}
+
+/**
+ * Monta o arquivo e executa o programa amostrando o interpretador (ver
+ * Profiler/sampler.h). No fim, grava as pilhas dobradas.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo do programa
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro da execução
+ */
+ErrorCode_t runAmostrando(Environment * env, FILE * file, OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "amostragem", OPCAO_ES | OPCAO_AMOSTRAR);
+    ErrorCode_t err = assemble_env(env, file);
+    if (err == EXIT_NO_INSTRUCTION)
+        return EXIT_SUCCESS; // arquivo vazio
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    if (sampler_start(env, opcoes->amostrar) != EXIT_SUCCESS) {
+        fprintf(stderr, "Erro: nao foi possivel amostrar o interpretador\n");
+        return EXIT_INVALID_ARGUMENT;
+    }
+    err = run_env(env);
+
+    if (sampler_stop(env) != EXIT_SUCCESS)
+        fprintf(stderr, "Erro: nao foi possivel gravar as amostras em \"%s\"\n", opcoes->amostrar);
+    else
+        printf("\nAmostras gravadas em \"%s\" (%lu amostras, pilhas dobradas)", opcoes->amostrar, sampler_sample_count());
+    return err;
+}
+
+/**
+ * Monta o arquivo e mede o desempenho da execução (ver Bench/bench.h):
+ * o programa é executado sem esperar o tempo dos T-States e, no fim, o
+ * tempo e os contadores de hardware da execução são impressos.
+ * @param env o ambiente do SAP2
+ * @param file o arquivo do programa
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro da execução
+ */
+ErrorCode_t runDesempenho(Environment * env, FILE * file, const OpcoesCLI * opcoes) {
+    rejeitarOpcoes(opcoes, "desempenho", OPCAO_ES | OPCAO_DESEMPENHO);
+    ErrorCode_t err = assemble_env(env, file);
+    if (err == EXIT_NO_INSTRUCTION)
+        return EXIT_SUCCESS; // arquivo vazio
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    benchResult_t result;
+    err = bench_evaluate(env, &result);
+    if (env->usedAddressesSize > 0 && env->params.hlt_prints_memory)
+        print_info(env);
+    bench_print(&result, stdout);
+    return err;
+}
+
+/**
+ * Abre o destino dos valores do OUT do ambiente (ver Output/output.h),
+ * liga os dispositivos das portas (ver Devices/devices.h), as entradas
+ * do IN fornecidas pelo --entrada (ver Input/input.h), a impressão da
+ * memória (ver Dump/dump.h) e o nível dos avisos
+ * @param env o ambiente do SAP2
+ * @param saida o destino
+ * @param opcoes as opções da linha de comando
+ */
+void abrirSaida(Environment * env, outputSink_t * saida, OpcoesCLI * opcoes) {
+    ErrorCode_t err = output_open(saida, opcoes->destino_saida, env->out,
+        opcoes->formato_saida, opcoes->descarga_saida, opcoes->descarga_valores,
+        opcoes->anel_saida, opcoes->anel_cheio);
+    if (err != EXIT_SUCCESS)
+        V_EXIT(EXIT_FILE_NOT_FOUND, "Nao foi possivel abrir o destino da saida \"%s\".", opcoes->destino_saida);
+    env->output = saida;
+    env->devices = opcoes->dispositivos;
+    if (opcoes->entrada != NULL)
+        env_set_input(env, opcoes->entrada, opcoes->entrada_tamanho);
+    env->inputEnd = opcoes->fim_entrada;
+    env->dump = &opcoes->memoria;
+    env->diagnostics.level = opcoes->avisos;
+}
+
+/**
+ * Fecha o destino dos valores do OUT e os dispositivos das portas,
+ * imprimindo o estado dos dispositivos, e libera as entradas do IN
+ * @param env o ambiente do SAP2
+ * @param saida o destino
+ * @param opcoes as opções da linha de comando
+ */
+void fecharSaida(Environment * env, outputSink_t * saida, OpcoesCLI * opcoes) {
+    if (output_close(saida) != EXIT_SUCCESS)
+        fprintf(stderr, "Erro: nao foi possivel escrever toda a saida em \"%s\"\n",
+            opcoes->destino_saida != NULL ? opcoes->destino_saida : "saida padrao");
+    env->output = NULL;
+    if (opcoes->anel_saida > 0)
+        printf("\nAnel da saida: %lu valores | Descartados: %llu | Esperas: %llu\n",
+            (unsigned long)saida->ringCapacity, (unsigned long long)saida->dropped, (unsigned long long)saida->waits);
+
+    // Os dispositivos são fechados aqui (os arquivos são descarregados)
+    if (opcoes->dispositivos != NULL) {
+        devices_report(opcoes->dispositivos, stdout);
+        devices_destroy(opcoes->dispositivos);
+        opcoes->dispositivos = NULL;
+    }
+    env->devices = NULL;
+
+    free(opcoes->entrada);
+    opcoes->entrada = NULL;
+    env_set_input(env, NULL, 0);
+    env->dump = NULL;
+
+    // Os avisos que ainda não entraram em um resumo (se a execução não
+    // terminou pelo run, como no --desempenho)
+    diagnostics_summary(&env->diagnostics);
+}
 
+/**
+ * Imprime o código de saída, o tempo que a interpretação demorou e a
+ * contagem dos ciclos: os T-States simulados (contando os pulos
+ * tomados), quanto tempo eles levariam no relógio do SAP2, as
+ * instruções por segundo e a velocidade em relação ao tempo real.
+ * @param err o código de saída
+ * @param elapsed_time o tempo (em segundos)
+ * @param parametros os parâmetros finais da interpretação
+ * @param instrucoes as instruções executadas durante o tempo medido
+ * @param tstates os T-States simulados durante o tempo medido
+ * @param opcoes as opções da linha de comando
+ */
+void printResumo(ErrorCode_t err, double elapsed_time, const Parametros * parametros,
+                 long instrucoes, uint64_t tstates, const OpcoesCLI * opcoes) {
     // Se não alterou o tempo máximo de execução durante o programa,
     // imprime as informações normalmente
     if (parametros->real_max_time == parametros->max_time) {
         printf("\nSaida de Erro: %d\nTempo de execucao: %.3f segundos",
             err,
-            stopWatch.elapsed_time);
+            elapsed_time);
 
     // Se alterou, avisa ao usuário que considerou o tempo de
     // depuração e de espera das entradas.
     } else {
         printf("\nSaida de Erro: %d\nTempo de execucao: %.3f segundos (considerando os tempos de espera)",
             err,
-            stopWatch.elapsed_time);
+            elapsed_time);
+    }
+
+    double simulado = (double)tstates / SAP2_CLOCK_HZ;
+    double mips = elapsed_time > 0 ? (double)instrucoes / elapsed_time / 1e6 : 0.0;
+    double mhz = elapsed_time > 0 ? (double)tstates / elapsed_time / 1e6 : 0.0;
+    double tempo_real = elapsed_time > 0 ? simulado / elapsed_time : 0.0;
+    printf("\nInstrucoes executadas: %ld | T-States simulados: %llu (%.6f segundos a %.3f MHz)",
+        instrucoes, (unsigned long long)tstates, simulado, SAP2_CLOCK_HZ / 1e6);
+    printf("\nVelocidade: %.3f MIPS, %.3f MHz simulados (%.3fx o tempo real)", mips, mhz, tempo_real);
+
+    // Linha estável para ser lida por outros programas: chaves e
+    // valores separados por espaços (novas chaves só entram no fim)
+    if (opcoes->resumo_linha) {
+        printf("\nRESUMO v1 saida=%d instrucoes=%ld tstates=%llu tempo_simulado=%.6f tempo_host=%.6f"
+               " mips=%.3f mhz=%.3f tempo_real=%.3f",
+            err, instrucoes, (unsigned long long)tstates, simulado, elapsed_time, mips, mhz, tempo_real);
     }
 
     fflush(stdout);
     printf("\n\n");
     fflush(stdout);
+}
+
+/**
+ * Executa o modo de carregar estado: continua a execução salva no
+ * arquivo de estado (ou faz uma varredura a partir dele).
+ * @param argc quantidade de argumentos
+ * @param argv os argumentos ("--carregar-estado <arquivo> [parametros]")
+ * @param opcoes as opções da linha de comando
+ * @return o código de erro
+ */
+ErrorCode_t runCarregarEstado(int argc, char ** argv, OpcoesCLI * opcoes) {
+    if (argc <= 2)
+        V_EXIT(EXIT_NULL_ARGUMENT, "Um valor eh esperado depois do parametro %s.", argv[1]);
+
+    Environment * env = NULL;
+    ErrorCode_t err = env_load_state(argv[2], &env);
+    if (err == EXIT_NO_MEMORY)
+        RETURN_ERR(EXIT_NO_MEMORY);
+    if (err != EXIT_SUCCESS)
+        RETURN_ERR(EXIT_STATE_FILE);
+
+    // Os limites não continuam os mesmos (senão, uma execução salva
+    // por ter atingido o limite pararia logo de novo). Os parâmetros
+    // dados substituem os salvos.
+    env->params.max_evaluated = STANDARD_MAX_EVALUATE;
+    env->params.max_time = STANDARD_MAX_TIME;
+    readParametros(&env->params, opcoes, argc, argv, 3, NULL, 0);
+    env->params.real_max_time = env->params.max_time;
+
+    if (opcoes->varredura != NULL || opcoes->varredura_completa) {
+        err = runVarredura(env, opcoes);
+        env_destroy(env);
+        return err;
+    }
+    if (opcoes->servidor_fork) {
+        rejeitarOpcoes(opcoes, "servidor por fork", 0);
+        env->inputEnd = opcoes->fim_entrada;
+        env->diagnostics.level = opcoes->avisos;
+        err = forkserver_serve(env, stdin, stdout);
+        env_destroy(env);
+        return err;
+    }
+
+    rejeitarOpcoes(opcoes, "carregar estado", OPCAO_ES | OPCAO_SALVAR_ESTADO);
+
+    // O resumo só conta o que foi executado agora
+    long instrucoes = env->totalInstructions;
+    uint64_t tstates = env->totalTStates;
+    outputSink_t saida;
+    abrirSaida(env, &saida, opcoes);
+    stopWatch_s stopWatch;
+    stopWatch_start(&stopWatch);
+    err = runSalvandoEstado(env, NULL, opcoes);
+    stopWatch_end(&stopWatch);
+    fecharSaida(env, &saida, opcoes);
+
+    printResumo(err, stopWatch.elapsed_time, &env->params,
+        env->totalInstructions - instrucoes, env->totalTStates - tstates, opcoes);
+    env_destroy(env);
+    return err;
+}
+
+int main(int argc, char ** argv) {
+
+    // Se tiver apenas 1 argumento(só a localização do executável),
+    // mostra como funciona
+    if (argc <= 1)
+        RETURN_ERR(EXIT_NO_FILE);
+
+    OpcoesCLI opcoes = {
+        .lote = NULL,
+        .threads = 0,
+        .mostrar_saidas = false,
+        .varredura = NULL,
+        .varredura_completa = false,
+        .salvar_estado = NULL,
+        .servidor_fork = false,
+        .gravar_traco = NULL,
+        .reproduzir_traco = NULL,
+        .gdb = NULL,
+        .perfil = NULL,
+        .amostrar = NULL,
+        .desempenho = false,
+        .resumo_linha = false,
+        .formato_saida = OUTPUT_FORMAT_HUMAN,
+        .destino_saida = NULL,
+        .descarga_saida = OUTPUT_FLUSH_AUTO,
+        .descarga_valores = 1,
+        .anel_saida = 0,
+        .anel_cheio = OUTPUT_FULL_BLOCK,
+        .dispositivos = NULL,
+        .entrada = NULL,
+        .entrada_tamanho = 0,
+        .fim_entrada = INPUT_END_ERROR,
+        .memoria = { .format = DUMP_FORMAT_TABLE, .rangeCount = 0, .changedOnly = false, .path = NULL },
+        .avisos = WARNINGS_FIRST
+    };
+
+    // Modo lote: "--lote <diretorio|lista> [parametros]"
+    if (strcmp(argv[1], "--lote") == 0 || strcmp(argv[1], "-l") == 0) {
+        if (argc <= 2)
+            V_EXIT(EXIT_NULL_ARGUMENT, "Um valor eh esperado depois do parametro %s.", argv[1]);
+        opcoes.lote = argv[2];
+
+        Parametros * parametros = get_standard_parameters();
+        readParametros(parametros, &opcoes, argc, argv, 3, NULL, 0);
+        ErrorCode_t err = runLote(parametros, &opcoes);
+        free(parametros);
+        return err;
+    }
+
+    // Continua uma execução salva: "--carregar-estado <arquivo> [parametros]"
+    if (strcmp(argv[1], "--carregar-estado") == 0 || strcmp(argv[1], "-ce") == 0)
+        return runCarregarEstado(argc, argv, &opcoes);
+
+    // Obtém o arquivo
+    FILE * file = fopen(argv[1], "r");
+    if (file == NULL)
+        RETURN_ERR(EXIT_FILE_NOT_FOUND);
+
+    // Obtém os parâmetros
+    Parametros * parametros = get_standard_parameters();
+    readParametros(parametros, &opcoes, argc, argv, 2, NULL, 0);
+
+    // Modo varredura: monta o programa uma vez só
+    if (opcoes.varredura != NULL || opcoes.varredura_completa) {
+        Environment * image = env_create(parametros, NULL);
+        if (image == NULL)
+            RETURN_ERR(EXIT_NO_MEMORY);
+        ErrorCode_t err = assemble(image, file);
+        if (err == EXIT_SUCCESS)
+            err = runVarredura(image, &opcoes);
+        env_destroy(image);
+        fclose(file);
+        free(parametros);
+        return err;
+    }
+
+    // Servidor por fork: monta o programa uma vez só e atende os
+    // pedidos da entrada padrão, respondendo na saída padrão
+    if (opcoes.servidor_fork) {
+        rejeitarOpcoes(&opcoes, "servidor por fork", 0);
+        Environment * image = env_create(parametros, NULL);
+        if (image == NULL)
+            RETURN_ERR(EXIT_NO_MEMORY);
+        // A saída padrão é só das respostas
+        image->diagnostics.warnings = stderr;
+        image->inputEnd = opcoes.fim_entrada;
+        image->diagnostics.level = opcoes.avisos;
+        ErrorCode_t err = assemble(image, file);
+        if (err == EXIT_SUCCESS)
+            err = forkserver_serve(image, stdin, stdout);
+        env_destroy(image);
+        fclose(file);
+        free(parametros);
+        return err;
+    }
+
+    // Depuração remota: monta o programa e espera o depurador (GDB)
+    if (opcoes.gdb != NULL) {
+        rejeitarOpcoes(&opcoes, "depuracao remota", 0);
+        Environment * env = env_create(parametros, NULL);
+        if (env == NULL)
+            RETURN_ERR(EXIT_NO_MEMORY);
+        env->inputEnd = opcoes.fim_entrada;
+        env->diagnostics.level = opcoes.avisos;
+        ErrorCode_t err = assemble_env(env, file);
+        if (err == EXIT_NO_INSTRUCTION)
+            err = EXIT_SUCCESS; // arquivo vazio
+        else if (err == EXIT_SUCCESS)
+            err = gdbstub_serve(env, opcoes.gdb);
+        env_destroy(env);
+        fclose(file);
+        free(parametros);
+        return err;
+    }
+
+    // Interpreta e calcula o tempo que demorou para interpretar
+    stopWatch_s stopWatch;
+    stopWatch_start(&stopWatch);
+
+    // Todos os modos usam um ambiente próprio, para que os contadores
+    // da execução apareçam no resumo
+    Environment * env = env_create(parametros, NULL);
+    if (env == NULL)
+        RETURN_ERR(EXIT_NO_MEMORY);
+    outputSink_t saida;
+    abrirSaida(env, &saida, &opcoes);
+
+    ErrorCode_t err;
+    if (opcoes.gravar_traco != NULL || opcoes.reproduzir_traco != NULL) {
+        err = runComTraco(env, file, &opcoes);
+    } else if (opcoes.perfil != NULL) {
+        err = runComPerfil(env, file, &opcoes);
+    } else if (opcoes.amostrar != NULL) {
+        err = runAmostrando(env, file, &opcoes);
+    } else if (opcoes.desempenho) {
+        err = runDesempenho(env, file, &opcoes);
+    } else {
+        // Interpreta o arquivo usando os parâmetros dados (e salva o
+        // estado no fim, se for pedido)
+        err = runSalvandoEstado(env, file, &opcoes);
+    }
+    stopWatch_end(&stopWatch);
+    fecharSaida(env, &saida, &opcoes);
+
+    printResumo(err, stopWatch.elapsed_time, &env->params, env->totalInstructions, env->totalTStates, &opcoes);
+    env_destroy(env);
 
     // Finaliza o programa
+    fclose(file);
     free(parametros);
     return err;
 }
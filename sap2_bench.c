@@ -0,0 +1,485 @@
+// Medição do desempenho do interpretador com programas sintéticos (ver
+// Interpreter/Bench/workloads.h) ou do montador com códigos gerados (ver
+// Interpreter/Bench/asmbench.h). Os resultados podem ser guardados em uma
+// base e comparados com ela (ver Interpreter/Bench/baseline.h). Uso:
+//     sap2_bench [--repeticoes <n>] [--aquecimento <n>] [--escala <n>]
+//                [--tempo-amostra <ms>] [--filtro <texto>] [--listar] [--exemplos <pasta>]
+//                [--salvar <base.json>] [--comparar <base.json>] [--ruido <%>]
+//     sap2_bench --montagem [--linhas <n>] [--rotulos <%>]
+//                [--comentarios <%>] [--adiante <%>] [--repeticoes <n>]
+//
+// Author: André
+// Date: 01/11/2025
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Interpreter/ErrorCodes.h"
+#include "Interpreter/interpreter.h"
+#include "Interpreter/Batch/batch.h"
+#include "Interpreter/Bench/asmbench.h"
+#include "Interpreter/Bench/baseline.h"
+#include "Interpreter/Bench/bench.h"
+#include "Interpreter/Bench/workloads.h"
+
+// Padrões das opções
+#define STANDARD_RUNS 7
+#define STANDARD_WARMUP 1
+#define STANDARD_SCALE 1
+#define STANDARD_MAX_LINES 100000
+#define STANDARD_LABEL_PERCENT 10
+#define STANDARD_COMMENT_PERCENT 20
+#define STANDARD_FORWARD_PERCENT 50
+#define STANDARD_NOISE_PERCENT 5
+#define STANDARD_SAMPLE_MS ((int)(BENCH_MIN_SAMPLE_SECONDS * 1000))
+#define STANDARD_EXAMPLES "Exemplos"
+// Menor código gerado (os próximos têm 10 vezes mais linhas)
+#define MIN_LINES 1000
+// Limite de instruções dos exemplos (alguns não terminam)
+#define EXAMPLE_MAX_INSTRUCTIONS 5000000
+
+/**
+ * Lê o inteiro positivo do argumento dado (ou encerra o programa)
+ */
+static int read_positive(char ** argv, int i) {
+    char * endptr = NULL;
+    long v = strtol(argv[i], &endptr, 10);
+    if (strlen(endptr) > 0 || v < 1 || v > 1000000)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera um inteiro positivo depois mas foi encontrado o valor \"%s\".", argv[i-1], argv[i]);
+    return (int)v;
+}
+
+/**
+ * Lê o inteiro (0 ou mais) do argumento dado (ou encerra o programa)
+ */
+static int read_nonnegative(char ** argv, int i) {
+    char * endptr = NULL;
+    long v = strtol(argv[i], &endptr, 10);
+    if (strlen(endptr) > 0 || v < 0 || v > 1000000)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera um inteiro (0 ou mais) depois mas foi encontrado o valor \"%s\".", argv[i-1], argv[i]);
+    return (int)v;
+}
+
+/**
+ * Lê a porcentagem do argumento dado (ou encerra o programa)
+ */
+static int read_percent(char ** argv, int i) {
+    int v = read_nonnegative(argv, i);
+    if (v > 100)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera uma porcentagem (de 0 a 100) mas foi encontrado o valor \"%s\".", argv[i-1], argv[i]);
+    return v;
+}
+
+static double assembly_lines_per_second(const asmBenchResult_t * result) {
+    double total = result->tokenizeSeconds + result->pass1Seconds + result->pass2Seconds;
+    return total > 0 ? (double)result->lines / total : 0.0;
+}
+
+static int compare_assemblies(const void * a, const void * b) {
+    double x = assembly_lines_per_second(a);
+    double y = assembly_lines_per_second(b);
+    return x < y ? -1 : x > y;
+}
+
+static int compare_numbers(const void * a, const void * b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Monta o código até somar "minSeconds" de montagem. Os tempos guardados
+ * são os de uma montagem (a média) e o pico de memória é o maior.
+ * @return o código de erro
+ */
+static ErrorCode_t measure_assembly(const asmSource_t * source, double minSeconds, asmBenchResult_t * result) {
+    asmBenchResult_t total;
+    int count = 0;
+    do {
+        asmBenchResult_t one;
+        ErrorCode_t err = asmbench_measure(source, &one);
+        if (err != EXIT_SUCCESS)
+            return err;
+        if (count == 0) {
+            total = one;
+        } else {
+            total.tokenizeSeconds += one.tokenizeSeconds;
+            total.pass1Seconds += one.pass1Seconds;
+            total.pass2Seconds += one.pass2Seconds;
+            if (one.peakKb > total.peakKb)
+                total.peakKb = one.peakKb;
+        }
+        count++;
+    } while (total.tokenizeSeconds + total.pass1Seconds + total.pass2Seconds < minSeconds);
+
+    total.tokenizeSeconds /= count;
+    total.pass1Seconds /= count;
+    total.pass2Seconds /= count;
+    *result = total;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Mede a montagem de códigos gerados com 1000, 10000, ... linhas (até
+ * "source->lines"). Cada tamanho é medido "runs" vezes (cada medição
+ * monta o código até somar "minSeconds") e a medição mediana (pelas
+ * linhas por segundo) é mostrada.
+ * @param baseline onde os resultados são guardados (NULL se não forem)
+ * @return o código de erro
+ */
+static ErrorCode_t bench_assembler(const asmSource_t * source, int runs, double minSeconds, baseline_t * baseline) {
+    if (runs < 1)
+        runs = 1;
+    printf("Montagem | Repeticoes: %d | Rotulos: %d%% | Comentarios: %d%% | Pulos para frente: %d%%\n\n",
+        runs, source->labelPercent, source->commentPercent, source->forwardPercent);
+    printf("%-9s| %-10s| %-8s| %-10s| %-10s| %-10s| %-12s| %-9s| %s\n",
+        "Linhas", "Bytes", "Rotulos", "Tokens (s)", "Pass. 1(s)", "Pass. 2(s)", "Linhas/s", "MB/s", "Pico (KB)");
+
+    asmBenchResult_t * results = malloc(sizeof(asmBenchResult_t) * runs);
+    double * samples = malloc(sizeof(double) * runs);
+    if (results == NULL || samples == NULL) {
+        free(results);
+        free(samples);
+        return EXIT_NO_MEMORY;
+    }
+
+    ErrorCode_t err = EXIT_SUCCESS;
+    for (long lines = MIN_LINES; err == EXIT_SUCCESS; lines *= 10) {
+        if (lines > source->lines)
+            lines = source->lines;
+        asmSource_t sized = *source;
+        sized.lines = lines;
+
+        for (int r = 0; r < runs && err == EXIT_SUCCESS; r++)
+            err = measure_assembly(&sized, minSeconds, &results[r]);
+        if (err != EXIT_SUCCESS) {
+            fprintf(stderr, "[ERRO] A montagem do codigo com %ld linhas terminou com a saida %d.\n", lines, err);
+            break;
+        }
+        qsort(results, runs, sizeof(asmBenchResult_t), compare_assemblies);
+        const asmBenchResult_t * median = &results[runs / 2];
+        double total = median->tokenizeSeconds + median->pass1Seconds + median->pass2Seconds;
+        if (total <= 0)
+            total = 1e-9;
+
+        printf("%-9ld| %-10ld| %-8lu| %-10.4f| %-10.4f| %-10.4f| %-12.0f| %-9.2f| ",
+            median->lines, median->bytes, (unsigned long)median->labels,
+            median->tokenizeSeconds, median->pass1Seconds, median->pass2Seconds,
+            (double)median->lines / total, (double)median->bytes / total / 1e6);
+        if (median->peakKb > 0)
+            printf("%ld\n", median->peakKb);
+        else
+            printf("-\n");
+        fflush(stdout);
+
+        if (baseline != NULL) {
+            char name[BASELINE_NAME_SIZE];
+            snprintf(name, sizeof(name), "montagem/%ld", lines);
+            for (int r = 0; r < runs; r++)
+                samples[r] = assembly_lines_per_second(&results[r]);
+            err = baseline_add(baseline, name, "linhas_por_s", assembly_lines_per_second(median),
+                samples[(runs - 1) / 10], samples[(runs - 1) * 9 / 10], true, samples, runs);
+            if (err == EXIT_SUCCESS && median->peakKb > 0) {
+                for (int r = 0; r < runs; r++)
+                    samples[r] = (double)results[r].peakKb;
+                qsort(samples, runs, sizeof(double), compare_numbers);
+                err = baseline_add(baseline, name, "pico_kb", samples[runs / 2],
+                    samples[(runs - 1) / 10], samples[(runs - 1) * 9 / 10], false, samples, runs);
+            }
+        }
+
+        if (lines >= source->lines)
+            break;
+    }
+
+    free(results);
+    free(samples);
+    return err;
+}
+
+/**
+ * Monta o programa do arquivo dado
+ * @param params os parâmetros do programa
+ * @return o ambiente com o programa montado (NULL se houver erro)
+ */
+static Environment * assemble_image(FILE * source, Parametros * params) {
+    params->hlt_prints_memory = false;
+    params->paced = false;
+    Environment * image = env_create(params, NULL);
+    if (image != NULL && assemble_env(image, source) != EXIT_SUCCESS) {
+        env_destroy(image);
+        image = NULL;
+    }
+    return image;
+}
+
+/**
+ * Monta o programa sintético
+ * @return o ambiente com o programa montado (NULL se houver erro)
+ */
+static Environment * assemble_workload(const workload_t * workload, int scale) {
+    FILE * source = tmpfile();
+    if (source == NULL)
+        return NULL;
+    if (workload_write(workload, scale, source) != EXIT_SUCCESS) {
+        fclose(source);
+        return NULL;
+    }
+    rewind(source);
+
+    Parametros * params = get_standard_parameters();
+    params->start_address = workload->start;
+    // Sem limite de tempo: a medição é que diz quanto demorou
+    params->max_time = 1e12;
+    params->real_max_time = params->max_time;
+    Environment * image = assemble_image(source, params);
+    free(params);
+    fclose(source);
+    return image;
+}
+
+/**
+ * Mede o programa montado e imprime a linha dele na tabela
+ * @param name o nome do programa na tabela e na base
+ * @param minSeconds o tempo mínimo de cada medição (em segundos)
+ * @param baseline onde o resultado é guardado (NULL se não for)
+ * @return o código de erro
+ */
+static ErrorCode_t bench_program(const char * name, Environment * image, int warmup, int runs,
+                                 double minSeconds, baseline_t * baseline) {
+    if (runs < 1)
+        runs = 1;
+    double * samples = malloc(sizeof(double) * runs);
+    if (samples == NULL)
+        return EXIT_NO_MEMORY;
+    benchSummary_t summary;
+    ErrorCode_t err = bench_measure(image, warmup, runs, minSeconds, samples, &summary);
+    if (err != EXIT_SUCCESS) {
+        fprintf(stderr, "[ERRO] O programa \"%s\" terminou com a saida %d.\n", name, err);
+        free(samples);
+        return err;
+    }
+
+    printf("%-32s| %-12llu| %-9.2f| %-9.2f| %-9.2f| %-11.4f| ",
+        name, (unsigned long long)summary.instructions,
+        summary.medianMips, summary.p10Mips, summary.p90Mips, summary.medianSeconds);
+    // Os contadores são da medição inteira (todas as execuções dela)
+    if (summary.counters.available[COUNTER_CYCLES] && summary.instructions > 0)
+        printf("%.2f\n", (double)summary.counters.values[COUNTER_CYCLES]
+            / ((double)summary.instructions * summary.executions));
+    else
+        printf("-\n");
+    fflush(stdout);
+
+    if (baseline != NULL)
+        err = baseline_add(baseline, name, "mips", summary.medianMips, summary.p10Mips, summary.p90Mips, true,
+            samples, runs);
+    free(samples);
+    return err;
+}
+
+/**
+ * Mede os programas ".asm" da pasta dada (como os do Exemplos/)
+ * @return o código de erro
+ */
+static ErrorCode_t bench_examples(const char * path, const char * filter, int warmup, int runs,
+                                  double minSeconds, baseline_t * baseline) {
+    Parametros * params = get_standard_parameters();
+    params->max_evaluated = EXAMPLE_MAX_INSTRUCTIONS;
+    params->max_time = 1e12;
+    params->real_max_time = params->max_time;
+    batch_t batch;
+    ErrorCode_t result = batch_discover(path, params, &batch);
+    free(params);
+    if (result != EXIT_SUCCESS) {
+        fprintf(stderr, "[ERRO] Nao foi possivel ler os exemplos de \"%s\".\n", path);
+        return result;
+    }
+
+    for (size_t i = 0; i < batch.count; i++) {
+        const char * file = strrchr(batch.jobs[i].path, '/');
+        file = file != NULL ? file + 1 : batch.jobs[i].path;
+        char name[BASELINE_NAME_SIZE];
+        snprintf(name, sizeof(name), "exemplo/%s", file);
+        if (filter != NULL && strstr(name, filter) == NULL)
+            continue;
+
+        FILE * source = fopen(batch.jobs[i].path, "r");
+        Environment * image = source != NULL ? assemble_image(source, &batch.jobs[i].params) : NULL;
+        if (source != NULL)
+            fclose(source);
+        if (image == NULL) {
+            fprintf(stderr, "[ERRO] Nao foi possivel montar o programa \"%s\".\n", batch.jobs[i].path);
+            result = EXIT_INVALID_ARGUMENT;
+            continue;
+        }
+        ErrorCode_t err = bench_program(name, image, warmup, runs, minSeconds, baseline);
+        env_destroy(image);
+        if (err != EXIT_SUCCESS)
+            result = err;
+    }
+
+    batch_free(&batch);
+    return result;
+}
+
+int main(int argc, char ** argv) {
+    int runs = STANDARD_RUNS;
+    int warmup = STANDARD_WARMUP;
+    int scale = STANDARD_SCALE;
+    int noise = STANDARD_NOISE_PERCENT;
+    int sampleMs = STANDARD_SAMPLE_MS;
+    const char * filter = NULL;
+    const char * examples = NULL;
+    const char * save = NULL;
+    const char * compare = NULL;
+    bool list = false;
+    bool assembler = false;
+    asmSource_t source = {
+        .lines = STANDARD_MAX_LINES,
+        .labelPercent = STANDARD_LABEL_PERCENT,
+        .commentPercent = STANDARD_COMMENT_PERCENT,
+        .forwardPercent = STANDARD_FORWARD_PERCENT,
+        .seed = 1
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--repeticoes") == 0 || strcmp(argv[i], "-r") == 0) && i + 1 < argc) {
+            runs = read_positive(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--aquecimento") == 0 || strcmp(argv[i], "-a") == 0) && i + 1 < argc) {
+            warmup = read_nonnegative(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--escala") == 0 || strcmp(argv[i], "-e") == 0) && i + 1 < argc) {
+            scale = read_positive(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--tempo-amostra") == 0 || strcmp(argv[i], "-ta") == 0) && i + 1 < argc) {
+            sampleMs = read_positive(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--filtro") == 0 || strcmp(argv[i], "-f") == 0) && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--listar") == 0 || strcmp(argv[i], "-l") == 0) {
+            list = true;
+        }
+        else if ((strcmp(argv[i], "--exemplos") == 0 || strcmp(argv[i], "-ex") == 0) && i + 1 < argc) {
+            examples = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--salvar") == 0 || strcmp(argv[i], "-s") == 0) && i + 1 < argc) {
+            save = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--comparar") == 0 || strcmp(argv[i], "-c") == 0) && i + 1 < argc) {
+            compare = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--ruido") == 0 || strcmp(argv[i], "-ru") == 0) && i + 1 < argc) {
+            noise = read_percent(argv, ++i);
+        }
+        else if (strcmp(argv[i], "--montagem") == 0 || strcmp(argv[i], "-m") == 0) {
+            assembler = true;
+        }
+        else if ((strcmp(argv[i], "--linhas") == 0 || strcmp(argv[i], "-li") == 0) && i + 1 < argc) {
+            source.lines = read_positive(argv, ++i);
+            if (source.lines < MIN_LINES)
+                source.lines = MIN_LINES;
+        }
+        else if ((strcmp(argv[i], "--rotulos") == 0 || strcmp(argv[i], "-ro") == 0) && i + 1 < argc) {
+            source.labelPercent = read_percent(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--comentarios") == 0 || strcmp(argv[i], "-co") == 0) && i + 1 < argc) {
+            source.commentPercent = read_percent(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--adiante") == 0 || strcmp(argv[i], "-ad") == 0) && i + 1 < argc) {
+            source.forwardPercent = read_percent(argv, ++i);
+        }
+        else {
+            WARN("Parametro desconhecido: %s", argv[i]);
+        }
+    }
+
+    if (list) {
+        for (int w = 0; w < WORKLOAD_COUNT; w++)
+            printf("%-20s %s\n", WORKLOADS[w].name, WORKLOADS[w].description);
+        return EXIT_SUCCESS;
+    }
+
+    // Com uma base, tudo é medido: os programas sintéticos, os exemplos e a montagem
+    bool withBaseline = save != NULL || compare != NULL;
+    baseline_t current = { NULL, 0, runs };
+    baseline_t * collect = withBaseline ? &current : NULL;
+    if (withBaseline && examples == NULL)
+        examples = STANDARD_EXAMPLES;
+
+    double minSeconds = sampleMs / 1000.0;
+    ErrorCode_t result = EXIT_SUCCESS;
+    if (!assembler || withBaseline) {
+        printf("Repeticoes: %d (+%d de aquecimento) | Escala: %d | Tempo minimo de cada repeticao: %d ms\n\n",
+            runs, warmup, scale, sampleMs);
+        printf("%-32s| %-12s| %-9s| %-9s| %-9s| %-11s| %s\n",
+            "Programa", "Instrucoes", "MIPS", "p10", "p90", "Tempo (s)", "Ciclos/instrucao");
+
+        for (int w = 0; w < WORKLOAD_COUNT; w++) {
+            const workload_t * workload = &WORKLOADS[w];
+            char name[BASELINE_NAME_SIZE];
+            snprintf(name, sizeof(name), "programa/%s", workload->name);
+            if (filter != NULL && strstr(name, filter) == NULL)
+                continue;
+
+            Environment * image = assemble_workload(workload, scale);
+            if (image == NULL) {
+                fprintf(stderr, "[ERRO] Nao foi possivel montar o programa \"%s\".\n", workload->name);
+                result = EXIT_INVALID_ARGUMENT;
+                continue;
+            }
+            ErrorCode_t err = bench_program(name, image, warmup, runs, minSeconds, collect);
+            env_destroy(image);
+            if (err != EXIT_SUCCESS)
+                result = err;
+        }
+
+        if (examples != NULL) {
+            ErrorCode_t err = bench_examples(examples, filter, warmup, runs, minSeconds, collect);
+            if (err != EXIT_SUCCESS)
+                result = err;
+        }
+    }
+
+    if (assembler || withBaseline) {
+        if (!assembler)
+            printf("\n");
+        ErrorCode_t err = bench_assembler(&source, runs, minSeconds, collect);
+        if (err != EXIT_SUCCESS)
+            result = err;
+    }
+
+    if (save != NULL) {
+        ErrorCode_t err = baseline_save(&current, save);
+        if (err != EXIT_SUCCESS) {
+            fprintf(stderr, "[ERRO] Nao foi possivel gravar a base \"%s\".\n", save);
+            result = err;
+        } else {
+            printf("\nBase gravada em \"%s\" (%lu resultados).\n", save, (unsigned long)current.count);
+        }
+    }
+
+    if (compare != NULL) {
+        baseline_t base;
+        ErrorCode_t err = baseline_load(&base, compare);
+        if (err != EXIT_SUCCESS) {
+            fprintf(stderr, "[ERRO] Nao foi possivel ler a base \"%s\".\n", compare);
+            result = err;
+        } else {
+            printf("\n");
+            if (baseline_compare(&base, &current, noise, stdout) > 0) {
+                fprintf(stderr, "[ERRO] %s\n", EXIT_REGRESSION_MESSAGE);
+                result = EXIT_REGRESSION;
+            }
+            baseline_free(&base);
+        }
+    }
+
+    baseline_free(&current);
+    return result;
+}
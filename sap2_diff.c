@@ -0,0 +1,211 @@
+// Testes diferenciais dos motores de execução (ver
+// Interpreter/Differential/differential.h). Gera programas aleatórios,
+// executa cada um com a referência e com os motores candidatos e, se
+// algum resultado for diferente, reduz o programa e mostra o menor
+// programa que ainda tem a diferença. Uso:
+//     sap2_diff [--programas <n>] [--semente <n>] [--tamanho <n>]
+//               [--motor <nome>] [--salvar <arquivo.asm>] [--listar]
+//     sap2_diff --semente-programa <n> [--tamanho <n>] [--motor <nome>]
+//               [--salvar <arquivo.asm>]
+//
+// Author: André
+// Date: 04/11/2025
+//
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Interpreter/ErrorCodes.h"
+#include "Interpreter/interpreter.h"
+#include "Interpreter/Differential/differential.h"
+#include "Interpreter/Differential/generator.h"
+#include "Interpreter/Instructions/Instructions.h"
+#include "Interpreter/Utils/Utils.h"
+
+// Padrões das opções
+#define STANDARD_PROGRAMS 1000
+#define STANDARD_SIZE 12
+
+/**
+ * Lê o inteiro positivo do argumento dado (ou encerra o programa)
+ */
+static long read_positive(char ** argv, int i) {
+    char * endptr = NULL;
+    long v = strtol(argv[i], &endptr, 10);
+    if (strlen(endptr) > 0 || v < 1 || v > 100000000)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera um inteiro positivo depois mas foi encontrado o valor \"%s\".", argv[i-1], argv[i]);
+    return v;
+}
+
+/**
+ * Lê a semente do argumento dado, de 0 a 4294967295 (ou encerra o programa)
+ */
+static uint32_t read_seed(char ** argv, int i) {
+    char * endptr = NULL;
+    unsigned long long v = strtoull(argv[i], &endptr, 10);
+    // strtoull aceita o sinal de menos (e "inverte" o valor)
+    if (!isdigit((unsigned char)argv[i][0]) || strlen(endptr) > 0 || v > UINT32_MAX)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera uma semente (de 0 a %lu) depois mas foi encontrado o valor \"%s\".",
+            argv[i-1], (unsigned long)UINT32_MAX, argv[i]);
+    return (uint32_t)v;
+}
+
+/**
+ * Reduz o programa com diferença e mostra (ou grava) o programa reduzido
+ * @return o código de erro
+ */
+static ErrorCode_t report_mismatch(const genProgram_t * program, const diffEngine_t * engine, const Parametros * params,
+                                   FILE * discard, const char * save) {
+    genProgram_t smallest;
+    ErrorCode_t err = differential_shrink(program, engine, params, discard, &smallest);
+    if (err != EXIT_SUCCESS)
+        return err;
+
+    char description[256];
+    bool mismatch = false;
+    err = differential_check(&smallest, engine, params, discard, &mismatch, description, sizeof(description));
+    if (err == EXIT_SUCCESS) {
+        printf("  Programa reduzido: %lu instrucoes (de %lu)\n  Diferenca: %s\n",
+            (unsigned long)smallest.count, (unsigned long)program->count, description);
+
+        FILE * out = save != NULL ? fopen(save, "w") : NULL;
+        if (save != NULL && out == NULL) {
+            fprintf(stderr, "[ERRO] Nao foi possivel gravar o programa em \"%s\".\n", save);
+            err = EXIT_FILE_NOT_FOUND;
+        }
+        if (out != NULL) {
+            generator_write_asm(&smallest, out);
+            fclose(out);
+            printf("  Programa gravado em \"%s\" (execute com: sap2 %s -i 8000H).\n", save, save);
+        } else {
+            printf("\n");
+            generator_write_asm(&smallest, stdout);
+        }
+    }
+    generator_free(&smallest);
+    return err;
+}
+
+int main(int argc, char ** argv) {
+    long programs = STANDARD_PROGRAMS;
+    long size = STANDARD_SIZE;
+    uint32_t seed = (uint32_t)time(NULL);
+    const char * engineName = NULL;
+    const char * save = NULL;
+    bool list = false;
+    // Se só o programa com a semente dada é testado (--semente-programa)
+    bool single = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--programas") == 0 || strcmp(argv[i], "-p") == 0) && i + 1 < argc) {
+            programs = read_positive(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--semente") == 0 || strcmp(argv[i], "-s") == 0) && i + 1 < argc) {
+            seed = read_seed(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--semente-programa") == 0 || strcmp(argv[i], "-sp") == 0) && i + 1 < argc) {
+            seed = read_seed(argv, ++i);
+            single = true;
+        }
+        else if ((strcmp(argv[i], "--tamanho") == 0 || strcmp(argv[i], "-t") == 0) && i + 1 < argc) {
+            size = read_positive(argv, ++i);
+        }
+        else if ((strcmp(argv[i], "--motor") == 0 || strcmp(argv[i], "-mo") == 0) && i + 1 < argc) {
+            engineName = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--salvar") == 0 || strcmp(argv[i], "-sa") == 0) && i + 1 < argc) {
+            save = argv[++i];
+        }
+        else if (strcmp(argv[i], "--listar") == 0 || strcmp(argv[i], "-l") == 0) {
+            list = true;
+        }
+        else {
+            WARN("Parametro desconhecido: %s", argv[i]);
+        }
+    }
+
+    if (list) {
+        for (int e = 0; e < DIFFERENTIAL_ENGINE_COUNT; e++)
+            printf("%-12s %s%s\n", DIFFERENTIAL_ENGINES[e].name, DIFFERENTIAL_ENGINES[e].description,
+                e == 0 ? " (referencia)" : "");
+        return EXIT_SUCCESS;
+    }
+
+    const diffEngine_t * only = NULL;
+    if (engineName != NULL && (only = differential_find_engine(engineName)) == NULL)
+        V_EXIT(EXIT_INVALID_ARGUMENT, "Motor desconhecido: \"%s\" (use --listar para ver os motores).", engineName);
+
+    Parametros * params = get_standard_parameters();
+    params->max_time = 1e12;
+    params->real_max_time = params->max_time;
+    FILE * discard = open_null_stream();
+    if (discard == NULL)
+        RETURN_ERR(EXIT_NO_MEMORY);
+
+    if (single) {
+        programs = 1;
+        printf("Semente do programa: %lu | Tamanho: %ld\n\n", (unsigned long)seed, size);
+    } else {
+        printf("Semente: %lu | Programas: %ld | Tamanho: %ld\n\n", (unsigned long)seed, programs, size);
+    }
+
+    ErrorCode_t result = EXIT_SUCCESS;
+    uint64_t counts[256] = { 0 };
+    for (long p = 0; p < programs && result == EXIT_SUCCESS; p++) {
+        // Cada programa tem a própria semente, para poder ser gerado de novo
+        // (com --semente-programa)
+        uint32_t programSeed = single ? seed : seed + (uint32_t)p * 2654435761u;
+        genProgram_t program;
+        result = generator_generate(programSeed, (int)size, &program);
+        if (result != EXIT_SUCCESS)
+            break;
+        result = differential_coverage(&program, params, discard, counts);
+
+        for (int e = 1; e < DIFFERENTIAL_ENGINE_COUNT && result == EXIT_SUCCESS; e++) {
+            const diffEngine_t * engine = &DIFFERENTIAL_ENGINES[e];
+            if (only != NULL && only != engine)
+                continue;
+            bool mismatch = false;
+            char description[256];
+            result = differential_check(&program, engine, params, discard, &mismatch, description, sizeof(description));
+            if (result != EXIT_SUCCESS || !mismatch)
+                continue;
+
+            printf("[DIFERENCA] Programa %ld (semente %lu, repita com --semente-programa %lu), motor \"%s\": %s\n",
+                p + 1, (unsigned long)programSeed, (unsigned long)programSeed, engine->name, description);
+            result = report_mismatch(&program, engine, params, discard, save);
+            // Só o primeiro programa com diferença é reduzido
+            if (result == EXIT_SUCCESS)
+                result = EXIT_MISMATCH;
+        }
+        generator_free(&program);
+    }
+
+    // Instruções que nenhum programa executou
+    int missing = 0;
+    for (int i = 0; i < GENERATOR_OPCODE_COUNT; i++) {
+        if (counts[GENERATOR_OPCODES[i]] == 0) {
+            if (missing++ == 0)
+                printf("\n[AVISO] Instrucoes que nao foram executadas:");
+            printf(" \"%s\"", getInstructionName(GENERATOR_OPCODES[i]));
+        }
+    }
+    if (missing > 0)
+        printf("\n");
+
+    if (result == EXIT_MISMATCH) {
+        fprintf(stderr, "[ERRO] %s\n", EXIT_MISMATCH_MESSAGE);
+    } else if (result == EXIT_SUCCESS) {
+        printf("\nNenhuma diferenca em %ld programas (%d motores candidatos).\n", programs,
+            only != NULL ? 1 : DIFFERENTIAL_ENGINE_COUNT - 1);
+    }
+
+    fclose(discard);
+    free(params);
+    return result;
+}
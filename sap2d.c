@@ -0,0 +1,58 @@
+// Servidor local de simulações do SAP2. Uso:
+//     sap2d [--socket <caminho>] [--threads <numero>]
+//
+// Author: André
+// Date: 25/10/2025
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <signal.h>
+#endif
+
+#include "Interpreter/ErrorCodes.h"
+#include "Interpreter/Server/daemon.h"
+
+#ifndef _WIN32
+static void on_stop_signal(int signal) {
+    (void)signal;
+    daemon_request_stop();
+}
+#endif
+
+int main(int argc, char ** argv) {
+    const char * path = DAEMON_SOCKET_PATH;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--socket") == 0 || strcmp(argv[i], "-s") == 0) && i + 1 < argc) {
+            path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && i + 1 < argc) {
+            char * endptr = NULL;
+            threads = (int) strtol(argv[++i], &endptr, 10);
+            if (strlen(endptr) > 0 || threads < 0)
+                V_EXIT(EXIT_INVALID_ARGUMENT, "O parametro \"%s\" espera um inteiro positivo depois mas foi encontrado o valor \"%s\".", argv[i-1], argv[i]);
+        }
+        else {
+            WARN("Parametro desconhecido: %s", argv[i]);
+        }
+    }
+
+#ifndef _WIN32
+    // Uma conexão fechada pelo cliente não pode encerrar o servidor
+    signal(SIGPIPE, SIG_IGN);
+
+    // SIGINT/SIGTERM param o servidor
+    struct sigaction action = { 0 };
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+#endif
+
+    return daemon_serve(path, threads);
+}